@@ -11,6 +11,11 @@ public:
         return;
     }
 
+    // То же из участка чужого буфера; наследник переопределяет, чтобы не копировать байты
+    virtual void fromRaw(const char *data, int size) {
+        fromBytes(QByteArray(data, size));
+    }
+
     virtual QByteArray toBytes() const {
         return QByteArray();
     }
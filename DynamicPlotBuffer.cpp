@@ -1,7 +1,10 @@
 #include "DynamicPlotBuffer.h"
 
-DynamicPlotBuffer::DynamicPlotBuffer(std::shared_ptr<DynamicSetting<int>> maxBufferSizeSetting)
-    : plotBufferSize(maxBufferSizeSetting), headIndex_(0), currentSize_(0)
+#include <algorithm>
+
+DynamicPlotBuffer::DynamicPlotBuffer(std::shared_ptr<DynamicSetting<int>> maxBufferSizeSetting,
+                                     std::shared_ptr<PlotHistoryBudget> historyBudget)
+    : plotBufferSize(maxBufferSizeSetting), headIndex_(0), currentSize_(0), history_(std::move(historyBudget))
 {
     if (plotBufferSize) {
         maxBufferSize_ = plotBufferSize->get();
@@ -18,8 +21,26 @@ DynamicPlotBuffer::DynamicPlotBuffer(std::shared_ptr<DynamicSetting<int>> maxBuf
 
 void DynamicPlotBuffer::addPoint(const QDateTime& time, double value)
 {
-    double key = time.toMSecsSinceEpoch() / 1000.0;
+    addPoint(time.toMSecsSinceEpoch() / 1000.0, value);
+}
+
+void DynamicPlotBuffer::addPoint(double key, double value)
+{
+    history_.append(key, value);
+    if (!live_) {
+        return;
+    }
+    pushRing(key, value);
+}
+
+void DynamicPlotBuffer::addFilePoint(double key, double value)
+{
+    fileBacked_ = true;
+    pushRing(key, value);
+}
 
+void DynamicPlotBuffer::pushRing(double key, double value)
+{
     timeData_[headIndex_] = key;
     valueData_[headIndex_] = value;
 
@@ -36,6 +57,9 @@ void DynamicPlotBuffer::clear()
     valueData_.fill(0);
     headIndex_ = 0;
     currentSize_ = 0;
+    history_.clear();
+    fileBacked_ = false;
+    live_ = true;
 }
 QVector<double> DynamicPlotBuffer::getVisibleTimeData() const
 {
@@ -108,13 +132,79 @@ QList<QPair<QDateTime, double>> DynamicPlotBuffer::getData() const
 
 void DynamicPlotBuffer::onMaxBufferSizeChanged(int newSize)
 {
+    resize(newSize);
+}
+
+void DynamicPlotBuffer::resize(int newSize)
+{
+    if (newSize <= 0 || (newSize == maxBufferSize_ && timeData_.size() == newSize)) {
+        return;
+    }
+
+    // Порядок точек в старом кольце после resize нарушен, поэтому кольцо собирается заново:
+    // из истории, а для данных файла - из последних точек старого кольца
+    QVector<double> keys;
+    QVector<double> values;
+    if (fileBacked_) {
+        keys = getVisibleTimeData();
+        values = getVisibleData();
+        const int dropped = std::max(0, static_cast<int>(keys.size()) - newSize);
+        keys.remove(0, dropped);
+        values.remove(0, dropped);
+    }
+
     maxBufferSize_ = newSize;
     timeData_.resize(maxBufferSize_);
     valueData_.resize(maxBufferSize_);
 
-    if (currentSize_ > maxBufferSize_) {
-        currentSize_ = maxBufferSize_;
+    if (!fileBacked_) {
+        if (live_) {
+            history_.readTail(maxBufferSize_, keys, values);
+        } else {
+            history_.readTail(viewStartKey_, viewEndKey_, maxBufferSize_, keys, values);
+        }
     }
+    fillRing(keys, values);
+}
+
+void DynamicPlotBuffer::showRange(double startKey, double endKey)
+{
+    live_ = false;
+    viewStartKey_ = startKey;
+    viewEndKey_ = endKey;
+
+    QVector<double> keys;
+    QVector<double> values;
+    history_.readTail(startKey, endKey, maxBufferSize_, keys, values);
+    fillRing(keys, values);
+}
+
+void DynamicPlotBuffer::showLatest()
+{
+    live_ = true;
+
+    QVector<double> keys;
+    QVector<double> values;
+    history_.readTail(maxBufferSize_, keys, values);
+    fillRing(keys, values);
+}
+
+bool DynamicPlotBuffer::isLive() const
+{
+    return live_;
+}
+
+const PlotHistory &DynamicPlotBuffer::history() const
+{
+    return history_;
+}
+
+void DynamicPlotBuffer::fillRing(const QVector<double> &keys, const QVector<double> &values)
+{
+    currentSize_ = std::min(static_cast<int>(keys.size()), maxBufferSize_);
+    std::copy(keys.cbegin(), keys.cbegin() + currentSize_, timeData_.begin());
+    std::copy(values.cbegin(), values.cbegin() + currentSize_, valueData_.begin());
+    headIndex_ = currentSize_ % maxBufferSize_;
 }
 
 QVector<double> DynamicPlotBuffer::getAllTimeData() const
@@ -7,17 +7,37 @@
 #include <QPair>
 #include <memory>
 #include <DynamicSetting.h>
+#include "plothistory.h"
 
+// Два уровня данных графика: кольцевой буфер на maxBufferSize точек для отрисовки
+// и полная история сессии (PlotHistory), из которой кольцо пересобирается
+// при смене размера буфера или при просмотре более ранних данных.
 class DynamicPlotBuffer
 {
 public:
-    explicit DynamicPlotBuffer(std::shared_ptr<DynamicSetting<int>> maxBufferSizeSetting = nullptr);
+    explicit DynamicPlotBuffer(std::shared_ptr<DynamicSetting<int>> maxBufferSizeSetting = nullptr,
+                               std::shared_ptr<PlotHistoryBudget> historyBudget = nullptr);
 
     void addPoint(const QDateTime& time, double value);
+    // key - время в секундах с эпохи, как на оси графика
+    void addPoint(double key, double value);
+    // Точка из файла записи: файл сам служит историей и перечитывается по интервалу,
+    // поэтому точка попадает только в кольцо. Сбрасывается clear().
+    void addFilePoint(double key, double value);
     void clear();
     QList<QPair<QDateTime, double>> getData() const;
 
     void setMaxBufferSize(std::shared_ptr<DynamicSetting<int>> maxBufferSizeSetting);
+    // Меняет размер кольца, заполняя его из истории; повторный вызов с тем же размером ничего не делает
+    void resize(int newSize);
+
+    // Показ последних точек интервала [startKey, endKey] из истории.
+    // Пока показ не вернется к живым данным (showLatest), новые точки попадают только в историю.
+    void showRange(double startKey, double endKey);
+    void showLatest();
+    bool isLive() const;
+
+    const PlotHistory &history() const;
 
     QVector<double> getVisibleTimeData() const;
     QVector<double> getVisibleData() const;
@@ -27,6 +47,8 @@ public:
 
 private:
     void onMaxBufferSizeChanged(int newSize);
+    void fillRing(const QVector<double> &keys, const QVector<double> &values);
+    void pushRing(double key, double value);
 
     int maxBufferSize_;
     int headIndex_;
@@ -36,6 +58,12 @@ private:
     QVector<double> valueData_;
 
     std::shared_ptr<DynamicSetting<int>> plotBufferSize;
+
+    PlotHistory history_;
+    bool fileBacked_ = false;
+    bool live_ = true;
+    double viewStartKey_ = 0;
+    double viewEndKey_ = 0;
 };
 
 #endif // DYNAMICPLOTBUFFER_H
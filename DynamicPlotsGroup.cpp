@@ -1,4 +1,6 @@
 #include "dynamicplotsgroup.h"
+#include "pipelinediagnostics.h"
+#include "tracer.h"
 
 DynamicPlotsGroup::DynamicPlotsGroup(QWidget *parent)
     : QWidget(parent)
@@ -34,18 +36,22 @@ void DynamicPlotsGroup::setMode(DisplayMode mode)
 
 void DynamicPlotsGroup::addPlot(const QString &label,
                                std::shared_ptr<DynamicSetting<int>> plotBufferSize,
-                               std::shared_ptr<DynamicSetting<int>> plotSize)
+                               std::shared_ptr<DynamicSetting<int>> plotSize,
+                               std::shared_ptr<PlotHistoryBudget> historyBudget)
 {
+    // Графики группы обычно делят одну настройку, и перерисовки на каждый график не нужны
+    if (std::find(plotBufferSizes_.begin(), plotBufferSizes_.end(), plotBufferSize) == plotBufferSizes_.end()) {
+        plotBufferSize->setOnUpdateCallback([this] (int newSize) -> void {
+            onMaxBufferSizeChanged(newSize);
+        });
+    }
+
     plotLabels_.push_back(label);
     plotBufferSizes_.push_back(plotBufferSize);
     plotSizes_.push_back(plotSize);
 
-    plotBufferSize->setOnUpdateCallback([this] (int newSize) -> void {
-        onMaxBufferSizeChanged(newSize);
-    });
-
     // Создаем новый буфер
-    dataBuffers_.push_back(new DynamicPlotBuffer(plotBufferSize));
+    dataBuffers_.push_back(new DynamicPlotBuffer(plotBufferSize, historyBudget));
 
     if (!tableWidget_) {
         tableWidget_ = new DataTableWidget(contentWidget_, dataBuffers_);
@@ -87,25 +93,15 @@ void DynamicPlotsGroup::clear()
     updateDisplayedData();
 }
 
-void DynamicPlotsGroup::plotSensorData(
-    const QList<TimestampedSensorData> &dataList,
-    const std::vector<std::pair<
-        std::function<double(const TimestampedSensorData&)>,
-        std::function<bool(const TimestampedSensorData&)>
-    >> &extractors)
+void DynamicPlotsGroup::beginBatchLoad()
 {
     for (auto &buffer : dataBuffers_) {
         buffer->clear();
     }
+}
 
-    for (const auto &data : dataList) {
-        for (size_t i = 0; i < extractors.size() && i < dataBuffers_.size(); ++i) {
-            if (extractors[i].second(data)) {
-                dataBuffers_[i]->addPoint(data.getTimestamp(), extractors[i].first(data));
-            }
-        }
-    }
-
+void DynamicPlotsGroup::endBatchLoad()
+{
     updateDisplayedData();
 }
 
@@ -140,6 +136,15 @@ QList<QList<QPair<QDateTime, double>>> DynamicPlotsGroup::getAllData() const
     return result;
 }
 
+void DynamicPlotsGroup::copyColumns(QVector<double> &times, std::vector<QVector<double>> &values) const
+{
+    times = dataBuffers_.empty() ? QVector<double>() : dataBuffers_.front()->getVisibleTimeData();
+    values.clear();
+    for (const auto &buffer : dataBuffers_) {
+        values.push_back(buffer->getVisibleData());
+    }
+}
+
 void DynamicPlotsGroup::updateLayout()
 {
     // Скрываем все виджеты
@@ -210,11 +215,22 @@ void DynamicPlotsGroup::addPoint(const QDateTime &timestamp, const std::vector<d
     }
 
     // Добавляем данные в буферы
-    for (size_t i = 0; i < dataBuffers_.size(); ++i) {
-        dataBuffers_[i]->addPoint(timestamp, values[i]);
+    {
+        ScopedStage stage(PipelineDiagnostics::BUFFER_UPDATE);
+        TraceSpan span("buffer update");
+        for (size_t i = 0; i < dataBuffers_.size(); ++i) {
+            dataBuffers_[i]->addPoint(timestamp, values[i]);
+        }
+    }
+
+    // При просмотре истории точка попадает только в историю
+    if (!isLive()) {
+        return;
     }
 
     // Обновляем отображение в зависимости от текущего режима
+    ScopedStage stage(PipelineDiagnostics::RENDER);
+    TraceSpan span("group render");
     switch (currentMode_) {
         case TABLE_VIEW:
             if (tableWidget_) {
@@ -234,16 +250,46 @@ void DynamicPlotsGroup::addPoint(const QDateTime &timestamp, const std::vector<d
     }
 }
 
-void DynamicPlotsGroup::onMaxBufferSizeChanged(int newSize)
+void DynamicPlotsGroup::showHistoryRange(const QDateTime &start, const QDateTime &end)
 {
-    if (tableWidget_) {
-        tableWidget_->clear();
+    for (auto &buffer : dataBuffers_) {
+        buffer->showRange(start.toMSecsSinceEpoch() / 1000.0, end.toMSecsSinceEpoch() / 1000.0);
     }
-    for (auto plot : plots_) {
-        plot->clear();
+    updateDisplayedData();
+}
+
+void DynamicPlotsGroup::showLatest()
+{
+    for (auto &buffer : dataBuffers_) {
+        buffer->showLatest();
     }
-    if (multiLinePlot_) {
-        multiLinePlot_->clear();
+    updateDisplayedData();
+}
+
+bool DynamicPlotsGroup::isLive() const
+{
+    return dataBuffers_.empty() || dataBuffers_.front()->isLive();
+}
+
+bool DynamicPlotsGroup::historyBounds(QDateTime &first, QDateTime &last) const
+{
+    if (dataBuffers_.empty() || dataBuffers_.front()->history().isEmpty()) {
+        return false;
     }
+    const PlotHistory &history = dataBuffers_.front()->history();
+    first = QDateTime::fromMSecsSinceEpoch(qRound64(history.firstKey() * 1000));
+    last = QDateTime::fromMSecsSinceEpoch(qRound64(history.lastKey() * 1000));
+    return true;
+}
+
+// Кольца пересобираются из истории, поэтому смена размера не теряет данные
+// (данные файла берутся из старого кольца и перечитываются при смене интервала).
+// Колбэки буферов на ту же настройку после этого ничего не делают.
+void DynamicPlotsGroup::onMaxBufferSizeChanged(int newSize)
+{
+    for (auto &buffer : dataBuffers_) {
+        buffer->resize(newSize);
+    }
+    updateDisplayedData();
 }
 
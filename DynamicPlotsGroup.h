@@ -7,6 +7,7 @@
 #include <QScrollArea>
 #include <QVBoxLayout>
 #include <vector>
+#include <algorithm>
 #include <memory>
 #include <MultiLinePlot.h>
 #include "DataTableWidget.h"
@@ -27,18 +28,30 @@ public:
     void setMode(DisplayMode mode);
     void addPlot(const QString &label, 
                  std::shared_ptr<DynamicSetting<int>> plotBufferSize,
-                 std::shared_ptr<DynamicSetting<int>> plotSize);
+                 std::shared_ptr<DynamicSetting<int>> plotSize,
+                 std::shared_ptr<PlotHistoryBudget> historyBudget = nullptr);
     void clear();
     
-    void plotSensorData(
-        const QList<TimestampedSensorData> &dataList,
-        const std::vector<std::pair<
-            std::function<double(const TimestampedSensorData&)>,
-            std::function<bool(const TimestampedSensorData&)>
-        >> &extractors);
+    // Пакетная загрузка колонок из курсора: beginBatchLoad очищает буферы,
+    // appendColumns дописывает пакет, endBatchLoad перерисовывает текущий режим.
+    // Данные файла идут только в кольца, минуя историю сессии.
+    void beginBatchLoad();
+    template<typename Columns>
+    void appendColumns(const QVector<qint64> &timestampsNs, const Columns &columns);
+    void endBatchLoad();
 
     void addPoint(const QDateTime &timestamp, const std::vector<double> &values);
+
+    // Просмотр истории сессии: графики показывают последние точки интервала
+    // и не перерисовываются на новых данных до возврата к showLatest
+    void showHistoryRange(const QDateTime &start, const QDateTime &end);
+    void showLatest();
+    bool isLive() const;
+    // Границы истории по первому буферу; false, если история пуста
+    bool historyBounds(QDateTime &first, QDateTime &last) const;
     QList<QList<QPair<QDateTime, double>>> getAllData() const;
+    // Копия буферов по колонкам: время в секундах с эпохи берется из первого буфера
+    void copyColumns(QVector<double> &times, std::vector<QVector<double>> &values) const;
 
 private:
     void onMaxBufferSizeChanged(int newSize);
@@ -66,4 +79,17 @@ private:
     std::vector<DynamicPlotBuffer*> dataBuffers_;
 };
 
+template<typename Columns>
+void DynamicPlotsGroup::appendColumns(const QVector<qint64> &timestampsNs, const Columns &columns)
+{
+    const size_t count = std::min(static_cast<size_t>(columns.size()), dataBuffers_.size());
+    for (size_t i = 0; i < count; ++i) {
+        const auto &column = columns[i];
+        DynamicPlotBuffer *buffer = dataBuffers_[i];
+        for (int row = 0; row < timestampsNs.size() && row < column.size(); ++row) {
+            buffer->addFilePoint(timestampsNs[row] / 1e9, static_cast<double>(column[row]));
+        }
+    }
+}
+
 #endif // DYNAMICPLOTSGROUP_H 
@@ -1,6 +1,7 @@
 #ifndef SENSORDATADAO_H
 #define SENSORDATADAO_H
 
+#include "channelschema.h"
 #include "extendedsensordata.h"
 #include <QSqlDatabase>
 #include <QSqlQuery>
@@ -8,150 +9,315 @@
 #include <QDateTime>
 #include <QDebug>
 #include <QIODevice>
+#include <QUuid>
+#include <QElapsedTimer>
 
 #include <comand/SensorData.h>
 
-#include <ISensorDataDAO.h>
+#include "isensordatadao.h"
 #include <QList>
+#include <limits>
+#include <memory>
+#include <stdexcept>
 
 
-class SensorDataDAO : public ISensorDataDAO 
+class SensorDataDAO : public ISensorDataDAO
 {
 public:
-    SensorDataDAO(const QString &databaseName)
+    // Версия схемы хранится в PRAGMA user_version.
+    // 1 - timestamp как ISO-строка, 2 - timestamp в наносекундах с эпохи.
+    static constexpr int SCHEMA_VERSION = 2;
+    static constexpr int DEFAULT_COMMIT_ROWS = 1000;
+
+    explicit SensorDataDAO(const QString &databaseName, int commitRows = DEFAULT_COMMIT_ROWS)
+        : connectionName_(QUuid::createUuid().toString()),
+          commitRows_(commitRows > 0 ? commitRows : 1)
     {
-        db = QSqlDatabase::addDatabase("QSQLITE");
+        // Отдельное соединение на каждый DAO, чтобы несколько баз могли быть открыты одновременно
+        db = QSqlDatabase::addDatabase("QSQLITE", connectionName_);
         db.setDatabaseName(databaseName);
 
         if (!db.open()) {
             qDebug() << "Failed to open database:" << db.lastError().text();
-        } else {
-            createTable();
+            throw std::runtime_error("Failed to open database.");
+        }
+
+        configureConnection();
+        createTable();
+
+        insertQuery_ = QSqlQuery(db);
+        if (!insertQuery_.prepare(QString("INSERT INTO SensorData (timestamp, %1) VALUES (?%2)")
+                                      .arg(channelColumns(), QString(", ?").repeated(ChannelSchema::CHANNEL_COUNT)))) {
+            qDebug() << "Failed to prepare insert statement:" << insertQuery_.lastError().text();
         }
     }
 
     ~SensorDataDAO()
     {
+        flush();
+        insertQuery_ = QSqlQuery();
         db.close();
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(connectionName_);
     }
 
-    bool insertSensorData(const TimestampedSensorData &data)
+    // Строка не пишется сразу: вставки копятся в открытой транзакции
+    // и фиксируются каждые commitRows_ строк либо при вызове flush().
+    bool insertSensorData(const TimestampedSensorData &data) override
     {
-        QSqlQuery query;
-        query.prepare("INSERT INTO SensorData (timestamp, temperature, humidity, pressure, gyro_x, gyro_y, gyro_z, accelero_x, accelero_y, accelero_z, "
-                      "magneto_x, magneto_y, magneto_z) "
-                      "VALUES (:timestamp, :temperature, :humidity, :pressure, :gyro_x, :gyro_y, :gyro_z, :accelero_x, :accelero_y, :accelero_z, "
-                      ":magneto_x, :magneto_y, :magneto_z)");
+        if (!inTransaction_) {
+            if (!db.transaction()) {
+                qDebug() << "Failed to begin transaction:" << db.lastError().text();
+                return false;
+            }
+            inTransaction_ = true;
+            transactionTimer_.start();
+        }
 
-        query.bindValue(":timestamp", QDateTime::currentDateTime().toString(Qt::ISODate));
-        const auto &envMeasures = data.getEnvironmentalMeasures();
-        const auto &gyroMeasures = data.getGyroMeasures();
-        const auto &acceleroMeasures = data.getAcceleroMeasures();
-        const auto &magnetoMeasures = data.getMagnetoMeasures();
+        insertQuery_.bindValue(0, toNanos(data.getTimestamp()));
 
-        if (envMeasures.size() >= 3) {
-            query.bindValue(":temperature", envMeasures[0]);
-            query.bindValue(":humidity", envMeasures[1]);
-            query.bindValue(":pressure", envMeasures[2]);
-        }
+        // Отсутствующая группа пишется нулями
+        ChannelSchema::forEachChannel([&](auto channel) {
+            constexpr int index = decltype(channel)::value;
+            constexpr ChannelSchema::Channel descriptor = ChannelSchema::CHANNELS[index];
+            insertQuery_.bindValue(1 + index, data.groupValues<descriptor.group>()[descriptor.axis]);
+        });
 
-        if (gyroMeasures.size() >= 3) {
-            query.bindValue(":gyro_x", gyroMeasures[0]);
-            query.bindValue(":gyro_y", gyroMeasures[1]);
-            query.bindValue(":gyro_z", gyroMeasures[2]);
+        if (!insertQuery_.exec()) {
+            qDebug() << "Failed to insert data:" << insertQuery_.lastError().text();
+            return false;
         }
 
-        if (acceleroMeasures.size() >= 3) {
-            query.bindValue(":accelero_x", acceleroMeasures[0]);
-            query.bindValue(":accelero_y", acceleroMeasures[1]);
-            query.bindValue(":accelero_z", acceleroMeasures[2]);
+        pendingTimestamp_ = toNanos(data.getTimestamp());
+        if (++pendingRows_ >= commitRows_
+            || (durability_.intervalMs > 0 && transactionTimer_.hasExpired(durability_.intervalMs))) {
+            return flush();
         }
+        return true;
+    }
+
+    // Транзакция фиксируется не реже durability_.intervalMs: с WAL зафиксированные
+    // строки переживают падение приложения. Порог по объему задает commitRows_.
+    void setDurabilityPolicy(const DurabilityPolicy &policy) override
+    {
+        durability_ = policy;
+    }
 
-        if (magnetoMeasures.size() >= 3) {
-            query.bindValue(":magneto_x", magnetoMeasures[0]);
-            query.bindValue(":magneto_z", magnetoMeasures[1]);
-            query.bindValue(":magneto_y", magnetoMeasures[2]);
+    qint64 lastDurableTimestamp() const override
+    {
+        return committedTimestamp_;
+    }
+
+    // Фиксирует накопленные вставки
+    bool flush()
+    {
+        if (!inTransaction_) {
+            return true;
         }
 
-        if (!query.exec()) {
-            qDebug() << "Failed to insert data:" << query.lastError().text();
+        inTransaction_ = false;
+        pendingRows_ = 0;
+        if (!db.commit()) {
+            qDebug() << "Failed to commit transaction:" << db.lastError().text();
+            db.rollback();
             return false;
         }
-
+        committedTimestamp_ = pendingTimestamp_;
         return true;
     }
 
-    QList<TimestampedSensorData> selectAllSensorData() override {
-        return QList<TimestampedSensorData>();
+    void setCommitRows(int commitRows)
+    {
+        commitRows_ = commitRows > 0 ? commitRows : 1;
+    }
+
+    std::unique_ptr<ISensorDataCursor> selectAllSensorDataCursor(int batchSize = DEFAULT_BATCH_SIZE) override
+    {
+        return openCursor(std::numeric_limits<qint64>::min(), std::numeric_limits<qint64>::max(), batchSize);
     }
 
-    QList<TimestampedSensorData> selectSensorData(const QDateTime &start, const QDateTime &end)
+    std::unique_ptr<ISensorDataCursor> selectSensorDataCursor(const QDateTime &start, const QDateTime &end,
+                                                              int batchSize = DEFAULT_BATCH_SIZE) override
     {
-        QList<TimestampedSensorData> dataList;
-        QSqlQuery query;
-        query.prepare("SELECT timestamp, temperature, humidity, pressure, gyro_x, gyro_y,"
-                      " gyro_z, accelero_x, accelero_y, accelero_z, magneto_x, magneto_y, magneto_z "
-                      "FROM SensorData WHERE timestamp BETWEEN :start AND :end");
-        query.bindValue(":start", start.toString(Qt::ISODate));
-        query.bindValue(":end", end.toString(Qt::ISODate));
+        return openCursor(toNanos(start), toNanos(end), batchSize);
+    }
+
+    // Выборка диапазона [startNs, endNs] по индексу на timestamp.
+    // Запрос однонаправленный, строки читаются из SQLite по мере вызова next().
+    std::unique_ptr<ISensorDataCursor> openCursor(qint64 startNs, qint64 endNs, int batchSize = DEFAULT_BATCH_SIZE)
+    {
+        // Незафиксированные строки иначе не будут видны в выборке
+        flush();
+
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        query.prepare(QString("SELECT timestamp, %1 FROM SensorData WHERE timestamp BETWEEN ? AND ? ORDER BY timestamp")
+                          .arg(channelColumns()));
+        query.bindValue(0, startNs);
+        query.bindValue(1, endNs);
 
         if (!query.exec()) {
             qDebug() << "Failed to select data:" << query.lastError().text();
-            return dataList;
+            return nullptr;
         }
 
-        while (query.next()) {
-            QList<float> env;
-            env.append(query.value("temperature").toFloat());
-            env.append(query.value("humidity").toFloat());
-            env.append(query.value("pressure").toFloat());
+        return std::unique_ptr<ISensorDataCursor>(new Cursor(std::move(query), batchSize));
+    }
+
+    static qint64 toNanos(const QDateTime &timestamp)
+    {
+        return SensorDataBatch::toNanos(timestamp);
+    }
+
+private:
+    // Колонки каналов в порядке ChannelSchema::CHANNELS
+    static QString channelColumns()
+    {
+        return SensorDataBatch::CHANNEL_NAMES.join(", ");
+    }
+
+    class Cursor : public ISensorDataCursor
+    {
+    public:
+        Cursor(QSqlQuery &&query, int batchSize)
+            : query_(std::move(query)), batchSize_(batchSize > 0 ? batchSize : DEFAULT_BATCH_SIZE) {}
 
-            QList<int16_t> accelero;
-            accelero.append(static_cast<int16_t>(query.value("accelero_x").toInt()));
-            accelero.append(static_cast<int16_t>(query.value("accelero_y").toInt()));
-            accelero.append(static_cast<int16_t>(query.value("accelero_z").toInt()));
+        // Колонки читаются по индексу: поиск по имени на каждой строке заметно дороже
+        bool next(SensorDataBatch &batch) override
+        {
+            batch.clear();
+            batch.channels = SensorDataBatch::ALL;
+            batch.reserve(batchSize_);
 
-            QList<int16_t> gyro;
-            gyro.append(static_cast<int16_t>(query.value("gyro_x").toInt()));
-            gyro.append(static_cast<int16_t>(query.value("gyro_y").toInt()));
-            gyro.append(static_cast<int16_t>(query.value("gyro_z").toInt()));
+            while (batch.size() < batchSize_ && query_.next()) {
+                batch.timestamps.append(query_.value(0).toLongLong());
+                ChannelSchema::forEachChannel([&](auto channel) {
+                    constexpr int index = decltype(channel)::value;
+                    batch.appendConverted<index>(query_.value(1 + index));
+                });
+            }
 
-            QList<int16_t> magneto;
-            magneto.append(static_cast<int16_t>(query.value("magneto_x").toInt()));
-            magneto.append(static_cast<int16_t>(query.value("magneto_y").toInt()));
-            magneto.append(static_cast<int16_t>(query.value("magneto_z").toInt()));
+            return !batch.isEmpty();
+        }
 
+    private:
+        QSqlQuery query_;
+        int batchSize_;
+    };
 
-            QDateTime timestamp = QDateTime::fromString(query.value("timestamp").toString(), Qt::ISODate);
-            TimestampedSensorData sensorData(env, gyro, accelero, magneto, timestamp);
-            dataList.append(sensorData);
+    void configureConnection()
+    {
+        QSqlQuery query(db);
+        // WAL позволяет читать базу во время записи и убирает fsync на каждую транзакцию
+        if (!query.exec("PRAGMA journal_mode=WAL")) {
+            qDebug() << "Failed to enable WAL:" << query.lastError().text();
         }
+        query.exec("PRAGMA synchronous=NORMAL");
+        query.exec("PRAGMA temp_store=MEMORY");
+    }
 
-        return dataList;
+    int schemaVersion()
+    {
+        QSqlQuery query(db);
+        if (query.exec("PRAGMA user_version") && query.next()) {
+            return query.value(0).toInt();
+        }
+        return 0;
     }
 
-private:
     void createTable()
     {
-        QSqlQuery query;
-        query.exec("CREATE TABLE IF NOT EXISTS SensorData ("
-                   "id INTEGER PRIMARY KEY AUTOINCREMENT, "
-                   "timestamp TEXT NOT NULL, "
-                   "temperature REAL NOT NULL, "
-                   "humidity REAL NOT NULL, "
-                   "pressure REAL NOT NULL, "
-                   "gyro_x INTEGER NOT NULL, "
-                   "gyro_y INTEGER NOT NULL, "
-                   "gyro_z INTEGER NOT NULL, "
-                   "accelero_x INTEGER NOT NULL, "
-                   "accelero_y INTEGER NOT NULL, "
-                   "accelero_z INTEGER NOT NULL,"
-                   "magneto_x INTEGER NOT NULL, "
-                   "magneto_y INTEGER NOT NULL, "
-                   "magneto_z INTEGER NOT NULL)");
+        const bool hasLegacyTable = schemaVersion() < SCHEMA_VERSION
+            && db.tables().contains("SensorData");
+
+        if (!hasLegacyTable) {
+            QSqlQuery query(db);
+            createSchema();
+            query.exec(QString("PRAGMA user_version=%1").arg(SCHEMA_VERSION));
+            return;
+        }
+
+        // Миграция и смена версии - одна транзакция: при ошибке база остается
+        // в схеме версии 1 и миграция повторится при следующем открытии
+        if (!db.transaction()) {
+            qDebug() << "Failed to begin migration:" << db.lastError().text();
+            throw std::runtime_error("Failed to migrate database.");
+        }
+        QSqlQuery query(db);
+        if (!migrateLegacyTable()
+            || !query.exec(QString("PRAGMA user_version=%1").arg(SCHEMA_VERSION))
+            || !db.commit()) {
+            qDebug() << "Failed to migrate legacy data:" << db.lastError().text();
+            db.rollback();
+            throw std::runtime_error("Failed to migrate database.");
+        }
+    }
+
+    bool createSchema()
+    {
+        QSqlQuery query(db);
+        QString columns;
+        for (const ChannelSchema::Channel &channel : ChannelSchema::CHANNELS) {
+            columns += QString(", %1 %2 NOT NULL").arg(QLatin1String(channel.name), QLatin1String(ChannelSchema::sqlType(channel.wire)));
+        }
+        return query.exec("CREATE TABLE IF NOT EXISTS SensorData (id INTEGER PRIMARY KEY, timestamp INTEGER NOT NULL" + columns + ")")
+            && query.exec("CREATE INDEX IF NOT EXISTS SensorData_timestamp_idx ON SensorData (timestamp)");
+    }
+
+    // Старые записи хранили местное время ISO-строкой без смещения, с точностью до секунды.
+    // Время разбирается так же, как его читала версия 1, - QDateTime в местном часовом поясе.
+    // Колонки здесь - схема версии 1, поэтому перечислены явно
+    bool migrateLegacyTable()
+    {
+        static const QString legacyColumns = "temperature, humidity, pressure, gyro_x, gyro_y, gyro_z, "
+                                             "accelero_x, accelero_y, accelero_z, magneto_x, magneto_y, magneto_z";
+        constexpr int legacyColumnCount = 12;
+        QSqlQuery query(db);
+        if (!query.exec("ALTER TABLE SensorData RENAME TO SensorData_v1") || !createSchema()) {
+            return false;
+        }
+
+        QSqlQuery select(db);
+        select.setForwardOnly(true);
+        QSqlQuery insert(db);
+        if (!select.exec("SELECT timestamp, " + legacyColumns + " FROM SensorData_v1 ORDER BY id")
+            || !insert.prepare(QString("INSERT INTO SensorData (timestamp, %1) VALUES (?%2)")
+                                   .arg(legacyColumns, QString(", ?").repeated(legacyColumnCount)))) {
+            return false;
+        }
+
+        int skipped = 0;
+        while (select.next()) {
+            const QDateTime timestamp = QDateTime::fromString(select.value(0).toString(), Qt::ISODate);
+            if (!timestamp.isValid()) {
+                ++skipped;
+                continue;
+            }
+            insert.bindValue(0, toNanos(timestamp));
+            for (int i = 1; i <= legacyColumnCount; ++i) {
+                insert.bindValue(i, select.value(i));
+            }
+            if (!insert.exec()) {
+                qDebug() << "Failed to copy legacy row:" << insert.lastError().text();
+                return false;
+            }
+        }
+        if (skipped > 0) {
+            qDebug() << "Skipped legacy rows with unreadable timestamp:" << skipped;
+        }
+        return query.exec("DROP TABLE SensorData_v1");
     }
 
+    QString connectionName_;
     QSqlDatabase db;
+    QSqlQuery insertQuery_;
+    int commitRows_;
+    int pendingRows_ = 0;
+    bool inTransaction_ = false;
+    DurabilityPolicy durability_ = {0, 0};
+    QElapsedTimer transactionTimer_;
+    qint64 pendingTimestamp_ = std::numeric_limits<qint64>::min();
+    qint64 committedTimestamp_ = std::numeric_limits<qint64>::min();
 };
 
 #endif // SENSORDATADAO_H
@@ -0,0 +1,205 @@
+#include "allocationcounter.h"
+
+#if defined(DIMPLOMA_ALLOCATION_COUNTING)
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<qint64> totalAllocations{0};
+// Тривиальная переменная потока в исполняемом файле не выделяет память при первом обращении
+thread_local qint64 threadAllocations = 0;
+
+inline void countAllocation()
+{
+    ++threadAllocations;
+    totalAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+
+}
+
+#if defined(__GLIBC__)
+
+// glibc: перехватывается malloc, поэтому учитываются и operator new, и контейнеры Qt
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *pointer);
+
+void *malloc(size_t size)
+{
+    countAllocation();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    countAllocation();
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+    countAllocation();
+    return __libc_realloc(pointer, size);
+}
+
+// Выровненные выделения, в том числе operator new с align_val_t
+void *memalign(size_t alignment, size_t size)
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+void *aligned_alloc(size_t alignment, size_t size)
+{
+    countAllocation();
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void **result, size_t alignment, size_t size)
+{
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    countAllocation();
+    void *pointer = __libc_memalign(alignment, size);
+    if (!pointer) {
+        return ENOMEM;
+    }
+    *result = pointer;
+    return 0;
+}
+
+void free(void *pointer)
+{
+    __libc_free(pointer);
+}
+}
+
+#else
+
+// Остальные библиотеки C (MinGW, MSVC, macOS) не дают перехватить malloc переносимо:
+// заменяются глобальные operator new и delete, учитываются только выделения C++.
+// Контейнеры Qt выделяют через malloc и в счетчик не попадают.
+namespace {
+
+// Выровненный блок берется из malloc с запасом, исходный указатель хранится перед блоком
+void *alignedAllocate(std::size_t size, std::size_t alignment)
+{
+    alignment = alignment < alignof(void*) ? alignof(void*) : alignment;
+    void *raw = std::malloc(size + alignment + sizeof(void*));
+    if (!raw) {
+        return nullptr;
+    }
+    const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*);
+    void *aligned = reinterpret_cast<void*>((start + alignment - 1) & ~(std::uintptr_t(alignment) - 1));
+    static_cast<void**>(aligned)[-1] = raw;
+    return aligned;
+}
+
+void alignedFree(void *pointer)
+{
+    if (pointer) {
+        std::free(static_cast<void**>(pointer)[-1]);
+    }
+}
+
+void *allocate(std::size_t size)
+{
+    countAllocation();
+    void *pointer = std::malloc(size ? size : 1);
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+void *allocate(std::size_t size, std::align_val_t alignment)
+{
+    countAllocation();
+    void *pointer = alignedAllocate(size ? size : 1, static_cast<std::size_t>(alignment));
+    if (!pointer) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+}
+
+void *operator new(std::size_t size) { return allocate(size); }
+void *operator new[](std::size_t size) { return allocate(size); }
+void *operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void *operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void *pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void *pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+
+void *operator new(std::size_t size, std::align_val_t alignment) { return allocate(size, alignment); }
+void *operator new[](std::size_t size, std::align_val_t alignment) { return allocate(size, alignment); }
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size, alignment); } catch (...) { return nullptr; }
+}
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size, alignment); } catch (...) { return nullptr; }
+}
+void operator delete(void *pointer, std::align_val_t) noexcept { alignedFree(pointer); }
+void operator delete[](void *pointer, std::align_val_t) noexcept { alignedFree(pointer); }
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept { alignedFree(pointer); }
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept { alignedFree(pointer); }
+void operator delete(void *pointer, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(pointer); }
+void operator delete[](void *pointer, std::align_val_t, const std::nothrow_t&) noexcept { alignedFree(pointer); }
+
+#endif
+
+bool AllocationCounter::isEnabled()
+{
+    return true;
+}
+
+qint64 AllocationCounter::threadCount()
+{
+    return threadAllocations;
+}
+
+qint64 AllocationCounter::totalCount()
+{
+    return totalAllocations.load(std::memory_order_relaxed);
+}
+
+#else
+
+bool AllocationCounter::isEnabled()
+{
+    return false;
+}
+
+qint64 AllocationCounter::threadCount()
+{
+    return 0;
+}
+
+qint64 AllocationCounter::totalCount()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+// Счетчик выделений памяти для проверки, что живой путь не выделяет память после прогрева.
+// Работает при сборке с DIMPLOMA_ALLOCATION_COUNTING (Debug и бенчмарки).
+// В glibc перехватывается malloc, в том числе выровненный, поэтому учитываются и operator new,
+// и контейнеры Qt. На других платформах заменяются глобальные operator new и delete:
+// учитываются только выделения C++. Без флага счетчики нулевые и ничего не стоят,
+// isEnabled() == false, и нули нельзя выдавать за отсутствие выделений.
+namespace AllocationCounter {
+
+bool isEnabled();
+// Выделения текущего потока с его запуска: разница двух значений - выделения участка кода
+qint64 threadCount();
+// Выделения всех потоков
+qint64 totalCount();
+
+}
+
+#endif // ALLOCATIONCOUNTER_H
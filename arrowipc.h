@@ -0,0 +1,921 @@
+#ifndef ARROWIPC_H
+#define ARROWIPC_H
+
+#include "sensordatacursor.h"
+#include <QFile>
+#include <QDebug>
+#include <QtEndian>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Минимальная реализация FlatBuffers, достаточная для метаданных Arrow IPC.
+// Объекты собираются деревом и пишутся от корня к листьям: смещения в FlatBuffers
+// беззнаковые и указывают вперед, поэтому дочерний объект пишется после родителя,
+// а смещение на него дописывается в родителя после записи.
+class FlatBuilder
+{
+public:
+    struct Node;
+    using NodePtr = std::shared_ptr<Node>;
+
+    struct Field {
+        int id;
+        int size;
+        quint64 value;
+        NodePtr child;
+    };
+
+    struct Node {
+        enum Kind { TABLE, STRING, STRUCT_VECTOR, TABLE_VECTOR } kind;
+        std::vector<Field> fields;
+        QByteArray bytes;
+        int count = 0;
+        std::vector<NodePtr> children;
+    };
+
+    static NodePtr table()
+    {
+        NodePtr node = std::make_shared<Node>();
+        node->kind = Node::TABLE;
+        return node;
+    }
+
+    static void scalar(const NodePtr &table, int id, int size, quint64 value)
+    {
+        table->fields.push_back({id, size, value, nullptr});
+    }
+
+    static void offset(const NodePtr &table, int id, const NodePtr &child)
+    {
+        table->fields.push_back({id, static_cast<int>(sizeof(quint32)), 0, child});
+    }
+
+    static NodePtr string(const QByteArray &text)
+    {
+        NodePtr node = std::make_shared<Node>();
+        node->kind = Node::STRING;
+        node->bytes = text;
+        return node;
+    }
+
+    // Вектор структур с выравниванием 8 байт (все структуры Arrow состоят из int64)
+    static NodePtr structVector(const QByteArray &elements, int count)
+    {
+        NodePtr node = std::make_shared<Node>();
+        node->kind = Node::STRUCT_VECTOR;
+        node->bytes = elements;
+        node->count = count;
+        return node;
+    }
+
+    static NodePtr tableVector(const std::vector<NodePtr> &tables)
+    {
+        NodePtr node = std::make_shared<Node>();
+        node->kind = Node::TABLE_VECTOR;
+        node->children = tables;
+        node->count = static_cast<int>(tables.size());
+        return node;
+    }
+
+    // Буфер дополняется до кратного 8 размера, как требует Arrow
+    static QByteArray finish(const NodePtr &root)
+    {
+        QByteArray out(sizeof(quint32), '\0');
+        const int rootPosition = write(out, root);
+        qToLittleEndian<quint32>(static_cast<quint32>(rootPosition), out.data());
+        padTo(out, 8);
+        return out;
+    }
+
+private:
+    static void padTo(QByteArray &out, int alignment, int remainder = 0)
+    {
+        while (out.size() % alignment != remainder) {
+            out.append('\0');
+        }
+    }
+
+    static void patchOffset(QByteArray &out, int position, int target)
+    {
+        qToLittleEndian<quint32>(static_cast<quint32>(target - position), out.data() + position);
+    }
+
+    static int write(QByteArray &out, const NodePtr &node)
+    {
+        switch (node->kind) {
+        case Node::STRING: {
+            padTo(out, 4);
+            const int position = out.size();
+            appendScalar(out, sizeof(quint32), static_cast<quint64>(node->bytes.size()));
+            out.append(node->bytes);
+            out.append('\0');
+            return position;
+        }
+        case Node::STRUCT_VECTOR: {
+            // Элементы должны начинаться с адреса, кратного 8
+            padTo(out, 8, 4);
+            const int position = out.size();
+            appendScalar(out, sizeof(quint32), static_cast<quint64>(node->count));
+            out.append(node->bytes);
+            return position;
+        }
+        case Node::TABLE_VECTOR: {
+            padTo(out, 4);
+            const int position = out.size();
+            appendScalar(out, sizeof(quint32), static_cast<quint64>(node->count));
+            out.append(QByteArray(node->count * static_cast<int>(sizeof(quint32)), '\0'));
+            for (int i = 0; i < node->count; ++i) {
+                const int slot = position + static_cast<int>(sizeof(quint32)) * (i + 1);
+                patchOffset(out, slot, write(out, node->children[i]));
+            }
+            return position;
+        }
+        case Node::TABLE:
+            break;
+        }
+
+        // Поля по убыванию размера: начало таблицы выравнивается так, что после
+        // soffset (4 байта) каждое поле оказывается выровненным без дополнения
+        std::vector<Field> fields = node->fields;
+        std::stable_sort(fields.begin(), fields.end(), [](const Field &a, const Field &b) {
+            return a.size > b.size;
+        });
+
+        int fieldCount = 0;
+        for (const Field &field : fields) {
+            fieldCount = std::max(fieldCount, field.id + 1);
+        }
+        std::vector<int> fieldOffsets(fieldCount, 0);
+        std::vector<int> sortedOffsets;
+        int inlineSize = sizeof(qint32);
+        for (const Field &field : fields) {
+            fieldOffsets[field.id] = inlineSize;
+            sortedOffsets.push_back(inlineSize);
+            inlineSize += field.size;
+        }
+
+        padTo(out, 2);
+        const int vtablePosition = out.size();
+        appendScalar(out, sizeof(quint16), static_cast<quint64>(4 + 2 * fieldCount));
+        appendScalar(out, sizeof(quint16), static_cast<quint64>(inlineSize));
+        for (int fieldOffset : fieldOffsets) {
+            appendScalar(out, sizeof(quint16), static_cast<quint64>(fieldOffset));
+        }
+
+        padTo(out, 8, 4);
+        const int tablePosition = out.size();
+        appendScalar(out, sizeof(qint32), static_cast<quint64>(tablePosition - vtablePosition));
+        for (size_t i = 0; i < fields.size(); ++i) {
+            appendScalar(out, fields[i].size, fields[i].value);
+        }
+
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (fields[i].child) {
+                const int fieldPosition = tablePosition + sortedOffsets[i];
+                patchOffset(out, fieldPosition, write(out, fields[i].child));
+            }
+        }
+        return tablePosition;
+    }
+
+    static void appendScalar(QByteArray &out, int size, quint64 value)
+    {
+        for (int i = 0; i < size; ++i) {
+            out.append(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+};
+
+// Чтение таблицы FlatBuffers с проверкой границ буфера.
+// Отсутствующие или выходящие за буфер поля возвращают значение по умолчанию.
+class FlatTable
+{
+public:
+    FlatTable() = default;
+
+    FlatTable(const uchar *buffer, qint64 size, qint64 position)
+        : buffer_(buffer), size_(size)
+    {
+        if (!inBounds(position, sizeof(qint32))) {
+            return;
+        }
+        const qint64 vtable = position - qFromLittleEndian<qint32>(buffer_ + position);
+        if (!inBounds(vtable, 2 * sizeof(quint16))) {
+            return;
+        }
+        const int vtableSize = qFromLittleEndian<quint16>(buffer_ + vtable);
+        if (vtableSize < 4 || !inBounds(vtable, vtableSize)) {
+            return;
+        }
+        position_ = position;
+        vtable_ = vtable;
+        vtableSize_ = vtableSize;
+    }
+
+    // Корневая таблица буфера
+    static FlatTable root(const uchar *buffer, qint64 size)
+    {
+        if (size < static_cast<qint64>(sizeof(quint32))) {
+            return FlatTable();
+        }
+        return FlatTable(buffer, size, qFromLittleEndian<quint32>(buffer));
+    }
+
+    bool isValid() const
+    {
+        return position_ >= 0;
+    }
+
+    template<typename T>
+    T scalar(int id, T defaultValue = T()) const
+    {
+        const qint64 position = fieldPosition(id);
+        if (position < 0 || !inBounds(position, sizeof(T))) {
+            return defaultValue;
+        }
+        return qFromLittleEndian<T>(buffer_ + position);
+    }
+
+    FlatTable table(int id) const
+    {
+        const qint64 target = dereference(fieldPosition(id));
+        return target < 0 ? FlatTable() : FlatTable(buffer_, size_, target);
+    }
+
+    QByteArray string(int id) const
+    {
+        const qint64 target = dereference(fieldPosition(id));
+        if (target < 0 || !inBounds(target, sizeof(quint32))) {
+            return QByteArray();
+        }
+        const quint32 length = qFromLittleEndian<quint32>(buffer_ + target);
+        if (!inBounds(target + sizeof(quint32), length)) {
+            return QByteArray();
+        }
+        return QByteArray(reinterpret_cast<const char*>(buffer_ + target + sizeof(quint32)), static_cast<int>(length));
+    }
+
+    // Вектор элементов размера elementSize: указатель на первый элемент и их число
+    bool vector(int id, int elementSize, const uchar *&elements, quint32 &count) const
+    {
+        const qint64 target = dereference(fieldPosition(id));
+        if (target < 0 || !inBounds(target, sizeof(quint32))) {
+            return false;
+        }
+        count = qFromLittleEndian<quint32>(buffer_ + target);
+        if (!inBounds(target + sizeof(quint32), static_cast<qint64>(count) * elementSize)) {
+            return false;
+        }
+        elements = buffer_ + target + sizeof(quint32);
+        return true;
+    }
+
+    // Элемент вектора таблиц
+    FlatTable vectorTable(const uchar *elements, int index) const
+    {
+        const qint64 target = dereference(elements - buffer_ + static_cast<qint64>(sizeof(quint32)) * index);
+        return target < 0 ? FlatTable() : FlatTable(buffer_, size_, target);
+    }
+
+private:
+    bool inBounds(qint64 position, qint64 length) const
+    {
+        return position >= 0 && length >= 0 && position <= size_ && length <= size_ - position;
+    }
+
+    qint64 fieldPosition(int id) const
+    {
+        const int entry = 4 + 2 * id;
+        if (!isValid() || entry + 2 > vtableSize_) {
+            return -1;
+        }
+        const int fieldOffset = qFromLittleEndian<quint16>(buffer_ + vtable_ + entry);
+        return fieldOffset == 0 ? -1 : position_ + fieldOffset;
+    }
+
+    qint64 dereference(qint64 position) const
+    {
+        if (position < 0 || !inBounds(position, sizeof(quint32))) {
+            return -1;
+        }
+        return position + qFromLittleEndian<quint32>(buffer_ + position);
+    }
+
+    const uchar *buffer_ = nullptr;
+    qint64 size_ = 0;
+    qint64 position_ = -1;
+    qint64 vtable_ = 0;
+    int vtableSize_ = 0;
+};
+
+// Константы формата Arrow IPC (Schema.fbs, Message.fbs, File.fbs) и раскладка колонок записи
+struct ArrowIpc
+{
+    static constexpr char MAGIC[6] = {'A', 'R', 'R', 'O', 'W', '1'};
+    static constexpr quint32 CONTINUATION = 0xFFFFFFFF;
+    static constexpr qint16 METADATA_V5 = 4;
+
+    // MessageHeader
+    static constexpr quint8 HEADER_SCHEMA = 1;
+    static constexpr quint8 HEADER_RECORD_BATCH = 3;
+
+    // Type
+    static constexpr quint8 TYPE_NULL = 1;
+    static constexpr quint8 TYPE_INT = 2;
+    static constexpr quint8 TYPE_FLOATING_POINT = 3;
+    static constexpr quint8 TYPE_BINARY = 4;
+    static constexpr quint8 TYPE_UTF8 = 5;
+    static constexpr quint8 TYPE_BOOL = 6;
+    static constexpr quint8 TYPE_DATE = 8;
+    static constexpr quint8 TYPE_TIME = 9;
+    static constexpr quint8 TYPE_TIMESTAMP = 10;
+    static constexpr quint8 TYPE_DURATION = 18;
+
+    static constexpr qint16 PRECISION_SINGLE = 1;
+    static constexpr qint16 PRECISION_DOUBLE = 2;
+    static constexpr qint16 UNIT_NANOSECOND = 3;
+
+    static constexpr int BLOCK_SIZE = 24;
+    static constexpr int FIELD_NODE_SIZE = 16;
+    static constexpr int BUFFER_SIZE = 16;
+
+    static constexpr const char *TIMESTAMP_NAME = "timestamp";
+
+    static qint64 align8(qint64 size)
+    {
+        return (size + 7) & ~static_cast<qint64>(7);
+    }
+
+    // Заголовок сообщения: маркер продолжения, длина метаданных, затем сами метаданные
+    static QByteArray message(const FlatBuilder::NodePtr &header, quint8 headerType, qint64 bodyLength)
+    {
+        FlatBuilder::NodePtr message = FlatBuilder::table();
+        FlatBuilder::scalar(message, 0, sizeof(qint16), METADATA_V5);
+        FlatBuilder::scalar(message, 1, sizeof(quint8), headerType);
+        FlatBuilder::offset(message, 2, header);
+        FlatBuilder::scalar(message, 3, sizeof(qint64), static_cast<quint64>(bodyLength));
+        return FlatBuilder::finish(message);
+    }
+};
+
+// Запись в формате Arrow IPC File (Feather v2): схема, по record batch на пакет, футер.
+// Время пишется как timestamp[ns, UTC] (int64), окружающая среда как float32, остальные каналы как int16.
+// Файл читается pyarrow.ipc.open_file, pandas.read_feather и polars.read_ipc без преобразований.
+class ArrowIpcWriter
+{
+    // Колонки пакета копируются в тело сообщения как есть, а схема объявляет little-endian
+    static_assert(Q_BYTE_ORDER == Q_LITTLE_ENDIAN, "Arrow export assumes a little-endian host");
+
+public:
+    ArrowIpcWriter(const QString &filePath, int channels)
+        : file_(filePath), channels_(channels)
+    {
+        if (!file_.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qDebug() << "Failed to open file for writing:" << filePath;
+            throw std::runtime_error("Failed to open file for writing.");
+        }
+
+        char header[8] = {};
+        std::memcpy(header, ArrowIpc::MAGIC, sizeof(ArrowIpc::MAGIC));
+        file_.write(header, sizeof(header));
+        writeMessage(ArrowIpc::message(schema(), ArrowIpc::HEADER_SCHEMA, 0), QByteArray(), nullptr);
+    }
+
+    ~ArrowIpcWriter()
+    {
+        close();
+    }
+
+    int channels() const
+    {
+        return channels_;
+    }
+
+    // Пишет пакет отдельным record batch; колонки вне маски каналов пропускаются
+    bool writeBatch(const SensorDataBatch &batch)
+    {
+        if (!file_.isOpen()) {
+            return false;
+        }
+        if (!batch.hasChannels(channels_)) {
+            qDebug() << "Batch does not contain the exported channels";
+            return false;
+        }
+        if (batch.isEmpty()) {
+            return true;
+        }
+
+        const qint64 rows = batch.size();
+        QByteArray body;
+        QByteArray nodes;
+        QByteArray buffers;
+        int columnCount = 0;
+
+        auto appendColumn = [&](const auto &column) {
+            using Value = typename std::decay_t<decltype(column)>::value_type;
+            const qint64 length = rows * static_cast<qint64>(sizeof(Value));
+            appendStruct(nodes, rows, 0);
+            // Битовая маска валидности не нужна: пропусков в записи нет
+            appendStruct(buffers, body.size(), 0);
+            appendStruct(buffers, body.size(), length);
+            body.append(reinterpret_cast<const char*>(column.constData()), static_cast<int>(length));
+            body.append(QByteArray(static_cast<int>(ArrowIpc::align8(length) - length), '\0'));
+            ++columnCount;
+        };
+
+        appendColumn(batch.timestamps);
+        ChannelSchema::forEachChannel([&](auto channel) {
+            constexpr int index = decltype(channel)::value;
+            if (channels_ & ChannelSchema::GROUPS[ChannelSchema::CHANNELS[index].group].mask) {
+                appendColumn(batch.column<index>());
+            }
+        });
+
+        FlatBuilder::NodePtr recordBatch = FlatBuilder::table();
+        FlatBuilder::scalar(recordBatch, 0, sizeof(qint64), static_cast<quint64>(rows));
+        FlatBuilder::offset(recordBatch, 1, FlatBuilder::structVector(nodes, columnCount));
+        FlatBuilder::offset(recordBatch, 2, FlatBuilder::structVector(buffers, 2 * columnCount));
+
+        Block block;
+        if (!writeMessage(ArrowIpc::message(recordBatch, ArrowIpc::HEADER_RECORD_BATCH, body.size()), body, &block)) {
+            return false;
+        }
+        blocks_.append(block);
+        return true;
+    }
+
+    // Дописывает футер со списком record batch; без него файл не читается как Arrow File
+    bool close()
+    {
+        if (!file_.isOpen()) {
+            return true;
+        }
+
+        QByteArray endOfStream(8, '\0');
+        qToLittleEndian<quint32>(ArrowIpc::CONTINUATION, endOfStream.data());
+        file_.write(endOfStream);
+
+        QByteArray blocks;
+        for (const Block &block : blocks_) {
+            appendBlock(blocks, block);
+        }
+
+        FlatBuilder::NodePtr footer = FlatBuilder::table();
+        FlatBuilder::scalar(footer, 0, sizeof(qint16), ArrowIpc::METADATA_V5);
+        FlatBuilder::offset(footer, 1, schema());
+        FlatBuilder::offset(footer, 2, FlatBuilder::structVector(QByteArray(), 0));
+        FlatBuilder::offset(footer, 3, FlatBuilder::structVector(blocks, blocks_.size()));
+        const QByteArray footerBytes = FlatBuilder::finish(footer);
+
+        char footerSize[4];
+        qToLittleEndian<qint32>(footerBytes.size(), footerSize);
+        file_.write(footerBytes);
+        file_.write(footerSize, sizeof(footerSize));
+        const bool ok = file_.write(ArrowIpc::MAGIC, sizeof(ArrowIpc::MAGIC)) == sizeof(ArrowIpc::MAGIC)
+                        && file_.flush();
+        file_.close();
+        if (!ok) {
+            qDebug() << "Failed to write Arrow footer:" << file_.errorString();
+        }
+        return ok;
+    }
+
+private:
+    struct Block {
+        qint64 offset = 0;
+        qint32 metadataLength = 0;
+        qint64 bodyLength = 0;
+    };
+
+    // Структура из двух полей int64 (FieldNode, Buffer) или начало Block
+    static void appendStruct(QByteArray &out, qint64 first, qint64 second)
+    {
+        char raw[16];
+        qToLittleEndian<qint64>(first, raw);
+        qToLittleEndian<qint64>(second, raw + 8);
+        out.append(raw, sizeof(raw));
+    }
+
+    static void appendBlock(QByteArray &out, const Block &block)
+    {
+        char raw[ArrowIpc::BLOCK_SIZE] = {};
+        qToLittleEndian<qint64>(block.offset, raw);
+        qToLittleEndian<qint32>(block.metadataLength, raw + 8);
+        qToLittleEndian<qint64>(block.bodyLength, raw + 16);
+        out.append(raw, sizeof(raw));
+    }
+
+    bool writeMessage(const QByteArray &metadata, const QByteArray &body, Block *block)
+    {
+        char prefix[8];
+        qToLittleEndian<quint32>(ArrowIpc::CONTINUATION, prefix);
+        qToLittleEndian<qint32>(metadata.size(), prefix + 4);
+
+        const qint64 offset = file_.pos();
+        if (file_.write(prefix, sizeof(prefix)) != sizeof(prefix)
+            || file_.write(metadata) != metadata.size()
+            || file_.write(body) != body.size()) {
+            qDebug() << "Failed to write Arrow message:" << file_.errorString();
+            return false;
+        }
+
+        if (block) {
+            block->offset = offset;
+            block->metadataLength = static_cast<qint32>(sizeof(prefix) + metadata.size());
+            block->bodyLength = body.size();
+        }
+        return true;
+    }
+
+    FlatBuilder::NodePtr schema() const
+    {
+        std::vector<FlatBuilder::NodePtr> fields;
+
+        FlatBuilder::NodePtr timestampType = FlatBuilder::table();
+        FlatBuilder::scalar(timestampType, 0, sizeof(qint16), ArrowIpc::UNIT_NANOSECOND);
+        FlatBuilder::offset(timestampType, 1, FlatBuilder::string("UTC"));
+        fields.push_back(field(ArrowIpc::TIMESTAMP_NAME, ArrowIpc::TYPE_TIMESTAMP, timestampType));
+
+        for (const ChannelSchema::Channel &channel : ChannelSchema::CHANNELS) {
+            if (!(channels_ & ChannelSchema::GROUPS[channel.group].mask)) {
+                continue;
+            }
+            const QByteArray name(channel.name);
+            FlatBuilder::NodePtr type = FlatBuilder::table();
+            if (channel.wire == ChannelSchema::WireType::Float32) {
+                FlatBuilder::scalar(type, 0, sizeof(qint16), ArrowIpc::PRECISION_SINGLE);
+                fields.push_back(field(name, ArrowIpc::TYPE_FLOATING_POINT, type));
+            } else {
+                FlatBuilder::scalar(type, 0, sizeof(qint32), ChannelSchema::wireSize(channel.wire) * 8);
+                FlatBuilder::scalar(type, 1, sizeof(quint8), 1);
+                fields.push_back(field(name, ArrowIpc::TYPE_INT, type));
+            }
+        }
+
+        FlatBuilder::NodePtr schema = FlatBuilder::table();
+        FlatBuilder::scalar(schema, 0, sizeof(qint16), 0); // little-endian
+        FlatBuilder::offset(schema, 1, FlatBuilder::tableVector(fields));
+        return schema;
+    }
+
+    static FlatBuilder::NodePtr field(const QByteArray &name, quint8 typeType, const FlatBuilder::NodePtr &type)
+    {
+        FlatBuilder::NodePtr field = FlatBuilder::table();
+        FlatBuilder::offset(field, 0, FlatBuilder::string(name));
+        FlatBuilder::scalar(field, 1, sizeof(quint8), 0);
+        FlatBuilder::scalar(field, 2, sizeof(quint8), typeType);
+        FlatBuilder::offset(field, 3, type);
+        FlatBuilder::offset(field, 5, FlatBuilder::tableVector({}));
+        return field;
+    }
+
+    QFile file_;
+    int channels_;
+    QVector<Block> blocks_;
+};
+
+// Чтение файла Arrow IPC: файл отображается в память, record batch копируются
+// в колонки пакета без разбора текста. Колонки ищутся по имени; поддерживаются
+// плоские схемы с целыми, float32/float64 и timestamp колонками, без сжатия.
+class ArrowIpcReader
+{
+public:
+    explicit ArrowIpcReader(const QString &filePath)
+        : file_(filePath)
+    {
+        if (!file_.open(QIODevice::ReadOnly)) {
+            qDebug() << "Failed to open file for reading:" << filePath;
+            return;
+        }
+
+        size_ = file_.size();
+        data_ = file_.map(0, size_);
+        if (data_ == nullptr) {
+            // Отображение недоступно (например, файл на сетевом диске)
+            content_ = file_.readAll();
+            data_ = reinterpret_cast<const uchar*>(content_.constData());
+        }
+
+        valid_ = parseFooter();
+        if (!valid_) {
+            qDebug() << "Invalid Arrow IPC file:" << filePath;
+        }
+    }
+
+    bool isValid() const
+    {
+        return valid_;
+    }
+
+    int channels() const
+    {
+        return channels_;
+    }
+
+    int recordBatchCount() const
+    {
+        return blocks_.size();
+    }
+
+    bool readRecordBatch(int index, SensorDataBatch &batch) const
+    {
+        batch.clear();
+        batch.channels = channels_;
+        if (!valid_ || index < 0 || index >= blocks_.size()) {
+            return false;
+        }
+
+        const Block &block = blocks_[index];
+        if (!inBounds(block.offset, block.metadataLength) || block.metadataLength < 8) {
+            return false;
+        }
+
+        // Файлы до версии 0.15 писались без маркера продолжения
+        qint64 metadataStart = block.offset + 4;
+        qint64 metadataSize = qFromLittleEndian<qint32>(data_ + block.offset);
+        if (qFromLittleEndian<quint32>(data_ + block.offset) == ArrowIpc::CONTINUATION) {
+            metadataStart += 4;
+            metadataSize = qFromLittleEndian<qint32>(data_ + block.offset + 4);
+        }
+        if (!inBounds(metadataStart, metadataSize)) {
+            return false;
+        }
+
+        const FlatTable message = FlatTable::root(data_ + metadataStart, metadataSize);
+        if (message.scalar<quint8>(1) != ArrowIpc::HEADER_RECORD_BATCH) {
+            return false;
+        }
+        const FlatTable recordBatch = message.table(2);
+        if (!recordBatch.isValid()) {
+            return false;
+        }
+        if (recordBatch.table(3).isValid()) {
+            qDebug() << "Compressed Arrow record batches are not supported";
+            return false;
+        }
+
+        const qint64 rows = recordBatch.scalar<qint64>(0);
+        const uchar *buffers = nullptr;
+        quint32 bufferCount = 0;
+        if (rows < 0 || rows > std::numeric_limits<int>::max()
+            || !recordBatch.vector(2, ArrowIpc::BUFFER_SIZE, buffers, bufferCount)
+            || static_cast<int>(bufferCount) < bufferTotal_) {
+            return false;
+        }
+
+        const qint64 bodyStart = block.offset + block.metadataLength;
+        const qint64 bodyLength = std::min(block.bodyLength, message.scalar<qint64>(3, block.bodyLength));
+        if (!inBounds(bodyStart, bodyLength)) {
+            return false;
+        }
+
+        for (const Column &column : columns_) {
+            const uchar *buffer = buffers + ArrowIpc::BUFFER_SIZE * column.dataBuffer;
+            const qint64 offset = qFromLittleEndian<qint64>(buffer);
+            const qint64 length = qFromLittleEndian<qint64>(buffer + 8);
+            if (offset < 0 || length < rows * column.bitWidth / 8 || offset > bodyLength || length > bodyLength - offset) {
+                qDebug() << "Arrow buffer out of bounds in record batch" << index;
+                return false;
+            }
+
+            // Битовые маски валидности не читаются: на месте пропусков остаются значения из буфера
+            const uchar *values = data_ + bodyStart + offset;
+            const int count = static_cast<int>(rows);
+            if (column.channel < 0) {
+                batch.timestamps.resize(count);
+                convertColumn(values, column, count, batch.timestamps.data());
+                if (column.nanosPerUnit != 1) {
+                    for (qint64 &timestamp : batch.timestamps) {
+                        timestamp *= column.nanosPerUnit;
+                    }
+                }
+                continue;
+            }
+
+            // Номер канала известен только во время выполнения: колонка выбирается среди всех каналов
+            ChannelSchema::forEachChannel([&](auto channel) {
+                constexpr int channelIndex = decltype(channel)::value;
+                if (channelIndex != column.channel || !batch.hasChannel<channelIndex>()) {
+                    return;
+                }
+                auto &target = batch.column<channelIndex>();
+                target.resize(count);
+                convertColumn(values, column, count, target.data());
+            });
+        }
+        return true;
+    }
+
+private:
+    struct Block {
+        qint64 offset = 0;
+        qint32 metadataLength = 0;
+        qint64 bodyLength = 0;
+    };
+
+    struct Column {
+        int channel = -1; // -1 - время, иначе индекс в SensorDataBatch::CHANNEL_NAMES
+        int dataBuffer = 0;
+        int bitWidth = 0;
+        bool isFloat = false;
+        bool isSigned = true;
+        qint64 nanosPerUnit = 1;
+    };
+
+    bool inBounds(qint64 position, qint64 length) const
+    {
+        return position >= 0 && length >= 0 && position <= size_ && length <= size_ - position;
+    }
+
+    bool parseFooter()
+    {
+        const qint64 trailerSize = sizeof(qint32) + sizeof(ArrowIpc::MAGIC);
+        if (data_ == nullptr || size_ < 8 + trailerSize
+            || std::memcmp(data_, ArrowIpc::MAGIC, sizeof(ArrowIpc::MAGIC)) != 0
+            || std::memcmp(data_ + size_ - sizeof(ArrowIpc::MAGIC), ArrowIpc::MAGIC, sizeof(ArrowIpc::MAGIC)) != 0) {
+            return false;
+        }
+
+        const qint64 footerSize = qFromLittleEndian<qint32>(data_ + size_ - trailerSize);
+        const qint64 footerStart = size_ - trailerSize - footerSize;
+        if (footerSize <= 0 || footerStart < 8) {
+            return false;
+        }
+
+        const FlatTable footer = FlatTable::root(data_ + footerStart, footerSize);
+        if (!footer.isValid() || !parseSchema(footer.table(1))) {
+            return false;
+        }
+
+        const uchar *blocks = nullptr;
+        quint32 blockCount = 0;
+        if (!footer.vector(3, ArrowIpc::BLOCK_SIZE, blocks, blockCount)) {
+            return false;
+        }
+        for (quint32 i = 0; i < blockCount; ++i) {
+            const uchar *raw = blocks + ArrowIpc::BLOCK_SIZE * i;
+            Block block;
+            block.offset = qFromLittleEndian<qint64>(raw);
+            block.metadataLength = qFromLittleEndian<qint32>(raw + 8);
+            block.bodyLength = qFromLittleEndian<qint64>(raw + 16);
+            blocks_.append(block);
+        }
+        return true;
+    }
+
+    bool parseSchema(const FlatTable &schema)
+    {
+        const uchar *fields = nullptr;
+        quint32 fieldCount = 0;
+        if (!schema.isValid() || schema.scalar<qint16>(0) != 0
+            || !schema.vector(1, sizeof(quint32), fields, fieldCount)) {
+            return false;
+        }
+
+        int bufferIndex = 0;
+        bool hasTimestamp = false;
+        bool found[ChannelSchema::CHANNEL_COUNT] = {};
+        for (quint32 i = 0; i < fieldCount; ++i) {
+            const FlatTable field = schema.vectorTable(fields, static_cast<int>(i));
+            const uchar *children = nullptr;
+            quint32 childCount = 0;
+            if (!field.isValid() || (field.vector(5, sizeof(quint32), children, childCount) && childCount > 0)) {
+                qDebug() << "Nested Arrow columns are not supported";
+                return false;
+            }
+
+            const QString name = QString::fromUtf8(field.string(0));
+            const quint8 typeType = field.scalar<quint8>(2);
+            const FlatTable type = field.table(3);
+
+            Column column;
+            column.dataBuffer = bufferIndex + 1;
+            bool usable = false;
+            switch (typeType) {
+            case ArrowIpc::TYPE_INT:
+                column.bitWidth = type.scalar<qint32>(0);
+                column.isSigned = type.scalar<quint8>(1) != 0;
+                usable = column.bitWidth == 8 || column.bitWidth == 16 || column.bitWidth == 32 || column.bitWidth == 64;
+                bufferIndex += 2;
+                break;
+            case ArrowIpc::TYPE_FLOATING_POINT: {
+                const qint16 precision = type.scalar<qint16>(0);
+                column.isFloat = true;
+                column.bitWidth = precision == ArrowIpc::PRECISION_DOUBLE ? 64 : 32;
+                usable = precision == ArrowIpc::PRECISION_SINGLE || precision == ArrowIpc::PRECISION_DOUBLE;
+                bufferIndex += 2;
+                break;
+            }
+            case ArrowIpc::TYPE_TIMESTAMP: {
+                static const qint64 nanosPerUnit[] = {1000000000, 1000000, 1000, 1};
+                const qint16 unit = type.scalar<qint16>(0);
+                column.bitWidth = 64;
+                column.nanosPerUnit = nanosPerUnit[qBound<qint16>(0, unit, ArrowIpc::UNIT_NANOSECOND)];
+                usable = true;
+                bufferIndex += 2;
+                break;
+            }
+            case ArrowIpc::TYPE_BOOL:
+            case ArrowIpc::TYPE_DATE:
+            case ArrowIpc::TYPE_TIME:
+            case ArrowIpc::TYPE_DURATION:
+                bufferIndex += 2;
+                break;
+            case ArrowIpc::TYPE_BINARY:
+            case ArrowIpc::TYPE_UTF8:
+                bufferIndex += 3;
+                break;
+            case ArrowIpc::TYPE_NULL:
+                break;
+            default:
+                qDebug() << "Unsupported Arrow column type" << typeType << "in column" << name;
+                return false;
+            }
+
+            if (!usable) {
+                continue;
+            }
+            if (name == ArrowIpc::TIMESTAMP_NAME && column.bitWidth == 64 && !column.isFloat) {
+                hasTimestamp = true;
+                column.channel = -1;
+                columns_.append(column);
+                continue;
+            }
+            const int channel = SensorDataBatch::CHANNEL_NAMES.indexOf(name);
+            if (channel >= 0) {
+                found[channel] = true;
+                column.channel = channel;
+                columns_.append(column);
+            }
+        }
+
+        bufferTotal_ = bufferIndex;
+        // Группа читается, только если в файле есть все ее каналы
+        channels_ = SensorDataBatch::ALL;
+        for (int channel = 0; channel < ChannelSchema::CHANNEL_COUNT; ++channel) {
+            if (!found[channel]) {
+                channels_ &= ~ChannelSchema::GROUPS[ChannelSchema::CHANNELS[channel].group].mask;
+            }
+        }
+        return hasTimestamp;
+    }
+
+    template<typename Target>
+    static void convertColumn(const uchar *values, const Column &column, int rows, Target *target)
+    {
+        if (column.isFloat) {
+            if (column.bitWidth == 32) {
+                castValues<float>(values, rows, target);
+            } else {
+                castValues<double>(values, rows, target);
+            }
+            return;
+        }
+        switch (column.bitWidth) {
+        case 8:
+            column.isSigned ? castValues<qint8>(values, rows, target) : castValues<quint8>(values, rows, target);
+            break;
+        case 16:
+            column.isSigned ? castValues<qint16>(values, rows, target) : castValues<quint16>(values, rows, target);
+            break;
+        case 32:
+            column.isSigned ? castValues<qint32>(values, rows, target) : castValues<quint32>(values, rows, target);
+            break;
+        default:
+            column.isSigned ? castValues<qint64>(values, rows, target) : castValues<quint64>(values, rows, target);
+            break;
+        }
+    }
+
+    // Совпадающий тип копируется целиком, иначе значения приводятся по одному
+    template<typename Source, typename Target>
+    static void castValues(const uchar *values, int rows, Target *target)
+    {
+        if (std::is_same<Source, Target>::value) {
+            std::memcpy(target, values, static_cast<size_t>(rows) * sizeof(Target));
+            return;
+        }
+        for (int i = 0; i < rows; ++i) {
+            Source value;
+            std::memcpy(&value, values + static_cast<size_t>(i) * sizeof(Source), sizeof(Source));
+            target[i] = static_cast<Target>(value);
+        }
+    }
+
+    QFile file_;
+    QByteArray content_;
+    const uchar *data_ = nullptr;
+    qint64 size_ = 0;
+    bool valid_ = false;
+    int channels_ = 0;
+    int bufferTotal_ = 0;
+    QVector<Column> columns_;
+    QVector<Block> blocks_;
+};
+
+#endif // ARROWIPC_H
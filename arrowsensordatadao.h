@@ -0,0 +1,90 @@
+#ifndef ARROWSENSORDATADAO_H
+#define ARROWSENSORDATADAO_H
+
+#include "isensordatadao.h"
+#include "arrowipc.h"
+#include <QDebug>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+// Чтение записей, экспортированных в Arrow IPC (*.arrow, *.feather).
+// Файл только читается: экспорт выполняет ExportJob через ArrowIpcWriter.
+class ArrowSensorDataDAO : public ISensorDataDAO {
+public:
+    explicit ArrowSensorDataDAO(const QString &filePath)
+        : filePath(filePath), reader(filePath) {
+        if (!reader.isValid()) {
+            qDebug() << "Failed to open Arrow file:" << filePath;
+            throw std::runtime_error("Failed to open Arrow file.");
+        }
+    }
+
+    bool insertSensorData(const TimestampedSensorData &data) override {
+        Q_UNUSED(data);
+        qDebug() << "Arrow files are opened read-only:" << filePath;
+        return false;
+    }
+
+    std::unique_ptr<ISensorDataCursor> selectSensorDataCursor(const QDateTime &start, const QDateTime &end,
+                                                              int batchSize = DEFAULT_BATCH_SIZE) override {
+        return openCursor(SensorDataBatch::toNanos(start), SensorDataBatch::toNanos(end), batchSize);
+    }
+
+    std::unique_ptr<ISensorDataCursor> selectAllSensorDataCursor(int batchSize = DEFAULT_BATCH_SIZE) override {
+        return openCursor(std::numeric_limits<qint64>::min(), std::numeric_limits<qint64>::max(), batchSize);
+    }
+
+    std::unique_ptr<ISensorDataCursor> openCursor(qint64 startNs, qint64 endNs, int batchSize = DEFAULT_BATCH_SIZE) {
+        return std::unique_ptr<ISensorDataCursor>(new Cursor(reader, startNs, endNs, batchSize));
+    }
+
+private:
+    // Record batch файла читаются по одному и нарезаются на пакеты batchSize строк
+    class Cursor : public ISensorDataCursor {
+    public:
+        Cursor(const ArrowIpcReader &reader, qint64 startNs, qint64 endNs, int batchSize)
+            : reader_(reader), startNs_(startNs), endNs_(endNs),
+              batchSize_(batchSize > 0 ? batchSize : DEFAULT_BATCH_SIZE) {}
+
+        bool next(SensorDataBatch &batch) override {
+            batch.clear();
+            batch.channels = reader_.channels();
+            batch.reserve(batchSize_);
+
+            while (batch.size() < batchSize_) {
+                if (position_ >= recordBatch_.size()) {
+                    position_ = 0;
+                    if (nextRecordBatch_ >= reader_.recordBatchCount()
+                        || !reader_.readRecordBatch(nextRecordBatch_++, recordBatch_)) {
+                        break;
+                    }
+                }
+
+                for (; position_ < recordBatch_.size() && batch.size() < batchSize_; ++position_) {
+                    const qint64 timestamp = recordBatch_.timestamps[position_];
+                    if (timestamp < startNs_ || timestamp > endNs_) {
+                        continue;
+                    }
+                    batch.appendRow(recordBatch_, position_);
+                }
+            }
+
+            return !batch.isEmpty();
+        }
+
+    private:
+        const ArrowIpcReader &reader_;
+        qint64 startNs_;
+        qint64 endNs_;
+        int batchSize_;
+        SensorDataBatch recordBatch_;
+        int nextRecordBatch_ = 0;
+        int position_ = 0;
+    };
+
+    QString filePath;
+    ArrowIpcReader reader;
+};
+
+#endif // ARROWSENSORDATADAO_H
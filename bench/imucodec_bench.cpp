@@ -0,0 +1,199 @@
+// Степень сжатия и скорость ImuCodec на записи.
+// Использование: imucodec_bench [запись.csv|.insr|.db] [повторов=20]
+// Без аргументов используется синтетическая запись на 1 000 000 строк.
+
+#include "csvsensordatadao.h"
+#include "binarysensordatadao.h"
+#include "SensorDataDAO.h"
+#include "imucodec.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+
+#include <cmath>
+#include <memory>
+
+static std::unique_ptr<ISensorDataDAO> openCapture(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == "db") {
+        return std::unique_ptr<ISensorDataDAO>(new SensorDataDAO(path));
+    }
+    if (suffix == "insr") {
+        return std::unique_ptr<ISensorDataDAO>(new BinarySensorDataDAO(path, BinarySensorDataDAO::ReadOnly()));
+    }
+    return std::unique_ptr<ISensorDataDAO>(new CsvSensorDataDAO(path));
+}
+
+static SensorDataBatch loadCapture(const QString &path)
+{
+    SensorDataBatch all;
+    std::unique_ptr<ISensorDataDAO> dao = openCapture(path);
+    std::unique_ptr<ISensorDataCursor> cursor = dao->selectAllSensorDataCursor();
+    SensorDataBatch batch;
+    while (cursor && cursor->next(batch)) {
+        all.channels = batch.channels;
+        for (int i = 0; i < batch.size(); ++i) {
+            all.append(batch.row(i));
+        }
+    }
+    return all;
+}
+
+static SensorDataBatch syntheticCapture(int rows)
+{
+    SensorDataBatch all;
+    all.reserve(rows);
+    const qint64 start = QDateTime::currentMSecsSinceEpoch() * SensorDataBatch::NANOS_IN_MSEC;
+    for (int i = 0; i < rows; ++i) {
+        const double phase = i * 0.01;
+        // 1 кГц с дрожанием времени прихода до 50 мкс
+        all.timestamps.append(start + i * 1000000LL + (i * 7919 % 50) * 1000);
+        all.env[0].append(static_cast<float>(22.0 + 0.01 * std::round(50 * std::sin(phase * 0.001))));
+        all.env[1].append(static_cast<float>(40.0 + 0.01 * std::round(100 * std::cos(phase * 0.002))));
+        all.env[2].append(static_cast<float>(101.3 + 0.001 * (i % 3)));
+        for (int axis = 0; axis < 3; ++axis) {
+            const int noise = (i * (axis + 3) * 2654435761u >> 28) % 5 - 2;
+            all.gyro[axis].append(static_cast<int16_t>(120 * std::sin(phase + axis) + noise));
+            all.accelero[axis].append(static_cast<int16_t>(1000 * std::cos(phase * 0.3 + axis) + noise));
+            all.magneto[axis].append(static_cast<int16_t>(300 + 20 * std::sin(phase * 0.05 + axis) + noise));
+        }
+    }
+    return all;
+}
+
+template<typename T, typename Encode, typename Decode>
+static void benchColumn(QTextStream &out, const QString &name, const QVector<T> &column,
+                        int repeats, Encode encode, Decode decode)
+{
+    const double rawBytes = static_cast<double>(column.size()) * sizeof(T);
+
+    QByteArray encoded;
+    QElapsedTimer timer;
+    timer.start();
+    for (int r = 0; r < repeats; ++r) {
+        encoded.clear();
+        for (int start = 0; start < column.size(); start += BinarySensorDataDAO::DEFAULT_CHUNK_ROWS) {
+            const int n = qMin(BinarySensorDataDAO::DEFAULT_CHUNK_ROWS, column.size() - start);
+            encode(column.constData() + start, n, encoded);
+        }
+    }
+    const double encodeSeconds = timer.nsecsElapsed() / 1e9 / repeats;
+
+    // Кодирование поблочное, поэтому и декодирование идет по тем же блокам
+    QByteArray perChunk;
+    QVector<QByteArray> chunks;
+    for (int start = 0; start < column.size(); start += BinarySensorDataDAO::DEFAULT_CHUNK_ROWS) {
+        perChunk.clear();
+        encode(column.constData() + start, qMin(BinarySensorDataDAO::DEFAULT_CHUNK_ROWS, column.size() - start), perChunk);
+        chunks.append(perChunk);
+    }
+
+    QVector<T> decoded(column.size());
+    bool ok = true;
+    timer.restart();
+    for (int r = 0; r < repeats; ++r) {
+        int start = 0;
+        for (const QByteArray &chunk : chunks) {
+            const int n = qMin(BinarySensorDataDAO::DEFAULT_CHUNK_ROWS, column.size() - start);
+            ok &= decode(chunk.constData(), chunk.size(), n, decoded.data() + start);
+            start += n;
+        }
+    }
+    const double decodeSeconds = timer.nsecsElapsed() / 1e9 / repeats;
+    ok &= std::memcmp(decoded.constData(), column.constData(), rawBytes) == 0;
+
+    out << qSetFieldWidth(12) << name << qSetFieldWidth(0)
+        << " ratio " << QString::number(rawBytes / qMax(1, encoded.size()), 'f', 2)
+        << "  encode " << QString::number(rawBytes / encodeSeconds / 1e9, 'f', 2) << " GB/s"
+        << "  decode " << QString::number(rawBytes / decodeSeconds / 1e9, 'f', 2) << " GB/s"
+        << (ok ? "" : "  ROUNDTRIP MISMATCH") << "\n";
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const QString capturePath = argc > 1 ? QString(argv[1]) : QString();
+    const int repeats = argc > 2 ? QString(argv[2]).toInt() : 20;
+
+    SensorDataBatch capture = capturePath.isEmpty() ? syntheticCapture(1000000) : loadCapture(capturePath);
+    out << "capture: " << (capturePath.isEmpty() ? QString("synthetic") : capturePath)
+        << ", rows: " << capture.size() << "\n";
+    if (capture.isEmpty()) {
+        return 1;
+    }
+
+    const QStringList axes = {"x", "y", "z"};
+    const QStringList envNames = {"temperature", "humidity", "pressure"};
+
+    benchColumn(out, "timestamp", capture.timestamps, repeats, ImuCodec::encodeTimestamps, ImuCodec::decodeTimestamps);
+    for (int i = 0; i < 3; ++i) {
+        if (capture.hasChannels(SensorDataBatch::ENV)) {
+            benchColumn(out, envNames[i], capture.env[i], repeats, ImuCodec::encodeFloat, ImuCodec::decodeFloat);
+        }
+    }
+    for (int i = 0; i < 3; ++i) {
+        if (capture.hasChannels(SensorDataBatch::GYRO)) {
+            benchColumn(out, "gyro_" + axes[i], capture.gyro[i], repeats, ImuCodec::encodeInt16, ImuCodec::decodeInt16);
+        }
+        if (capture.hasChannels(SensorDataBatch::ACCELERO)) {
+            benchColumn(out, "accelero_" + axes[i], capture.accelero[i], repeats, ImuCodec::encodeInt16, ImuCodec::decodeInt16);
+        }
+        if (capture.hasChannels(SensorDataBatch::MAGNETO)) {
+            benchColumn(out, "magneto_" + axes[i], capture.magneto[i], repeats, ImuCodec::encodeInt16, ImuCodec::decodeInt16);
+        }
+    }
+
+    // Сравнение полного чтения: несжатые колонки против файла *.insr через курсор
+    const QString rawPath = QDir::temp().filePath("imucodec_bench.raw");
+    const QString insrPath = QDir::temp().filePath("imucodec_bench.insr");
+    QFile::remove(insrPath);
+    {
+        QFile raw(rawPath);
+        raw.open(QIODevice::WriteOnly | QIODevice::Truncate);
+        raw.write(reinterpret_cast<const char*>(capture.timestamps.constData()), capture.size() * sizeof(qint64));
+        for (int i = 0; i < 3; ++i) {
+            raw.write(reinterpret_cast<const char*>(capture.env[i].constData()), capture.env[i].size() * sizeof(float));
+            raw.write(reinterpret_cast<const char*>(capture.gyro[i].constData()), capture.gyro[i].size() * sizeof(int16_t));
+            raw.write(reinterpret_cast<const char*>(capture.accelero[i].constData()), capture.accelero[i].size() * sizeof(int16_t));
+            raw.write(reinterpret_cast<const char*>(capture.magneto[i].constData()), capture.magneto[i].size() * sizeof(int16_t));
+        }
+
+        BinarySensorDataDAO insr(insrPath, capture.channels);
+        for (int i = 0; i < capture.size(); ++i) {
+            insr.insertSensorData(capture.row(i));
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    {
+        QFile raw(rawPath);
+        raw.open(QIODevice::ReadOnly);
+        QByteArray content = raw.readAll();
+        Q_UNUSED(content);
+    }
+    const double rawSeconds = timer.nsecsElapsed() / 1e9;
+
+    timer.restart();
+    qint64 rows = 0;
+    {
+        BinarySensorDataDAO dao(insrPath, BinarySensorDataDAO::ReadOnly());
+        std::unique_ptr<ISensorDataCursor> cursor = dao.selectAllSensorDataCursor();
+        SensorDataBatch batch;
+        while (cursor->next(batch)) {
+            rows += batch.size();
+        }
+    }
+    const double insrSeconds = timer.nsecsElapsed() / 1e9;
+
+    out << "raw file:  " << QFileInfo(rawPath).size() / 1024 << " KiB, read " << rawSeconds * 1000 << " ms\n"
+        << "insr file: " << QFileInfo(insrPath).size() / 1024 << " KiB, read+decode " << insrSeconds * 1000
+        << " ms (" << rows << " rows)\n";
+    return 0;
+}
@@ -0,0 +1,332 @@
+// Микробенчмарки пути приема: буфер, разбор потока на кадры, CommandResponse, SensorData, CRC.
+// Использование: ingest_bench [--capture файл] [--frames N] [--repeats N] [--json результат.json]
+//                             [--bit-error-rate p] [--burst-rate p] [--seed N]
+// Без --capture поток синтетический: кадры SensorData с ошибками битов и вставками мусора,
+// нарезанный на чтения случайной длины. С --capture берутся куски записи сырого потока
+// (.insraw) или кадры, заново собранные из записи (.csv, .insr, .db, .arrow).
+// Результат дублируется в JSON для сравнения между коммитами.
+
+#include "allocationcounter.h"
+#include "inscommandprocessor.h"
+#include "replayengine.h"
+#include "comand/commandresponse.h"
+#include "comand/SensorData.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+struct BenchResult
+{
+    QString name;
+    qint64 bytes = 0;
+    qint64 frames = 0;
+    double seconds = 0;       // медиана по повторам
+    qint64 allocations = 0;   // за один повтор
+};
+
+// Доступ к закрытому разбору InsCommandProcessor: замеряется тот же код, что работает с портом
+class IngestBench
+{
+public:
+    static void prepare(InsCommandProcessor &processor, const InsCommandProcessor::ResponseCallback &callback) {
+        processor.responseCallback_ = callback;
+    }
+
+    static void feed(InsCommandProcessor &processor, const IngestChunk &chunk) {
+        processor.handleDataReceived(chunk.data, chunk.arrivalNs);
+    }
+
+    static bool validateCRC(const InsCommandProcessor &processor, const QByteArray &frame) {
+        return processor.validateCRC(frame.constData(), frame.size() - 1, static_cast<uint8_t>(frame.at(frame.size() - 1)));
+    }
+};
+
+// Разбор печатает отвергнутые кадры через qDebug; на время замера вывод глушится, но его цена остается
+static void silentMessageHandler(QtMsgType, const QMessageLogContext &, const QString &) {}
+
+static std::vector<IngestChunk> syntheticStream(int frames, double bitErrorRate, double burstRate, quint32 seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    std::uniform_int_distribution<int> byteValue(0, 255);
+    std::uniform_int_distribution<int> burstBytes(1, 32);
+    // Длина чтения как у QSerialPort::read(BUFFER_SIZE / 10) под нагрузкой
+    std::uniform_int_distribution<int> readBytes(1, 2048);
+
+    SensorDataBatch batch;
+    batch.channels = SensorDataBatch::ALL;
+    batch.reserve(1);
+    batch.timestamps.append(0);
+    for (int axis = 0; axis < 3; ++axis) {
+        batch.env[axis].append(0);
+        batch.gyro[axis].append(0);
+        batch.accelero[axis].append(0);
+        batch.magneto[axis].append(0);
+    }
+
+    QByteArray stream;
+    QByteArray frame;
+    for (int i = 0; i < frames; ++i) {
+        const double phase = i * 0.01;
+        for (int axis = 0; axis < 3; ++axis) {
+            batch.env[axis][0] = static_cast<float>(22.0 + axis * 20 + std::sin(phase * 0.01));
+            // В записи угловая скорость уже умножена на масштаб гироскопа из ChannelSchema, кадр получит до ±20000
+            batch.gyro[axis][0] = static_cast<int16_t>(20 * std::sin(phase + axis));
+            batch.accelero[axis][0] = static_cast<int16_t>(1000 * std::cos(phase * 0.3 + axis));
+            batch.magneto[axis][0] = static_cast<int16_t>(300 + 20 * std::sin(phase * 0.05 + axis));
+        }
+        RecordingReplaySource::encodeFrame(batch, 0, static_cast<uint8_t>(i), frame);
+        if (chance(random) < burstRate) {
+            for (int n = burstBytes(random); n > 0; --n) {
+                stream.append(static_cast<char>(byteValue(random)));
+            }
+        }
+        stream.append(frame);
+    }
+    if (bitErrorRate > 0) {
+        for (int i = 0; i < stream.size(); ++i) {
+            if (chance(random) < bitErrorRate) {
+                stream[i] = static_cast<char>(stream[i] ^ (1 << (byteValue(random) % 8)));
+            }
+        }
+    }
+
+    std::vector<IngestChunk> chunks;
+    qint64 arrivalNs = 0;
+    for (int offset = 0; offset < stream.size();) {
+        const int size = std::min(readBytes(random), static_cast<int>(stream.size()) - offset);
+        chunks.push_back({stream.mid(offset, size), arrivalNs});
+        offset += size;
+        arrivalNs += 1000000;
+    }
+    return chunks;
+}
+
+static std::vector<IngestChunk> recordedStream(const QString &path)
+{
+    std::vector<IngestChunk> chunks;
+    std::unique_ptr<ReplaySource> source = ReplayEngine::openSource(path);
+    if (!source) {
+        return chunks;
+    }
+    IngestChunk chunk;
+    while (source->next(chunk)) {
+        chunks.push_back(chunk);
+    }
+    return chunks;
+}
+
+static BenchResult measure(const QString &name, int repeats, qint64 bytes, qint64 frames,
+                           const std::function<void()> &setup, const std::function<void()> &body)
+{
+    BenchResult result;
+    result.name = name;
+    result.bytes = bytes;
+    result.frames = frames;
+
+    std::vector<double> seconds;
+    QElapsedTimer timer;
+    for (int r = 0; r < repeats; ++r) {
+        setup();
+        const qint64 allocationsBefore = AllocationCounter::totalCount();
+        timer.start();
+        body();
+        seconds.push_back(timer.nsecsElapsed() / 1e9);
+        result.allocations = AllocationCounter::totalCount() - allocationsBefore;
+    }
+    std::sort(seconds.begin(), seconds.end());
+    result.seconds = seconds[seconds.size() / 2];
+    return result;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({"capture", "Запись сырого потока или файл записи", "file"});
+    parser.addOption({"frames", "Кадров в синтетическом потоке", "count", "200000"});
+    parser.addOption({"repeats", "Повторов каждого замера", "count", "5"});
+    parser.addOption({"json", "Файл результатов", "file", "ingest_bench.json"});
+    parser.addOption({"bit-error-rate", "Вероятность ошибки бита на байт", "p", "0.00001"});
+    parser.addOption({"burst-rate", "Вероятность вставки мусора перед кадром", "p", "0.0001"});
+    parser.addOption({"seed", "Зерно генератора", "seed", "1"});
+    parser.process(app);
+
+    const QString capturePath = parser.value("capture");
+    const int repeats = std::max(1, parser.value("repeats").toInt());
+    const std::vector<IngestChunk> chunks = capturePath.isEmpty()
+        ? syntheticStream(parser.value("frames").toInt(), parser.value("bit-error-rate").toDouble(),
+                          parser.value("burst-rate").toDouble(), parser.value("seed").toUInt())
+        : recordedStream(capturePath);
+    if (chunks.empty()) {
+        out << "no data\n";
+        return 1;
+    }
+
+    qint64 streamBytes = 0;
+    for (const IngestChunk &chunk : chunks) {
+        streamBytes += chunk.data.size();
+    }
+
+    // Кадры, выделенные разбором, - вход для замеров декодирования
+    std::vector<QByteArray> frames;
+    LinkStats link;
+    {
+        InsCommandProcessor processor;
+        IngestBench::prepare(processor, [&frames](const QByteArray &message, qint64) {
+            frames.push_back(message);
+        });
+        qInstallMessageHandler(silentMessageHandler);
+        for (const IngestChunk &chunk : chunks) {
+            IngestBench::feed(processor, chunk);
+        }
+        qInstallMessageHandler(nullptr);
+        link = processor.getLinkStats();
+    }
+    std::vector<QByteArray> bodies;
+    bodies.reserve(frames.size());
+    for (const QByteArray &frame : frames) {
+        bodies.push_back(frame.mid(3, static_cast<uint8_t>(frame.at(2))));
+    }
+    qint64 frameBytes = 0;
+    for (const QByteArray &frame : frames) {
+        frameBytes += frame.size();
+    }
+    qint64 bodyBytes = 0;
+    for (const QByteArray &body : bodies) {
+        bodyBytes += body.size();
+    }
+    const qint64 frameCount = static_cast<qint64>(frames.size());
+
+    out << "stream: " << (capturePath.isEmpty() ? QString("synthetic") : capturePath)
+        << ", bytes: " << streamBytes << ", reads: " << chunks.size()
+        << ", frames: " << link.frames << ", crc failures: " << link.crcFailures
+        << ", resync bytes: " << link.resyncBytes << "\n";
+
+    std::vector<BenchResult> results;
+    volatile qint64 sink = 0;
+
+    // Буфер тем же порядком вызовов, что в разборе: заголовок, затем кадр целиком в переиспользуемый массив
+    DynamicCircularBuffer buffer(2048 * 10);
+    const int frameSize = frames.empty() ? 35 : frames.front().size();
+    QByteArray frame(frameSize, Qt::Uninitialized);
+    results.push_back(measure("circular_buffer", repeats, streamBytes, streamBytes / frameSize,
+        [&]() { buffer.discard(buffer.size()); },
+        [&]() {
+            for (const IngestChunk &chunk : chunks) {
+                buffer.append(chunk.data);
+                while (buffer.size() >= frameSize) {
+                    sink += static_cast<uint8_t>(buffer.at(2));
+                    buffer.pop(frame.data(), frameSize);
+                    sink += frame.size();
+                }
+            }
+        }));
+
+    std::unique_ptr<InsCommandProcessor> processor;
+    qInstallMessageHandler(silentMessageHandler);
+    results.push_back(measure("framing", repeats, streamBytes, frameCount,
+        [&]() {
+            processor.reset(new InsCommandProcessor());
+            IngestBench::prepare(*processor, [&sink](const QByteArray &message, qint64) { sink += message.size(); });
+        },
+        [&]() {
+            for (const IngestChunk &chunk : chunks) {
+                IngestBench::feed(*processor, chunk);
+            }
+        }));
+
+    results.push_back(measure("command_response", repeats, frameBytes, frameCount, []() {},
+        [&]() {
+            for (const QByteArray &frame : frames) {
+                CommandResponse<SensorData> response(frame);
+                sink += response.getResponseType();
+            }
+        }));
+
+    results.push_back(measure("sensor_data_from_bytes", repeats, bodyBytes, frameCount, []() {},
+        [&]() {
+            SensorData data;
+            for (const QByteArray &body : bodies) {
+                data.fromBytes(body);
+                sink += data.getDataSendCount();
+            }
+        }));
+
+    results.push_back(measure("crc8", repeats, frameBytes, frameCount, []() {},
+        [&]() {
+            for (const QByteArray &frame : frames) {
+                sink += IngestBench::validateCRC(*processor, frame);
+            }
+        }));
+    qInstallMessageHandler(nullptr);
+
+    QJsonArray jsonResults;
+    for (const BenchResult &result : results) {
+        const double seconds = std::max(result.seconds, 1e-9);
+        const double allocationsPerFrame = result.frames > 0 ? static_cast<double>(result.allocations) / result.frames : 0;
+        // Без счетчика выделений ноль ничего не значит
+        const QString allocations = AllocationCounter::isEnabled() ? QString::number(allocationsPerFrame, 'f', 2)
+                                                                   : QString("unsupported");
+        out << result.name.leftJustified(24)
+            << QString::number(result.bytes / seconds / 1e6, 'f', 1) << " MB/s  "
+            << QString::number(result.frames / seconds / 1e6, 'f', 3) << " Mframes/s  "
+            << allocations << " alloc/frame\n";
+
+        QJsonObject json;
+        json["name"] = result.name;
+        json["bytes"] = result.bytes;
+        json["frames"] = result.frames;
+        json["seconds"] = result.seconds;
+        json["bytes_per_s"] = result.bytes / seconds;
+        json["frames_per_s"] = result.frames / seconds;
+        if (AllocationCounter::isEnabled()) {
+            json["allocations_per_frame"] = allocationsPerFrame;
+        }
+        jsonResults.append(json);
+    }
+
+    QJsonObject stream;
+    stream["source"] = capturePath.isEmpty() ? QString("synthetic") : capturePath;
+    stream["bytes"] = streamBytes;
+    stream["reads"] = static_cast<qint64>(chunks.size());
+    stream["frames"] = link.frames;
+    stream["crc_failures"] = link.crcFailures;
+    stream["resync_bytes"] = link.resyncBytes;
+    stream["seed"] = parser.value("seed").toInt();
+
+    QJsonObject report;
+    report["benchmark"] = "ingest_bench";
+    report["host"] = QSysInfo::machineHostName();
+    report["cpu"] = QSysInfo::currentCpuArchitecture();
+    report["qt"] = qVersion();
+    report["repeats"] = repeats;
+    report["stream"] = stream;
+    report["results"] = jsonResults;
+
+    QFile file(parser.value("json"));
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        out << "cannot write " << file.fileName() << "\n";
+        return 1;
+    }
+    file.write(QJsonDocument(report).toJson());
+    out << "results: " << file.fileName() << "\n";
+    return 0;
+}
@@ -0,0 +1,98 @@
+// Замер устойчивой скорости вставки в SQLite-хранилище.
+// Использование: sqlitedao_bench [строк=1000000] [строк_в_транзакции=1000] [файл_базы]
+
+#include "SensorDataDAO.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTextStream>
+
+#include <cmath>
+
+static TimestampedSensorData makeSample(qint64 index, const QDateTime &start)
+{
+    // Плавные сигналы с небольшим шумом, похожие на реальные измерения
+    const double phase = index * 0.01;
+    QList<float> env = {
+        static_cast<float>(22.0 + 0.5 * std::sin(phase * 0.01)),
+        static_cast<float>(40.0 + std::cos(phase * 0.02)),
+        static_cast<float>(101.3 + 0.01 * std::sin(phase))
+    };
+    QList<int16_t> gyro = {
+        static_cast<int16_t>(100 * std::sin(phase)),
+        static_cast<int16_t>(100 * std::cos(phase)),
+        static_cast<int16_t>(index % 7)
+    };
+    QList<int16_t> accelero = {
+        static_cast<int16_t>(1000 * std::sin(phase * 0.5)),
+        static_cast<int16_t>(1000 * std::cos(phase * 0.5)),
+        static_cast<int16_t>(-1000 + index % 5)
+    };
+    QList<int16_t> magneto = {
+        static_cast<int16_t>(300 + index % 3),
+        static_cast<int16_t>(-200 + index % 4),
+        static_cast<int16_t>(450)
+    };
+    return TimestampedSensorData(env, gyro, accelero, magneto, start.addMSecs(index));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const qint64 rows = argc > 1 ? QString(argv[1]).toLongLong() : 1000000;
+    const int commitRows = argc > 2 ? QString(argv[2]).toInt() : SensorDataDAO::DEFAULT_COMMIT_ROWS;
+    const QString databasePath = argc > 3 ? QString(argv[3]) : QDir::temp().filePath("sqlitedao_bench.db");
+
+    QFile::remove(databasePath);
+    QFile::remove(databasePath + "-wal");
+    QFile::remove(databasePath + "-shm");
+
+    const QDateTime start = QDateTime::currentDateTimeUtc();
+    QList<TimestampedSensorData> samples;
+    samples.reserve(1024);
+    for (int i = 0; i < 1024; ++i) {
+        samples.append(makeSample(i, start));
+    }
+
+    double insertSeconds = 0;
+    double selectSeconds = 0;
+    qint64 selectedRows = 0;
+    {
+        SensorDataDAO dao(databasePath, commitRows);
+
+        QElapsedTimer timer;
+        timer.start();
+        for (qint64 i = 0; i < rows; ++i) {
+            TimestampedSensorData &sample = samples[i % samples.size()];
+            sample.setTimestamp(start.addMSecs(i));
+            dao.insertSensorData(sample);
+        }
+        dao.flush();
+        insertSeconds = timer.nsecsElapsed() / 1e9;
+
+        // Выборка середины записи по индексу на timestamp
+        timer.restart();
+        auto cursor = dao.openCursor(SensorDataDAO::toNanos(start.addMSecs(rows / 4)),
+                                     SensorDataDAO::toNanos(start.addMSecs(rows / 2)));
+        SensorDataBatch batch;
+        while (cursor && cursor->next(batch)) {
+            selectedRows += batch.size();
+        }
+        cursor.reset();
+        selectSeconds = timer.nsecsElapsed() / 1e9;
+    }
+
+    out << "rows: " << rows << "\n"
+        << "rows per transaction: " << commitRows << "\n"
+        << "insert: " << insertSeconds << " s, " << qint64(rows / insertSeconds) << " rows/s\n"
+        << "range select: " << selectedRows << " rows in " << selectSeconds << " s, "
+        << qint64(selectedRows / (selectSeconds > 0 ? selectSeconds : 1)) << " rows/s\n"
+        << "file size: " << QFileInfo(databasePath).size() / 1024 << " KiB\n";
+
+    return 0;
+}
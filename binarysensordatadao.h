@@ -0,0 +1,490 @@
+#ifndef BINARYSENSORDATADAO_H
+#define BINARYSENSORDATADAO_H
+
+#include "isensordatadao.h"
+#include "imucodec.h"
+#include "recordingdurability.h"
+#include <QFile>
+#include <QDebug>
+#include <QtEndian>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+// Бинарный формат записи (*.insr).
+// Файл: заголовок FILE_HEADER_SIZE байт (магия "INSR", версия, маска каналов),
+// затем блоки. Блок: заголовок CHUNK_HEADER_SIZE байт (магия, число строк,
+// минимальное и максимальное время, размер и CRC-32 данных) и колонки,
+// каждая с префиксом длины. Колонки сжаты ImuCodec.
+// Заголовок блока позволяет пропускать блоки вне запрошенного диапазона без декодирования.
+class BinarySensorDataDAO : public ISensorDataDAO {
+public:
+    static constexpr char FILE_MAGIC[4] = {'I', 'N', 'S', 'R'};
+    static constexpr quint16 FORMAT_VERSION = 1;
+    static constexpr int FILE_HEADER_SIZE = 16;
+    static constexpr quint32 CHUNK_MAGIC = 0x4B4E4843; // "CHNK"
+    static constexpr int CHUNK_HEADER_SIZE = 32;
+    static constexpr int DEFAULT_CHUNK_ROWS = 4096;
+    // Больше строк в блок не пишется; блок с большим числом строк в заголовке считается поврежденным
+    static constexpr int MAX_CHUNK_ROWS = 1 << 20;
+
+    // Признак открытия только для чтения
+    struct ReadOnly {};
+
+    // Запись: пустой файл получает заголовок, существующий дописывается
+    explicit BinarySensorDataDAO(const QString &filePath,
+                                 int channels = SensorDataBatch::ALL,
+                                 int chunkRows = DEFAULT_CHUNK_ROWS)
+        : filePath(filePath), file(filePath), channels(channels),
+          chunkRows(chunkRows > 0 ? qMin(chunkRows, int(MAX_CHUNK_ROWS)) : DEFAULT_CHUNK_ROWS) {
+        if (!file.open(QIODevice::ReadWrite)) {
+            qDebug() << "Failed to open file for reading and writing:" << filePath;
+            throw std::runtime_error("Failed to open file for reading and writing.");
+        }
+
+        if (file.size() == 0) {
+            writeFileHeader();
+        } else {
+            // Существующий файл дописывается с его собственным набором каналов
+            if (!readFileHeader(file, this->channels)) {
+                qDebug() << "Invalid binary header in file:" << filePath;
+                throw std::runtime_error("Invalid binary header in file.");
+            }
+            file.seek(file.size());
+        }
+
+        pending.channels = this->channels;
+        pending.reserve(this->chunkRows);
+    }
+
+    // Чтение существующего файла: файл не изменяется, вставка отклоняется
+    BinarySensorDataDAO(const QString &filePath, ReadOnly)
+        : filePath(filePath), file(filePath), channels(0), chunkRows(DEFAULT_CHUNK_ROWS) {
+        if (!file.open(QIODevice::ReadOnly)) {
+            qDebug() << "Failed to open file for reading:" << filePath;
+            throw std::runtime_error("Failed to open file for reading.");
+        }
+        if (!readFileHeader(file, channels)) {
+            qDebug() << "Invalid binary header in file:" << filePath;
+            throw std::runtime_error("Invalid binary header in file.");
+        }
+        pending.channels = channels;
+    }
+
+    ~BinarySensorDataDAO() {
+        flush();
+        if (syncer) {
+            syncer->finish(file.handle());
+            syncer.reset();
+        }
+        if (file.isOpen()) {
+            file.close();
+        }
+    }
+
+    // Включает периодический сброс на диск. Неполный блок тоже записывается
+    // по истечении интервала, чтобы потери при сбое не превышали policy.intervalMs.
+    void setDurabilityPolicy(const DurabilityPolicy &policy) override {
+        if (!file.isWritable()) {
+            return;
+        }
+        if (syncer) {
+            syncer->finish(file.handle());
+        }
+        syncer.reset(policy.isEnabled() ? new FileSyncer(policy) : nullptr);
+    }
+
+    // Время последней строки, гарантированно сохраненной на диск
+    qint64 lastDurableTimestamp() const override {
+        return syncer ? syncer->lastDurableTimestamp() : std::numeric_limits<qint64>::min();
+    }
+
+    void syncIfDue() override {
+        if (!syncer || !file.isOpen()) {
+            return;
+        }
+        if (syncer->intervalElapsed()) {
+            flush();
+        }
+        if (syncer->isDue()) {
+            syncer->requestSync(file.handle());
+        }
+    }
+
+    bool insertSensorData(const TimestampedSensorData &data) override {
+        if (!file.isWritable()) {
+            qDebug() << "File is not open for writing:" << filePath;
+            return false;
+        }
+
+        pending.append(data);
+        if (pending.size() >= chunkRows || (syncer && syncer->intervalElapsed())) {
+            return flush();
+        }
+        return true;
+    }
+
+    // Сжимает и дописывает накопленные строки отдельным блоком
+    bool flush() {
+        if (pending.isEmpty() || !file.isOpen()) {
+            return true;
+        }
+
+        const QByteArray chunk = encodeChunk(pending);
+        const qint64 lastTimestamp = pending.timestamps.last();
+        pending.clear();
+
+        file.seek(file.size());
+        if (file.write(chunk) != chunk.size()) {
+            qDebug() << "Failed to write chunk:" << file.errorString();
+            return false;
+        }
+        if (!file.flush()) {
+            return false;
+        }
+
+        if (syncer) {
+            syncer->written(chunk.size(), lastTimestamp);
+            if (syncer->isDue()) {
+                syncer->requestSync(file.handle());
+            }
+        }
+        return true;
+    }
+
+    std::unique_ptr<ISensorDataCursor> selectSensorDataCursor(const QDateTime &start, const QDateTime &end,
+                                                              int batchSize = DEFAULT_BATCH_SIZE) override {
+        return openCursor(SensorDataBatch::toNanos(start), SensorDataBatch::toNanos(end), batchSize);
+    }
+
+    std::unique_ptr<ISensorDataCursor> selectAllSensorDataCursor(int batchSize = DEFAULT_BATCH_SIZE) override {
+        return openCursor(std::numeric_limits<qint64>::min(), std::numeric_limits<qint64>::max(), batchSize);
+    }
+
+    std::unique_ptr<ISensorDataCursor> openCursor(qint64 startNs, qint64 endNs, int batchSize = DEFAULT_BATCH_SIZE) {
+        // Строки из неполного блока иначе не попадут в выборку
+        flush();
+        return std::unique_ptr<ISensorDataCursor>(new Cursor(filePath, startNs, endNs, batchSize));
+    }
+
+    std::unique_ptr<ISensorDataCursor> selectFollowCursor(int batchSize = DEFAULT_BATCH_SIZE) override {
+        flush();
+        return std::unique_ptr<ISensorDataCursor>(new Cursor(filePath, std::numeric_limits<qint64>::min(),
+                                                             std::numeric_limits<qint64>::max(), batchSize, true));
+    }
+
+    // Восстановление после аварийного завершения записи: файл обрезается
+    // по концу последнего целого блока. Блок пишется одним вызовом write,
+    // поэтому поврежденным может оказаться только последний; его CRC проверяется.
+    static RecoveryReport recoverFile(const QString &filePath) {
+        RecoveryReport report;
+        QFile source(filePath);
+        int channels = 0;
+        if (!source.open(QIODevice::ReadWrite) || !readFileHeader(source, channels)) {
+            qDebug() << "Failed to open binary file for recovery:" << filePath;
+            return report;
+        }
+
+        // Заголовки читаются подряд без данных; время до последнего блока
+        // копится отдельно, чтобы отбросить последний блок, если не сойдется его CRC
+        const qint64 size = source.size();
+        qint64 position = FILE_HEADER_SIZE;
+        qint64 lastChunk = -1;
+        ChunkHeader lastHeader;
+        qint64 timestampBeforeLast = std::numeric_limits<qint64>::min();
+        char rawHeader[CHUNK_HEADER_SIZE];
+        while (source.seek(position) && source.read(rawHeader, CHUNK_HEADER_SIZE) == CHUNK_HEADER_SIZE) {
+            ChunkHeader header;
+            if (!parseChunkHeader(rawHeader, header) || header.payloadSize > size - position - CHUNK_HEADER_SIZE) {
+                break;
+            }
+            if (lastChunk >= 0) {
+                timestampBeforeLast = qMax(timestampBeforeLast, lastHeader.maxTimestamp);
+            }
+            lastChunk = position;
+            lastHeader = header;
+            position += CHUNK_HEADER_SIZE + header.payloadSize;
+        }
+
+        report.lastTimestampNs = timestampBeforeLast;
+        if (lastChunk >= 0) {
+            QByteArray payload(static_cast<int>(lastHeader.payloadSize), '\0');
+            source.seek(lastChunk + CHUNK_HEADER_SIZE);
+            if (source.read(payload.data(), payload.size()) == payload.size()
+                && ImuCodec::crc32(payload.constData(), payload.size()) == lastHeader.payloadCrc) {
+                report.lastTimestampNs = qMax(report.lastTimestampNs, lastHeader.maxTimestamp);
+            } else {
+                position = lastChunk;
+            }
+        }
+
+        report.validBytes = position;
+        report.truncatedBytes = size - position;
+        if (report.truncatedBytes > 0) {
+            qDebug() << "Truncating" << report.truncatedBytes << "bytes of torn data in" << filePath;
+            source.resize(position);
+        }
+        return report;
+    }
+
+    static QByteArray encodeChunk(const SensorDataBatch &batch) {
+        QByteArray payload;
+        appendColumn(payload, [&batch](QByteArray &out) {
+            ImuCodec::encodeTimestamps(batch.timestamps.constData(), batch.size(), out);
+        });
+        // Колонки присутствующих каналов идут в порядке ChannelSchema::CHANNELS
+        ChannelSchema::forEachChannel([&](auto channel) {
+            constexpr int index = decltype(channel)::value;
+            if (!batch.hasChannel<index>()) {
+                return;
+            }
+            const auto &column = batch.column<index>();
+            appendColumn(payload, [&column](QByteArray &out) {
+                encodeValues(column.constData(), column.size(), out);
+            });
+        });
+
+        qint64 minTimestamp = std::numeric_limits<qint64>::max();
+        qint64 maxTimestamp = std::numeric_limits<qint64>::min();
+        for (qint64 timestamp : batch.timestamps) {
+            minTimestamp = qMin(minTimestamp, timestamp);
+            maxTimestamp = qMax(maxTimestamp, timestamp);
+        }
+
+        char header[CHUNK_HEADER_SIZE];
+        qToLittleEndian<quint32>(CHUNK_MAGIC, header);
+        qToLittleEndian<quint32>(static_cast<quint32>(batch.size()), header + 4);
+        qToLittleEndian<qint64>(minTimestamp, header + 8);
+        qToLittleEndian<qint64>(maxTimestamp, header + 16);
+        qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), header + 24);
+        qToLittleEndian<quint32>(ImuCodec::crc32(payload.constData(), payload.size()), header + 28);
+
+        QByteArray chunk(header, CHUNK_HEADER_SIZE);
+        chunk.append(payload);
+        return chunk;
+    }
+
+    static bool readFileHeader(QFile &source, int &channels) {
+        char header[FILE_HEADER_SIZE];
+        source.seek(0);
+        if (source.read(header, FILE_HEADER_SIZE) != FILE_HEADER_SIZE
+            || std::memcmp(header, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0
+            || qFromLittleEndian<quint16>(header + 4) != FORMAT_VERSION) {
+            return false;
+        }
+        channels = qFromLittleEndian<quint16>(header + 6);
+        return true;
+    }
+
+private:
+    struct ChunkHeader {
+        quint32 rowCount = 0;
+        qint64 minTimestamp = 0;
+        qint64 maxTimestamp = 0;
+        quint32 payloadSize = 0;
+        quint32 payloadCrc = 0;
+    };
+
+    class Cursor : public ISensorDataCursor {
+    public:
+        Cursor(const QString &filePath, qint64 startNs, qint64 endNs, int batchSize, bool follow = false)
+            : file_(filePath), startNs_(startNs), endNs_(endNs),
+              batchSize_(batchSize > 0 ? batchSize : DEFAULT_BATCH_SIZE), follow_(follow) {
+            if (!file_.open(QIODevice::ReadOnly) || !readFileHeader(file_, channels_)) {
+                qDebug() << "Failed to open binary file for reading:" << filePath;
+                file_.close();
+            }
+            chunk_.channels = channels_;
+        }
+
+        bool next(SensorDataBatch &batch) override {
+            batch.clear();
+            batch.channels = channels_;
+            if (!file_.isOpen()) {
+                return false;
+            }
+            batch.reserve(batchSize_);
+
+            while (batch.size() < batchSize_) {
+                if (position_ >= chunk_.size() && !loadNextChunk()) {
+                    break;
+                }
+
+                for (; position_ < chunk_.size() && batch.size() < batchSize_; ++position_) {
+                    const qint64 timestamp = chunk_.timestamps[position_];
+                    if (timestamp < startNs_ || timestamp > endNs_) {
+                        continue;
+                    }
+                    batch.appendRow(chunk_, position_);
+                }
+            }
+
+            return !batch.isEmpty();
+        }
+
+    private:
+        // Читает следующий блок, пересекающийся с диапазоном; остальные пропускаются по заголовку.
+        // В режиме слежения недописанный блок не считается ошибкой: позиция
+        // возвращается к его началу, и блок читается снова при следующем вызове.
+        bool loadNextChunk() {
+            chunk_.clear();
+            position_ = 0;
+
+            char rawHeader[CHUNK_HEADER_SIZE];
+            while (true) {
+                const qint64 chunkStart = file_.pos();
+                if (file_.read(rawHeader, CHUNK_HEADER_SIZE) != CHUNK_HEADER_SIZE) {
+                    return rewind(chunkStart);
+                }
+
+                ChunkHeader header;
+                if (!parseChunkHeader(rawHeader, header)) {
+                    if (follow_) {
+                        return rewind(chunkStart);
+                    }
+                    qDebug() << "Invalid chunk header at" << chunkStart;
+                    return false;
+                }
+
+                if (header.maxTimestamp < startNs_ || header.minTimestamp > endNs_) {
+                    file_.seek(file_.pos() + header.payloadSize);
+                    continue;
+                }
+
+                payload_.resize(static_cast<int>(header.payloadSize));
+                if (file_.read(payload_.data(), payload_.size()) != payload_.size()) {
+                    return rewind(chunkStart);
+                }
+                if (ImuCodec::crc32(payload_.constData(), payload_.size()) != header.payloadCrc) {
+                    if (follow_) {
+                        return rewind(chunkStart);
+                    }
+                    qDebug() << "Chunk CRC mismatch at" << file_.pos() - payload_.size();
+                    return false;
+                }
+                // Частично заполненный блок оставил бы колонки разной длины
+                if (!decodeChunk(payload_, static_cast<int>(header.rowCount), chunk_)) {
+                    qDebug() << "Failed to decode chunk at" << chunkStart;
+                    chunk_.clear();
+                    return false;
+                }
+                return true;
+            }
+        }
+
+        bool rewind(qint64 chunkStart) {
+            if (follow_) {
+                file_.seek(chunkStart);
+            }
+            return false;
+        }
+
+        QFile file_;
+        qint64 startNs_;
+        qint64 endNs_;
+        int batchSize_;
+        bool follow_;
+        int channels_ = 0;
+        SensorDataBatch chunk_;
+        int position_ = 0;
+        QByteArray payload_;
+    };
+
+    static bool parseChunkHeader(const char *raw, ChunkHeader &header) {
+        if (qFromLittleEndian<quint32>(raw) != CHUNK_MAGIC) {
+            return false;
+        }
+        header.rowCount = qFromLittleEndian<quint32>(raw + 4);
+        header.minTimestamp = qFromLittleEndian<qint64>(raw + 8);
+        header.maxTimestamp = qFromLittleEndian<qint64>(raw + 16);
+        header.payloadSize = qFromLittleEndian<quint32>(raw + 24);
+        header.payloadCrc = qFromLittleEndian<quint32>(raw + 28);
+        // Число строк не покрыто CRC, поэтому проверяется до выделения памяти под колонки
+        return header.rowCount > 0 && header.rowCount <= static_cast<quint32>(MAX_CHUNK_ROWS)
+               && header.payloadSize <= static_cast<quint32>(std::numeric_limits<int>::max());
+    }
+
+    static bool decodeChunk(const QByteArray &payload, int rows, SensorDataBatch &chunk) {
+        const char *p = payload.constData();
+        const char *end = p + payload.size();
+
+        chunk.timestamps.resize(rows);
+        if (!nextColumn(p, end, [&](const char *data, int size) {
+                return ImuCodec::decodeTimestamps(data, size, rows, chunk.timestamps.data());
+            })) {
+            return false;
+        }
+
+        bool ok = true;
+        ChannelSchema::forEachChannel([&](auto channel) {
+            constexpr int index = decltype(channel)::value;
+            if (!ok || !chunk.hasChannel<index>()) {
+                return;
+            }
+            auto &column = chunk.column<index>();
+            column.resize(rows);
+            ok = nextColumn(p, end, [&](const char *data, int size) {
+                return decodeValues(data, size, rows, column.data());
+            });
+        });
+        return ok && p == end;
+    }
+
+    // Кодек колонки выбирается по типу канала
+    static void encodeValues(const float *values, int count, QByteArray &out) {
+        ImuCodec::encodeFloat(values, count, out);
+    }
+
+    static void encodeValues(const int16_t *values, int count, QByteArray &out) {
+        ImuCodec::encodeInt16(values, count, out);
+    }
+
+    static bool decodeValues(const char *data, int size, int count, float *values) {
+        return ImuCodec::decodeFloat(data, size, count, values);
+    }
+
+    static bool decodeValues(const char *data, int size, int count, int16_t *values) {
+        return ImuCodec::decodeInt16(data, size, count, values);
+    }
+
+    template<typename Encoder>
+    static void appendColumn(QByteArray &payload, Encoder encode) {
+        const int sizeOffset = payload.size();
+        payload.append(QByteArray(sizeof(quint32), '\0'));
+        encode(payload);
+        qToLittleEndian<quint32>(static_cast<quint32>(payload.size() - sizeOffset - sizeof(quint32)),
+                                 payload.data() + sizeOffset);
+    }
+
+    template<typename Decoder>
+    static bool nextColumn(const char *&p, const char *end, Decoder decode) {
+        if (end - p < static_cast<qint64>(sizeof(quint32))) {
+            return false;
+        }
+        const quint32 size = qFromLittleEndian<quint32>(p);
+        p += sizeof(quint32);
+        if (static_cast<quint64>(end - p) < size || !decode(p, static_cast<int>(size))) {
+            return false;
+        }
+        p += size;
+        return true;
+    }
+
+    void writeFileHeader() {
+        char header[FILE_HEADER_SIZE] = {};
+        std::memcpy(header, FILE_MAGIC, sizeof(FILE_MAGIC));
+        qToLittleEndian<quint16>(FORMAT_VERSION, header + 4);
+        qToLittleEndian<quint16>(static_cast<quint16>(channels), header + 6);
+        file.write(header, FILE_HEADER_SIZE);
+        file.flush();
+    }
+
+    QString filePath;
+    QFile file;
+    int channels;
+    int chunkRows;
+    SensorDataBatch pending;
+    std::unique_ptr<FileSyncer> syncer;
+};
+
+#endif // BINARYSENSORDATADAO_H
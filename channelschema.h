@@ -0,0 +1,165 @@
+#ifndef CHANNELSCHEMA_H
+#define CHANNELSCHEMA_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+// Единое описание каналов SensorData: порядок, тип и смещение в теле кадра, масштаб, подписи.
+// По таблице на этапе компиляции строятся декодер и кодер кадра, а в хранилищах и на графиках -
+// имена колонок, типы SQL и подписи. Смена состава каналов - правка только здесь.
+namespace ChannelSchema
+{
+
+enum class WireType {
+    Float32,
+    Int16
+};
+
+constexpr int wireSize(WireType type) {
+    return type == WireType::Float32 ? 4 : 2;
+}
+
+// Тип колонки в SQLite
+constexpr const char *sqlType(WireType type) {
+    return type == WireType::Float32 ? "REAL" : "INTEGER";
+}
+
+enum GroupIndex {
+    ENV_GROUP,
+    GYRO_GROUP,
+    ACCELERO_GROUP,
+    MAGNETO_GROUP
+};
+
+struct Group
+{
+    const char *title;
+    int mask;               // совпадает с SensorData::Channels и SensorDataBatch::Channels
+};
+
+struct Channel
+{
+    const char *name;       // имя колонки во всех форматах записи
+    WireType wire;
+    int offset;             // смещение в теле кадра, байт
+    float scale;            // значение = значение в кадре * scale
+    const char *title;      // подпись графика
+    const char *unit;
+    int group;
+    int axis;
+};
+
+constexpr int AXES = 3;
+
+constexpr Group GROUPS[] = {
+    {"Окружающая среда", 0x01},
+    {"Гироскоп", 0x02},
+    {"Акселерометр", 0x04},
+    {"Магнитометр", 0x08}
+};
+
+constexpr Channel CHANNELS[] = {
+    {"temperature", WireType::Float32, 0, 1.0f, "Температура", "°C", ENV_GROUP, 0},
+    {"humidity", WireType::Float32, 4, 1.0f, "Влажность", "%", ENV_GROUP, 1},
+    {"pressure", WireType::Float32, 8, 1.0f, "Давление", "кПа", ENV_GROUP, 2},
+    {"gyro_x", WireType::Int16, 12, 0.001f, "Угловая скорость X", "град/c", GYRO_GROUP, 0},
+    {"gyro_y", WireType::Int16, 14, 0.001f, "Угловая скорость Y", "град/c", GYRO_GROUP, 1},
+    {"gyro_z", WireType::Int16, 16, 0.001f, "Угловая скорость Z", "град/c", GYRO_GROUP, 2},
+    {"accelero_x", WireType::Int16, 18, 1.0f, "Линейное ускорение X", "mg", ACCELERO_GROUP, 0},
+    {"accelero_y", WireType::Int16, 20, 1.0f, "Линейное ускорение Y", "mg", ACCELERO_GROUP, 1},
+    {"accelero_z", WireType::Int16, 22, 1.0f, "Линейное ускорение Z", "mg", ACCELERO_GROUP, 2},
+    {"magneto_x", WireType::Int16, 24, 1.0f, "Магнитная индукция X", "мГc", MAGNETO_GROUP, 0},
+    {"magneto_y", WireType::Int16, 26, 1.0f, "Магнитная индукция Y", "мГc", MAGNETO_GROUP, 1},
+    {"magneto_z", WireType::Int16, 28, 1.0f, "Магнитная индукция Z", "мГc", MAGNETO_GROUP, 2}
+};
+
+constexpr int GROUP_COUNT = sizeof(GROUPS) / sizeof(GROUPS[0]);
+constexpr int CHANNEL_COUNT = sizeof(CHANNELS) / sizeof(CHANNELS[0]);
+
+// Размер измерений в теле кадра; за ними идет байт счетчика
+constexpr int MEASURES_BYTES = CHANNELS[CHANNEL_COUNT - 1].offset + wireSize(CHANNELS[CHANNEL_COUNT - 1].wire);
+
+// Каналы идут группами по AXES без пропусков, у группы один тип:
+// на этом держатся массивы по группам в SensorData и SensorDataBatch
+constexpr bool isPacked() {
+    int offset = 0;
+    for (int i = 0; i < CHANNEL_COUNT; ++i) {
+        const Channel &channel = CHANNELS[i];
+        if (channel.offset != offset || channel.group != i / AXES || channel.axis != i % AXES
+            || channel.wire != CHANNELS[channel.group * AXES].wire) {
+            return false;
+        }
+        offset += wireSize(channel.wire);
+    }
+    return true;
+}
+
+static_assert(CHANNEL_COUNT == GROUP_COUNT * AXES, "у каждой группы AXES каналов");
+static_assert(isPacked(), "каналы должны идти подряд по группам");
+
+template<WireType Type>
+struct Wire;
+
+template<>
+struct Wire<WireType::Float32>
+{
+    using type = float;
+};
+
+template<>
+struct Wire<WireType::Int16>
+{
+    using type = int16_t;
+};
+
+// Тип значения канала после декодирования совпадает с типом в кадре
+template<int Index>
+using ValueType = typename Wire<CHANNELS[Index].wire>::type;
+
+template<int Group>
+using GroupValueType = ValueType<Group * AXES>;
+
+// Значение канала из тела кадра; масштаб применяется в float, как у прошивки
+template<int Index>
+ValueType<Index> decode(const char *body) {
+    constexpr Channel channel = CHANNELS[Index];
+    ValueType<Index> raw;
+    std::memcpy(&raw, body + channel.offset, sizeof(raw));
+    if constexpr (channel.scale != 1.0f) {
+        return static_cast<ValueType<Index>>(raw * channel.scale);
+    } else {
+        return raw;
+    }
+}
+
+// Обратное к decode: целые каналы округляются и ограничиваются диапазоном типа
+template<int Index>
+void encode(double value, char *body) {
+    constexpr Channel channel = CHANNELS[Index];
+    ValueType<Index> raw;
+    if constexpr (channel.wire == WireType::Int16) {
+        raw = static_cast<int16_t>(std::max(-32768.0, std::min(32767.0, std::round(value / channel.scale))));
+    } else {
+        raw = static_cast<ValueType<Index>>(value / channel.scale);
+    }
+    std::memcpy(body + channel.offset, &raw, sizeof(raw));
+}
+
+template<typename F, int... Index>
+void forEachChannel(F &&function, std::integer_sequence<int, Index...>) {
+    (function(std::integral_constant<int, Index>()), ...);
+}
+
+// Вызывает function(std::integral_constant<int, Index>) для каждого канала по порядку:
+// номер канала - константа компиляции, цикл разворачивается без косвенных вызовов
+template<typename F>
+void forEachChannel(F &&function) {
+    forEachChannel(function, std::make_integer_sequence<int, CHANNEL_COUNT>());
+}
+
+}
+
+#endif // CHANNELSCHEMA_H
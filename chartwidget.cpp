@@ -7,6 +7,13 @@
 #include "uartwidget.h"
 #include "dynamicplotsgroup.h"
 #include "OrientablePushButton.h"
+#include "experimentcatalogdialog.h"
+#include "exportdialog.h"
+#include "exportjob.h"
+#include "allocationcounter.h"
+#include "channelschema.h"
+#include "pipelinediagnostics.h"
+#include "tracer.h"
 
 #include <QVBoxLayout>
 #include <QDateTime>
@@ -17,15 +24,21 @@
 #include <QTabWidget>
 #include <QFileDialog>
 #include <QDir>
+#include <QFileInfo>
 #include <QButtonGroup>
+#include <QProgressDialog>
+#include <QFontDatabase>
 
 
 ChartWidget::ChartWidget(InsCommandProcessor *serial,
                          std::shared_ptr<DynamicSetting<int>> plotBufferSize,
                          std::shared_ptr<DynamicSetting<int>> plotSize,
+                         std::shared_ptr<DynamicSetting<int>> plotHistoryMemory,
+                         std::shared_ptr<DynamicSetting<int>> sensorNominalRate,
                          FileStorageManager *storageManager,
                          QWidget *parent)
-    : RoutableWidget(parent), processor(serial), ui(new Ui::ChartWidget), isUartWidgetVisible(true), storageManager(storageManager)
+    : RoutableWidget(parent), processor(serial), ui(new Ui::ChartWidget), isUartWidgetVisible(true), storageManager(storageManager),
+      sensorNominalRate(sensorNominalRate)
 {
     ui->setupUi(this);
 
@@ -39,10 +52,12 @@ ChartWidget::ChartWidget(InsCommandProcessor *serial,
     initStorageButtons();
 
     // Setup charts
-    initCharts(plotBufferSize, plotSize);
+    initCharts(plotBufferSize, plotSize, plotHistoryMemory);
 
     // Connect ToggleButton signals
     initStartToggleButton();
+
+    initDiagnostics();
 }
 
 ChartWidget::~ChartWidget()
@@ -64,7 +79,7 @@ void ChartWidget::initRangeSlider() {
     rangeSlider->setVisible(false); // Скрываем до загрузки файла
     ui->horizontalLayout->insertWidget(5, rangeSlider); // Добавляем слайдер в layout
 
-    connect(rangeSlider, &RangeSlider::rangeChanged, this, &ChartWidget::loadDataForPeriod);
+    connect(rangeSlider, &RangeSlider::rangeChanged, this, &ChartWidget::onRangeChanged);
 }
 
 void ChartWidget::initUartWidget() {
@@ -93,6 +108,11 @@ void ChartWidget::initStartToggleButton() {
     connect(ui->startToggleButton, &ToggleButton::pauseSignal, this, &ChartWidget::stopShowData);
     connect(ui->startToggleButton, &ToggleButton::stopSignal, this, &ChartWidget::handleStopSignal);
     // connect(processor, &InsCommandProcessor::stopped, ui->startToggleButton, &ToggleButton::onPauseClicked);
+    // После перемотки записи графики начинаются заново, модель времени тоже
+    connect(processor, &InsCommandProcessor::replaySought, this, [this]() {
+        clearGraphs();
+        sampleTiming.reset();
+    });
     ui->startToggleButton->setVisible(false);
 }
 
@@ -100,34 +120,68 @@ void ChartWidget::initStorageButtons() {
     connect(processor, &InsCommandProcessor::connectionStatusChanged, this, &ChartWidget::onUartConnectionChanged);
     connect(ui->saveToFileButton, &QPushButton::clicked, this, &ChartWidget::saveToFile);
     connect(ui->loadButton, &QPushButton::clicked, this, &ChartWidget::loadFromFile);
+    connect(ui->catalogButton, &QPushButton::clicked, this, &ChartWidget::openCatalog);
+    connect(ui->exportArrowButton, &QPushButton::clicked, this, &ChartWidget::exportToArrow);
+    ui->exportArrowButton->setVisible(false);
+
+    // QFileSystemWatcher в Linux построен на inotify
+    recordingWatcher = new QFileSystemWatcher(this);
+    followTimer = new QTimer(this);
+    followTimer->setSingleShot(true);
+    followTimer->setInterval(FOLLOW_DELAY_MS);
+    connect(recordingWatcher, &QFileSystemWatcher::fileChanged, this, [this]() {
+        if (!followTimer->isActive()) {
+            followTimer->start();
+        }
+    });
+    connect(followTimer, &QTimer::timeout, this, &ChartWidget::readAppendedData);
+    connect(ui->followButton, &QPushButton::toggled, this, &ChartWidget::toggleFollow);
 }
 
-void ChartWidget::initCharts(std::shared_ptr<DynamicSetting<int>> plotBufferSize, std::shared_ptr<DynamicSetting<int>> plotSize)
+void ChartWidget::initDiagnostics() {
+    ui->diagnosticsLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    ui->diagnosticsLabel->setVisible(false);
+    diagnosticsTimer = new QTimer(this);
+    diagnosticsTimer->setInterval(DIAGNOSTICS_INTERVAL_MS);
+    connect(diagnosticsTimer, &QTimer::timeout, this, &ChartWidget::updateDiagnostics);
+    connect(ui->diagnosticsButton, &QPushButton::toggled, this, &ChartWidget::toggleDiagnostics);
+    connect(ui->dumpDiagnosticsButton, &QPushButton::clicked, this, &ChartWidget::dumpDiagnostics);
+    connect(ui->traceButton, &QPushButton::toggled, this, &ChartWidget::toggleTrace);
+    // Трассировка может быть запущена из командной строки
+    ui->traceButton->setChecked(Tracer::instance().isRecording());
+    // Частоты этапов считаются по таймеру, поэтому он идет и при скрытой панели
+    diagnosticsTimer->start();
+}
+
+void ChartWidget::initCharts(std::shared_ptr<DynamicSetting<int>> plotBufferSize,
+                             std::shared_ptr<DynamicSetting<int>> plotSize,
+                             std::shared_ptr<DynamicSetting<int>> plotHistoryMemory)
 {
-    // Создаем группы графиков
-    envGroup_ = new DynamicPlotsGroup(this);
-    envGroup_->addPlot("Температура, °C", plotBufferSize, plotSize);
-    envGroup_->addPlot("Влажность, %", plotBufferSize, plotSize);
-    envGroup_->addPlot("Давление, кПа", plotBufferSize, plotSize);
-    ui->verticalLayoutEnv_2->addWidget(envGroup_);
-
-    acceleroGroup_ = new DynamicPlotsGroup(this);
-    acceleroGroup_->addPlot("Линейное ускорение X, mg", plotBufferSize, plotSize);
-    acceleroGroup_->addPlot("Линейное ускорение Y, mg", plotBufferSize, plotSize);
-    acceleroGroup_->addPlot("Линейное ускорение Z, mg", plotBufferSize, plotSize);
-    ui->verticalLayoutAccelero_2->addWidget(acceleroGroup_);
-
-    gyroGroup_ = new DynamicPlotsGroup(this);
-    gyroGroup_->addPlot("Угловая скорость X, град/c", plotBufferSize, plotSize);
-    gyroGroup_->addPlot("Угловая скорость Y, град/c", plotBufferSize, plotSize);
-    gyroGroup_->addPlot("Угловая скорость Z, град/c", plotBufferSize, plotSize);
-    ui->verticalLayoutGyro_2->addWidget(gyroGroup_);
-
-    magnetoGroup_ = new DynamicPlotsGroup(this);
-    magnetoGroup_->addPlot("Магнитная индукция X, мГc", plotBufferSize, plotSize);
-    magnetoGroup_->addPlot("Магнитная индукция Y, мГc", plotBufferSize, plotSize);
-    magnetoGroup_->addPlot("Магнитная индукция Z, мГc", plotBufferSize, plotSize);
-    ui->verticalLayoutMagneto_2->addWidget(magnetoGroup_);
+    // Память истории задается на все графики вместе, а не на каждый из CHANNEL_COUNT графиков
+    auto historyBudget = std::make_shared<PlotHistoryBudget>();
+    if (plotHistoryMemory) {
+        historyBudget->setLimit(static_cast<qint64>(plotHistoryMemory->get()) * 1024 * 1024);
+        plotHistoryMemory->setOnUpdateCallback([historyBudget](int megabytes) {
+            historyBudget->setLimit(static_cast<qint64>(megabytes) * 1024 * 1024);
+        });
+    }
+
+    // Подписи графиков группы берутся из ChannelSchema
+    auto createGroup = [&](int group, QLayout *layout) {
+        DynamicPlotsGroup *plotsGroup = new DynamicPlotsGroup(this);
+        for (int axis = 0; axis < ChannelSchema::AXES; ++axis) {
+            const ChannelSchema::Channel &channel = ChannelSchema::CHANNELS[group * ChannelSchema::AXES + axis];
+            plotsGroup->addPlot(QString::fromUtf8(channel.title) + ", " + QString::fromUtf8(channel.unit),
+                                plotBufferSize, plotSize, historyBudget);
+        }
+        layout->addWidget(plotsGroup);
+        return plotsGroup;
+    };
+
+    envGroup_ = createGroup(ChannelSchema::ENV_GROUP, ui->verticalLayoutEnv_2);
+    acceleroGroup_ = createGroup(ChannelSchema::ACCELERO_GROUP, ui->verticalLayoutAccelero_2);
+    gyroGroup_ = createGroup(ChannelSchema::GYRO_GROUP, ui->verticalLayoutGyro_2);
+    magnetoGroup_ = createGroup(ChannelSchema::MAGNETO_GROUP, ui->verticalLayoutMagneto_2);
 }
 
 void ChartWidget::clearGraphs()
@@ -138,42 +192,177 @@ void ChartWidget::clearGraphs()
     magnetoGroup_->clear();
 }
 
+template<typename T>
+void ChartWidget::addGroupPoint(DynamicPlotsGroup *group, const QDateTime &timestamp, const std::array<T, SensorData::AXES> &values)
+{
+    pointValues.assign(values.begin(), values.end());
+    group->addPoint(timestamp, pointValues);
+}
+
 void ChartWidget::updateGraphs(const SensorData &data, const QDateTime &timestamp)
 {
-    if (!data.getEnvironmentalMeasures().empty()) {
-        std::vector<double> envValues;
-        for (const auto &value : data.getEnvironmentalMeasures()) {
-            envValues.push_back(value);
-        }
-        envGroup_->addPoint(timestamp, envValues);
+    if (data.hasChannels(SensorData::ENV)) {
+        addGroupPoint(envGroup_, timestamp, data.environmental());
+    }
+    if (data.hasChannels(SensorData::ACCELERO)) {
+        addGroupPoint(acceleroGroup_, timestamp, data.accelero());
+    }
+    if (data.hasChannels(SensorData::GYRO)) {
+        addGroupPoint(gyroGroup_, timestamp, data.gyro());
+    }
+    if (data.hasChannels(SensorData::MAGNETO)) {
+        addGroupPoint(magnetoGroup_, timestamp, data.magneto());
     }
 
-    if (!data.getAcceleroMeasures().empty()) {
-        std::vector<double> acceleroValues;
-        for (const auto &value : data.getAcceleroMeasures()) {
-            acceleroValues.push_back(value);
+    // Подписи и ползунок собирают строки, поэтому обновляются не чаще LABELS_INTERVAL_NS, а не на каждый кадр
+    lastDataSendCount = data.getDataSendCount();
+    const qint64 nowNs = MonotonicClock::nowNs();
+    if (nowNs - lastLabelsUpdateNs >= LABELS_INTERVAL_NS) {
+        lastLabelsUpdateNs = nowNs;
+        updateHistoryRange();
+        updateIngestMetrics();
+    }
+}
+
+
+void ChartWidget::updateIngestMetrics()
+{
+    ui->writeSpeedLabel->setText(QString::number(lastDataSendCount));
+
+    const SampleTimingMetrics &metrics = sampleTiming.metrics();
+    QString text = QString("Потеряно кадров: %1, частота: %2 Гц")
+                       .arg(metrics.dropped)
+                       .arg(metrics.rateHz, 0, 'f', 2);
+    if (metrics.hasDrift()) {
+        text += QString(", дрейф: %1 ppm").arg(metrics.driftPpm, 0, 'f', 1);
+    }
+    if (metrics.duplicates > 0) {
+        text += QString(", повторы: %1").arg(metrics.duplicates);
+    }
+    ui->timingLabel->setText(text);
+
+    const IngestStats ingest = processor->getIngestStats();
+    const ReaderStats reader = processor->getReaderStats();
+    const QString modeName = reader.mode == SerialReadMode::LOW_LATENCY ? "низкая задержка"
+                             : reader.mode == SerialReadMode::THROUGHPUT ? "пропускная способность"
+                                                                         : "стандартный";
+    ui->ingestLabel->setText(QString("Очередь: %1/%2, макс. %3, вытеснено: %4\n"
+                                     "Чтение (%5): %6 Б/чтение, задержка кадра ср. %7 мкс, макс. %8 мкс")
+                                 .arg(ingest.depth)
+                                 .arg(ingest.capacity)
+                                 .arg(ingest.maxDepth)
+                                 .arg(ingest.dropped)
+                                 .arg(modeName)
+                                 .arg(reader.wakeups > 0 ? reader.bytes / reader.wakeups : 0)
+                                 .arg(reader.meanLatencyNs / 1000, 0, 'f', 1)
+                                 .arg(reader.maxLatencyNs / 1000));
+
+    // Снимок публикуется раз в окно; без новых кадров частоты обнуляются
+    LinkMetricsSnapshot link = processor->getLinkMetrics();
+    if (link.isStale(MonotonicClock::nowNs(), LinkMetrics::WINDOW_NS)) {
+        link = LinkMetricsSnapshot();
+    }
+    ui->readSpeedLabel->setText(QString("%1 (сглаж. %2)").arg(link.rateHz, 0, 'f', 1).arg(link.ewmaRateHz, 0, 'f', 1));
+    ui->ingestLabel->setText(ui->ingestLabel->text()
+                             + QString("\nСвязь: %1 КиБ/с, интервал p50 %2 мкс, p99 %3 мкс, макс. %4 мкс, джиттер %5 мкс, "
+                                       "ошибки CRC %6/с, ресинхронизация %7 Б/с")
+                                   .arg(link.bytesPerSecond / 1024, 0, 'f', 1)
+                                   .arg(link.intervalP50Ns / 1000)
+                                   .arg(link.intervalP99Ns / 1000)
+                                   .arg(link.intervalMaxNs / 1000)
+                                   .arg(link.jitterNs / 1000, 0, 'f', 1)
+                                   .arg(link.crcFailuresPerSecond, 0, 'f', 1)
+                                   .arg(link.resyncBytesPerSecond, 0, 'f', 0));
+
+    const RawCaptureStats raw = processor->getRawCaptureStats();
+    if (raw.records > 0) {
+        QString rawText = QString("\nСырой поток: %1 КиБ").arg(raw.writtenBytes / 1024);
+        if (raw.droppedBytes > 0) {
+            rawText += QString(", потеряно %1 Б").arg(raw.droppedBytes);
         }
-        acceleroGroup_->addPoint(timestamp, acceleroValues);
+        ui->ingestLabel->setText(ui->ingestLabel->text() + rawText);
     }
 
-    if (!data.getGyroMeasures().empty()) {
-        std::vector<double> gyroValues;
-        for (const auto &value : data.getGyroMeasures()) {
-            gyroValues.push_back(value);
+    if (storageManager->isRecording()) {
+        const LiveRecorderStats recording = storageManager->getRecordingStats();
+        QString recordingText = QString("\nЗапись: %1, строк %2")
+                                    .arg(QFileInfo(storageManager->getSaveFileName()).fileName())
+                                    .arg(recording.writtenRows);
+        if (recording.files > 1) {
+            recordingText += QString(", сегмент %1").arg(recording.files);
         }
-        gyroGroup_->addPoint(timestamp, gyroValues);
+        if (recording.hasDurableTimestamp()) {
+            recordingText += ", на диске до " + SensorDataBatch::fromNanos(recording.durableTimestampNs).toString("HH:mm:ss");
+        }
+        if (recording.droppedRows > 0 || recording.failedRows > 0) {
+            recordingText += QString(", потеряно %1").arg(recording.droppedRows + recording.failedRows);
+        }
+        ui->ingestLabel->setText(ui->ingestLabel->text() + recordingText);
     }
+}
 
-    if (!data.getMagnetoMeasures().empty()) {
-        std::vector<double> magnetoValues;
-        for (const auto &value : data.getMagnetoMeasures()) {
-            magnetoValues.push_back(value);
+QString ChartWidget::diagnosticsText() const
+{
+    return PipelineDiagnostics::instance().report()
+        + QString("\nЧтение -> экран: кадров %1, p50 %2 мкс, p99 %3 мкс, p99.9 %4 мкс, макс. %5 мкс\n")
+              .arg(pixelLatency.count())
+              .arg(pixelLatency.percentileNs(0.5) / 1e3, 0, 'f', 1)
+              .arg(pixelLatency.percentileNs(0.99) / 1e3, 0, 'f', 1)
+              .arg(pixelLatency.percentileNs(0.999) / 1e3, 0, 'f', 1)
+              .arg(pixelLatency.maxNs() / 1e3, 0, 'f', 1);
+}
+
+void ChartWidget::updateDiagnostics()
+{
+    const ReaderStats reader = processor->getReaderStats();
+    PipelineDiagnostics::instance().updateRates(MonotonicClock::nowNs(), reader.wakeups, reader.bytes);
+    if (ui->diagnosticsLabel->isVisible()) {
+        ui->diagnosticsLabel->setText(diagnosticsText());
+    }
+}
+
+void ChartWidget::toggleDiagnostics(bool visible)
+{
+    ui->diagnosticsLabel->setVisible(visible);
+    if (visible) {
+        ui->diagnosticsLabel->setText(diagnosticsText());
+    }
+}
+
+void ChartWidget::dumpDiagnostics()
+{
+    const QString directory = FileStorageManager::experimentsDirectory();
+    QDir().mkpath(directory);
+    const QDateTime now = QDateTime::currentDateTime();
+    const QString path = QDir(directory).filePath("diagnostics_" + now.toString("yyyyMMdd_HHmmss") + ".txt");
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        QMessageBox::critical(this, "Диагностика", QString("Не удалось записать %1: %2").arg(path, file.errorString()));
+        return;
+    }
+    file.write((now.toString(Qt::ISODateWithMs) + "\n" + diagnosticsText()).toUtf8());
+    QMessageBox::information(this, "Диагностика", QString("Сохранено в %1").arg(path));
+}
+
+void ChartWidget::toggleTrace(bool enabled)
+{
+    Tracer &tracer = Tracer::instance();
+    if (enabled) {
+        if (!tracer.isRecording()) {
+            tracer.start();
         }
-        magnetoGroup_->addPoint(timestamp, magnetoValues);
+        return;
     }
 
-    ui->writeSpeedLabel->setText(QString::number(data.getDataSendCount()));
-    ui->readSpeedLabel->setText(QString::number(processor->getFrequency()));
+    const QString directory = FileStorageManager::experimentsDirectory();
+    QDir().mkpath(directory);
+    const QString path = QDir(directory).filePath("trace_" + QDateTime::currentDateTime().toString("yyyyMMdd_HHmmss") + ".json");
+    if (!tracer.stop(path)) {
+        QMessageBox::critical(this, "Трассировка", QString("Не удалось записать %1").arg(path));
+        return;
+    }
+    QMessageBox::information(this, "Трассировка",
+                             QString("Сохранено в %1\nФайл открывается в ui.perfetto.dev или chrome://tracing").arg(path));
 }
 
 void ChartWidget::toggleUartWidget()
@@ -209,19 +398,39 @@ void ChartWidget::toggleUartWidget()
 void ChartWidget::handleStopSignal()
 {
     stopShowData();
+    storageManager->stopRecording();
     clearGraphs();
 }
 
 void ChartWidget::showData()
 {
-    if (mode != ChartWidget::WidgetMode::UART) {
+    const bool wasFileMode = mode != ChartWidget::WidgetMode::UART;
+    if (wasFileMode) {
         clearGraphs();
     }
 
     setMode(ChartWidget::WidgetMode::UART);
-    
+    PipelineDiagnostics::instance().reset();
+    pixelLatency.reset();
+    sampleTiming.reset();
+    sampleTiming.setNominalRate(sensorNominalRate ? sensorNominalRate->get() : 0);
+    if (wasFileMode) {
+        // Ползунки возвращаются к концу шкалы, чтобы графики следили за новыми данными
+        const QDateTime now = QDateTime::currentDateTime();
+        rangeSlider->setRange(now, now);
+    }
 
-    processor->readData([this](const QByteArray &data) {
+    // Прием пишется в experiments; после паузы запись продолжается в тот же файл.
+    // Воспроизведение уже записанного не пишется повторно
+    if (storageManager->isRecordingEnabled() && !storageManager->isRecording() && !processor->isReplaying()
+        && !storageManager->startRecording()) {
+        QMessageBox::warning(this, "Запись", "Не удалось начать запись в каталог experiments, прием идет без записи.");
+    }
+
+    processor->readData([this](const QByteArray &data, qint64 arrivalNs) {
+        TraceSpan span("decode frame");
+        const qint64 decodeStartNs = MonotonicClock::nowNs();
+        const qint64 decodeStartAllocations = AllocationCounter::threadCount();
         CommandResponse<SensorData> response(data);
         if (response.getResponseType() == CommandResponse<SensorData>::BAD_RESPONSE) {
             qDebug() << "Bad response: " << response.getError();
@@ -238,136 +447,315 @@ void ChartWidget::showData()
             return;
         }
 
-        updateGraphs(response.getMessageBody(), QDateTime::currentDateTime());
+        // Время берется из потока чтения и сглаживается моделью по счетчику кадров
+        const SensorData body = response.getMessageBody();
+        PipelineDiagnostics::instance().record(PipelineDiagnostics::DECODE, MonotonicClock::nowNs() - decodeStartNs,
+                                               AllocationCounter::threadCount() - decodeStartAllocations);
+        const qint64 sampleNs = sampleTiming.update(body.getDataSendCount(), arrivalNs);
+        updateGraphs(body, processor->getSessionClock().toDateTime(sampleNs));
+        storageManager->record(processor->getSessionClock().toWallNs(sampleNs), body);
+        // replot отрисовывает слои синхронно, поэтому после updateGraphs кадр уже на графиках
+        if (processor->hasMonotonicArrivals()) {
+            pixelLatency.record(MonotonicClock::nowNs() - arrivalNs);
+        }
     });
 }
 
 void ChartWidget::stopShowData()
 {
     processor->interrupt();
+    // Подписи обновляются с прореживанием, последний кадр показывается здесь
+    updateHistoryRange();
+    updateIngestMetrics();
+}
+
+void ChartWidget::startLive()
+{
+    showData();
+}
+
+void ChartWidget::stopLive()
+{
+    stopShowData();
+}
+
+const LatencyHistogram &ChartWidget::getPixelLatency() const
+{
+    return pixelLatency;
+}
+
+void ChartWidget::resetPixelLatency()
+{
+    pixelLatency.reset();
 }
 
 void ChartWidget::onUartConnectionChanged(bool connected)
 {
+    if (!connected) {
+        storageManager->stopRecording();
+    }
     ui->startToggleButton->setVisible(connected);
     toggleUartWidget();
 }
 
 void ChartWidget::saveToFile()
 {
-    // Collect data from all charts
-    QList<TimestampedSensorData> allData;
-
-    // Environment data
-    QList<QPair<QDateTime, double>> temperatureData = envGroup_->getAllData().at(0);
-    QList<QPair<QDateTime, double>> humidityData = envGroup_->getAllData().at(1);
-    QList<QPair<QDateTime, double>> pressureData = envGroup_->getAllData().at(2);
-
-    // Acceleration data
-    QList<QPair<QDateTime, double>> acceleroXData = acceleroGroup_->getAllData().at(0);
-    QList<QPair<QDateTime, double>> acceleroYData = acceleroGroup_->getAllData().at(1);
-    QList<QPair<QDateTime, double>> acceleroZData = acceleroGroup_->getAllData().at(2);
-
-    // Gyroscope data
-    QList<QPair<QDateTime, double>> gyroXData = gyroGroup_->getAllData().at(0);
-    QList<QPair<QDateTime, double>> gyroYData = gyroGroup_->getAllData().at(1);
-    QList<QPair<QDateTime, double>> gyroZData = gyroGroup_->getAllData().at(2);
-
-    // Magnetometer data
-    QList<QPair<QDateTime, double>> magnetoXData = magnetoGroup_->getAllData().at(0);
-    QList<QPair<QDateTime, double>> magnetoYData = magnetoGroup_->getAllData().at(1);
-    QList<QPair<QDateTime, double>> magnetoZData = magnetoGroup_->getAllData().at(2);
-
-    // Check if all data lists have the same size
-    if (temperatureData.size() != humidityData.size() || temperatureData.size() != pressureData.size() ||
-        temperatureData.size() != acceleroXData.size() || temperatureData.size() != acceleroYData.size() ||
-        temperatureData.size() != acceleroZData.size() || temperatureData.size() != gyroXData.size() ||
-        temperatureData.size() != gyroYData.size() || temperatureData.size() != gyroZData.size() ||
-        temperatureData.size() != magnetoXData.size() || temperatureData.size() != magnetoYData.size() ||
-        temperatureData.size() != magnetoZData.size()) {
-        qDebug() << "Error: Data sizes do not match!";
+    startExport("csv");
+}
+
+void ChartWidget::loadFromFile() {
+    try {
+        storageManager->loadFile(this, ui->followButton->isChecked());
+        if (storageManager->getReadFileName().isEmpty()) {
+            return;
+        }
+        showLoadedFile();
+    } catch (const std::exception &e) {
+        QMessageBox::critical(this, "Ошибка", QString("Не удалось загрузить файл: %1").arg(e.what()));
+    }
+}
+
+void ChartWidget::openCatalog() {
+    ExperimentCatalogDialog dialog(FileStorageManager::experimentsDirectory(), this);
+    if (dialog.exec() != QDialog::Accepted || dialog.selectedFilePath().isEmpty()) {
         return;
     }
 
-    // Combine data into TimestampedSensorData objects
-    for (int i = 0; i < temperatureData.size(); ++i) {
-        TimestampedSensorData data;
-        data.setTimestamp(temperatureData[i].first);
-        data.setEnvironmentalMeasures({
-            static_cast<float>(temperatureData[i].second),
-            static_cast<float>(humidityData[i].second),
-            static_cast<float>(pressureData[i].second)
-        });
-        data.setAcceleroMeasures({
-            static_cast<int16_t>(acceleroXData[i].second),
-            static_cast<int16_t>(acceleroYData[i].second),
-            static_cast<int16_t>(acceleroZData[i].second)
-        });
-        data.setGyroMeasures({
-            static_cast<int16_t>(gyroXData[i].second),
-            static_cast<int16_t>(gyroYData[i].second),
-            static_cast<int16_t>(gyroZData[i].second)
-        });
-        data.setMagnetoMeasures({
-            static_cast<int16_t>(magnetoXData[i].second),
-            static_cast<int16_t>(magnetoYData[i].second),
-            static_cast<int16_t>(magnetoZData[i].second)
-        });
-        allData.append(data);
+    try {
+        storageManager->loadFile(dialog.selectedFilePath(), ui->followButton->isChecked());
+        showLoadedFile();
+    } catch (const std::exception &e) {
+        QMessageBox::critical(this, "Ошибка", QString("Не удалось загрузить файл: %1").arg(e.what()));
     }
+}
 
-    storageManager->openFileToSave();
-    // Write data to CSV
-    for (const auto& data : allData) {
-        storageManager->saveData(data);
+void ChartWidget::showLoadedFile() {
+    const RecoveryReport recovery = storageManager->getRecoveryReport();
+    if (recovery.truncatedBytes > 0) {
+        const QString lastRow = recovery.hasTimestamp()
+            ? SensorDataBatch::fromNanos(recovery.lastTimestampNs).toString("yyyy-MM-dd HH:mm:ss.zzz")
+            : QString("нет");
+        QMessageBox::warning(this, "Восстановление записи",
+                             QString("Запись была прервана. Отброшен недописанный хвост: %1 Б.\n"
+                                     "Последняя сохраненная строка: %2").arg(recovery.truncatedBytes).arg(lastRow));
     }
 
-    QMessageBox::information(this, "Статус записи", QString("Экперимент успешно сохранен по пути:\n %1").arg(storageManager->getSaveFileName()));
+    // Запись, за которой следим, может быть еще пустой
+    if (storageManager->getRowCount() == 0 && !storageManager->isFollowing()) {
+        throw std::runtime_error("Файл не содержит данных.");
+    }
+
+    minTimestamp = storageManager->getMinTimestamp();
+    maxTimestamp = storageManager->getMaxTimestamp();
+
+    rangeSlider->setRange(minTimestamp, maxTimestamp);
+    loadDataForPeriod(minTimestamp, maxTimestamp);
+
+    setMode(ChartWidget::WidgetMode::FILE);
+    updateFollowWatcher();
 }
 
-void ChartWidget::loadFromFile() {
+void ChartWidget::toggleFollow(bool enabled) {
+    if (mode != ChartWidget::WidgetMode::FILE || storageManager->getReadFilePath().isEmpty()) {
+        return;
+    }
+
+    if (!enabled) {
+        storageManager->stopFollowing();
+        updateFollowWatcher();
+        return;
+    }
+
+    // Загруженный файл перечитывается один раз курсором слежения, дальше читаются только новые байты
     try {
-        storageManager->loadFile(this);
-        if (storageManager->getReadFileName().isEmpty()) {
-            return;
+        storageManager->loadFile(storageManager->getReadFilePath(), true);
+        showLoadedFile();
+    } catch (const std::exception &e) {
+        QMessageBox::critical(this, "Ошибка", QString("Не удалось загрузить файл: %1").arg(e.what()));
+    }
+}
+
+void ChartWidget::readAppendedData() {
+    TraceSpan span("read appended");
+    // Новые строки дорисовываются, только если на слайдере выбран конец записи
+    const bool atEnd = rangeSlider->isAtEnd();
+    bool appended = false;
+
+    SensorDataBatch batch;
+    while (storageManager->readAppended(batch)) {
+        if (atEnd) {
+            appendBatch(batch);
         }
+        appended = true;
+    }
 
-        QList<TimestampedSensorData> allData = storageManager->loadAllData();
-        if (allData.isEmpty()) {
-            throw std::runtime_error("Файл не содержит данных.");
+    if (appended) {
+        minTimestamp = storageManager->getMinTimestamp();
+        maxTimestamp = storageManager->getMaxTimestamp();
+        rangeSlider->extendRange(minTimestamp, maxTimestamp);
+        if (atEnd) {
+            for (auto group : {envGroup_, acceleroGroup_, gyroGroup_, magnetoGroup_}) {
+                group->endBatchLoad();
+            }
         }
+    }
 
-        minTimestamp = allData.first().getTimestamp();
-        maxTimestamp = allData.last().getTimestamp();
+    // Манифест сессии заменяется атомарно, и наблюдение за ним нужно восстановить
+    updateFollowWatcher();
+}
 
-        rangeSlider->setRange(minTimestamp, maxTimestamp);
-        loadDataForPeriod(minTimestamp, maxTimestamp);
+void ChartWidget::updateFollowWatcher() {
+    const QStringList paths = storageManager->isFollowing() ? storageManager->getFollowedPaths() : QStringList();
+    const QStringList watched = recordingWatcher->files();
 
-    } catch (const std::exception &e) {
-        QMessageBox::critical(this, "Ошибка", QString("Не удалось загрузить файл: %1").arg(e.what()));
+    for (const QString &path : watched) {
+        if (!paths.contains(path)) {
+            recordingWatcher->removePath(path);
+        }
+    }
+    for (const QString &path : paths) {
+        if (!watched.contains(path)) {
+            recordingWatcher->addPath(path);
+        }
+    }
+}
+
+void ChartWidget::exportToArrow() {
+    startExport("arrow");
+}
+
+// Экспорт идет в фоне: из загруженного файла в режиме FILE, из буферов графиков в режиме UART
+void ChartWidget::startExport(const QString &defaultSuffix) {
+    ExportRequest request;
+    QDateTime start;
+    QDateTime end;
+    int availableChannels = 0;
+    QString baseName;
+
+    if (mode == ChartWidget::WidgetMode::FILE && !storageManager->getReadFilePath().isEmpty()) {
+        request.sourcePath = storageManager->getReadFilePath();
+        start = rangeSlider->getStartTimestamp();
+        end = rangeSlider->getEndTimestamp();
+        availableChannels = storageManager->getChannels();
+        baseName = QFileInfo(request.sourcePath).completeBaseName();
+    } else {
+        request.snapshot = liveSnapshot();
+        if (request.snapshot.isEmpty()) {
+            QMessageBox::information(this, "Экспорт", "Нет данных для экспорта.");
+            return;
+        }
+        start = SensorDataBatch::fromNanos(request.snapshot.first().timestamps.first());
+        end = SensorDataBatch::fromNanos(request.snapshot.last().timestamps.last());
+        availableChannels = request.snapshot.first().channels;
+        baseName = QDateTime::currentDateTime().toString("yyyy-MM-dd_HH-mm-ss-zzz");
+    }
+
+    const QString defaultPath = FileStorageManager::experimentsDirectory() + "/" + baseName + "." + defaultSuffix;
+    ExportDialog dialog(defaultPath, start, end, availableChannels, this);
+    if (dialog.exec() != QDialog::Accepted) {
         return;
     }
 
-    setMode(ChartWidget::WidgetMode::FILE);
+    request.targetPath = dialog.targetPath();
+    request.channels = dialog.channels();
+    request.startNs = SensorDataBatch::toNanos(dialog.startTimestamp());
+    // Конец интервала включает всю последнюю миллисекунду
+    request.endNs = SensorDataBatch::toNanos(dialog.endTimestamp()) + SensorDataBatch::NANOS_IN_MSEC - 1;
+    request.precision = storageManager->getMeasuresPrecision();
+    QDir().mkpath(QFileInfo(request.targetPath).absolutePath());
+
+    ExportJob *job = new ExportJob(request, this);
+    QProgressDialog *progress = new QProgressDialog(
+        QString("Экспорт в %1...").arg(QFileInfo(request.targetPath).fileName()), "Отмена", 0, 100, this);
+    progress->setMinimumDuration(500);
+
+    connect(job, &ExportJob::progressChanged, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, job, &ExportJob::cancel);
+    connect(job, &ExportJob::finished, this, [this, job, progress, request](bool ok, const QString &message) {
+        progress->deleteLater();
+        job->deleteLater();
+        if (!ok) {
+            QMessageBox::warning(this, "Экспорт", message);
+            return;
+        }
+        QMessageBox::information(this, "Статус экспорта",
+                                 QString("Запись экспортирована по пути:\n %1\n%2").arg(request.targetPath, message));
+    });
+    job->start();
+}
+
+// Снимок буферов графиков по пакетам; группа попадает в снимок, если ее длина совпадает с общей
+QVector<SensorDataBatch> ChartWidget::liveSnapshot() const {
+    // В порядке ChannelSchema::GROUPS
+    DynamicPlotsGroup *const groups[] = {envGroup_, gyroGroup_, acceleroGroup_, magnetoGroup_};
+
+    QVector<double> times;
+    QVector<double> groupTimes;
+    std::array<std::vector<QVector<double>>, ChannelSchema::GROUP_COUNT> values;
+    int channels = 0;
+    for (int group = 0; group < ChannelSchema::GROUP_COUNT; ++group) {
+        groups[group]->copyColumns(groupTimes, values[group]);
+        if (groupTimes.isEmpty() || values[group].size() != ChannelSchema::AXES) {
+            continue;
+        }
+        if (times.isEmpty()) {
+            times = groupTimes;
+        }
+        if (groupTimes.size() == times.size()) {
+            channels |= ChannelSchema::GROUPS[group].mask;
+        }
+    }
+
+    QVector<SensorDataBatch> batches;
+    for (int offset = 0; offset < times.size(); offset += ISensorDataDAO::DEFAULT_BATCH_SIZE) {
+        const int rows = std::min(ISensorDataDAO::DEFAULT_BATCH_SIZE, static_cast<int>(times.size()) - offset);
+        SensorDataBatch batch;
+        batch.channels = channels;
+        batch.reserve(rows);
+        for (int row = offset; row < offset + rows; ++row) {
+            // Время на оси графика хранится в секундах, в записи - с точностью до миллисекунды
+            batch.timestamps.append(qRound64(times[row] * 1000) * SensorDataBatch::NANOS_IN_MSEC);
+            ChannelSchema::forEachChannel([&](auto channel) {
+                constexpr int index = decltype(channel)::value;
+                constexpr ChannelSchema::Channel descriptor = ChannelSchema::CHANNELS[index];
+                if (batch.hasChannel<index>()) {
+                    batch.column<index>().append(
+                        static_cast<ChannelSchema::ValueType<index>>(values[descriptor.group][descriptor.axis][row]));
+                }
+            });
+        }
+        batches.append(batch);
+    }
+    return batches;
 }
 
 void ChartWidget::setMode(WidgetMode mode) {
     if (mode == ChartWidget::WidgetMode::UART) {
-        rangeSlider->setVisible(false);
+        // В режиме UART слайдер листает историю сессии
+        rangeSlider->setVisible(true);
         ui->currentFileLabel->setVisible(false);
         ui->label->setVisible(true);
         ui->label_2->setVisible(true);
         ui->readSpeedLabel->setVisible(true);
         ui->writeSpeedLabel->setVisible(true);
+        ui->timingLabel->setVisible(true);
+        ui->ingestLabel->setVisible(true);
         ui->currentFileLabel->setVisible(false);
+        ui->exportArrowButton->setVisible(false);
+
+        storageManager->stopFollowing();
+        updateFollowWatcher();
     } else {
         ui->label->setVisible(false);
         ui->label_2->setVisible(false);
         ui->readSpeedLabel->setVisible(false);
         ui->writeSpeedLabel->setVisible(false);
+        ui->timingLabel->setVisible(false);
+        ui->ingestLabel->setVisible(false);
 
         rangeSlider->setVisible(true);
         ui->currentFileLabel->setVisible(true);
+        ui->exportArrowButton->setVisible(true);
 
         ui->startToggleButton->onPauseClicked();
         ui->currentFileLabel->setText(storageManager->getReadFileName());
@@ -377,66 +765,74 @@ void ChartWidget::setMode(WidgetMode mode) {
     this->mode = mode;
 }
 
+// В режиме FILE слайдер выбирает интервал файла, в режиме UART - интервал истории сессии.
+// Правый ползунок в конце шкалы возвращает графики к живым данным.
+void ChartWidget::onRangeChanged(const QDateTime &start, const QDateTime &end) {
+    if (mode == ChartWidget::WidgetMode::FILE) {
+        loadDataForPeriod(start, end);
+        return;
+    }
+
+    const bool live = rangeSlider->isAtEnd();
+    for (auto group : {envGroup_, acceleroGroup_, gyroGroup_, magnetoGroup_}) {
+        if (live) {
+            group->showLatest();
+        } else {
+            group->showHistoryRange(start, end);
+        }
+    }
+}
+
+void ChartWidget::updateHistoryRange() {
+    QDateTime first;
+    QDateTime last;
+    for (auto group : {envGroup_, acceleroGroup_, gyroGroup_, magnetoGroup_}) {
+        QDateTime groupFirst;
+        QDateTime groupLast;
+        if (!group->historyBounds(groupFirst, groupLast)) {
+            continue;
+        }
+        first = first.isValid() ? std::min(first, groupFirst) : groupFirst;
+        last = last.isValid() ? std::max(last, groupLast) : groupLast;
+    }
+    if (first.isValid()) {
+        rangeSlider->extendRange(first, last);
+    }
+}
+
 void ChartWidget::loadDataForPeriod(const QDateTime &start, const QDateTime &end) {
-    clearGraphs();
+    TraceSpan span("range query");
+    const QList<DynamicPlotsGroup*> groups = {envGroup_, acceleroGroup_, gyroGroup_, magnetoGroup_};
+    for (auto group : groups) {
+        group->beginBatchLoad();
+    }
 
-    QList<TimestampedSensorData> dataList = storageManager->loadDataForPeriod(start, end);
-
-    // Environmental data
-    std::vector<std::pair<
-        std::function<double(const TimestampedSensorData&)>,
-        std::function<bool(const TimestampedSensorData&)>
-    >> envExtractors = {
-        {[](const TimestampedSensorData &d) { return d.getEnvironmentalMeasures().at(0); },
-         [](const TimestampedSensorData &d) { return !d.getEnvironmentalMeasures().empty(); }},
-        {[](const TimestampedSensorData &d) { return d.getEnvironmentalMeasures().at(1); },
-         [](const TimestampedSensorData &d) { return d.getEnvironmentalMeasures().size() > 1; }},
-        {[](const TimestampedSensorData &d) { return d.getEnvironmentalMeasures().at(2); },
-         [](const TimestampedSensorData &d) { return d.getEnvironmentalMeasures().size() > 2; }}
-    };
-    envGroup_->plotSensorData(dataList, envExtractors);
-
-    // Accelerometer data
-    std::vector<std::pair<
-        std::function<double(const TimestampedSensorData&)>,
-        std::function<bool(const TimestampedSensorData&)>
-    >> acceleroExtractors = {
-        {[](const TimestampedSensorData &d) { return d.getAcceleroMeasures().at(0); },
-         [](const TimestampedSensorData &d) { return !d.getAcceleroMeasures().empty(); }},
-        {[](const TimestampedSensorData &d) { return d.getAcceleroMeasures().at(1); },
-         [](const TimestampedSensorData &d) { return d.getAcceleroMeasures().size() > 1; }},
-        {[](const TimestampedSensorData &d) { return d.getAcceleroMeasures().at(2); },
-         [](const TimestampedSensorData &d) { return d.getAcceleroMeasures().size() > 2; }}
-    };
-    acceleroGroup_->plotSensorData(dataList, acceleroExtractors);
-
-    // Gyroscope data
-    std::vector<std::pair<
-        std::function<double(const TimestampedSensorData&)>,
-        std::function<bool(const TimestampedSensorData&)>
-    >> gyroExtractors = {
-        {[](const TimestampedSensorData &d) { return d.getGyroMeasures().at(0); },
-         [](const TimestampedSensorData &d) { return !d.getGyroMeasures().empty(); }},
-        {[](const TimestampedSensorData &d) { return d.getGyroMeasures().at(1); },
-         [](const TimestampedSensorData &d) { return d.getGyroMeasures().size() > 1; }},
-        {[](const TimestampedSensorData &d) { return d.getGyroMeasures().at(2); },
-         [](const TimestampedSensorData &d) { return d.getGyroMeasures().size() > 2; }}
-    };
-    gyroGroup_->plotSensorData(dataList, gyroExtractors);
-
-    // Magnetometer data
-    std::vector<std::pair<
-        std::function<double(const TimestampedSensorData&)>,
-        std::function<bool(const TimestampedSensorData&)>
-    >> magnetoExtractors = {
-        {[](const TimestampedSensorData &d) { return d.getMagnetoMeasures().at(0); },
-         [](const TimestampedSensorData &d) { return !d.getMagnetoMeasures().empty(); }},
-        {[](const TimestampedSensorData &d) { return d.getMagnetoMeasures().at(1); },
-         [](const TimestampedSensorData &d) { return d.getMagnetoMeasures().size() > 1; }},
-        {[](const TimestampedSensorData &d) { return d.getMagnetoMeasures().at(2); },
-         [](const TimestampedSensorData &d) { return d.getMagnetoMeasures().size() > 2; }}
-    };
-    magnetoGroup_->plotSensorData(dataList, magnetoExtractors);
+    // Данные читаются пакетами: в памяти одновременно находится только один пакет
+    std::unique_ptr<ISensorDataCursor> cursor = storageManager->openCursor(start, end);
+    SensorDataBatch batch;
+    while (cursor && cursor->next(batch)) {
+        appendBatch(batch);
+    }
+
+    for (auto group : groups) {
+        group->endBatchLoad();
+    }
+}
+
+void ChartWidget::appendBatch(const SensorDataBatch &batch) {
+    TraceSpan span("append batch");
+    if (batch.hasChannels(SensorDataBatch::ENV)) {
+        envGroup_->appendColumns(batch.timestamps, batch.env);
+    }
+    if (batch.hasChannels(SensorDataBatch::ACCELERO)) {
+        acceleroGroup_->appendColumns(batch.timestamps, batch.accelero);
+    }
+    if (batch.hasChannels(SensorDataBatch::GYRO)) {
+        gyroGroup_->appendColumns(batch.timestamps, batch.gyro);
+    }
+    if (batch.hasChannels(SensorDataBatch::MAGNETO)) {
+        magnetoGroup_->appendColumns(batch.timestamps, batch.magneto);
+    }
 }
 
 void ChartWidget::initDisplayModeButtons()
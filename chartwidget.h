@@ -9,8 +9,12 @@
 #include <CsvSensorDataDAO.h>
 #include <DynamicSetting.h>
 #include <QPushButton>
+#include <QFileSystemWatcher>
+#include <QTimer>
 #include <RangeSlider.h>
 #include "dynamicplotsgroup.h"
+#include "latencyhistogram.h"
+#include "sampletiming.h"
 #include "OrientablePushButton.h"
 
 namespace Ui {
@@ -32,6 +36,8 @@ public:
     explicit ChartWidget(InsCommandProcessor *serial,
                          std::shared_ptr<DynamicSetting<int>> plotBufferSize,
                          std::shared_ptr<DynamicSetting<int>> plotSize, 
+                         std::shared_ptr<DynamicSetting<int>> plotHistoryMemory,
+                         std::shared_ptr<DynamicSetting<int>> sensorNominalRate,
                          FileStorageManager *storageManager,
                          QWidget *parent = nullptr);
     ~ChartWidget();
@@ -39,19 +45,39 @@ public:
     void onPageHide() override;
     void onPageShow(Page page) override;
 
+    // Запуск и остановка приема без кнопок, для режима замера
+    void startLive();
+    void stopLive();
+    // Задержка от чтения кадра из порта до его отрисовки на графиках
+    const LatencyHistogram &getPixelLatency() const;
+    void resetPixelLatency();
+
 private:
     void clearGraphs();
     void updateGraphs(const SensorData &data, const QDateTime &timstamp);
+    template<typename T>
+    void addGroupPoint(DynamicPlotsGroup *group, const QDateTime &timestamp, const std::array<T, SensorData::AXES> &values);
     void setMode(WidgetMode mode);
+    void showLoadedFile();
+    void appendBatch(const SensorDataBatch &batch);
+    void startExport(const QString &defaultSuffix);
+    QVector<SensorDataBatch> liveSnapshot() const;
+    void updateFollowWatcher();
+    void updateHistoryRange();
+    void updateIngestMetrics();
+    QString diagnosticsText() const;
 
     void initUartWidget();
     void initRangeSlider();
     void initSplitter();
     void initToggleUartButton();
     void initStartToggleButton();
-    void initCharts(std::shared_ptr<DynamicSetting<int>> plotBufferSize, std::shared_ptr<DynamicSetting<int>> plotSize);
+    void initCharts(std::shared_ptr<DynamicSetting<int>> plotBufferSize,
+                    std::shared_ptr<DynamicSetting<int>> plotSize,
+                    std::shared_ptr<DynamicSetting<int>> plotHistoryMemory);
     void initStorageButtons();
     void initDisplayModeButtons();
+    void initDiagnostics();
 
 private slots:
     void showData();
@@ -60,8 +86,17 @@ private slots:
     void toggleUartWidget();
     void saveToFile();
     void loadFromFile();
+    void openCatalog();
+    void exportToArrow();
+    void toggleFollow(bool enabled);
+    void readAppendedData();
     void onUartConnectionChanged(bool connected);
     void loadDataForPeriod(const QDateTime &start, const QDateTime &end);
+    void onRangeChanged(const QDateTime &start, const QDateTime &end);
+    void updateDiagnostics();
+    void toggleDiagnostics(bool visible);
+    void dumpDiagnostics();
+    void toggleTrace(bool enabled);
 
 private:
     InsCommandProcessor *processor;
@@ -72,10 +107,27 @@ private:
     Ui::ChartWidget *ui;
 
     RangeSlider *rangeSlider;
+    // Уведомления об изменении файла приходят на каждую запись, поэтому
+    // чтение новых строк откладывается на FOLLOW_DELAY_MS и объединяет их
+    static constexpr int FOLLOW_DELAY_MS = 100;
+    QFileSystemWatcher *recordingWatcher;
+    QTimer *followTimer;
+    static constexpr int DIAGNOSTICS_INTERVAL_MS = 1000;
+    QTimer *diagnosticsTimer;
     bool isFileLoaded;
     QDateTime minTimestamp;
     QDateTime maxTimestamp;
 
+    // Время отсчетов восстанавливается по счетчику кадров, а не по моменту прихода
+    SampleTimingModel sampleTiming;
+    std::shared_ptr<DynamicSetting<int>> sensorNominalRate;
+    LatencyHistogram pixelLatency;
+    // Значения точки группы; вектор переиспользуется, чтобы живой путь не выделял память
+    std::vector<double> pointValues;
+    static constexpr qint64 LABELS_INTERVAL_NS = 250000000;
+    qint64 lastLabelsUpdateNs = 0;
+    uint8_t lastDataSendCount = 0;
+
     DynamicPlotsGroup *envGroup_;
     DynamicPlotsGroup *acceleroGroup_;
     DynamicPlotsGroup *gyroGroup_;
@@ -90,7 +142,7 @@ private:
     OrientablePushButton* separatePlotsButton_ = nullptr;
     OrientablePushButton* combinedPlotButton_ = nullptr;
     OrientablePushButton* tableViewButton_ = nullptr;
-    ChartWidget::WidgetMode mode;
+    ChartWidget::WidgetMode mode = ChartWidget::WidgetMode::UART;
 };
 
 #endif // CHARTWIDGET_H
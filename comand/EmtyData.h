@@ -1,7 +1,7 @@
 #ifndef EMTYDATA_H
 #define EMTYDATA_H
 
-#include "bytearrayconvertible.h"
+#include "ByteArrayConvertible.h"
 
 class EmptyData : public ByteArrayConvertible
 {
@@ -4,11 +4,31 @@
 #include <QByteArray>
 #include <QList>
 #include <QDebug>
-#include "bytearrayconvertible.h"
-
+#include <array>
+#include <cstring>
+#include <type_traits>
+#include "ByteArrayConvertible.h"
+#include "channelschema.h"
+
+// Измерения хранятся в массивах фиксированного размера: декодирование кадра и копирование
+// объекта не выделяют память. Методы с QList собирают список по запросу - для хранилища и файлов.
 class SensorData : public ByteArrayConvertible
 {
 public:
+    static constexpr int AXES = ChannelSchema::AXES;
+
+    // Группы измерений, присутствующие в объекте
+    enum Channels {
+        ENV = 0x01,
+        GYRO = 0x02,
+        ACCELERO = 0x04,
+        MAGNETO = 0x08,
+        ALL = ENV | GYRO | ACCELERO | MAGNETO
+    };
+
+    using EnvValues = std::array<ChannelSchema::GroupValueType<ChannelSchema::ENV_GROUP>, AXES>;
+    using AxisValues = std::array<int16_t, AXES>;
+
     // Конструктор по умолчанию
     SensorData() {}
 
@@ -20,107 +40,158 @@ public:
 
     // Конструктор, принимающий все приватные переменные
     SensorData(const QList<float> &envMeasures, const QList<int16_t> &gyroMeasures, const QList<int16_t> &acceleroMeasures, const QList<int16_t> &magnetoMeasures)
-        : envMeasures_(envMeasures), gyroMeasures_(gyroMeasures), acceleroMeasures_(acceleroMeasures) , magnetoMeasures_(magnetoMeasures){}
+    {
+        setEnvironmentalMeasures(envMeasures);
+        setGyroMeasures(gyroMeasures);
+        setAcceleroMeasures(acceleroMeasures);
+        setMagnetoMeasures(magnetoMeasures);
+    }
 
     SensorData(const QList<float> &envMeasures, const QList<int16_t> &gyroMeasures, const QList<int16_t> &acceleroMeasures, const QList<int16_t> &magnetoMeasures, uint8_t dataSendCount)
-        : envMeasures_(envMeasures), gyroMeasures_(gyroMeasures), acceleroMeasures_(acceleroMeasures) , magnetoMeasures_(magnetoMeasures){
+        : SensorData(envMeasures, gyroMeasures, acceleroMeasures, magnetoMeasures) {
         this->dataSendCount = dataSendCount;
     }
 
     void fromBytes(const QByteArray &data) override
     {
-        if (data.size() < sizeof(float) * 3 + sizeof(int16_t) * 3 * 3) {
+        fromRaw(data.constData(), data.size());
+    }
+
+    void fromRaw(const char *data, int size) override
+    {
+        if (size < ChannelSchema::MEASURES_BYTES) {
             qDebug() << "Data size is too small for SensorData";
             return;
         }
 
-        int index = 0;
+        // Смещения, типы и масштаб каналов берутся из ChannelSchema при компиляции
+        ChannelSchema::forEachChannel([&](auto channel) {
+            constexpr int index = decltype(channel)::value;
+            constexpr ChannelSchema::Channel descriptor = ChannelSchema::CHANNELS[index];
+            groupOf<descriptor.group>(*this)[descriptor.axis] = ChannelSchema::decode<index>(data);
+        });
 
-        // Извлечение данных среды
-        envMeasures_.clear();
-        for (int i = 0; i < 3; ++i) {
-            float measure;
-            std::memcpy(&measure, data.constData() + index, sizeof(float));
-            envMeasures_.append(measure);
-            index += sizeof(float);
-        }
+        channels_ = ALL;
+        this->dataSendCount = data[size - 1];
+    }
 
-        // Извлечение данных гироскопа
-        gyroMeasures_.clear();
-        for (int i = 0; i < 3; ++i) {
-            int16_t measure;
-            std::memcpy(&measure, data.constData() + index, sizeof(int16_t));
-            gyroMeasures_.append(measure * GYRO_MULTIPLIER);
-            index += sizeof(int16_t);
-        }
+    bool hasChannels(int mask) const {
+        return (channels_ & mask) == mask;
+    }
 
-        // Извлечение данных акселерометра
-        acceleroMeasures_.clear();
-        for (int i = 0; i < 3; ++i) {
-            int16_t measure;
-            std::memcpy(&measure, data.constData() + index, sizeof(int16_t));
-            acceleroMeasures_.append(measure);
-            index += sizeof(int16_t);
-        }
+    // Доступ без выделения памяти; значения отсутствующей группы - нули
+    const EnvValues &environmental() const {
+        return envMeasures_;
+    }
 
-        magnetoMeasures_.clear();
-        for (int i = 0; i < 3; ++i) {
-            int16_t measure;
-            std::memcpy(&measure, data.constData() + index, sizeof(int16_t));
-            magnetoMeasures_.append(measure);
-            index += sizeof(int16_t);
-        }
+    const AxisValues &gyro() const {
+        return gyroMeasures_;
+    }
 
-        this->dataSendCount = data.at(data.size() - 1);
+    const AxisValues &accelero() const {
+        return acceleroMeasures_;
+    }
+
+    const AxisValues &magneto() const {
+        return magnetoMeasures_;
+    }
+
+    // Массив группы по номеру ChannelSchema::GroupIndex
+    template<int Group>
+    const auto &groupValues() const {
+        return groupOf<Group>(*this);
     }
 
     QList<float> getEnvironmentalMeasures() const
     {
-        return envMeasures_;
+        return toList(envMeasures_, ENV);
     }
 
     QList<int16_t> getGyroMeasures() const
     {
-        return gyroMeasures_;
+        return toList(gyroMeasures_, GYRO);
     }
 
     QList<int16_t> getAcceleroMeasures() const
     {
-        return acceleroMeasures_;
+        return toList(acceleroMeasures_, ACCELERO);
     }
 
     QList<int16_t> getMagnetoMeasures() const
     {
-        return magnetoMeasures_;
+        return toList(magnetoMeasures_, MAGNETO);
     }
 
     uint8_t getDataSendCount() const {
         return dataSendCount;
     }
 
+    // Пустой список убирает группу, недостающие значения заполняются нулями
     void setEnvironmentalMeasures(const QList<float> &measures) {
-        envMeasures_ = measures;
+        fromList(envMeasures_, measures, ENV);
     }
 
     void setGyroMeasures(const QList<int16_t> &measures) {
-        gyroMeasures_ = measures;
+        fromList(gyroMeasures_, measures, GYRO);
     }
 
     void setAcceleroMeasures(const QList<int16_t> &measures) {
-        acceleroMeasures_ = measures;
+        fromList(acceleroMeasures_, measures, ACCELERO);
     }
 
     void setMagnetoMeasures(const QList<int16_t> &measures) {
-        magnetoMeasures_ = measures;
+        fromList(magnetoMeasures_, measures, MAGNETO);
     }
 
 private:
-    float GYRO_MULTIPLIER = 0.001;
-    QList<float> envMeasures_;
-    QList<int16_t> gyroMeasures_;
-    QList<int16_t> acceleroMeasures_;
-    QList<int16_t> magnetoMeasures_;
+    template<int Group, typename Self>
+    static auto &groupOf(Self &self) {
+        if constexpr (Group == ChannelSchema::ENV_GROUP) {
+            return self.envMeasures_;
+        } else if constexpr (Group == ChannelSchema::GYRO_GROUP) {
+            return self.gyroMeasures_;
+        } else if constexpr (Group == ChannelSchema::ACCELERO_GROUP) {
+            return self.acceleroMeasures_;
+        } else {
+            return self.magnetoMeasures_;
+        }
+    }
+
+    template<typename T>
+    QList<T> toList(const std::array<T, AXES> &values, int mask) const {
+        QList<T> list;
+        if (hasChannels(mask)) {
+            for (const T &value : values) {
+                list.append(value);
+            }
+        }
+        return list;
+    }
+
+    template<typename T>
+    void fromList(std::array<T, AXES> &values, const QList<T> &measures, int mask) {
+        for (int i = 0; i < AXES; ++i) {
+            values[i] = i < measures.size() ? measures[i] : T();
+        }
+        channels_ = measures.isEmpty() ? channels_ & ~mask : channels_ | mask;
+    }
+
+    EnvValues envMeasures_{};
+    AxisValues gyroMeasures_{};
+    AxisValues acceleroMeasures_{};
+    AxisValues magnetoMeasures_{};
+    int channels_ = 0;
     uint8_t dataSendCount = 0;
+
+    static_assert(std::is_same<AxisValues::value_type, ChannelSchema::GroupValueType<ChannelSchema::GYRO_GROUP>>::value
+                  && std::is_same<AxisValues::value_type, ChannelSchema::GroupValueType<ChannelSchema::ACCELERO_GROUP>>::value
+                  && std::is_same<AxisValues::value_type, ChannelSchema::GroupValueType<ChannelSchema::MAGNETO_GROUP>>::value,
+                  "группы осей хранятся в AxisValues");
+    static_assert(ChannelSchema::GROUPS[ChannelSchema::ENV_GROUP].mask == ENV
+                  && ChannelSchema::GROUPS[ChannelSchema::GYRO_GROUP].mask == GYRO
+                  && ChannelSchema::GROUPS[ChannelSchema::ACCELERO_GROUP].mask == ACCELERO
+                  && ChannelSchema::GROUPS[ChannelSchema::MAGNETO_GROUP].mask == MAGNETO,
+                  "маски групп SensorData и ChannelSchema расходятся");
 };
 
 #endif // SENSORDATA_H
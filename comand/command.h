@@ -1,7 +1,7 @@
 #ifndef COMMAND_H
 #define COMMAND_H
 
-#include "bytearrayconvertible.h"
+#include "ByteArrayConvertible.h"
 #include <QByteArray>
 #include <QDataStream>
 #include <QIODevice>
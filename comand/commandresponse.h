@@ -1,7 +1,7 @@
 #ifndef COMMANDRESPONSE_H
 #define COMMANDRESPONSE_H
 
-#include "bytearrayconvertible.h"
+#include "ByteArrayConvertible.h"
 
 #include <QByteArray>
 #include <QString>
@@ -30,7 +30,7 @@ public:
     QString getError() const;
 
 private:
-    uint8_t calculateCRC(const QByteArray &data) const;
+    uint8_t calculateCRC(const char *data, int size) const;
 
     ResponseType responseType_;
     T messageBody_;
@@ -65,9 +65,9 @@ CommandResponse<T>::CommandResponse(const QByteArray &data)
         return;
     }
 
-    QByteArray messageBodyData = data.mid(3, messageLength);
+    // Тело и CRC читаются прямо из data, без копий
     uint8_t receivedCRC = static_cast<uint8_t>(data.at(3 + messageLength));
-    uint8_t calculatedCRC = calculateCRC(data.left(3 + messageLength));
+    uint8_t calculatedCRC = calculateCRC(data.constData(), 3 + messageLength);
 
     if (receivedCRC != calculatedCRC) {
         responseType_ = CRC_FAIL;
@@ -77,9 +77,7 @@ CommandResponse<T>::CommandResponse(const QByteArray &data)
 
     responseType_ = static_cast<ResponseType>(responseType);
 
-    // Предположим, у T есть метод fromBytes, который получает T из QByteArray.
-    // Если это не так, вам нужно будет изменить реализацию в соответствии с вашим требованием.
-    messageBody_.fromBytes(messageBodyData);
+    messageBody_.fromRaw(data.constData() + 3, messageLength);
     error_.clear(); // Очистка сообщения об ошибке, если ошибок нет
 }
 
@@ -106,12 +104,12 @@ QString CommandResponse<T>::getError() const
 
 // Вычисляет CRC для данных
 template<typename T>
-uint8_t CommandResponse<T>::calculateCRC(const QByteArray &data) const
+uint8_t CommandResponse<T>::calculateCRC(const char *data, int size) const
 {
     uint8_t polynomial = 0x07;
     uint8_t crc = 0x00;
 
-    for (size_t i = 0; i < data.size(); i++) {
+    for (int i = 0; i < size; i++) {
         crc ^= data[i];
         for (uint8_t j = 0; j < 8; j++) {
             if (crc & 0x80) {
@@ -0,0 +1,19 @@
+#ifndef CRC8_H
+#define CRC8_H
+
+#include <cstdint>
+
+// CRC-8 кадра устройства: полином 0x07, начальное значение 0, по заголовку и телу
+inline uint8_t crc8(const char *data, int size)
+{
+    uint8_t crc = 0x00;
+    for (int i = 0; i < size; ++i) {
+        crc ^= static_cast<uint8_t>(data[i]);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+#endif // CRC8_H
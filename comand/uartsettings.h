@@ -4,13 +4,14 @@
 #include "ByteArrayConvertible.h"
 #include <QByteArray>
 #include <QSerialPort>
+#include <QVector>
 #include <cstdint>
 #include <stdexcept>
 
 class UartSettings : public ByteArrayConvertible
 {
 public:
-    UartSettings(QSerialPort::BaudRate baudRate, QSerialPort::DataBits dataBits, QSerialPort::Parity parity, QSerialPort::FlowControl flowControl, QSerialPort::StopBits stopBits)
+    UartSettings(qint32 baudRate, QSerialPort::DataBits dataBits, QSerialPort::Parity parity, QSerialPort::FlowControl flowControl, QSerialPort::StopBits stopBits)
         : baudRate_(baudRate), dataBits_(dataBits), parity_(parity), flowControl_(flowControl), stopBits_(stopBits) {}
 
     virtual QByteArray toBytes() const override {
@@ -30,23 +31,65 @@ public:
         return result;
     }
 
+    // Скорости, которые можно передать устройству командой ReconfigureUart, по возрастанию
+    static QVector<qint32> deviceBaudRates() {
+        QVector<qint32> rates;
+        for (const BaudRateCode &entry : BAUD_RATE_CODES) {
+            rates.append(entry.baudRate);
+        }
+        return rates;
+    }
+
+    static bool isDeviceBaudRate(qint32 baudRate) {
+        return deviceBaudRates().contains(baudRate);
+    }
+
+    // Скорость по коду из тела команды, 0 - неизвестный код
+    static qint32 baudRateFromCode(uint8_t code) {
+        for (const BaudRateCode &entry : BAUD_RATE_CODES) {
+            if (entry.code == code) {
+                return entry.baudRate;
+            }
+        }
+        return 0;
+    }
+
 private:
-    QSerialPort::BaudRate baudRate_;
+    struct BaudRateCode
+    {
+        qint32 baudRate;
+        uint8_t code;
+    };
+
+    // Коды 1-5 - исходный протокол, 6 и выше - расширение для скоростей выше 115200
+    static constexpr BaudRateCode BAUD_RATE_CODES[] = {
+        {9600, 1},
+        {19200, 2},
+        {38400, 3},
+        {57600, 4},
+        {115200, 5},
+        {230400, 6},
+        {460800, 7},
+        {921600, 8},
+        {1000000, 9},
+        {2000000, 10},
+        {3000000, 11},
+        {4000000, 12},
+    };
+
+    qint32 baudRate_;
     QSerialPort::DataBits dataBits_;
     QSerialPort::Parity parity_;
     QSerialPort::FlowControl flowControl_;
     QSerialPort::StopBits stopBits_;
 
-    uint8_t mapBaudRate(QSerialPort::BaudRate baudRate) const {
-        switch (baudRate) {
-        case QSerialPort::BaudRate::Baud9600: return 1;
-        case QSerialPort::BaudRate::Baud19200: return 2;
-        case QSerialPort::BaudRate::Baud38400: return 3;
-        case QSerialPort::BaudRate::Baud57600: return 4;
-        case QSerialPort::BaudRate::Baud115200: return 5;
-        default:
-            throw std::invalid_argument("Invalid DataBits value");
+    uint8_t mapBaudRate(qint32 baudRate) const {
+        for (const BaudRateCode &entry : BAUD_RATE_CODES) {
+            if (entry.baudRate == baudRate) {
+                return entry.code;
+            }
         }
+        throw std::invalid_argument("Invalid BaudRate value");
     }
 
     uint8_t mapDataBits(QSerialPort::DataBits dataBits) const {
@@ -3,13 +3,19 @@
 
 #include "isensordatadao.h"
 #include "comand/SensorData.h"
+#include "recordingdurability.h"
 #include <QFile>
 #include <QTextStream>
 #include <QDebug>
+#include <limits>
+#include <memory>
 #include <stdexcept> // Для std::runtime_error
 
 class CsvSensorDataDAO : public ISensorDataDAO {
 public:
+    // Сколько байт с конца файла просматривает восстановление
+    static constexpr qint64 RECOVERY_WINDOW = 64 * 1024;
+
     explicit CsvSensorDataDAO(
         const QString &filePath,
         bool envMeasuresEnabled = true,
@@ -52,156 +58,269 @@ public:
     }
 
     ~CsvSensorDataDAO() {
+        if (syncer) {
+            file.flush();
+            syncer->finish(file.handle());
+            syncer.reset();
+        }
         if (file.isOpen()) {
             file.close();
         }
     }
 
-    bool insertSensorData(const TimestampedSensorData &data) override {
-        if (!file.isOpen()) {
-            qDebug() << "File is not open:" << filePath;
-            return false;
+    // Включает периодический сброс записанных строк на диск
+    void setDurabilityPolicy(const DurabilityPolicy &policy) override {
+        if (syncer) {
+            file.flush();
+            syncer->finish(file.handle());
         }
+        syncer.reset(policy.isEnabled() ? new FileSyncer(policy) : nullptr);
+    }
 
-        // Перемещаем указатель в конец файла для записи новых данных
-        file.seek(file.size());
+    // Время последней строки, гарантированно сохраненной на диск
+    qint64 lastDurableTimestamp() const override {
+        return syncer ? syncer->lastDurableTimestamp() : std::numeric_limits<qint64>::min();
+    }
 
-        QTextStream out(&file);
-        out << data.getTimestamp().toMSecsSinceEpoch() << ","; // Записываем timestamp в формате epoch
+    void syncIfDue() override {
+        if (syncer && file.isOpen() && syncer->isDue()) {
+            file.flush();
+            syncer->requestSync(file.handle());
+        }
+    }
 
-        if (envMeasuresEnabled) {
-            out << QString::number(data.getEnvironmentalMeasures().at(0), 'f', envMeasuresPrecision) << ","
-                << QString::number(data.getEnvironmentalMeasures().at(1), 'f', envMeasuresPrecision) << ","
-                << QString::number(data.getEnvironmentalMeasures().at(2), 'f', envMeasuresPrecision) << ",";
+    // Восстановление после аварийного завершения записи: отбрасывается
+    // недописанная последняя строка и нули, которые файловая система могла
+    // оставить в конце файла. Проверяется только хвост файла.
+    static RecoveryReport recoverFile(const QString &filePath) {
+        RecoveryReport report;
+        QFile source(filePath);
+        if (!source.open(QIODevice::ReadWrite)) {
+            qDebug() << "Failed to open file for recovery:" << filePath;
+            return report;
         }
 
-        if (gyroMeasuresEnabled) {
-            out << data.getGyroMeasures().at(0) << ","
-                << data.getGyroMeasures().at(1) << ","
-                << data.getGyroMeasures().at(2) << ",";
+        const qint64 size = source.size();
+        const QByteArray header = source.readLine();
+        if (!header.endsWith('\n')) {
+            report.validBytes = size;
+            return report;
         }
+        const int columnCount = header.trimmed().split(',').size();
+
+        const qint64 dataStart = source.pos();
+        const qint64 windowStart = qMax(dataStart, size - RECOVERY_WINDOW);
+        source.seek(windowStart);
+        const QByteArray tail = source.read(size - windowStart);
+
+        // Индекс последнего перевода строки перед позицией before, либо -1
+        auto lastNewline = [&tail](int before) {
+            for (int i = before - 1; i >= 0; --i) {
+                if (tail[i] == '\n') {
+                    return i;
+                }
+            }
+            return -1;
+        };
 
-        if (acceleroMeasuresEnabled) {
-            out << data.getAcceleroMeasures().at(0) << ","
-                << data.getAcceleroMeasures().at(1) << ","
-                << data.getAcceleroMeasures().at(2) << ",";
+        int end = tail.size();
+        while (end > 0 && tail[end - 1] == '\0') {
+            --end;
         }
+        end = lastNewline(end) + 1;
+
+        // Строки с неверным числом полей или временем тоже отбрасываются с конца
+        while (end > 0) {
+            const int lineStart = lastNewline(end - 1) + 1;
+            if (lineStart == 0 && windowStart > dataStart) {
+                // Начало строки за пределами окна: проверить ее нельзя, оставляем как есть
+                break;
+            }
 
-        if (magnetoMeasuresEnabled) {
-            out << data.getMagnetoMeasures().at(0) << ","
-                << data.getMagnetoMeasures().at(1) << ","
-                << data.getMagnetoMeasures().at(2);
+            QList<QByteArray> fields = tail.mid(lineStart, end - lineStart).trimmed().split(',');
+            if (!fields.isEmpty() && fields.last().isEmpty()) {
+                fields.removeLast();
+            }
+            bool ok = false;
+            const qint64 timestamp = fields.first().toLongLong(&ok);
+            if (ok && fields.size() == columnCount) {
+                report.lastTimestampNs = timestamp * SensorDataBatch::NANOS_IN_MSEC;
+                break;
+            }
+            end = lineStart;
         }
 
-        out << "\n";
-        return true;
+        report.validBytes = windowStart + end;
+        report.truncatedBytes = size - report.validBytes;
+        if (report.truncatedBytes > 0) {
+            qDebug() << "Truncating" << report.truncatedBytes << "bytes of torn data in" << filePath;
+            source.resize(report.validBytes);
+        }
+        return report;
     }
 
-    QList<TimestampedSensorData> selectSensorData(const QDateTime &start, const QDateTime &end) override {
-        QList<TimestampedSensorData> dataList;
+    bool insertSensorData(const TimestampedSensorData &data) override {
         if (!file.isOpen()) {
             qDebug() << "File is not open:" << filePath;
-            return dataList;
+            return false;
         }
 
-        // Перемещаем указатель в начало файла для чтения
-        file.seek(0);
-
-        QTextStream in(&file);
-        QString header = in.readLine(); // Читаем заголовок
-        QStringList columns = header.split(',');
-
-        while (!in.atEnd()) {
-            QString line = in.readLine();
-            QStringList fields = line.split(',');
-            if (!fields.isEmpty() && fields.last().isEmpty()) {
-                fields.removeLast();
-            }
+        // Перемещаем указатель в конец файла для записи новых данных
+        const qint64 rowStart = file.size();
+        file.seek(rowStart);
 
-            if (fields.size() == columns.size()) {
-                qint64 epochTime = fields[0].toLongLong(); // Считываем timestamp в формате epoch
-                QDateTime timestamp = QDateTime::fromMSecsSinceEpoch(epochTime); // Преобразуем в QDateTime
+        // Поток сбрасывается в файл при выходе из блока
+        {
+            QTextStream out(&file);
+            out << data.getTimestamp().toMSecsSinceEpoch() << ","; // Записываем timestamp в формате epoch
+
+            const bool enabled[ChannelSchema::GROUP_COUNT] = {
+                envMeasuresEnabled, gyroMeasuresEnabled, acceleroMeasuresEnabled, magnetoMeasuresEnabled
+            };
+            const int precision[ChannelSchema::GROUP_COUNT] = {
+                envMeasuresPrecision, gyroMeasuresPrecision, acceleroMeasuresPrecision, magnetoMeasuresPrecision
+            };
+            ChannelSchema::forEachChannel([&](auto channel) {
+                constexpr int index = decltype(channel)::value;
+                constexpr ChannelSchema::Channel descriptor = ChannelSchema::CHANNELS[index];
+                if (!enabled[descriptor.group]) {
+                    return;
+                }
+                const auto value = data.groupValues<descriptor.group>()[descriptor.axis];
+                if constexpr (descriptor.wire == ChannelSchema::WireType::Float32) {
+                    out << QString::number(value, 'f', precision[descriptor.group]);
+                } else {
+                    out << value;
+                }
+                // После последнего канала запятой нет, как и раньше
+                if (index + 1 < ChannelSchema::CHANNEL_COUNT) {
+                    out << ",";
+                }
+            });
 
-                if (timestamp >= start && timestamp <= end) {
-                    int index = 1;
-                    QList<float> envMeasures;
-                    if (columns.contains("temperature") && columns.contains("humidity") && columns.contains("pressure")) {
-                        envMeasures = {fields[index++].toFloat(), fields[index++].toFloat(), fields[index++].toFloat()};
-                    }
-                    QList<int16_t> gyroMeasures;
-                    if (columns.contains("gyro_x") && columns.contains("gyro_y") && columns.contains("gyro_z")) {
-                        gyroMeasures = {static_cast<int16_t>(fields[index++].toInt()), static_cast<int16_t>(fields[index++].toInt()), static_cast<int16_t>(fields[index++].toInt())};
-                    }
-                    QList<int16_t> acceleroMeasures;
-                    if (columns.contains("accelero_x") && columns.contains("accelero_y") && columns.contains("accelero_z")) {
-                        acceleroMeasures = {static_cast<int16_t>(fields[index++].toInt()), static_cast<int16_t>(fields[index++].toInt()), static_cast<int16_t>(fields[index++].toInt())};
-                    }
-                    QList<int16_t> magnetoMeasures;
-                    if (columns.contains("magneto_x") && columns.contains("magneto_y") && columns.contains("magneto_z")) {
-                        magnetoMeasures = {static_cast<int16_t>(fields[index++].toInt()), static_cast<int16_t>(fields[index++].toInt()), static_cast<int16_t>(fields[index++].toInt())};
-                    }
+            out << "\n";
+        }
 
-                    TimestampedSensorData data(envMeasures, gyroMeasures, acceleroMeasures, magnetoMeasures, timestamp);
-                    dataList.append(data);
-                }
+        if (syncer) {
+            syncer->written(file.pos() - rowStart, SensorDataBatch::toNanos(data.getTimestamp()));
+            if (syncer->isDue()) {
+                file.flush();
+                syncer->requestSync(file.handle());
             }
         }
+        return true;
+    }
 
-        return dataList;
+    std::unique_ptr<ISensorDataCursor> selectSensorDataCursor(const QDateTime &start, const QDateTime &end,
+                                                              int batchSize = DEFAULT_BATCH_SIZE) override {
+        return openCursor(SensorDataBatch::toNanos(start), SensorDataBatch::toNanos(end), batchSize);
     }
 
-    QList<TimestampedSensorData> selectAllSensorData() override {
-        QList<TimestampedSensorData> dataList;
-        if (!file.isOpen()) {
-            qDebug() << "File is not open:" << filePath;
-            return dataList;
-        }
+    std::unique_ptr<ISensorDataCursor> selectAllSensorDataCursor(int batchSize = DEFAULT_BATCH_SIZE) override {
+        return openCursor(std::numeric_limits<qint64>::min(), std::numeric_limits<qint64>::max(), batchSize);
+    }
 
-        // Перемещаем указатель в начало файла для чтения
-        file.seek(0);
+    std::unique_ptr<ISensorDataCursor> selectFollowCursor(int batchSize = DEFAULT_BATCH_SIZE) override {
+        return std::unique_ptr<ISensorDataCursor>(new Cursor(filePath, std::numeric_limits<qint64>::min(),
+                                                             std::numeric_limits<qint64>::max(), batchSize, true));
+    }
 
-        QTextStream in(&file);
-        QString header = in.readLine(); // Читаем заголовок
-        QStringList columns = header.split(',');
+private:
+    // Читает файл через собственный дескриптор, не сбивая позицию записи.
+    // Индексы колонок вычисляются один раз по заголовку.
+    class Cursor : public ISensorDataCursor {
+    public:
+        Cursor(const QString &filePath, qint64 startNs, qint64 endNs, int batchSize, bool follow = false)
+            : file_(filePath), startNs_(startNs), endNs_(endNs),
+              batchSize_(batchSize > 0 ? batchSize : DEFAULT_BATCH_SIZE), follow_(follow) {
+            if (!file_.open(QIODevice::ReadOnly)) {
+                qDebug() << "Failed to open file for reading:" << filePath;
+                return;
+            }
 
-        while (!in.atEnd()) {
-            QString line = in.readLine();
-            QStringList fields = line.split(',');
-            if (!fields.isEmpty() && fields.last().isEmpty()) {
-                fields.removeLast();
+            const QList<QByteArray> columns = file_.readLine().trimmed().split(',');
+            columnCount_ = columns.size();
+            for (int i = 0; i < ChannelSchema::CHANNEL_COUNT; ++i) {
+                channelIndex_[i] = columns.indexOf(QByteArray(ChannelSchema::CHANNELS[i].name));
             }
 
-            if (fields.size() == columns.size()) {
-                qint64 epochTime = fields[0].toLongLong(); // Считываем timestamp в формате epoch
-                QDateTime timestamp = QDateTime::fromMSecsSinceEpoch(epochTime); // Преобразуем в QDateTime
+            channels_ = 0;
+            for (int group = 0; group < ChannelSchema::GROUP_COUNT; ++group) {
+                bool present = true;
+                for (int axis = 0; axis < ChannelSchema::AXES; ++axis) {
+                    present = present && channelIndex_[group * ChannelSchema::AXES + axis] >= 0;
+                }
+                if (present) {
+                    channels_ |= ChannelSchema::GROUPS[group].mask;
+                }
+            }
+        }
 
-                int index = 1;
-                QList<float> envMeasures;
-                if (columns.contains("temperature") && columns.contains("humidity") && columns.contains("pressure")) {
-                    envMeasures = {fields[index++].toFloat(), fields[index++].toFloat(), fields[index++].toFloat()};
+        bool next(SensorDataBatch &batch) override {
+            batch.clear();
+            batch.channels = channels_;
+            if (!file_.isOpen()) {
+                return false;
+            }
+            batch.reserve(batchSize_);
+
+            QList<QByteArray> fields;
+            while (batch.size() < batchSize_ && (follow_ || !file_.atEnd())) {
+                const qint64 lineStart = file_.pos();
+                const QByteArray line = file_.readLine();
+                // Недописанная строка будет прочитана целиком при следующем вызове
+                if (follow_ && !line.endsWith('\n')) {
+                    file_.seek(lineStart);
+                    break;
                 }
-                QList<int16_t> gyroMeasures;
-                if (columns.contains("gyro_x") && columns.contains("gyro_y") && columns.contains("gyro_z")) {
-                    gyroMeasures = {static_cast<int16_t>(fields[index++].toInt()), static_cast<int16_t>(fields[index++].toInt()), static_cast<int16_t>(fields[index++].toInt())};
+
+                fields = line.trimmed().split(',');
+                if (!fields.isEmpty() && fields.last().isEmpty()) {
+                    fields.removeLast();
                 }
-                QList<int16_t> acceleroMeasures;
-                if (columns.contains("accelero_x") && columns.contains("accelero_y") && columns.contains("accelero_z")) {
-                    acceleroMeasures = {static_cast<int16_t>(fields[index++].toInt()), static_cast<int16_t>(fields[index++].toInt()), static_cast<int16_t>(fields[index++].toInt())};
+                if (fields.size() != columnCount_) {
+                    continue;
                 }
-                QList<int16_t> magnetoMeasures;
-                if (columns.contains("magneto_x") && columns.contains("magneto_y") && columns.contains("magneto_z")) {
-                    magnetoMeasures = {static_cast<int16_t>(fields[index++].toInt()), static_cast<int16_t>(fields[index++].toInt()), static_cast<int16_t>(fields[index++].toInt())};
+
+                // Timestamp записывается в миллисекундах с эпохи
+                const qint64 timestamp = fields[0].toLongLong() * SensorDataBatch::NANOS_IN_MSEC;
+                if (timestamp < startNs_ || timestamp > endNs_) {
+                    continue;
                 }
 
-                TimestampedSensorData data(envMeasures, gyroMeasures, acceleroMeasures, magnetoMeasures, timestamp);
-                dataList.append(data);
+                batch.timestamps.append(timestamp);
+                ChannelSchema::forEachChannel([&](auto channel) {
+                    constexpr int index = decltype(channel)::value;
+                    if (batch.hasChannels(ChannelSchema::GROUPS[ChannelSchema::CHANNELS[index].group].mask)) {
+                        batch.appendConverted<index>(fields[channelIndex_[index]]);
+                    }
+                });
             }
+
+            return !batch.isEmpty();
         }
 
-        return dataList;
+    private:
+        QFile file_;
+        qint64 startNs_;
+        qint64 endNs_;
+        int batchSize_;
+        bool follow_;
+        int columnCount_ = 0;
+        int channels_ = 0;
+        int channelIndex_[ChannelSchema::CHANNEL_COUNT];
+    };
+
+    std::unique_ptr<ISensorDataCursor> openCursor(qint64 startNs, qint64 endNs, int batchSize) {
+        if (!file.isOpen()) {
+            qDebug() << "File is not open:" << filePath;
+            return nullptr;
+        }
+        // Дописанные, но еще не сброшенные строки должны попасть в выборку
+        file.flush();
+        return std::unique_ptr<ISensorDataCursor>(new Cursor(filePath, startNs, endNs, batchSize));
     }
 
-private:
     QString filePath;
     QFile file;
     bool envMeasuresEnabled;
@@ -212,20 +331,17 @@ private:
     int gyroMeasuresPrecision;
     bool magnetoMeasuresEnabled;
     int magnetoMeasuresPrecision;
+    std::unique_ptr<FileSyncer> syncer;
 
     QString generateHeader() const {
+        const bool enabled[ChannelSchema::GROUP_COUNT] = {
+            envMeasuresEnabled, gyroMeasuresEnabled, acceleroMeasuresEnabled, magnetoMeasuresEnabled
+        };
         QStringList headers = {"timestamp"};
-        if (envMeasuresEnabled) {
-            headers << "temperature" << "humidity" << "pressure";
-        }
-        if (gyroMeasuresEnabled) {
-            headers << "gyro_x" << "gyro_y" << "gyro_z";
-        }
-        if (acceleroMeasuresEnabled) {
-            headers << "accelero_x" << "accelero_y" << "accelero_z";
-        }
-        if (magnetoMeasuresEnabled) {
-            headers << "magneto_x" << "magneto_y" << "magneto_z";
+        for (const ChannelSchema::Channel &channel : ChannelSchema::CHANNELS) {
+            if (enabled[channel.group]) {
+                headers << QString::fromLatin1(channel.name);
+            }
         }
         return headers.join(',');
     }
@@ -234,9 +350,8 @@ private:
         if (!columns.contains("timestamp")) {
             return false;
         }
-        QStringList validHeaders = {"timestamp", "temperature", "humidity", "pressure", "gyro_x", "gyro_y", "gyro_z", "accelero_x", "accelero_y", "accelero_z", "magneto_x", "magneto_y", "magneto_z"};
         for (const QString &column : columns) {
-            if (!validHeaders.contains(column)) {
+            if (column != "timestamp" && !SensorDataBatch::CHANNEL_NAMES.contains(column)) {
                 return false;
             }
         }
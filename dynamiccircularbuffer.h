@@ -3,6 +3,8 @@
 
 #include <QByteArray>
 #include <QDebug>
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
 class DynamicCircularBuffer {
@@ -20,30 +22,52 @@ public:
         }
 
         // Insert new data
-        for (int i = 0; i < dataSize; ++i) {
-            m_buffer[(m_start + m_size) % m_capacity] = data[i];
-            ++m_size;
-        }
+        const int tail = (m_start + m_size) % m_capacity;
+        const int first = std::min(dataSize, m_capacity - tail);
+        std::memcpy(m_buffer.data() + tail, data.constData(), first);
+        std::memcpy(m_buffer.data(), data.constData() + first, dataSize - first);
+        m_size += dataSize;
     }
 
     QByteArray read(int bytes) const {
+        QByteArray result(bytes, Qt::Uninitialized);
+        read(result.data(), bytes);
+        return result;
+    }
+
+    // Копирует bytes байт от начала в out без выделения памяти
+    void read(char *out, int bytes) const {
         if (bytes > m_size) {
             throw std::out_of_range("Requested more bytes than available in buffer.");
         }
 
-        QByteArray result;
-        result.reserve(bytes);
-        for (int i = 0; i < bytes; ++i) {
-            result.append(m_buffer[(m_start + i) % m_capacity]);
-        }
-        return result;
+        const int first = std::min(bytes, m_capacity - m_start);
+        std::memcpy(out, m_buffer.constData() + m_start, first);
+        std::memcpy(out + first, m_buffer.constData(), bytes - first);
+    }
+
+    // Байт по смещению от начала, без проверки границ
+    char at(int index) const {
+        return m_buffer.at((m_start + index) % m_capacity);
     }
 
     QByteArray pop(int bytes) {
         QByteArray result = read(bytes);
+        discard(bytes);
+        return result;
+    }
+
+    void pop(char *out, int bytes) {
+        read(out, bytes);
+        discard(bytes);
+    }
+
+    void discard(int bytes) {
+        if (bytes > m_size) {
+            throw std::out_of_range("Requested more bytes than available in buffer.");
+        }
         m_start = (m_start + bytes) % m_capacity;
         m_size -= bytes;
-        return result;
     }
 
     QByteArray toByteArray() const {
@@ -1,4 +1,6 @@
 #include "dynamicplot.h"
+#include "pipelinediagnostics.h"
+#include "tracer.h"
 #include <QVBoxLayout>
 #include <QSharedPointer>
 #include <QDateTime>
@@ -9,6 +11,7 @@ DynamicPlot::DynamicPlot(QWidget *parent,
                         DynamicPlotBuffer* buffer)
     : QWidget(parent)
     , buffer_(buffer)
+    , diagnosticsId_(PipelineDiagnostics::instance().registerPlot("График"))
 {
     customPlot_ = new QCustomPlot(this);
 
@@ -59,6 +62,7 @@ void DynamicPlot::setLabel(const QString &title) {
     customPlot_->plotLayout()->addElement(0, 0, titleElement);
 
     customPlot_->yAxis->setLabel(title);
+    PipelineDiagnostics::instance().renamePlot(diagnosticsId_, title);
 }
 
 void DynamicPlot::addPoint(const QDateTime& time, double value)
@@ -76,33 +80,6 @@ void DynamicPlot::addPoint(const QDateTime& time, double value)
     }
 }
 
-void DynamicPlot::plotSensorData(
-    const QList<TimestampedSensorData> &dataList,
-    std::function<double(const TimestampedSensorData&)> valueExtractor,
-    std::function<bool(const TimestampedSensorData&)> shouldPlot)
-{
-    QVector<double> timeData;
-    QVector<double> valueData;
-
-    for (const auto &data : dataList) {
-        if (!shouldPlot(data)) {
-            continue;
-        }
-        double key = data.getTimestamp().toMSecsSinceEpoch() / 1000.0;
-        double value = valueExtractor(data);
-        timeData.append(key);
-        valueData.append(value);
-    }
-
-    graph_->setData(timeData, valueData);
-    graph_->setLineStyle(QCPGraph::lsLine);
-    if (!timeData.isEmpty()) {
-        customPlot_->xAxis->setRange(timeData.first(), timeData.last());
-    }
-    customPlot_->rescaleAxes(true);
-    customPlot_->replot();
-}
-
 QList<QPair<QDateTime, double>> DynamicPlot::getData()
 {
     QList<QPair<QDateTime, double>> dataList;
@@ -129,6 +106,8 @@ void DynamicPlot::update()
         return;
     }
 
+    TraceSpan span("plot update");
+    const qint64 startNs = MonotonicClock::nowNs();
     QVector<double> timeData = buffer_->getVisibleTimeData();
     QVector<double> valueData = buffer_->getVisibleData();
     
@@ -137,7 +116,11 @@ void DynamicPlot::update()
         customPlot_->xAxis->setRange(timeData.first(), timeData.last());
     }
     customPlot_->rescaleAxes(true);
-    customPlot_->replot();
+    {
+        TraceSpan replotSpan("replot");
+        customPlot_->replot();
+    }
+    PipelineDiagnostics::instance().recordRender(diagnosticsId_, MonotonicClock::nowNs() - startNs);
 }
 
 bool DynamicPlot::eventFilter(QObject *obj, QEvent *event)
@@ -24,10 +24,6 @@ public:
     void setLabel(const QString &title);
     void setPlotSize(std::shared_ptr<DynamicSetting<int>> plotWidth);
     void clear();
-    void plotSensorData(
-        const QList<TimestampedSensorData> &dataList,
-        std::function<double(const TimestampedSensorData&)> valueExtractor,
-        std::function<bool(const TimestampedSensorData&)> shouldPlot = [](const TimestampedSensorData&) { return true; });
     QList<QPair<QDateTime, double>> getData();
     void update();
 
@@ -41,6 +37,8 @@ private:
 
     DynamicPlotBuffer* buffer_;
     std::shared_ptr<DynamicSetting<int>> plotSize;
+    // Номер в PipelineDiagnostics для времени отрисовки
+    int diagnosticsId_;
 
     bool shouldHandleWheelEvent(QWheelEvent *event) const;
     QScrollArea* findParentScrollArea() const;
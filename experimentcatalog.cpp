@@ -0,0 +1,248 @@
+#include "experimentcatalog.h"
+#include "storagemanager.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QHash>
+#include <QDebug>
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+ExperimentCatalog::ExperimentCatalog(const QString &directory)
+    : directory_(directory)
+{
+}
+
+const QStringList &ExperimentCatalog::recordingPatterns() {
+    static const QStringList patterns = {"*.csv", "*.insr", "*.db", "*.arrow", "*.feather", "*.session"};
+    return patterns;
+}
+
+int ExperimentCatalog::refresh(const ProgressCallback &progress) {
+    if (!indexLoaded_) {
+        loadIndex();
+        indexLoaded_ = true;
+    }
+
+    QHash<QString, ExperimentInfo> cached;
+    for (const ExperimentInfo &info : entries_) {
+        cached.insert(info.fileName, info);
+    }
+
+    const QFileInfoList files = QDir(directory_).entryInfoList(recordingPatterns(), QDir::Files, QDir::Name);
+    QVector<ExperimentInfo> updated;
+    updated.reserve(files.size());
+    int rescanned = 0;
+    bool cancelled = false;
+
+    for (int i = 0; i < files.size(); ++i) {
+        const QFileInfo &file = files[i];
+        const qint64 modifiedMs = file.lastModified().toMSecsSinceEpoch();
+
+        auto it = cached.constFind(file.fileName());
+        if (it != cached.constEnd() && it->fileSize == file.size() && it->modifiedMs == modifiedMs) {
+            updated.append(*it);
+            continue;
+        }
+
+        // После отмены новые файлы не читаются, но устаревшие записи индекса сохраняются
+        if (cancelled || (progress && !progress(i, files.size()))) {
+            cancelled = true;
+            if (it != cached.constEnd()) {
+                updated.append(*it);
+            }
+            continue;
+        }
+
+        ExperimentInfo info = scanFile(file.absoluteFilePath());
+        info.fileSize = file.size();
+        info.modifiedMs = modifiedMs;
+        updated.append(info);
+        ++rescanned;
+    }
+
+    if (progress && !cancelled) {
+        progress(files.size(), files.size());
+    }
+
+    entries_ = updated;
+    if (rescanned > 0 || entries_.size() != cached.size()) {
+        saveIndex();
+    }
+    return rescanned;
+}
+
+const QVector<ExperimentInfo> &ExperimentCatalog::entries() const {
+    return entries_;
+}
+
+QString ExperimentCatalog::directory() const {
+    return directory_;
+}
+
+QString ExperimentCatalog::filePath(const ExperimentInfo &info) const {
+    return QDir(directory_).filePath(info.fileName);
+}
+
+ExperimentInfo ExperimentCatalog::scanFile(const QString &filePath) {
+    ExperimentInfo info;
+    info.fileName = QFileInfo(filePath).fileName();
+
+    std::unique_ptr<ISensorDataDAO> dao;
+    try {
+        dao.reset(FileStorageManager::createReadDao(filePath));
+    } catch (const std::exception &e) {
+        qDebug() << "Failed to open recording for catalog:" << filePath << e.what();
+        return info;
+    }
+
+    std::unique_ptr<ISensorDataCursor> cursor = dao->selectAllSensorDataCursor();
+    if (!cursor) {
+        return info;
+    }
+
+    // Среднее и дисперсия считаются за один проход по алгоритму Уэлфорда
+    std::array<double, ChannelSchema::CHANNEL_COUNT> sumSquares = {};
+    for (ChannelStats &stats : info.stats) {
+        stats.min = std::numeric_limits<double>::max();
+        stats.max = std::numeric_limits<double>::lowest();
+    }
+
+    auto accumulate = [&info, &sumSquares](int channel, double value) {
+        ChannelStats &stats = info.stats[channel];
+        stats.min = std::min(stats.min, value);
+        stats.max = std::max(stats.max, value);
+        const double delta = value - stats.mean;
+        stats.mean += delta / info.rowCount;
+        sumSquares[channel] += delta * (value - stats.mean);
+    };
+
+    info.startNs = std::numeric_limits<qint64>::max();
+    info.endNs = std::numeric_limits<qint64>::min();
+    info.channels = SensorDataBatch::ALL;
+
+    SensorDataBatch batch;
+    while (cursor->next(batch)) {
+        info.channels &= batch.channels;
+        for (int row = 0; row < batch.size(); ++row) {
+            ++info.rowCount;
+            info.startNs = std::min(info.startNs, batch.timestamps[row]);
+            info.endNs = std::max(info.endNs, batch.timestamps[row]);
+            ChannelSchema::forEachChannel([&](auto channel) {
+                constexpr int index = decltype(channel)::value;
+                if (batch.hasChannel<index>()) {
+                    accumulate(index, batch.column<index>()[row]);
+                }
+            });
+        }
+    }
+
+    info.readable = true;
+    if (info.rowCount == 0) {
+        info.startNs = 0;
+        info.endNs = 0;
+        info.channels = 0;
+        info.stats = {};
+        return info;
+    }
+
+    for (int channel = 0; channel < ChannelSchema::CHANNEL_COUNT; ++channel) {
+        if (!(info.channels & ChannelSchema::GROUPS[ChannelSchema::CHANNELS[channel].group].mask)) {
+            info.stats[channel] = ChannelStats();
+            continue;
+        }
+        info.stats[channel].stddev = std::sqrt(sumSquares[channel] / info.rowCount);
+    }
+
+    if (info.rowCount > 1 && info.endNs > info.startNs) {
+        info.sampleRate = (info.rowCount - 1) / info.durationSeconds();
+    }
+    return info;
+}
+
+void ExperimentCatalog::loadIndex() {
+    entries_.clear();
+
+    QFile file(QDir(directory_).filePath(INDEX_FILE_NAME));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root.value("version").toInt() != INDEX_VERSION) {
+        // Индекс другой версии просто строится заново
+        return;
+    }
+
+    for (const QJsonValue &value : root.value("files").toArray()) {
+        entries_.append(fromJson(value.toObject()));
+    }
+}
+
+bool ExperimentCatalog::saveIndex() const {
+    QJsonArray files;
+    for (const ExperimentInfo &info : entries_) {
+        files.append(toJson(info));
+    }
+
+    QJsonObject root;
+    root.insert("version", INDEX_VERSION);
+    root.insert("files", files);
+
+    // Индекс заменяется атомарно, чтобы прерванная запись не испортила кэш
+    QSaveFile file(QDir(directory_).filePath(INDEX_FILE_NAME));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug() << "Failed to write catalog index:" << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+// Время в наносекундах не помещается в double без потерь, поэтому хранится строкой
+QJsonObject ExperimentCatalog::toJson(const ExperimentInfo &info) {
+    QJsonArray stats;
+    for (const ChannelStats &channel : info.stats) {
+        stats.append(QJsonArray{channel.min, channel.max, channel.mean, channel.stddev});
+    }
+
+    QJsonObject object;
+    object.insert("name", info.fileName);
+    object.insert("size", QString::number(info.fileSize));
+    object.insert("modified", QString::number(info.modifiedMs));
+    object.insert("readable", info.readable);
+    object.insert("start", QString::number(info.startNs));
+    object.insert("end", QString::number(info.endNs));
+    object.insert("rows", QString::number(info.rowCount));
+    object.insert("channels", info.channels);
+    object.insert("rate", info.sampleRate);
+    object.insert("stats", stats);
+    return object;
+}
+
+ExperimentInfo ExperimentCatalog::fromJson(const QJsonObject &object) {
+    ExperimentInfo info;
+    info.fileName = object.value("name").toString();
+    info.fileSize = object.value("size").toString().toLongLong();
+    info.modifiedMs = object.value("modified").toString().toLongLong();
+    info.readable = object.value("readable").toBool();
+    info.startNs = object.value("start").toString().toLongLong();
+    info.endNs = object.value("end").toString().toLongLong();
+    info.rowCount = object.value("rows").toString().toLongLong();
+    info.channels = object.value("channels").toInt();
+    info.sampleRate = object.value("rate").toDouble();
+
+    const QJsonArray stats = object.value("stats").toArray();
+    for (int channel = 0; channel < stats.size() && channel < ChannelSchema::CHANNEL_COUNT; ++channel) {
+        const QJsonArray values = stats[channel].toArray();
+        info.stats[channel] = {values[0].toDouble(), values[1].toDouble(), values[2].toDouble(), values[3].toDouble()};
+    }
+    return info;
+}
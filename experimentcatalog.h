@@ -0,0 +1,82 @@
+#ifndef EXPERIMENTCATALOG_H
+#define EXPERIMENTCATALOG_H
+
+#include "sensordatacursor.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QJsonObject>
+#include <array>
+#include <functional>
+
+// Сводка по одному каналу записи
+struct ChannelStats
+{
+    double min = 0;
+    double max = 0;
+    double mean = 0;
+    double stddev = 0;
+};
+
+// Метаданные файла записи, сохраняемые в индексе каталога
+struct ExperimentInfo
+{
+    QString fileName;
+    qint64 fileSize = 0;
+    qint64 modifiedMs = 0;
+
+    bool readable = false;
+    qint64 startNs = 0;
+    qint64 endNs = 0;
+    qint64 rowCount = 0;
+    int channels = 0;
+    double sampleRate = 0; // Гц
+    std::array<ChannelStats, ChannelSchema::CHANNEL_COUNT> stats; // в порядке SensorDataBatch::CHANNEL_NAMES
+
+    double durationSeconds() const {
+        return (endNs - startNs) / 1e9;
+    }
+};
+
+// Каталог записей в директории experiments.
+// Метаданные каждого файла вычисляются одним проходом курсора и кэшируются
+// в INDEX_FILE_NAME; при обновлении повторно читаются только файлы,
+// у которых изменились размер или время модификации.
+class ExperimentCatalog
+{
+public:
+    static constexpr int INDEX_VERSION = 1;
+    static constexpr const char *INDEX_FILE_NAME = ".catalog.json";
+
+    // Возвращает false, чтобы прервать обновление
+    using ProgressCallback = std::function<bool(int done, int total)>;
+
+    explicit ExperimentCatalog(const QString &directory);
+
+    // Синхронизирует индекс с директорией и сохраняет его.
+    // Возвращает число заново прочитанных файлов.
+    int refresh(const ProgressCallback &progress = nullptr);
+
+    const QVector<ExperimentInfo> &entries() const;
+    QString directory() const;
+    QString filePath(const ExperimentInfo &info) const;
+
+    // Читает запись целиком и собирает ее метаданные
+    static ExperimentInfo scanFile(const QString &filePath);
+
+    static const QStringList &recordingPatterns();
+
+private:
+    void loadIndex();
+    bool saveIndex() const;
+
+    static QJsonObject toJson(const ExperimentInfo &info);
+    static ExperimentInfo fromJson(const QJsonObject &object);
+
+    QString directory_;
+    QVector<ExperimentInfo> entries_;
+    bool indexLoaded_ = false;
+};
+
+#endif // EXPERIMENTCATALOG_H
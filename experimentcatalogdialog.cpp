@@ -0,0 +1,241 @@
+#include "experimentcatalogdialog.h"
+
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QProgressDialog>
+#include <QDateTime>
+#include <QCoreApplication>
+#include <QLocale>
+#include <cmath>
+
+namespace {
+
+enum Column {
+    NAME,
+    START,
+    DURATION,
+    ROWS,
+    RATE,
+    CHANNELS,
+    SIZE,
+    COLUMN_COUNT
+};
+
+// Числовые ячейки сортируются по значению, а не по тексту
+QTableWidgetItem *numberItem(const QVariant &value, const QString &text)
+{
+    QTableWidgetItem *item = new QTableWidgetItem();
+    item->setData(Qt::DisplayRole, value);
+    item->setData(Qt::ToolTipRole, text);
+    item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    return item;
+}
+
+}
+
+ExperimentCatalogDialog::ExperimentCatalogDialog(const QString &directory, QWidget *parent)
+    : QDialog(parent), catalog_(directory)
+{
+    setWindowTitle("Каталог записей");
+    resize(900, 600);
+    setupUi();
+}
+
+QString ExperimentCatalogDialog::selectedFilePath() const
+{
+    const ExperimentInfo *info = currentInfo();
+    return info ? catalog_.filePath(*info) : QString();
+}
+
+void ExperimentCatalogDialog::showEvent(QShowEvent *event)
+{
+    QDialog::showEvent(event);
+    refreshCatalog();
+}
+
+void ExperimentCatalogDialog::setupUi()
+{
+    QVBoxLayout *layout = new QVBoxLayout(this);
+
+    QHBoxLayout *filterLayout = new QHBoxLayout();
+    filterEdit_ = new QLineEdit(this);
+    filterEdit_->setPlaceholderText("Фильтр по имени файла");
+    filterEdit_->setClearButtonEnabled(true);
+
+    channelFilter_ = new QComboBox(this);
+    channelFilter_->addItem("Все каналы", 0);
+    channelFilter_->addItem("Окружающая среда", static_cast<int>(SensorDataBatch::ENV));
+    channelFilter_->addItem("Гироскоп", static_cast<int>(SensorDataBatch::GYRO));
+    channelFilter_->addItem("Акселерометр", static_cast<int>(SensorDataBatch::ACCELERO));
+    channelFilter_->addItem("Магнитометр", static_cast<int>(SensorDataBatch::MAGNETO));
+
+    QPushButton *refreshButton = new QPushButton("Обновить", this);
+    filterLayout->addWidget(filterEdit_);
+    filterLayout->addWidget(channelFilter_);
+    filterLayout->addWidget(refreshButton);
+    layout->addLayout(filterLayout);
+
+    table_ = new QTableWidget(0, COLUMN_COUNT, this);
+    table_->setHorizontalHeaderLabels({"Файл", "Начало", "Длительность, с", "Строк",
+                                       "Частота, Гц", "Каналы", "Размер, КиБ"});
+    table_->setSelectionBehavior(QAbstractItemView::SelectRows);
+    table_->setSelectionMode(QAbstractItemView::SingleSelection);
+    table_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    table_->setAlternatingRowColors(true);
+    table_->setShowGrid(false);
+    table_->verticalHeader()->setVisible(false);
+    table_->horizontalHeader()->setStretchLastSection(true);
+    table_->setSortingEnabled(true);
+    layout->addWidget(table_, 3);
+
+    previewLabel_ = new QLabel(this);
+    previewLabel_->setTextFormat(Qt::RichText);
+    previewLabel_->setAlignment(Qt::AlignTop | Qt::AlignLeft);
+    previewLabel_->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    layout->addWidget(previewLabel_, 2);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    openButton_ = new QPushButton("Открыть", this);
+    openButton_->setEnabled(false);
+    QPushButton *cancelButton = new QPushButton("Отмена", this);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(openButton_);
+    buttonLayout->addWidget(cancelButton);
+    layout->addLayout(buttonLayout);
+
+    connect(filterEdit_, &QLineEdit::textChanged, this, &ExperimentCatalogDialog::applyFilter);
+    connect(channelFilter_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ExperimentCatalogDialog::applyFilter);
+    connect(refreshButton, &QPushButton::clicked, this, &ExperimentCatalogDialog::refreshCatalog);
+    connect(table_, &QTableWidget::itemSelectionChanged, this, &ExperimentCatalogDialog::updatePreview);
+    connect(table_, &QTableWidget::cellDoubleClicked, this, &ExperimentCatalogDialog::accept);
+    connect(openButton_, &QPushButton::clicked, this, &ExperimentCatalogDialog::accept);
+    connect(cancelButton, &QPushButton::clicked, this, &ExperimentCatalogDialog::reject);
+}
+
+void ExperimentCatalogDialog::refreshCatalog()
+{
+    // Окно прогресса появляется, только если новых файлов много и чтение затянулось
+    QProgressDialog progressDialog("Индексация записей...", "Отмена", 0, 0, this);
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setMinimumDuration(500);
+
+    catalog_.refresh([&progressDialog](int done, int total) {
+        progressDialog.setMaximum(total);
+        progressDialog.setValue(done);
+        QCoreApplication::processEvents();
+        return !progressDialog.wasCanceled();
+    });
+
+    fillTable();
+}
+
+void ExperimentCatalogDialog::fillTable()
+{
+    const QLocale locale;
+
+    table_->setSortingEnabled(false);
+    table_->clearContents();
+    table_->setRowCount(catalog_.entries().size());
+
+    for (int row = 0; row < catalog_.entries().size(); ++row) {
+        const ExperimentInfo &info = catalog_.entries()[row];
+
+        QTableWidgetItem *nameItem = new QTableWidgetItem(info.fileName);
+        nameItem->setData(Qt::UserRole, row);
+        table_->setItem(row, NAME, nameItem);
+
+        const QString start = info.rowCount > 0
+            ? SensorDataBatch::fromNanos(info.startNs).toString("yyyy-MM-dd HH:mm:ss")
+            : QString(info.readable ? "пусто" : "ошибка чтения");
+        table_->setItem(row, START, new QTableWidgetItem(start));
+        table_->setItem(row, DURATION, numberItem(std::round(info.durationSeconds() * 10) / 10,
+                                                  QString::number(info.durationSeconds(), 'f', 3)));
+        table_->setItem(row, ROWS, numberItem(static_cast<qlonglong>(info.rowCount), locale.toString(info.rowCount)));
+        table_->setItem(row, RATE, numberItem(std::round(info.sampleRate * 10) / 10,
+                                              QString::number(info.sampleRate, 'f', 3)));
+        table_->setItem(row, CHANNELS, new QTableWidgetItem(channelsText(info.channels)));
+        table_->setItem(row, SIZE, numberItem(static_cast<qlonglong>(info.fileSize / 1024), locale.toString(info.fileSize) + " Б"));
+    }
+
+    table_->setSortingEnabled(true);
+    table_->sortItems(NAME, Qt::DescendingOrder);
+    table_->resizeColumnsToContents();
+    applyFilter();
+}
+
+void ExperimentCatalogDialog::applyFilter()
+{
+    const QString text = filterEdit_->text().trimmed();
+    const int channels = channelFilter_->currentData().toInt();
+
+    for (int row = 0; row < table_->rowCount(); ++row) {
+        const int index = table_->item(row, NAME)->data(Qt::UserRole).toInt();
+        const ExperimentInfo &info = catalog_.entries()[index];
+        const bool matches = info.fileName.contains(text, Qt::CaseInsensitive)
+                             && (info.channels & channels) == channels;
+        table_->setRowHidden(row, !matches);
+    }
+    updatePreview();
+}
+
+void ExperimentCatalogDialog::updatePreview()
+{
+    const ExperimentInfo *info = currentInfo();
+    openButton_->setEnabled(info != nullptr && info->rowCount > 0);
+    if (info == nullptr) {
+        previewLabel_->clear();
+        return;
+    }
+
+    QString html = QString("<b>%1</b><br>").arg(info->fileName.toHtmlEscaped());
+    if (info->rowCount == 0) {
+        previewLabel_->setText(html + (info->readable ? "Файл не содержит данных." : "Не удалось прочитать файл."));
+        return;
+    }
+
+    html += QString("%1 — %2, %3 строк, %4 Гц<br>")
+                .arg(SensorDataBatch::fromNanos(info->startNs).toString("yyyy-MM-dd HH:mm:ss.zzz"),
+                     SensorDataBatch::fromNanos(info->endNs).toString("HH:mm:ss.zzz"),
+                     QLocale().toString(info->rowCount),
+                     QString::number(info->sampleRate, 'f', 1));
+    html += "<table cellspacing=6><tr><th align=left>Канал</th><th>Мин</th><th>Макс</th>"
+            "<th>Среднее</th><th>СКО</th></tr>";
+    for (int channel = 0; channel < SensorDataBatch::CHANNEL_NAMES.size(); ++channel) {
+        if (!(info->channels & ChannelSchema::GROUPS[ChannelSchema::CHANNELS[channel].group].mask)) {
+            continue;
+        }
+        const ChannelStats &stats = info->stats[channel];
+        html += QString("<tr><td>%1</td><td align=right>%2</td><td align=right>%3</td>"
+                        "<td align=right>%4</td><td align=right>%5</td></tr>")
+                    .arg(SensorDataBatch::CHANNEL_NAMES[channel],
+                         QString::number(stats.min, 'g', 6),
+                         QString::number(stats.max, 'g', 6),
+                         QString::number(stats.mean, 'g', 6),
+                         QString::number(stats.stddev, 'g', 6));
+    }
+    html += "</table>";
+    previewLabel_->setText(html);
+}
+
+const ExperimentInfo *ExperimentCatalogDialog::currentInfo() const
+{
+    const QList<QTableWidgetItem*> selected = table_->selectedItems();
+    if (selected.isEmpty() || table_->isRowHidden(selected.first()->row())) {
+        return nullptr;
+    }
+    const int index = table_->item(selected.first()->row(), NAME)->data(Qt::UserRole).toInt();
+    return &catalog_.entries()[index];
+}
+
+QString ExperimentCatalogDialog::channelsText(int channels)
+{
+    static const QStringList names = {"среда", "гиро", "аксел", "магн"};
+    QStringList present;
+    for (int group = 0; group < 4; ++group) {
+        if (channels & SensorDataBatch::GROUP_MASKS[group]) {
+            present.append(names[group]);
+        }
+    }
+    return present.join(", ");
+}
@@ -0,0 +1,47 @@
+#ifndef EXPERIMENTCATALOGDIALOG_H
+#define EXPERIMENTCATALOGDIALOG_H
+
+#include "experimentcatalog.h"
+
+#include <QDialog>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QTableWidget>
+#include <QLabel>
+#include <QPushButton>
+
+// Просмотр каталога записей: фильтр по имени и каналам, сводка по выбранной записи.
+// Метаданные берутся из индекса каталога, сами файлы при просмотре не открываются.
+class ExperimentCatalogDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    explicit ExperimentCatalogDialog(const QString &directory, QWidget *parent = nullptr);
+
+    // Путь к выбранной записи после accept()
+    QString selectedFilePath() const;
+
+protected:
+    void showEvent(QShowEvent *event) override;
+
+private slots:
+    void refreshCatalog();
+    void applyFilter();
+    void updatePreview();
+
+private:
+    void setupUi();
+    void fillTable();
+    const ExperimentInfo *currentInfo() const;
+
+    static QString channelsText(int channels);
+
+    ExperimentCatalog catalog_;
+    QLineEdit *filterEdit_;
+    QComboBox *channelFilter_;
+    QTableWidget *table_;
+    QLabel *previewLabel_;
+    QPushButton *openButton_;
+};
+
+#endif // EXPERIMENTCATALOGDIALOG_H
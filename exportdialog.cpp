@@ -0,0 +1,111 @@
+#include "exportdialog.h"
+#include "sensordatacursor.h"
+
+#include <QFormLayout>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QPushButton>
+#include <QFileDialog>
+
+namespace {
+
+const char *const TIME_FORMAT = "yyyy-MM-dd HH:mm:ss.zzz";
+
+}
+
+ExportDialog::ExportDialog(const QString &defaultPath, const QDateTime &start, const QDateTime &end,
+                           int availableChannels, QWidget *parent)
+    : QDialog(parent)
+{
+    setWindowTitle("Экспорт записи");
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    QFormLayout *form = new QFormLayout();
+
+    QHBoxLayout *pathLayout = new QHBoxLayout();
+    pathEdit_ = new QLineEdit(defaultPath, this);
+    QPushButton *browseButton = new QPushButton("Обзор...", this);
+    pathLayout->addWidget(pathEdit_);
+    pathLayout->addWidget(browseButton);
+    form->addRow("Файл:", pathLayout);
+
+    QVBoxLayout *channelsLayout = new QVBoxLayout();
+    for (int group = 0; group < ChannelSchema::GROUP_COUNT; ++group) {
+        channelBoxes_[group] = new QCheckBox(QString::fromUtf8(ChannelSchema::GROUPS[group].title), this);
+        const bool available = availableChannels & SensorDataBatch::GROUP_MASKS[group];
+        channelBoxes_[group]->setEnabled(available);
+        channelBoxes_[group]->setChecked(available);
+        channelsLayout->addWidget(channelBoxes_[group]);
+        connect(channelBoxes_[group], &QCheckBox::toggled, this, &ExportDialog::validate);
+    }
+    form->addRow("Каналы:", channelsLayout);
+
+    startEdit_ = new QDateTimeEdit(start, this);
+    endEdit_ = new QDateTimeEdit(end, this);
+    for (QDateTimeEdit *edit : {startEdit_, endEdit_}) {
+        edit->setDisplayFormat(TIME_FORMAT);
+        edit->setDateTimeRange(start, end);
+    }
+    form->addRow("Начало:", startEdit_);
+    form->addRow("Конец:", endEdit_);
+    layout->addLayout(form);
+
+    QHBoxLayout *buttonLayout = new QHBoxLayout();
+    exportButton_ = new QPushButton("Экспортировать", this);
+    exportButton_->setDefault(true);
+    QPushButton *cancelButton = new QPushButton("Отмена", this);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(exportButton_);
+    buttonLayout->addWidget(cancelButton);
+    layout->addLayout(buttonLayout);
+
+    connect(browseButton, &QPushButton::clicked, this, &ExportDialog::browse);
+    connect(pathEdit_, &QLineEdit::textChanged, this, &ExportDialog::validate);
+    connect(startEdit_, &QDateTimeEdit::dateTimeChanged, this, &ExportDialog::validate);
+    connect(endEdit_, &QDateTimeEdit::dateTimeChanged, this, &ExportDialog::validate);
+    connect(exportButton_, &QPushButton::clicked, this, &ExportDialog::accept);
+    connect(cancelButton, &QPushButton::clicked, this, &ExportDialog::reject);
+    validate();
+}
+
+QString ExportDialog::targetPath() const
+{
+    return pathEdit_->text().trimmed();
+}
+
+int ExportDialog::channels() const
+{
+    int channels = 0;
+    for (int group = 0; group < ChannelSchema::GROUP_COUNT; ++group) {
+        if (channelBoxes_[group]->isChecked()) {
+            channels |= SensorDataBatch::GROUP_MASKS[group];
+        }
+    }
+    return channels;
+}
+
+QDateTime ExportDialog::startTimestamp() const
+{
+    return startEdit_->dateTime();
+}
+
+QDateTime ExportDialog::endTimestamp() const
+{
+    return endEdit_->dateTime();
+}
+
+void ExportDialog::browse()
+{
+    const QString filePath = QFileDialog::getSaveFileName(this, "Экспорт записи", targetPath(),
+                                                          "CSV Files (*.csv);;Сжатые записи (*.insr);;"
+                                                          "Arrow IPC (*.arrow *.feather)");
+    if (!filePath.isEmpty()) {
+        pathEdit_->setText(filePath);
+    }
+}
+
+void ExportDialog::validate()
+{
+    exportButton_->setEnabled(!targetPath().isEmpty() && channels() != 0
+                              && startTimestamp() <= endTimestamp());
+}
@@ -0,0 +1,38 @@
+#ifndef EXPORTDIALOG_H
+#define EXPORTDIALOG_H
+
+#include "channelschema.h"
+
+#include <QDialog>
+#include <QLineEdit>
+#include <QCheckBox>
+#include <QDateTimeEdit>
+#include <QDateTime>
+#include <array>
+
+// Параметры экспорта: файл (формат по расширению), группы каналов и интервал
+class ExportDialog : public QDialog
+{
+    Q_OBJECT
+public:
+    ExportDialog(const QString &defaultPath, const QDateTime &start, const QDateTime &end,
+                 int availableChannels, QWidget *parent = nullptr);
+
+    QString targetPath() const;
+    int channels() const;
+    QDateTime startTimestamp() const;
+    QDateTime endTimestamp() const;
+
+private slots:
+    void browse();
+    void validate();
+
+private:
+    QLineEdit *pathEdit_;
+    std::array<QCheckBox*, ChannelSchema::GROUP_COUNT> channelBoxes_;
+    QDateTimeEdit *startEdit_;
+    QDateTimeEdit *endEdit_;
+    QPushButton *exportButton_;
+};
+
+#endif // EXPORTDIALOG_H
@@ -0,0 +1,276 @@
+#include "exportjob.h"
+#include "storagemanager.h"
+#include "binarysensordatadao.h"
+#include "arrowipc.h"
+#include "sessionsensordatadao.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+#include <memory>
+
+namespace {
+
+// Приемник экспорта: формат файла скрыт за write/close
+class ExportSink
+{
+public:
+    virtual ~ExportSink() = default;
+    virtual bool write(const SensorDataBatch &batch) = 0;
+    virtual bool close() = 0;
+};
+
+// CSV и бинарный формат пишутся своими DAO построчно
+class DaoSink : public ExportSink
+{
+public:
+    explicit DaoSink(ISensorDataDAO *dao) : dao_(dao) {}
+
+    bool write(const SensorDataBatch &batch) override {
+        for (int row = 0; row < batch.size(); ++row) {
+            if (!dao_->insertSensorData(batch.row(row))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Деструктор DAO дописывает буферы в файл
+    bool close() override {
+        dao_.reset();
+        return true;
+    }
+
+private:
+    std::unique_ptr<ISensorDataDAO> dao_;
+};
+
+class ArrowSink : public ExportSink
+{
+public:
+    ArrowSink(const QString &filePath, int channels) : writer_(filePath, channels) {}
+
+    bool write(const SensorDataBatch &batch) override {
+        return writer_.writeBatch(batch);
+    }
+
+    bool close() override {
+        return writer_.close();
+    }
+
+private:
+    ArrowIpcWriter writer_;
+};
+
+ExportSink *createSink(const ExportRequest &request, int channels) {
+    const QString suffix = QFileInfo(request.targetPath).suffix();
+    if (suffix.compare("arrow", Qt::CaseInsensitive) == 0 || suffix.compare("feather", Qt::CaseInsensitive) == 0) {
+        return new ArrowSink(request.targetPath, channels);
+    }
+    if (suffix.compare("insr", Qt::CaseInsensitive) == 0) {
+        return new DaoSink(new BinarySensorDataDAO(request.targetPath, channels));
+    }
+    return new DaoSink(new CsvSensorDataDAO(
+        request.targetPath,
+        channels & SensorDataBatch::ENV, request.precision,
+        channels & SensorDataBatch::GYRO, request.precision,
+        channels & SensorDataBatch::ACCELERO, request.precision,
+        channels & SensorDataBatch::MAGNETO, request.precision));
+}
+
+// Курсор по снимку живых данных
+class SnapshotCursor : public ISensorDataCursor
+{
+public:
+    explicit SnapshotCursor(const QVector<SensorDataBatch> &batches) : batches_(batches) {}
+
+    bool next(SensorDataBatch &batch) override {
+        if (next_ >= batches_.size()) {
+            batch.clear();
+            return false;
+        }
+        batch = batches_[next_++];
+        return true;
+    }
+
+private:
+    const QVector<SensorDataBatch> &batches_;
+    int next_ = 0;
+};
+
+// Выходной файл стирается перед записью, поэтому он не должен быть источником
+// или сегментом экспортируемого сеанса
+bool overwritesSource(const QString &sourcePath, const QString &targetPath) {
+    const QString sourceCanonical = QFileInfo(sourcePath).canonicalFilePath();
+    if (sourceCanonical.isEmpty()) {
+        return false;
+    }
+    // Для еще не созданного файла canonicalFilePath пуст: берется канонический каталог
+    const QFileInfo target(targetPath);
+    const QString targetCanonical = target.exists()
+        ? target.canonicalFilePath()
+        : QFileInfo(target.absolutePath()).canonicalFilePath() + "/" + target.fileName();
+    if (targetCanonical == sourceCanonical) {
+        return true;
+    }
+    if (QFileInfo(sourcePath).suffix().compare(SessionSensorDataDAO::MANIFEST_SUFFIX, Qt::CaseInsensitive) != 0) {
+        return false;
+    }
+    const QString segments = QFileInfo(SessionSensorDataDAO::segmentDirectory(sourcePath)).canonicalFilePath();
+    return !segments.isEmpty() && targetCanonical.startsWith(segments + "/");
+}
+
+// Оставляет в пакете строки из [startNs, endNs] и только выбранные группы каналов
+void filterBatch(SensorDataBatch &batch, qint64 startNs, qint64 endNs, int channels) {
+    batch.channels &= channels;
+    if (batch.isEmpty() || (batch.timestamps.first() >= startNs && batch.timestamps.last() <= endNs)) {
+        return;
+    }
+
+    int kept = 0;
+    for (int row = 0; row < batch.size(); ++row) {
+        if (batch.timestamps[row] < startNs || batch.timestamps[row] > endNs) {
+            continue;
+        }
+        batch.timestamps[kept] = batch.timestamps[row];
+        ChannelSchema::forEachChannel([&](auto channel) {
+            constexpr int index = decltype(channel)::value;
+            if (batch.hasChannel<index>()) {
+                batch.column<index>()[kept] = batch.column<index>()[row];
+            }
+        });
+        ++kept;
+    }
+
+    batch.timestamps.resize(kept);
+    ChannelSchema::forEachChannel([&](auto channel) {
+        constexpr int index = decltype(channel)::value;
+        batch.column<index>().resize(batch.hasChannel<index>() ? kept : 0);
+    });
+}
+
+}
+
+ExportJob::ExportJob(const ExportRequest &request, QObject *parent)
+    : QObject(parent), request_(request)
+{
+    thread_ = QThread::create([this]() { run(); });
+}
+
+ExportJob::~ExportJob()
+{
+    cancel();
+    thread_->wait();
+    delete thread_;
+}
+
+void ExportJob::start()
+{
+    thread_->start();
+}
+
+void ExportJob::cancel()
+{
+    cancelled_ = true;
+}
+
+void ExportJob::run()
+{
+    if (overwritesSource(request_.sourcePath, request_.targetPath)) {
+        emit finished(false, "Файл экспорта совпадает с источником");
+        return;
+    }
+
+    QString error;
+    const bool ok = exportData(error);
+    if (!ok || cancelled_) {
+        QFile::remove(request_.targetPath);
+    }
+
+    if (cancelled_) {
+        emit finished(false, "Экспорт отменен");
+    } else if (!ok) {
+        emit finished(false, error);
+    } else {
+        emit finished(true, QString("Экспортировано строк: %1").arg(rowsWritten_));
+    }
+}
+
+bool ExportJob::exportData(QString &error)
+{
+    // Источник открывается заново в этом потоке и не зависит от DAO интерфейса
+    std::unique_ptr<ISensorDataDAO> source;
+    std::unique_ptr<ISensorDataCursor> cursor;
+    try {
+        if (request_.sourcePath.isEmpty()) {
+            cursor.reset(new SnapshotCursor(request_.snapshot));
+        } else {
+            source.reset(FileStorageManager::createReadDao(request_.sourcePath));
+            cursor = source->selectSensorDataCursor(SensorDataBatch::fromNanos(request_.startNs),
+                                                    SensorDataBatch::fromNanos(request_.endNs));
+        }
+    } catch (const std::exception &e) {
+        error = QString("Не удалось открыть запись: %1").arg(e.what());
+        return false;
+    }
+    if (!cursor) {
+        error = "Не удалось открыть запись";
+        return false;
+    }
+
+    // Экспортируемый файл заменяется целиком; DAO иначе дописали бы его
+    QFile::remove(request_.targetPath);
+
+    // Набор каналов источника известен только после первого пакета
+    std::unique_ptr<ExportSink> sink;
+    int sinkChannels = 0;
+    SensorDataBatch batch;
+    try {
+        while (!cancelled_ && cursor->next(batch)) {
+            filterBatch(batch, request_.startNs, request_.endNs, request_.channels);
+            if (!sink) {
+                sinkChannels = batch.channels;
+                sink.reset(createSink(request_, sinkChannels));
+            }
+            if (!batch.hasChannels(sinkChannels)) {
+                error = "Набор каналов меняется внутри записи";
+                return false;
+            }
+            if (!sink->write(batch)) {
+                error = "Ошибка записи в файл";
+                return false;
+            }
+            rowsWritten_ += batch.size();
+            if (!batch.isEmpty()) {
+                reportProgress(batch.timestamps.last());
+            }
+        }
+
+        if (!sink) {
+            sink.reset(createSink(request_, request_.channels));
+        }
+    } catch (const std::exception &e) {
+        error = QString("Не удалось создать файл: %1").arg(e.what());
+        return false;
+    }
+
+    if (!sink->close()) {
+        error = "Ошибка записи в файл";
+        return false;
+    }
+    emit progressChanged(100);
+    return true;
+}
+
+// Прогресс оценивается по времени строки внутри экспортируемого интервала
+void ExportJob::reportProgress(qint64 timestampNs)
+{
+    const qint64 span = request_.endNs - request_.startNs;
+    const int percent = span > 0
+        ? static_cast<int>(qBound<qint64>(0, (timestampNs - request_.startNs) * 100 / span, 99))
+        : 0;
+    if (percent != lastPercent_) {
+        lastPercent_ = percent;
+        emit progressChanged(percent);
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef EXPORTJOB_H
+#define EXPORTJOB_H
+
+#include "sensordatacursor.h"
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <atomic>
+
+// Что и куда экспортировать
+struct ExportRequest
+{
+    // Файл записи; если пуст, экспортируется snapshot
+    QString sourcePath;
+    // Снимок живых данных графиков
+    QVector<SensorDataBatch> snapshot;
+
+    qint64 startNs = 0;
+    qint64 endNs = 0;
+    int channels = SensorDataBatch::ALL;
+
+    // Формат определяется по расширению: csv, insr, arrow/feather
+    QString targetPath;
+    int precision = 2; // знаков после запятой для CSV
+};
+
+// Экспорт в фоновом потоке. Источник читается курсором пакетами,
+// каждый пакет сразу пишется в файл, поэтому в памяти находится
+// только один пакет. При отмене или ошибке недописанный файл удаляется.
+class ExportJob : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ExportJob(const ExportRequest &request, QObject *parent = nullptr);
+    ~ExportJob();
+
+    void start();
+    void cancel();
+
+signals:
+    void progressChanged(int percent);
+    void finished(bool ok, const QString &message);
+
+private:
+    void run();
+    bool exportData(QString &error);
+    void reportProgress(qint64 timestampNs);
+
+    ExportRequest request_;
+    QThread *thread_ = nullptr;
+    std::atomic<bool> cancelled_{false};
+    qint64 rowsWritten_ = 0;
+    int lastPercent_ = -1;
+};
+
+#endif // EXPORTJOB_H
@@ -0,0 +1,369 @@
+#ifndef IMUCODEC_H
+#define IMUCODEC_H
+
+#include <QByteArray>
+#include <QtAlgorithms>
+#include <cstdint>
+#include <cstring>
+
+// Сжатие без потерь для колонок записи:
+//  - время: delta-of-delta + zigzag + varint (равномерный шаг кодируется одним байтом);
+//  - int16 каналы (гироскоп, акселерометр, магнитометр): delta + zigzag + упаковка
+//    блоками по BLOCK_SIZE значений с общей для блока шириной в битах;
+//  - float каналы (окружающая среда): XOR с предыдущим значением по схеме Gorilla.
+// Декодеры проверяют границы входа и возвращают false на поврежденных данных.
+class ImuCodec
+{
+public:
+    static constexpr int BLOCK_SIZE = 128;
+
+    static void encodeTimestamps(const qint64 *values, int count, QByteArray &out)
+    {
+        qint64 previous = 0;
+        qint64 previousDelta = 0;
+        for (int i = 0; i < count; ++i) {
+            const qint64 delta = static_cast<qint64>(static_cast<quint64>(values[i]) - static_cast<quint64>(previous));
+            const qint64 deltaOfDelta = static_cast<qint64>(static_cast<quint64>(delta) - static_cast<quint64>(previousDelta));
+            putVarint(out, zigzag64(deltaOfDelta));
+            previousDelta = delta;
+            previous = values[i];
+        }
+    }
+
+    static bool decodeTimestamps(const char *data, int size, int count, qint64 *values)
+    {
+        const uint8_t *p = reinterpret_cast<const uint8_t*>(data);
+        const uint8_t *end = p + size;
+        quint64 previous = 0;
+        quint64 previousDelta = 0;
+        for (int i = 0; i < count; ++i) {
+            quint64 encoded;
+            if (!getVarint(p, end, encoded)) {
+                return false;
+            }
+            previousDelta += static_cast<quint64>(unzigzag64(encoded));
+            previous += previousDelta;
+            values[i] = static_cast<qint64>(previous);
+        }
+        return p == end;
+    }
+
+    static void encodeInt16(const int16_t *values, int count, QByteArray &out)
+    {
+        quint32 zigzagged[BLOCK_SIZE];
+        qint32 previous = 0;
+        for (int start = 0; start < count; start += BLOCK_SIZE) {
+            const int n = qMin(BLOCK_SIZE, count - start);
+            quint32 bitsUsed = 0;
+            for (int i = 0; i < n; ++i) {
+                const qint32 value = values[start + i];
+                zigzagged[i] = zigzag32(value - previous);
+                bitsUsed |= zigzagged[i];
+                previous = value;
+            }
+
+            const int width = bitsUsed ? 32 - qCountLeadingZeroBits(bitsUsed) : 0;
+            out.append(static_cast<char>(width));
+
+            BitWriter writer(out);
+            for (int i = 0; i < n; ++i) {
+                writer.write(zigzagged[i], width);
+            }
+            writer.finish();
+        }
+    }
+
+    static bool decodeInt16(const char *data, int size, int count, int16_t *values)
+    {
+        const uint8_t *p = reinterpret_cast<const uint8_t*>(data);
+        const uint8_t *end = p + size;
+        qint32 previous = 0;
+        for (int start = 0; start < count; start += BLOCK_SIZE) {
+            const int n = qMin(BLOCK_SIZE, count - start);
+            if (p >= end) {
+                return false;
+            }
+
+            // Разность двух int16 после zigzag занимает не больше 17 бит
+            const int width = *p++;
+            if (width > 17) {
+                return false;
+            }
+            const qint64 bytes = (static_cast<qint64>(n) * width + 7) / 8;
+            if (end - p < bytes) {
+                return false;
+            }
+
+            const quint32 mask = width ? (1u << width) - 1 : 0;
+            quint64 accumulator = 0;
+            int bits = 0;
+            const uint8_t *q = p;
+            for (int i = 0; i < n; ++i) {
+                while (bits < width) {
+                    accumulator |= static_cast<quint64>(*q++) << bits;
+                    bits += 8;
+                }
+                previous += unzigzag32(static_cast<quint32>(accumulator) & mask);
+                accumulator >>= width;
+                bits -= width;
+                values[start + i] = static_cast<int16_t>(previous);
+            }
+            p += bytes;
+        }
+        return p == end;
+    }
+
+    static void encodeFloat(const float *values, int count, QByteArray &out)
+    {
+        if (count == 0) {
+            return;
+        }
+
+        BitWriter writer(out);
+        quint32 previous = floatBits(values[0]);
+        writer.write(previous, 32);
+
+        int previousLeading = -1;
+        int previousTrailing = 0;
+        for (int i = 1; i < count; ++i) {
+            const quint32 current = floatBits(values[i]);
+            const quint32 xored = current ^ previous;
+            previous = current;
+
+            if (xored == 0) {
+                writer.write(0, 1);
+                continue;
+            }
+            writer.write(1, 1);
+
+            const int leading = qCountLeadingZeroBits(xored);
+            const int trailing = qCountTrailingZeroBits(xored);
+            if (previousLeading >= 0 && leading >= previousLeading && trailing >= previousTrailing) {
+                // Значащие биты укладываются в окно предыдущего значения
+                writer.write(0, 1);
+                writer.write(xored >> previousTrailing, 32 - previousLeading - previousTrailing);
+            } else {
+                const int length = 32 - leading - trailing;
+                writer.write(1, 1);
+                writer.write(static_cast<quint32>(leading), 5);
+                writer.write(static_cast<quint32>(length - 1), 5);
+                writer.write(xored >> trailing, length);
+                previousLeading = leading;
+                previousTrailing = trailing;
+            }
+        }
+        writer.finish();
+    }
+
+    static bool decodeFloat(const char *data, int size, int count, float *values)
+    {
+        if (count == 0) {
+            return size == 0;
+        }
+
+        BitReader reader(data, size);
+        quint32 previous;
+        if (!reader.read(32, previous)) {
+            return false;
+        }
+        values[0] = bitsFloat(previous);
+
+        int previousLeading = 0;
+        int previousTrailing = 0;
+        for (int i = 1; i < count; ++i) {
+            quint32 flag;
+            if (!reader.read(1, flag)) {
+                return false;
+            }
+            if (flag) {
+                quint32 newWindow;
+                if (!reader.read(1, newWindow)) {
+                    return false;
+                }
+                if (newWindow) {
+                    quint32 leading;
+                    quint32 length;
+                    if (!reader.read(5, leading) || !reader.read(5, length)) {
+                        return false;
+                    }
+                    length += 1;
+                    if (leading + length > 32) {
+                        return false;
+                    }
+                    previousLeading = static_cast<int>(leading);
+                    previousTrailing = 32 - static_cast<int>(leading + length);
+                }
+
+                quint32 meaningful;
+                if (!reader.read(32 - previousLeading - previousTrailing, meaningful)) {
+                    return false;
+                }
+                previous ^= meaningful << previousTrailing;
+            }
+            values[i] = bitsFloat(previous);
+        }
+        return reader.exhausted();
+    }
+
+    // CRC-32 (IEEE 802.3), для контроля целостности блоков записи
+    static quint32 crc32(const char *data, int size, quint32 crc = 0)
+    {
+        static const CrcTable table;
+        crc = ~crc;
+        for (int i = 0; i < size; ++i) {
+            crc = table.values[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+private:
+    // Биты пишутся начиная с младшего, как и читаются в BitReader
+    class BitWriter
+    {
+    public:
+        explicit BitWriter(QByteArray &out) : out_(out) {}
+
+        void write(quint32 value, int count)
+        {
+            if (count == 0) {
+                return;
+            }
+            if (count < 32) {
+                value &= (1u << count) - 1;
+            }
+            accumulator_ |= static_cast<quint64>(value) << bits_;
+            bits_ += count;
+            while (bits_ >= 8) {
+                out_.append(static_cast<char>(accumulator_ & 0xFF));
+                accumulator_ >>= 8;
+                bits_ -= 8;
+            }
+        }
+
+        void finish()
+        {
+            if (bits_ > 0) {
+                out_.append(static_cast<char>(accumulator_ & 0xFF));
+            }
+            accumulator_ = 0;
+            bits_ = 0;
+        }
+
+    private:
+        QByteArray &out_;
+        quint64 accumulator_ = 0;
+        int bits_ = 0;
+    };
+
+    class BitReader
+    {
+    public:
+        BitReader(const char *data, int size)
+            : p_(reinterpret_cast<const uint8_t*>(data)), end_(p_ + size) {}
+
+        bool read(int count, quint32 &value)
+        {
+            while (bits_ < count) {
+                if (p_ >= end_) {
+                    return false;
+                }
+                accumulator_ |= static_cast<quint64>(*p_++) << bits_;
+                bits_ += 8;
+            }
+            value = count == 32 ? static_cast<quint32>(accumulator_)
+                                : static_cast<quint32>(accumulator_ & ((1ull << count) - 1));
+            accumulator_ >>= count;
+            bits_ -= count;
+            return true;
+        }
+
+        // Весь вход прочитан, остались только биты дополнения последнего байта
+        bool exhausted() const
+        {
+            return p_ == end_ && bits_ < 8;
+        }
+
+    private:
+        const uint8_t *p_;
+        const uint8_t *end_;
+        quint64 accumulator_ = 0;
+        int bits_ = 0;
+    };
+
+    struct CrcTable
+    {
+        quint32 values[256];
+
+        CrcTable()
+        {
+            for (quint32 i = 0; i < 256; ++i) {
+                quint32 crc = i;
+                for (int j = 0; j < 8; ++j) {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+                }
+                values[i] = crc;
+            }
+        }
+    };
+
+    static quint32 zigzag32(qint32 value)
+    {
+        return (static_cast<quint32>(value) << 1) ^ static_cast<quint32>(value >> 31);
+    }
+
+    static qint32 unzigzag32(quint32 value)
+    {
+        return static_cast<qint32>(value >> 1) ^ -static_cast<qint32>(value & 1);
+    }
+
+    static quint64 zigzag64(qint64 value)
+    {
+        return (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+    }
+
+    static qint64 unzigzag64(quint64 value)
+    {
+        return static_cast<qint64>(value >> 1) ^ -static_cast<qint64>(value & 1);
+    }
+
+    static void putVarint(QByteArray &out, quint64 value)
+    {
+        while (value >= 0x80) {
+            out.append(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        out.append(static_cast<char>(value));
+    }
+
+    static bool getVarint(const uint8_t *&p, const uint8_t *end, quint64 &value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p >= end) {
+                return false;
+            }
+            const uint8_t byte = *p++;
+            value |= static_cast<quint64>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static quint32 floatBits(float value)
+    {
+        quint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    static float bitsFloat(quint32 bits)
+    {
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+};
+
+#endif // IMUCODEC_H
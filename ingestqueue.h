@@ -0,0 +1,107 @@
+#ifndef INGESTQUEUE_H
+#define INGESTQUEUE_H
+
+#include <QByteArray>
+#include <QtGlobal>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// Прочитанный из порта кусок и монотонное время чтения
+struct IngestChunk
+{
+    QByteArray data;
+    qint64 arrivalNs = 0;
+};
+
+struct IngestStats
+{
+    qint64 enqueued = 0;  // принято в очередь
+    qint64 dropped = 0;   // вытеснено при переполнении
+    int depth = 0;        // текущая длина
+    int maxDepth = 0;     // наибольшая длина за сессию
+    int capacity = 0;
+};
+
+// Ограниченная очередь между потоком чтения и потребителем в GUI.
+// При переполнении DROP_OLDEST вытесняет самые старые куски (для отображения важна свежесть),
+// BLOCK останавливает поток чтения до освобождения места (для записи важна полнота).
+// Потребитель будится одним уведомлением на серию: push возвращает true,
+// только если предыдущее уведомление уже обработано drain.
+class IngestQueue
+{
+public:
+    enum OverflowPolicy {
+        DROP_OLDEST,
+        BLOCK
+    };
+
+    IngestQueue(int capacity, OverflowPolicy policy)
+        : capacity_(std::max(1, capacity)), policy_(policy) {}
+
+    IngestQueue(const IngestQueue&) = delete;
+    IngestQueue &operator=(const IngestQueue&) = delete;
+
+    bool push(IngestChunk &&chunk) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (policy_ == BLOCK) {
+            notFull_.wait(lock, [this]() { return closed_ || static_cast<int>(chunks_.size()) < capacity_; });
+            if (closed_) {
+                return false;
+            }
+        } else if (static_cast<int>(chunks_.size()) >= capacity_) {
+            chunks_.pop_front();
+            ++stats_.dropped;
+        }
+
+        chunks_.push_back(std::move(chunk));
+        ++stats_.enqueued;
+        stats_.maxDepth = std::max(stats_.maxDepth, static_cast<int>(chunks_.size()));
+
+        const bool wake = !consumerNotified_;
+        consumerNotified_ = true;
+        return wake;
+    }
+
+    // Забирает все накопленные куски; следующий push снова разбудит потребителя
+    void drain(std::deque<IngestChunk> &out) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            out.swap(chunks_);
+            chunks_.clear();
+            consumerNotified_ = false;
+        }
+        notFull_.notify_all();
+    }
+
+    // Освобождает поток чтения, ожидающий места в очереди
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        notFull_.notify_all();
+    }
+
+    IngestStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        IngestStats stats = stats_;
+        stats.depth = static_cast<int>(chunks_.size());
+        stats.capacity = capacity_;
+        return stats;
+    }
+
+private:
+    const int capacity_;
+    const OverflowPolicy policy_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable notFull_;
+    std::deque<IngestChunk> chunks_;
+    IngestStats stats_;
+    bool consumerNotified_ = false;
+    bool closed_ = false;
+};
+
+#endif // INGESTQUEUE_H
@@ -1,10 +1,16 @@
 #include "inscommandprocessor.h"
 #include "comand/command.h"
 #include "comand/uartsettings.h"
+#include "allocationcounter.h"
+#include "pipelinediagnostics.h"
+#include "tracer.h"
+#include <QDateTime>
 #include <QDebug>
+#include <QDir>
 #include <QException>
 #include <QMessageBox>
 #include <qthread.h>
+#include <algorithm>
 #include <comand/EmtyData.h>
 
 InsCommandProcessor::InsCommandProcessor(QObject *parent)
@@ -12,81 +18,270 @@ InsCommandProcessor::InsCommandProcessor(QObject *parent)
       tail(0),
       head(0),
       buffer_(BUFFER_SIZE),
-      readThread(new QThread(this)),
+      readThread(nullptr),
       shouldStopReading(false)
 {
-    timer.setInterval(1000);
-    connect(&timer, &QTimer::timeout, this, &InsCommandProcessor::updateCounter);
-    connect(this, &InsCommandProcessor::dataReceived, this, &InsCommandProcessor::handleDataReceived);
-    timer.start();
+    connect(this, &InsCommandProcessor::dataAvailable, this, &InsCommandProcessor::handleDataAvailable);
+}
+
+InsCommandProcessor::~InsCommandProcessor()
+{
+    stopReadThread();
+}
 
-    // Setup and start read thread
-    connect(readThread, &QThread::started, this, [this]() {
-        readThreadFunction();
-    });
+// Поток чтения запускается вместе с потоком данных: до открытия порта читать нечего.
+// QSerialPort не потокобезопасен, а запись команд, смена скорости и его собственный
+// уведомитель работают в потоке GUI, поэтому он читается там же, в слоте readyRead.
+// Отдельный поток есть только у воспроизведения и собственного чтения порта в Linux.
+void InsCommandProcessor::startReadThread()
+{
+    if (readThread || serialReadConnection_) {
+        return;
+    }
+    shouldStopReading = false;
+    ingestQueue_.reset(new IngestQueue(ingestCapacity_, ingestPolicy_));
+    readWakeups_ = 0;
+    readBytes_ = 0;
+    latencyFrames_ = 0;
+    latencySumNs_ = 0;
+    maxLatencyNs_ = 0;
+    linkMetrics_.reset();
+    if (replay_) {
+        readThread = QThread::create([this]() { readReplayThreadFunction(); });
+    } else if (isNativePortOpen()) {
+        readThread = QThread::create([this]() { readNativeThreadFunction(); });
+    } else {
+        serialReadConnection_ = connect(serialPort, &QSerialPort::readyRead,
+                                        this, &InsCommandProcessor::handleSerialReadyRead);
+        // Данные, пришедшие до подключения слота, readyRead повторно не объявит
+        if (serialPort->bytesAvailable() > 0) {
+            QMetaObject::invokeMethod(this, &InsCommandProcessor::handleSerialReadyRead, Qt::QueuedConnection);
+        }
+        return;
+    }
+    // Имя потока видно в трассировке
+    readThread->setObjectName("reader");
     readThread->start();
 }
 
-InsCommandProcessor::~InsCommandProcessor()
+void InsCommandProcessor::stopReadThread()
 {
     shouldStopReading = true;
+    if (serialReadConnection_) {
+        disconnect(serialReadConnection_);
+        serialReadConnection_ = QMetaObject::Connection();
+    }
+    if (ingestQueue_) {
+        ingestQueue_->close();
+    }
+#ifdef Q_OS_LINUX
+    nativePort_.wakeUp();
+#endif
+    if (replay_) {
+        replay_->wakeUp();
+    }
     if (readThread) {
-        readThread->quit();
         readThread->wait();
         delete readThread;
+        readThread = nullptr;
     }
 }
 
-void InsCommandProcessor::readData(const std::function<void(const QByteArray&)> &callback)
+void InsCommandProcessor::readData(const ResponseCallback &callback)
 {
-    if (!serialPort->isOpen()) {
+    startReading(callback, true);
+}
+
+void InsCommandProcessor::readTrialData(const ResponseCallback &callback)
+{
+    startReading(callback, false);
+}
+
+void InsCommandProcessor::startReading(const ResponseCallback &callback, bool rawCapture)
+{
+    if (!isConnected()) {
         qDebug() << "Serial port is not open.";
         return;
     }
 
     responseCallback_ = callback;
+    sessionClock_.restart();
+    if (replay_ && replay_->options().originalTimestamps) {
+        sessionClock_.setAnchors(replay_->wallAnchorNs(), replay_->monotonicAnchorNs());
+    }
+    if (rawCapture) {
+        startRawCapture();
+    }
+    startReadThread();
     Command<EmptyData> command(CommandType::GetData);
 
     QByteArray commandData = command.toByteArray();
     qDebug() << "GetData: " << commandData;
-    int writtenBytes = serialPort->write(commandData);
+    int writtenBytes = writeCommand(commandData);
     if (writtenBytes < commandData.size()) {
         qDebug() << "Failed to send full command";
         throw new QException();
     }
 }
 
-void InsCommandProcessor::readThreadFunction()
+void InsCommandProcessor::handleSerialReadyRead()
 {
-    while (!shouldStopReading && serialPort->isOpen()) {
-        if (serialPort->waitForReadyRead(100)) {
-            QByteArray incomingData = serialPort->read(BUFFER_SIZE / 10);
-            if (!incomingData.isEmpty()) {
-                emit dataReceived(incomingData);
-            }
+    if (!serialReadConnection_) {
+        return;
+    }
+    const QByteArray incomingData = serialPort->readAll();
+    // Метка снимается сразу после чтения, до очереди и разбора
+    const qint64 arrivalNs = MonotonicClock::nowNs();
+    if (!incomingData.isEmpty()) {
+        enqueueRead(incomingData, arrivalNs);
+    }
+}
+
+// Чтение через termios и epoll: поток спит до набора порога VMIN или до wakeUp
+void InsCommandProcessor::readNativeThreadFunction()
+{
+#ifdef Q_OS_LINUX
+    nativePort_.applyThreadOptions();
+    while (!shouldStopReading && !nativePort_.hasHungUp()) {
+        const QByteArray incomingData = nativePort_.read();
+        const qint64 arrivalNs = MonotonicClock::nowNs();
+        if (!incomingData.isEmpty()) {
+            enqueueRead(incomingData, arrivalNs);
+        }
+    }
+    // Порт закрывается в потоке GUI, где его используют запись и смена скорости
+    if (nativePort_.hasHungUp()) {
+        QMetaObject::invokeMethod(this, &InsCommandProcessor::handleNativeHangUp, Qt::QueuedConnection);
+    }
+#endif
+}
+
+void InsCommandProcessor::handleNativeHangUp()
+{
+#ifdef Q_OS_LINUX
+    if (!nativePort_.isOpen() || !nativePort_.hasHungUp()) {
+        return;
+    }
+    lastError = "Порт закрыт устройством";
+    qDebug() << lastError << portName_;
+    // Остановит поток чтения, закроет дескрипторы и сообщит об отключении
+    closeSerialPort();
+#endif
+}
+
+// Источник воспроизведения выдает куски в их время, как порт
+void InsCommandProcessor::readReplayThreadFunction()
+{
+    IngestChunk chunk;
+    while (!shouldStopReading) {
+        if (replay_->next(chunk, shouldStopReading)) {
+            enqueueRead(chunk.data, chunk.arrivalNs);
         }
     }
 }
 
-void InsCommandProcessor::handleDataReceived(const QByteArray& incomingData)
+void InsCommandProcessor::enqueueRead(const QByteArray &data, qint64 arrivalNs)
+{
+    TraceSpan span("reader wakeup");
+    ++readWakeups_;
+    readBytes_ += data.size();
+    // Копия до очереди и разбора: в файл попадает ровно то, что пришло из порта
+    if (std::shared_ptr<RawCaptureWriter> capture = std::atomic_load(&rawCapture_)) {
+        capture->append(data.constData(), data.size(), arrivalNs);
+    }
+    // Поток GUI будится одним сигналом на серию, очередь событий Qt не растет
+    if (ingestQueue_->push({data, arrivalNs})) {
+        emit dataAvailable();
+    }
+}
+
+qint64 InsCommandProcessor::writeCommand(const QByteArray &data)
+{
+    if (replay_) {
+        // Из команд устройства воспроизведение понимает только запуск и остановку
+        const uint8_t type = data.size() > 1 ? static_cast<uint8_t>(data.at(1)) : 0;
+        if (type == GetData) {
+            replay_->play();
+        } else if (type == Stop) {
+            replay_->pause();
+        }
+        return data.size();
+    }
+#ifdef Q_OS_LINUX
+    if (nativePort_.isOpen()) {
+        return nativePort_.write(data);
+    }
+#endif
+    return serialPort->write(data);
+}
+
+bool InsCommandProcessor::isNativePortOpen() const
+{
+#ifdef Q_OS_LINUX
+    return nativePort_.isOpen();
+#else
+    return false;
+#endif
+}
+
+bool InsCommandProcessor::isConnected() const
+{
+    return replay_ || isNativePortOpen() || (serialPort && serialPort->isOpen());
+}
+
+void InsCommandProcessor::handleDataAvailable()
+{
+    if (!ingestQueue_) {
+        return;
+    }
+
+    TraceSpan span("ingest drain");
+    // Очередь и drained_ обмениваются деками, поэтому их блоки переиспользуются
+    ingestQueue_->drain(drained_);
+    PipelineDiagnostics &diagnostics = PipelineDiagnostics::instance();
+    const bool monotonic = hasMonotonicArrivals();
+    const qint64 drainedNs = MonotonicClock::nowNs();
+    for (const IngestChunk &chunk : drained_) {
+        if (monotonic) {
+            diagnostics.record(PipelineDiagnostics::QUEUE_WAIT, drainedNs - chunk.arrivalNs);
+        }
+        handleDataReceived(chunk.data, chunk.arrivalNs);
+    }
+    drained_.clear();
+}
+
+void InsCommandProcessor::handleDataReceived(const QByteArray& incomingData, qint64 arrivalNs)
 {
     if (!responseCallback_) {
         return;
     }
 
+    TraceSpan span("parse chunk");
+
+    // Время разбора кадра - от начала куска или конца предыдущего кадра, без колбэка
+    PipelineDiagnostics &diagnostics = PipelineDiagnostics::instance();
+    qint64 framingStartNs = MonotonicClock::nowNs();
+    qint64 framingStartAllocations = AllocationCounter::threadCount();
+
     buffer_.append(incomingData);
+    receivedBytes_ += incomingData.size();
+    linkMetrics_.addBytes(incomingData.size());
+    arrivals_.push_back(qMakePair(receivedBytes_, arrivalNs));
 
+    // Заголовок читается из буфера по байтам, кадр - в переиспользуемый frame_:
+    // после прогрева разбор не выделяет память
     while (buffer_.size() >= 3) { // Минимальный размер для чтения заголовка
-        QByteArray header = buffer_.read(3); // Читаем первые три байта
-
-        uint8_t startByte = static_cast<uint8_t>(header.at(0));
+        uint8_t startByte = static_cast<uint8_t>(buffer_.at(0));
         if (startByte != Command<EmptyData>::START_BYTE) {
-            buffer_.pop(1); // Удаляем первый байт и продолжаем
+            buffer_.discard(1); // Удаляем первый байт и продолжаем
+            consumedBytes_ += 1;
+            ++linkStats_.resyncBytes;
+            linkMetrics_.addResync(1);
             continue;
         }
 
-        uint8_t responseType = static_cast<uint8_t>(header.at(1));
-        uint8_t messageLength = static_cast<uint8_t>(header.at(2));
+        uint8_t responseType = static_cast<uint8_t>(buffer_.at(1));
+        uint8_t messageLength = static_cast<uint8_t>(buffer_.at(2));
 
         // Проверяем, достаточно ли данных в буфере для полного сообщения
         if (buffer_.size() < 3 + messageLength + 1) {
@@ -94,12 +289,31 @@ void InsCommandProcessor::handleDataReceived(const QByteArray& incomingData)
         }
 
         // Если сообщение корректно, вызываем колбэк и удаляем данные из буфера
-        responseCallback_(buffer_.pop(3 + messageLength + 1));
-        messagesCount += 1;
+        const int messageSize = 3 + messageLength + 1;
+        const qint64 messageArrivalNs = takeArrival(messageSize);
+        // При воспроизведении с исходным временем задержка не имеет смысла
+        if (hasMonotonicArrivals()) {
+            const qint64 latencyNs = MonotonicClock::nowNs() - messageArrivalNs;
+            ++latencyFrames_;
+            latencySumNs_ += latencyNs;
+            maxLatencyNs_ = std::max(maxLatencyNs_, latencyNs);
+        }
+        frame_.resize(messageSize);
+        buffer_.pop(frame_.data(), messageSize);
+        const bool crcOk = validateCRC(frame_.constData(), messageSize - 1, static_cast<uint8_t>(frame_.at(messageSize - 1)));
+        if (crcOk) {
+            ++linkStats_.frames;
+        } else {
+            ++linkStats_.crcFailures;
+        }
+        linkMetrics_.addFrame(messageArrivalNs, crcOk);
+        diagnostics.record(PipelineDiagnostics::FRAMING, MonotonicClock::nowNs() - framingStartNs,
+                           AllocationCounter::threadCount() - framingStartAllocations);
+        responseCallback_(frame_, messageArrivalNs);
+        framingStartNs = MonotonicClock::nowNs();
+        framingStartAllocations = AllocationCounter::threadCount();
+        // Принятые кадры идут сотнями в секунду, в журнал пишутся только отказы
         switch (responseType) {
-        case Accepted:
-            qDebug() << "Accepted";
-            break;
         case Rejected:
             qDebug() << "Rejected";
             break;
@@ -108,11 +322,12 @@ void InsCommandProcessor::handleDataReceived(const QByteArray& incomingData)
             break;
         }
     }
+    linkMetrics_.flush(MonotonicClock::nowNs());
 }
 
 void InsCommandProcessor::interrupt()
 {
-    if (!serialPort->isOpen()) {
+    if (!isConnected()) {
         qDebug() << "Serial port is not open.";
         return;
     }
@@ -121,55 +336,195 @@ void InsCommandProcessor::interrupt()
 
     QByteArray commandData = command.toByteArray();
     qDebug() << "Stop command data: " << commandData;
-    int writtenBytes = serialPort->write(commandData);
+    int writtenBytes = writeCommand(commandData);
     if (writtenBytes < commandData.size()) {
         qDebug() << "Failed to send full command";
         throw new QException();
     }
 
-    shouldStopReading = true;
-    if (readThread) {
-        readThread->quit();
-        readThread->wait();
-        delete readThread;
-        readThread = nullptr;
+    stopReadThread();
+    stopRawCapture();
+}
+
+// Время чтения куска, в котором пришел последний байт сообщения
+qint64 InsCommandProcessor::takeArrival(int messageSize)
+{
+    while (arrivalsHead_ < arrivals_.size() && arrivals_[arrivalsHead_].first <= consumedBytes_) {
+        ++arrivalsHead_;
+    }
+    // Разобранные куски убираются сдвигом, емкость вектора сохраняется
+    if (arrivalsHead_ > 0 && arrivalsHead_ * 2 >= arrivals_.size()) {
+        arrivals_.erase(arrivals_.begin(), arrivals_.begin() + arrivalsHead_);
+        arrivalsHead_ = 0;
     }
+    consumedBytes_ += messageSize;
+    for (size_t i = arrivalsHead_; i < arrivals_.size(); ++i) {
+        if (arrivals_[i].first >= consumedBytes_) {
+            return arrivals_[i].second;
+        }
+    }
+    return arrivalsHead_ == arrivals_.size() ? MonotonicClock::nowNs() : arrivals_.back().second;
+}
+
+// Недоразобранный хвост и границы его кусков больше не нужны
+void InsCommandProcessor::discardBuffered()
+{
+    buffer_.discard(buffer_.size());
+    consumedBytes_ = receivedBytes_;
+    arrivals_.clear();
+    arrivalsHead_ = 0;
 }
 
-void InsCommandProcessor::reconfigureUart(QSerialPort::BaudRate baudRate, QSerialPort::DataBits dataBits, QSerialPort::Parity parity, QSerialPort::FlowControl flowControl, QSerialPort::StopBits stopBits)
+void InsCommandProcessor::reconfigureUart(qint32 baudRate, QSerialPort::DataBits dataBits, QSerialPort::Parity parity, QSerialPort::FlowControl flowControl, QSerialPort::StopBits stopBits)
 {
-    if (!serialPort->isOpen()) {
+    if (!isConnected()) {
         qDebug() << "Serial port is not open.";
         return;
     }
     responseCallback_ = EMPTY_CALLBACK;
 
+    if (!sendUartSettings(baudRate, dataBits, parity, flowControl, stopBits)) {
+        throw new QException();
+    }
+
+    emit stopped();
+}
+
+bool InsCommandProcessor::sendUartSettings(qint32 baudRate, QSerialPort::DataBits dataBits, QSerialPort::Parity parity, QSerialPort::FlowControl flowControl, QSerialPort::StopBits stopBits)
+{
+    if (!isConnected()) {
+        qDebug() << "Serial port is not open.";
+        return false;
+    }
+
     UartSettings uartSettings(baudRate, dataBits, parity, flowControl, stopBits);
     Command<UartSettings> command(CommandType::ReconfigureUart);
     command.setBody(uartSettings);
 
     QByteArray commandData = command.toByteArray();
     qDebug() << "Reconfigure UART command data: " << commandData;
-    int writtenBytes = serialPort->write(commandData);
+    int writtenBytes = writeCommand(commandData);
     if (writtenBytes < commandData.size()) {
         qDebug() << "Failed to send full command";
-        throw new QException();
+        return false;
     }
+    return true;
+}
 
-    emit stopped();
+
+const SessionClock &InsCommandProcessor::getSessionClock() const {
+    return sessionClock_;
+}
+
+void InsCommandProcessor::setIngestPolicy(int capacity, IngestQueue::OverflowPolicy policy) {
+    ingestCapacity_ = capacity;
+    ingestPolicy_ = policy;
 }
 
-void InsCommandProcessor::updateCounter() {
-    frequency = messagesCount;
-    messagesCount = 0;
+IngestStats InsCommandProcessor::getIngestStats() const {
+    return ingestQueue_ ? ingestQueue_->stats() : IngestStats();
 }
 
-int InsCommandProcessor::getFrequency() {
-    return frequency;
+void InsCommandProcessor::setRawCaptureDirectory(const QString &directory) {
+    rawCaptureDirectory_ = directory;
 }
 
-void InsCommandProcessor::setSpeed(QSerialPort::BaudRate baudRate) {
+RawCaptureStats InsCommandProcessor::getRawCaptureStats() const {
+    std::shared_ptr<RawCaptureWriter> capture = std::atomic_load(&rawCapture_);
+    return capture ? capture->stats() : RawCaptureStats();
+}
+
+QString InsCommandProcessor::getRawCaptureFileName() const {
+    return rawCaptureFileName_;
+}
+
+// Файл открывается до GetData, чтобы в него попал весь ответ устройства
+void InsCommandProcessor::startRawCapture()
+{
+    if (rawCaptureDirectory_.isEmpty() || std::atomic_load(&rawCapture_)) {
+        return;
+    }
+    QDir dir(rawCaptureDirectory_);
+    if (!dir.exists()) {
+        dir.mkpath(".");
+    }
+    // Перезапуск в ту же миллисекунду получает следующий свободный номер
+    const QString stamp = sessionClock_.toDateTime(sessionClock_.monotonicAnchorNs()).toString("yyyyMMdd_HHmmss_zzz");
+    QString path = dir.filePath(QString("raw_%1.%2").arg(stamp).arg(RawCapture::SUFFIX));
+    for (int index = 1; QFile::exists(path) && index < MAX_RAW_CAPTURE_NAME_TRIES; ++index) {
+        path = dir.filePath(QString("raw_%1_%2.%3").arg(stamp).arg(index).arg(RawCapture::SUFFIX));
+    }
+    std::shared_ptr<RawCaptureWriter> capture = std::make_shared<RawCaptureWriter>();
+    if (!capture->open(path, sessionClock_.wallAnchorNs(), sessionClock_.monotonicAnchorNs())) {
+        qDebug() << "Сырой поток не записывается: файл" << path << "не создан";
+        return;
+    }
+    rawCaptureFileName_ = path;
+    std::atomic_store(&rawCapture_, capture);
+}
+
+// Поток чтения к этому моменту остановлен, последний append уже в буфере записи
+void InsCommandProcessor::stopRawCapture()
+{
+    std::shared_ptr<RawCaptureWriter> capture = std::atomic_exchange(&rawCapture_, std::shared_ptr<RawCaptureWriter>());
+    if (capture) {
+        capture->close();
+    }
+}
+
+void InsCommandProcessor::setSpeed(qint32 baudRate) {
+    if (replay_) {
+        return;
+    }
+    // Недоразобранный хвост пришел на прежней скорости
+    discardBuffered();
+#ifdef Q_OS_LINUX
+    if (nativePort_.isOpen()) {
+        nativePort_.setBaudRate(baudRate);
+        nativePort_.flushInput();
+        return;
+    }
+#endif
     serialPort->setBaudRate(baudRate);
+    serialPort->clear(QSerialPort::Input);
+}
+
+LinkStats InsCommandProcessor::getLinkStats() const {
+    return linkStats_;
+}
+
+void InsCommandProcessor::resetLinkStats() {
+    linkStats_ = LinkStats();
+}
+
+LinkMetricsSnapshot InsCommandProcessor::getLinkMetrics() const {
+    return linkMetrics_.snapshot();
+}
+
+void InsCommandProcessor::setReadMode(SerialReadMode mode) {
+#ifndef Q_OS_LINUX
+    if (mode != SerialReadMode::STANDARD) {
+        qDebug() << "Собственное чтение порта доступно только в Linux, используется QSerialPort";
+        mode = SerialReadMode::STANDARD;
+    }
+#endif
+    readMode_ = mode;
+}
+
+void InsCommandProcessor::setReaderThreadOptions(bool realtime, int cpu) {
+    nativeOptions_.realtime = realtime;
+    nativeOptions_.cpu = cpu;
+}
+
+ReaderStats InsCommandProcessor::getReaderStats() const {
+    ReaderStats stats;
+    stats.mode = isNativePortOpen() ? readMode_ : SerialReadMode::STANDARD;
+    stats.wakeups = readWakeups_;
+    stats.bytes = readBytes_;
+    stats.frames = latencyFrames_;
+    stats.meanLatencyNs = latencyFrames_ > 0 ? latencySumNs_ / latencyFrames_ : 0;
+    stats.maxLatencyNs = maxLatencyNs_;
+    return stats;
 }
 
 QString InsCommandProcessor::responseTypeToString(ResponseType type) const
@@ -183,10 +538,10 @@ QString InsCommandProcessor::responseTypeToString(ResponseType type) const
     }
 }
 
-bool InsCommandProcessor::validateCRC(const QByteArray &message, uint8_t expectedCrc) const
+bool InsCommandProcessor::validateCRC(const char *message, int size, uint8_t expectedCrc) const
 {
     uint8_t polynomial = 0x07;
-    uint8_t crc = 0x00;for (size_t i = 0; i < message.size(); i++) {
+    uint8_t crc = 0x00;for (int i = 0; i < size; i++) {
         crc ^= message[i];
         for (uint8_t j = 0; j < 8; j++) {
             if (crc & 0x80) {
@@ -200,17 +555,99 @@ bool InsCommandProcessor::validateCRC(const QByteArray &message, uint8_t expecte
     return expectedCrc == crc;
 }
 
-bool InsCommandProcessor::openSerialPort(const QString &portName, QSerialPort::BaudRate baudRate,
+bool InsCommandProcessor::openSerialPort(const QString &portName, qint32 baudRate,
                                        QSerialPort::DataBits dataBits, QSerialPort::Parity parity,
                                        QSerialPort::StopBits stopBits, QSerialPort::FlowControl flowControl)
 {
-    bool result = SerialReaderWriter::openSerialPort(portName, baudRate, dataBits, parity, stopBits, flowControl);
+    if (ReplayEngine::isReplayFile(portName)) {
+        return openReplay(portName);
+    }
+
+    bool result = false;
+#ifdef Q_OS_LINUX
+    if (readMode_ != SerialReadMode::STANDARD) {
+        NativeReaderOptions options = nativeOptions_;
+        options.mode = readMode_;
+        options.frameBytes = SENSOR_FRAME_BYTES;
+        portName_ = portName;
+        result = nativePort_.open(portName, baudRate, dataBits, parity, stopBits, flowControl, options);
+        lastError = result ? QString() : nativePort_.errorString();
+        emit connectionStatusChanged(result);
+        return result;
+    }
+#endif
+    result = SerialReaderWriter::openSerialPort(portName, baudRate, dataBits, parity, stopBits, flowControl);
     emit connectionStatusChanged(result);
     return result;
 }
 
 void InsCommandProcessor::closeSerialPort()
 {
+    stopReadThread();
+    stopRawCapture();
+#ifdef Q_OS_LINUX
+    nativePort_.close();
+#endif
+    replay_.reset();
     SerialReaderWriter::closeSerialPort();
     emit connectionStatusChanged(false);
 }
+
+bool InsCommandProcessor::openReplay(const QString &path)
+{
+    stopReadThread();
+    std::unique_ptr<ReplaySource> source = ReplayEngine::openSource(path);
+    if (!source) {
+        lastError = "Не удалось открыть запись " + path;
+        emit connectionStatusChanged(false);
+        return false;
+    }
+    replay_.reset(new ReplayEngine(std::move(source), replayOptions_));
+    portName_ = path;
+    lastError.clear();
+    emit connectionStatusChanged(true);
+    return true;
+}
+
+bool InsCommandProcessor::isReplaying() const
+{
+    return replay_ != nullptr;
+}
+
+void InsCommandProcessor::setReplayOptions(const ReplayOptions &options)
+{
+    replayOptions_ = options;
+    if (replay_) {
+        replay_->setSpeed(options.speed);
+    }
+}
+
+void InsCommandProcessor::seekReplay(qint64 timeNs)
+{
+    if (!replay_) {
+        return;
+    }
+    // Принятое, но не разобранное относится к прежней позиции и отбрасывается
+    const bool reading = readThread != nullptr || serialReadConnection_;
+    stopReadThread();
+    if (ingestQueue_) {
+        std::deque<IngestChunk> stale;
+        ingestQueue_->drain(stale);
+    }
+    discardBuffered();
+    replay_->seek(timeNs);
+    emit replaySought();
+    if (reading) {
+        startReadThread();
+    }
+}
+
+ReplayPosition InsCommandProcessor::getReplayPosition() const
+{
+    return replay_ ? replay_->position() : ReplayPosition();
+}
+
+bool InsCommandProcessor::hasMonotonicArrivals() const
+{
+    return !replay_ || !replay_->options().originalTimestamps;
+}
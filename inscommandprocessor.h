@@ -8,13 +8,43 @@
 #include <functional>
 #include <qtimer.h>
 #include <QThread>
+#include <QPair>
+#include <atomic>
+#include <memory>
 
 #include "dynamiccircularbuffer.h"
+#include "ingestqueue.h"
+#include "linkmetrics.h"
+#include "monotonicclock.h"
+#include "nativeserialport.h"
+#include "rawcapture.h"
+#include "replayengine.h"
 #include "serialreader.h"
 
+// Счетчики потока чтения и задержка кадра от чтения до передачи в колбэк
+struct ReaderStats
+{
+    SerialReadMode mode = SerialReadMode::STANDARD;
+    qint64 wakeups = 0;        // чтения с данными
+    qint64 bytes = 0;
+    qint64 frames = 0;
+    double meanLatencyNs = 0;
+    qint64 maxLatencyNs = 0;
+};
+
+// Качество связи: по нему подбирается скорость порта
+struct LinkStats
+{
+    qint64 frames = 0;       // сообщения с верным CRC
+    qint64 crcFailures = 0;  // сообщения с неверным CRC
+    qint64 resyncBytes = 0;  // байты, пропущенные при поиске стартового байта
+};
+
 class InsCommandProcessor : public SerialReaderWriter
 {
     Q_OBJECT
+    // Микробенчмарк разбора в bench/ingest_bench.cpp
+    friend class IngestBench;
 
 public:
     enum ResponseType {
@@ -24,54 +54,151 @@ public:
         BAD_RESPONSE = 0x04
     };
 
+    // Ответ и монотонное время чтения, в котором пришел его последний байт
+    using ResponseCallback = std::function<void(const QByteArray&, qint64 arrivalNs)>;
+
     explicit InsCommandProcessor(QObject *parent = nullptr);
     ~InsCommandProcessor();
 
-    virtual bool openSerialPort(const QString &portName, QSerialPort::BaudRate baudRate,
+    virtual bool openSerialPort(const QString &portName, qint32 baudRate,
                        QSerialPort::DataBits dataBits, QSerialPort::Parity parity,
                        QSerialPort::StopBits stopBits, QSerialPort::FlowControl flowControl) override;
     virtual void closeSerialPort() override;
 
-    bool isConnected() const { return serialPort && serialPort->isOpen(); }
+    bool isConnected() const;
 
-    void readData(const std::function<void(const QByteArray&)> &callback);
+    // Режим чтения и параметры потока чтения применяются при следующем подключении
+    void setReadMode(SerialReadMode mode);
+    void setReaderThreadOptions(bool realtime, int cpu);
+    ReaderStats getReaderStats() const;
+
+    void readData(const ResponseCallback &callback);
+    // Пробный прием: счетчики связи и метрики идут как обычно, но файл сырого потока не создается
+    void readTrialData(const ResponseCallback &callback);
     void interrupt();
-    void reconfigureUart(QSerialPort::BaudRate baudRate, QSerialPort::DataBits dataBits, QSerialPort::Parity parity, QSerialPort::FlowControl flowControl, QSerialPort::StopBits stopBits);
+    void reconfigureUart(qint32 baudRate, QSerialPort::DataBits dataBits, QSerialPort::Parity parity, QSerialPort::FlowControl flowControl, QSerialPort::StopBits stopBits);
+    // Отправляет устройству новые параметры UART без остановки приема и сигнала stopped
+    bool sendUartSettings(qint32 baudRate, QSerialPort::DataBits dataBits, QSerialPort::Parity parity, QSerialPort::FlowControl flowControl, QSerialPort::StopBits stopBits);
+
+    // Меняет скорость порта; байты, принятые на прежней скорости, отбрасываются
+    void setSpeed(qint32 baudRate);
 
-    void setSpeed(QSerialPort::BaudRate baudRate);
+    LinkStats getLinkStats() const;
+    void resetLinkStats();
+    // Последний опубликованный снимок; обновляется раз в LinkMetrics::WINDOW_NS
+    LinkMetricsSnapshot getLinkMetrics() const;
 
 public:
-    int getFrequency();
+    // Якорь календарного времени текущей сессии чтения
+    const SessionClock &getSessionClock() const;
+
+    // Размер и политика очереди приема применяются при следующем запуске чтения
+    void setIngestPolicy(int capacity, IngestQueue::OverflowPolicy policy);
+    IngestStats getIngestStats() const;
+
+    // Сырой поток порта пишется в directory на каждый запуск чтения; пустой каталог - не писать
+    void setRawCaptureDirectory(const QString &directory);
+    RawCaptureStats getRawCaptureStats() const;
+    QString getRawCaptureFileName() const;
+
+    // Воспроизведение записи вместо порта: openSerialPort с путем к файлу записи
+    // или сырого потока открывает его как устройство. GetData запускает воспроизведение,
+    // Stop ставит на паузу, разбор и колбэк те же, что для порта.
+    bool openReplay(const QString &path);
+    bool isReplaying() const;
+    // Скорость применяется сразу, исходное время - при следующем открытии
+    void setReplayOptions(const ReplayOptions &options);
+    void seekReplay(qint64 timeNs);
+    ReplayPosition getReplayPosition() const;
+    // Метки кадров - монотонное время чтения; при воспроизведении с исходным временем - нет
+    bool hasMonotonicArrivals() const;
 
 signals:
     void connectionStatusChanged(bool connected);
     void stopped();
-    void dataReceived(const QByteArray& data);
+    // В очереди приема появились данные; одно уведомление на серию кусков
+    void dataAvailable();
+    // Воспроизведение перемотано: показанные данные больше не продолжаются новыми
+    void replaySought();
 
 private slots:
-    void updateCounter();
-    void handleDataReceived(const QByteArray& data);
+    void handleDataAvailable();
+    void handleSerialReadyRead();
+    void handleNativeHangUp();
 
 private:
-    void readThreadFunction();
+    void startReading(const ResponseCallback &callback, bool rawCapture);
+    void startReadThread();
+    void stopReadThread();
+    void readNativeThreadFunction();
+    void readReplayThreadFunction();
+    void enqueueRead(const QByteArray &data, qint64 arrivalNs);
+    void startRawCapture();
+    void stopRawCapture();
+    qint64 writeCommand(const QByteArray &data);
+    bool isNativePortOpen() const;
+    void handleDataReceived(const QByteArray& data, qint64 arrivalNs);
+    qint64 takeArrival(int messageSize);
+    void discardBuffered();
     QString responseTypeToString(ResponseType type) const;
-    bool validateCRC(const QByteArray &message, uint8_t crc) const;
+    bool validateCRC(const char *message, int size, uint8_t crc) const;
 
     const int BUFFER_SIZE = 2048 * 10;
-    std::function<void(const QByteArray&)> EMPTY_CALLBACK = [this](const QByteArray &data) {};
-    std::function<void(const QByteArray&)> responseCallback_;
+    ResponseCallback EMPTY_CALLBACK = [this](const QByteArray &data, qint64 arrivalNs) {};
+    ResponseCallback responseCallback_;
     DynamicCircularBuffer buffer_;
+    // Кадр, передаваемый в колбэк; переиспользуется между кадрами
+    QByteArray frame_;
+    // Границы прочитанных кусков в сквозной нумерации байт и время их чтения, с arrivalsHead_ до конца
+    std::vector<QPair<qint64, qint64>> arrivals_;
+    size_t arrivalsHead_ = 0;
+    qint64 receivedBytes_ = 0;
+    qint64 consumedBytes_ = 0;
+    SessionClock sessionClock_;
     int tail;
     int head;
 
     bool addByteToBuffer(uint8_t byte);
     QByteArray getCompleteMessage();
 
-    int messagesCount = 0;
-    int frequency = 0;
-    QTimer timer;
     QThread* readThread;
-    bool shouldStopReading;
+    std::atomic<bool> shouldStopReading;
+    // Чтение QSerialPort в потоке GUI: соединение с readyRead на время приема
+    QMetaObject::Connection serialReadConnection_;
+
+    // Очередь создается заново на каждый запуск чтения и живет до следующего
+    std::unique_ptr<IngestQueue> ingestQueue_;
+    // Куски, забранные из очереди за одно уведомление
+    std::deque<IngestChunk> drained_;
+    int ingestCapacity_ = 1024;
+    IngestQueue::OverflowPolicy ingestPolicy_ = IngestQueue::DROP_OLDEST;
+
+    // Кадр данных датчика: заголовок 3 байта, 3 float, 9 int16, счетчик и CRC
+    static constexpr int SENSOR_FRAME_BYTES = 3 + sizeof(float) * 3 + sizeof(int16_t) * 9 + 1 + 1;
+    SerialReadMode readMode_ = SerialReadMode::STANDARD;
+    NativeReaderOptions nativeOptions_;
+#ifdef Q_OS_LINUX
+    NativeSerialPort nativePort_;
+#endif
+
+    std::atomic<qint64> readWakeups_{0};
+    std::atomic<qint64> readBytes_{0};
+    qint64 latencyFrames_ = 0;
+    double latencySumNs_ = 0;
+    qint64 maxLatencyNs_ = 0;
+
+    LinkStats linkStats_;
+    LinkMetrics linkMetrics_;
+
+    // Попыток подобрать свободное имя файла сырого потока
+    static constexpr int MAX_RAW_CAPTURE_NAME_TRIES = 100;
+    QString rawCaptureDirectory_;
+    // Поток чтения берет указатель через atomic_load, поэтому остановка записи его не ждет
+    std::shared_ptr<RawCaptureWriter> rawCapture_;
+    QString rawCaptureFileName_;
+
+    std::unique_ptr<ReplayEngine> replay_;
+    ReplayOptions replayOptions_;
 };
 
 #endif // INSCOMMANDPROCESSOR_H
@@ -2,16 +2,78 @@
 #define ISENSORDATADAO_H
 
 #include "extendedsensordata.h"
+#include "sensordatacursor.h"
+#include "recordingdurability.h"
 #include <QString>
 #include <QList>
+#include <limits>
+#include <memory>
 
 class ISensorDataDAO {
 public:
+    static constexpr int DEFAULT_BATCH_SIZE = 4096;
+
     virtual ~ISensorDataDAO() = default;
 
     virtual bool insertSensorData(const TimestampedSensorData &data) = 0;
-    virtual QList<TimestampedSensorData> selectSensorData(const QDateTime &start, const QDateTime &end) = 0;
-    virtual QList<TimestampedSensorData> selectAllSensorData() = 0; // Новый метод
+
+    // Как часто записанное сбрасывается на диск; форматы только для чтения политику игнорируют
+    virtual void setDurabilityPolicy(const DurabilityPolicy &policy) {
+        Q_UNUSED(policy);
+    }
+
+    // Время последней строки, гарантированно сохраненной на диск
+    virtual qint64 lastDurableTimestamp() const {
+        return std::numeric_limits<qint64>::min();
+    }
+
+    // Вызывается пишущим потоком и в паузах между строками: дописывает отложенное
+    // и сбрасывает на диск, если по политике подошел срок
+    virtual void syncIfDue() {
+    }
+
+    // Сколько файлов занимает запись; больше одного только у сессии с ротацией
+    virtual int fileCount() const {
+        return 1;
+    }
+
+    // Потоковая выборка: строки выдаются пакетами по batchSize
+    virtual std::unique_ptr<ISensorDataCursor> selectSensorDataCursor(const QDateTime &start, const QDateTime &end,
+                                                                      int batchSize = DEFAULT_BATCH_SIZE) = 0;
+    virtual std::unique_ptr<ISensorDataCursor> selectAllSensorDataCursor(int batchSize = DEFAULT_BATCH_SIZE) = 0;
+
+    // Курсор по записи, которая еще пишется: когда целые строки заканчиваются,
+    // next() возвращает false, но после дописывания файла может вызываться снова
+    // и читает только новые байты. Форматы без дописывания возвращают nullptr.
+    virtual std::unique_ptr<ISensorDataCursor> selectFollowCursor(int batchSize = DEFAULT_BATCH_SIZE) {
+        Q_UNUSED(batchSize);
+        return nullptr;
+    }
+
+    // Полная материализация выборки, для небольших объемов
+    virtual QList<TimestampedSensorData> selectSensorData(const QDateTime &start, const QDateTime &end) {
+        return collect(selectSensorDataCursor(start, end));
+    }
+
+    virtual QList<TimestampedSensorData> selectAllSensorData() {
+        return collect(selectAllSensorDataCursor());
+    }
+
+private:
+    static QList<TimestampedSensorData> collect(std::unique_ptr<ISensorDataCursor> cursor) {
+        QList<TimestampedSensorData> dataList;
+        if (!cursor) {
+            return dataList;
+        }
+
+        SensorDataBatch batch;
+        while (cursor->next(batch)) {
+            for (int i = 0; i < batch.size(); ++i) {
+                dataList.append(batch.row(i));
+            }
+        }
+        return dataList;
+    }
 };
 
 #endif // ISENSORDATADAO_H
@@ -0,0 +1,93 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QtGlobal>
+#include <algorithm>
+#include <array>
+
+// Гистограмма задержек в наносекундах для перцентилей без хранения выборки.
+// Корзины логарифмические, по SUB_BUCKETS на октаву: погрешность перцентиля не больше 1/SUB_BUCKETS.
+// Запись без выделения памяти, пишет один поток.
+class LatencyHistogram
+{
+public:
+    static constexpr int SUB_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BITS;
+    // Старший бит 40 - около 1100 с, большие значения попадают в последнюю корзину
+    static constexpr int MAX_BIT = 40;
+    static constexpr int BUCKETS = (MAX_BIT - SUB_BITS + 2) * SUB_BUCKETS;
+
+    void record(qint64 valueNs) {
+        valueNs = std::max<qint64>(0, valueNs);
+        ++buckets_[bucketOf(valueNs)];
+        ++count_;
+        sumNs_ += valueNs;
+        maxNs_ = std::max(maxNs_, valueNs);
+    }
+
+    void reset() {
+        buckets_.fill(0);
+        count_ = 0;
+        sumNs_ = 0;
+        maxNs_ = 0;
+    }
+
+    qint64 count() const {
+        return count_;
+    }
+
+    qint64 maxNs() const {
+        return maxNs_;
+    }
+
+    double meanNs() const {
+        return count_ > 0 ? sumNs_ / count_ : 0;
+    }
+
+    // fraction от 0 до 1: 0.5 - медиана, 0.999 - p99.9
+    qint64 percentileNs(double fraction) const {
+        if (count_ == 0) {
+            return 0;
+        }
+        const qint64 rank = std::max<qint64>(1, static_cast<qint64>(fraction * count_ + 0.5));
+        qint64 seen = 0;
+        for (int i = 0; i < BUCKETS; ++i) {
+            seen += buckets_[i];
+            if (seen >= rank) {
+                return std::min(valueOf(i), maxNs_);
+            }
+        }
+        return maxNs_;
+    }
+
+private:
+    static int bucketOf(qint64 value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<int>(value);
+        }
+        int topBit = SUB_BITS;
+        while (topBit < MAX_BIT && (value >> (topBit + 1)) != 0) {
+            ++topBit;
+        }
+        const int shift = topBit - SUB_BITS;
+        const int sub = static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+        return std::min(BUCKETS - 1, (shift + 1) * SUB_BUCKETS + sub);
+    }
+
+    // Середина корзины
+    static qint64 valueOf(int bucket) {
+        if (bucket < SUB_BUCKETS) {
+            return bucket;
+        }
+        const int shift = bucket / SUB_BUCKETS - 1;
+        const qint64 sub = bucket % SUB_BUCKETS;
+        return ((SUB_BUCKETS + sub) << shift) + ((qint64(1) << shift) >> 1);
+    }
+
+    std::array<qint64, BUCKETS> buckets_{};
+    qint64 count_ = 0;
+    double sumNs_ = 0;
+    qint64 maxNs_ = 0;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -0,0 +1,142 @@
+#ifndef LINKMETRICS_H
+#define LINKMETRICS_H
+
+#include "latencyhistogram.h"
+
+#include <QtGlobal>
+#include <cmath>
+
+// Снимок метрик связи за последнее окно
+struct LinkMetricsSnapshot
+{
+    double rateHz = 0;                // кадров в секунду за окно
+    double ewmaRateHz = 0;            // по сглаженному интервалу между кадрами
+    double bytesPerSecond = 0;
+    double crcFailuresPerSecond = 0;
+    double resyncBytesPerSecond = 0;
+    qint64 intervalP50Ns = 0;         // средний интервал между кадрами соседних чтений за окно
+    qint64 intervalP99Ns = 0;
+    qint64 intervalMaxNs = 0;
+    double jitterNs = 0;              // сглаженное отклонение интервала от среднего, как в RFC 3550
+    qint64 publishedNs = 0;           // монотонное время публикации, 0 - снимка еще нет
+
+    // Новых кадров нет: последний снимок показывает прошлое
+    bool isStale(qint64 nowNs, qint64 windowNs) const {
+        return publishedNs == 0 || nowNs - publishedNs > 2 * windowNs;
+    }
+};
+
+// Частота, интервалы и ошибки связи. Считаются при разборе кадров в handleDataReceived
+// без блокировок и выделений; раз в окно сохраняется снимок. Запись и чтение снимка идут
+// в потоке GUI, поэтому синхронизация не нужна.
+// У кадров одного чтения общее время прихода, поэтому интервал считается только между чтениями:
+// время между чтениями делится на число кадров предыдущего чтения. Иначе нулевые интервалы
+// внутри чтения показывали бы пакетирование чтения порта, а не связь.
+class LinkMetrics
+{
+public:
+    static constexpr qint64 WINDOW_NS = 1000000000;
+    // Вес нового интервала в сглаженном среднем и в джиттере
+    static constexpr double EWMA_WEIGHT = 1.0 / 16;
+
+    // Вызывается при новом сеансе чтения
+    void reset() {
+        interval_.reset();
+        readArrivalNs_ = 0;
+        readFrames_ = 0;
+        ewmaIntervalNs_ = 0;
+        jitterNs_ = 0;
+        windowStartNs_ = 0;
+        frames_ = 0;
+        bytes_ = 0;
+        crcFailures_ = 0;
+        resyncBytes_ = 0;
+        published_ = LinkMetricsSnapshot();
+    }
+
+    void addBytes(qint64 bytes) {
+        bytes_ += bytes;
+    }
+
+    void addResync(qint64 bytes) {
+        resyncBytes_ += bytes;
+    }
+
+    // arrivalNs - время чтения, в котором пришел кадр
+    void addFrame(qint64 arrivalNs, bool crcOk) {
+        if (!crcOk) {
+            ++crcFailures_;
+            return;
+        }
+        ++frames_;
+        if (arrivalNs == readArrivalNs_) {
+            ++readFrames_;
+            return;
+        }
+
+        // Первый кадр нового чтения закрывает предыдущее; при перемотке воспроизведения время идет назад
+        if (readFrames_ > 0 && arrivalNs > readArrivalNs_) {
+            const qint64 interval = (arrivalNs - readArrivalNs_) / readFrames_;
+            interval_.record(interval);
+            if (ewmaIntervalNs_ == 0) {
+                ewmaIntervalNs_ = interval;
+            }
+            jitterNs_ += (std::abs(interval - ewmaIntervalNs_) - jitterNs_) * EWMA_WEIGHT;
+            ewmaIntervalNs_ += (interval - ewmaIntervalNs_) * EWMA_WEIGHT;
+        }
+        readArrivalNs_ = arrivalNs;
+        readFrames_ = 1;
+    }
+
+    // Конец разобранного куска: по истечении окна публикуется снимок
+    void flush(qint64 nowNs) {
+        if (windowStartNs_ == 0) {
+            windowStartNs_ = nowNs;
+            return;
+        }
+        const qint64 elapsed = nowNs - windowStartNs_;
+        if (elapsed < WINDOW_NS) {
+            return;
+        }
+        const double seconds = elapsed / 1e9;
+        LinkMetricsSnapshot snapshot;
+        snapshot.rateHz = frames_ / seconds;
+        snapshot.ewmaRateHz = ewmaIntervalNs_ > 0 ? 1e9 / ewmaIntervalNs_ : 0;
+        snapshot.bytesPerSecond = bytes_ / seconds;
+        snapshot.crcFailuresPerSecond = crcFailures_ / seconds;
+        snapshot.resyncBytesPerSecond = resyncBytes_ / seconds;
+        snapshot.intervalP50Ns = interval_.percentileNs(0.5);
+        snapshot.intervalP99Ns = interval_.percentileNs(0.99);
+        snapshot.intervalMaxNs = interval_.maxNs();
+        snapshot.jitterNs = jitterNs_;
+        snapshot.publishedNs = nowNs;
+        published_ = snapshot;
+
+        interval_.reset();
+        windowStartNs_ = nowNs;
+        frames_ = 0;
+        bytes_ = 0;
+        crcFailures_ = 0;
+        resyncBytes_ = 0;
+    }
+
+    LinkMetricsSnapshot snapshot() const {
+        return published_;
+    }
+
+private:
+    LatencyHistogram interval_;
+    qint64 readArrivalNs_ = 0;        // время чтения последнего кадра
+    qint64 readFrames_ = 0;           // кадров в этом чтении
+    double ewmaIntervalNs_ = 0;
+    double jitterNs_ = 0;
+    qint64 windowStartNs_ = 0;
+    qint64 frames_ = 0;
+    qint64 bytes_ = 0;
+    qint64 crcFailures_ = 0;
+    qint64 resyncBytes_ = 0;
+
+    LinkMetricsSnapshot published_;
+};
+
+#endif // LINKMETRICS_H
@@ -0,0 +1,143 @@
+#include "linkspeedtuner.h"
+
+#include <QDebug>
+#include <QException>
+#include <algorithm>
+
+LinkSpeedTuner::LinkSpeedTuner(InsCommandProcessor *processor, QObject *parent)
+    : QObject(parent), processor_(processor)
+{
+    trialTimer_.setSingleShot(true);
+    connect(&trialTimer_, &QTimer::timeout, this, &LinkSpeedTuner::endTrial);
+}
+
+bool LinkSpeedTuner::start(qint32 currentBaudRate, const QVector<qint32> &candidates,
+                           QSerialPort::DataBits dataBits, QSerialPort::Parity parity,
+                           QSerialPort::FlowControl flowControl, QSerialPort::StopBits stopBits)
+{
+    if (running_ || !processor_->isConnected()) {
+        return false;
+    }
+
+    candidates_.clear();
+    for (qint32 baudRate : candidates) {
+        if (baudRate > currentBaudRate) {
+            candidates_.append(baudRate);
+        }
+    }
+    std::sort(candidates_.begin(), candidates_.end());
+
+    dataBits_ = dataBits;
+    parity_ = parity;
+    flowControl_ = flowControl;
+    stopBits_ = stopBits;
+    nextCandidate_ = 0;
+    bestBaudRate_ = currentBaudRate;
+    trialBaudRate_ = currentBaudRate;
+    baselineChecked_ = false;
+    cancelled_ = false;
+    running_ = true;
+
+    // Сначала замер на текущей скорости: без него нельзя отличить плохую ступень от плохой связи
+    beginTrial();
+    return true;
+}
+
+void LinkSpeedTuner::cancel()
+{
+    cancelled_ = true;
+}
+
+bool LinkSpeedTuner::isRunning() const
+{
+    return running_;
+}
+
+void LinkSpeedTuner::setTrialDuration(int ms)
+{
+    trialMs_ = std::max(100, ms);
+}
+
+void LinkSpeedTuner::beginTrial()
+{
+    processor_->resetLinkStats();
+    // Замер не оставляет файлов: сырой поток не пишется, а запись сеанса ведет
+    // только график, колбэк подбора данные не сохраняет
+    try {
+        processor_->readTrialData([](const QByteArray&, qint64) {});
+    } catch (QException *e) {
+        delete e;
+    }
+    trialTimer_.start(trialMs_);
+}
+
+void LinkSpeedTuner::endTrial()
+{
+    try {
+        processor_->interrupt();
+    } catch (QException *e) {
+        delete e;
+    }
+
+    const LinkStats stats = processor_->getLinkStats();
+    const bool clean = isClean(stats);
+    qDebug() << "Скорость" << trialBaudRate_ << ": кадров" << stats.frames
+             << "ошибок CRC" << stats.crcFailures << "пропущено байт" << stats.resyncBytes;
+    emit stepFinished(trialBaudRate_, stats, clean);
+
+    if (!baselineChecked_) {
+        baselineChecked_ = true;
+        if (!clean) {
+            running_ = false;
+            emit finished(bestBaudRate_, false);
+            return;
+        }
+    } else if (clean) {
+        bestBaudRate_ = trialBaudRate_;
+    } else {
+        restoreAndFinish();
+        return;
+    }
+
+    if (cancelled_ || nextCandidate_ >= candidates_.size()) {
+        running_ = false;
+        emit finished(bestBaudRate_, true);
+        return;
+    }
+
+    switchTo(candidates_[nextCandidate_++]);
+}
+
+// Устройство переключается по команде на прежней скорости, порт - после того,
+// как команда ушла и устройство успело перестроиться
+void LinkSpeedTuner::switchTo(qint32 baudRate)
+{
+    trialBaudRate_ = baudRate;
+    processor_->sendUartSettings(baudRate, dataBits_, parity_, flowControl_, stopBits_);
+    QTimer::singleShot(SETTLE_MS, this, [this]() {
+        processor_->setSpeed(trialBaudRate_);
+        beginTrial();
+    });
+}
+
+// Неизвестно, переключилось ли устройство на неудачную скорость, поэтому команда возврата
+// отправляется дважды: на неудачной скорости и на последней чистой
+void LinkSpeedTuner::restoreAndFinish()
+{
+    processor_->sendUartSettings(bestBaudRate_, dataBits_, parity_, flowControl_, stopBits_);
+    QTimer::singleShot(SETTLE_MS, this, [this]() {
+        processor_->setSpeed(bestBaudRate_);
+        processor_->sendUartSettings(bestBaudRate_, dataBits_, parity_, flowControl_, stopBits_);
+        QTimer::singleShot(SETTLE_MS, this, [this]() {
+            running_ = false;
+            emit finished(bestBaudRate_, true);
+        });
+    });
+}
+
+bool LinkSpeedTuner::isClean(const LinkStats &stats) const
+{
+    return stats.frames >= MIN_TRIAL_FRAMES
+        && stats.crcFailures == 0
+        && stats.resyncBytes <= RESYNC_TOLERANCE_BYTES;
+}
@@ -0,0 +1,72 @@
+#ifndef LINKSPEEDTUNER_H
+#define LINKSPEEDTUNER_H
+
+#include "inscommandprocessor.h"
+
+#include <QObject>
+#include <QSerialPort>
+#include <QTimer>
+#include <QVector>
+
+// Подбор скорости UART: устройство и порт по очереди переводятся на более высокие скорости,
+// на каждой ступени поток данных запускается на время замера и проверяются
+// ошибки CRC и пропущенные при ресинхронизации байты. Подъем останавливается на первой
+// ступени с ошибками, после чего обе стороны возвращаются на последнюю чистую скорость.
+// Подбор идет асинхронно в потоке GUI; прием данных на время подбора занят им.
+class LinkSpeedTuner : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Время на отправку команды и переключение устройства
+    static constexpr int SETTLE_MS = 200;
+    static constexpr int DEFAULT_TRIAL_MS = 1000;
+    // Меньше кадров за замер - скорость не проверена
+    static constexpr int MIN_TRIAL_FRAMES = 10;
+    // Допуск на обрывок кадра на границе замера
+    static constexpr int RESYNC_TOLERANCE_BYTES = 64;
+
+    explicit LinkSpeedTuner(InsCommandProcessor *processor, QObject *parent = nullptr);
+
+    // currentBaudRate - скорость, на которой устройство и порт работают сейчас;
+    // candidates - проверяемые скорости, берутся только большие текущей.
+    // false - подбор уже идет или порт закрыт
+    bool start(qint32 currentBaudRate, const QVector<qint32> &candidates,
+               QSerialPort::DataBits dataBits, QSerialPort::Parity parity,
+               QSerialPort::FlowControl flowControl, QSerialPort::StopBits stopBits);
+    void cancel();
+    bool isRunning() const;
+
+    void setTrialDuration(int ms);
+
+signals:
+    void stepFinished(qint32 baudRate, const LinkStats &stats, bool clean);
+    // success == false, если связь не чистая даже на исходной скорости
+    void finished(qint32 baudRate, bool success);
+
+private:
+    void beginTrial();
+    void endTrial();
+    void switchTo(qint32 baudRate);
+    void restoreAndFinish();
+    bool isClean(const LinkStats &stats) const;
+
+    InsCommandProcessor *processor_;
+    QTimer trialTimer_;
+    int trialMs_ = DEFAULT_TRIAL_MS;
+
+    QVector<qint32> candidates_;
+    int nextCandidate_ = 0;
+    qint32 bestBaudRate_ = 0;
+    qint32 trialBaudRate_ = 0;
+    bool baselineChecked_ = false;
+    bool running_ = false;
+    bool cancelled_ = false;
+
+    QSerialPort::DataBits dataBits_ = QSerialPort::Data8;
+    QSerialPort::Parity parity_ = QSerialPort::NoParity;
+    QSerialPort::FlowControl flowControl_ = QSerialPort::NoFlowControl;
+    QSerialPort::StopBits stopBits_ = QSerialPort::OneStop;
+};
+
+#endif // LINKSPEEDTUNER_H
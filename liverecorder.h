@@ -0,0 +1,167 @@
+#ifndef LIVERECORDER_H
+#define LIVERECORDER_H
+
+#include "isensordatadao.h"
+#include "sensordatacursor.h"
+
+#include <QDebug>
+#include <QtGlobal>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+struct LiveRecorderStats
+{
+    qint64 rows = 0;         // принято в запись
+    qint64 writtenRows = 0;  // передано DAO
+    qint64 droppedRows = 0;  // не поместились: диск не успевает
+    qint64 failedRows = 0;   // DAO вернул ошибку
+    // Последняя строка, которая по политике сброса уже гарантированно на диске
+    qint64 durableTimestampNs = std::numeric_limits<qint64>::min();
+    int files = 0;           // сегментов сессии при ротации, иначе 1
+
+    bool hasDurableTimestamp() const {
+        return durableTimestampNs != std::numeric_limits<qint64>::min();
+    }
+};
+
+// Запись принимаемых данных в файл во время приема.
+// append только дописывает строку в текущий пакет под коротким мьютексом;
+// заполненные пакеты вставляет в DAO отдельный поток, поэтому форматирование, сжатие,
+// ротация сегментов и fsync не задерживают отрисовку. DAO используется только этим потоком:
+// при ротации сегмент закрывается и следующий создается тоже в нем.
+// Если диск отстает больше чем на MAX_QUEUED_BATCHES пакетов, новые строки отбрасываются.
+class LiveRecorder
+{
+public:
+    static constexpr int BATCH_ROWS = 1024;
+    static constexpr int MAX_QUEUED_BATCHES = 64;
+    static constexpr int SPARE_BATCHES = 4;
+    // Неполный пакет уходит в DAO не реже чем раз в FLUSH_INTERVAL_MS
+    static constexpr int FLUSH_INTERVAL_MS = 1000;
+
+    // Владеет dao; деструктор дописывает принятые строки и закрывает файл.
+    // flushIntervalMs меньше FLUSH_INTERVAL_MS нужен, когда политика сброса DAO требует
+    // сохранять данные чаще: строки, не дошедшие до DAO, fsync не покрывает
+    explicit LiveRecorder(ISensorDataDAO *dao, int flushIntervalMs = FLUSH_INTERVAL_MS)
+        : dao_(dao), flushIntervalMs_(flushIntervalMs > 0 ? flushIntervalMs : FLUSH_INTERVAL_MS) {
+        active_.reserve(BATCH_ROWS);
+        thread_ = std::thread(&LiveRecorder::run, this);
+    }
+
+    ~LiveRecorder() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        condition_.notify_one();
+        thread_.join();
+    }
+
+    LiveRecorder(const LiveRecorder&) = delete;
+    LiveRecorder &operator=(const LiveRecorder&) = delete;
+
+    // Вызывается из потока GUI на каждый принятый кадр; timestampNs - наносекунды с эпохи
+    void append(qint64 timestampNs, const SensorData &data) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.rows;
+        if (static_cast<int>(full_.size()) >= MAX_QUEUED_BATCHES) {
+            ++stats_.droppedRows;
+            return;
+        }
+
+        active_.append(timestampNs, data);
+        if (active_.size() >= BATCH_ROWS) {
+            rotateBatch();
+            condition_.notify_one();
+        }
+    }
+
+    LiveRecorderStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    // Записанные пакеты возвращаются в spare_, поэтому в потоке GUI память не выделяется
+    void rotateBatch() {
+        full_.push_back(std::move(active_));
+        if (!spare_.empty()) {
+            active_ = std::move(spare_.back());
+            spare_.pop_back();
+        } else {
+            active_ = SensorDataBatch();
+            active_.reserve(BATCH_ROWS);
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            condition_.wait_for(lock, std::chrono::milliseconds(flushIntervalMs_),
+                                [this] { return stopping_ || !full_.empty(); });
+            // По таймауту и при остановке уходит и неполный пакет
+            if (full_.empty() && !active_.isEmpty()) {
+                rotateBatch();
+            }
+
+            std::deque<SensorDataBatch> batches;
+            batches.swap(full_);
+            const bool stopping = stopping_;
+            lock.unlock();
+
+            qint64 written = 0;
+            qint64 failed = 0;
+            for (SensorDataBatch &batch : batches) {
+                for (int row = 0; row < batch.size(); ++row) {
+                    if (dao_->insertSensorData(batch.row(row))) {
+                        ++written;
+                    } else {
+                        ++failed;
+                    }
+                }
+                batch.clear();
+            }
+            // В паузе приема новых строк нет, поэтому срок сброса проверяется и по таймауту
+            dao_->syncIfDue();
+            const qint64 durableTimestampNs = dao_->lastDurableTimestamp();
+            const int files = dao_->fileCount();
+
+            lock.lock();
+            if (failed > 0 && stats_.failedRows == 0) {
+                qDebug() << "Ошибка записи принимаемых данных, строк:" << failed;
+            }
+            stats_.writtenRows += written;
+            stats_.failedRows += failed;
+            stats_.durableTimestampNs = durableTimestampNs;
+            stats_.files = files;
+            while (!batches.empty() && static_cast<int>(spare_.size()) < SPARE_BATCHES) {
+                spare_.push_back(std::move(batches.front()));
+                batches.pop_front();
+            }
+            if (stopping && full_.empty() && active_.isEmpty()) {
+                break;
+            }
+        }
+        lock.unlock();
+        // Деструктор DAO сбрасывает буферы и дожидается fsync - тоже в потоке записи
+        dao_.reset();
+    }
+
+    std::unique_ptr<ISensorDataDAO> dao_;
+    const int flushIntervalMs_;
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    SensorDataBatch active_;
+    std::deque<SensorDataBatch> full_;
+    std::deque<SensorDataBatch> spare_;
+    LiveRecorderStats stats_;
+    bool stopping_ = false;
+};
+
+#endif // LIVERECORDER_H
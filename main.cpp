@@ -2,12 +2,17 @@
 #include "chartwidget.h"
 #include "inscommandprocessor.h"
 #include "pagerouter.h"
+#include "pipelinebench.h"
 #include "qmenubar.h"
+#include "tracer.h"
 #include "uartwidget.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QDebug>
 #include <QFile>
 #include <QMainWindow>
+#include <algorithm>
 
 void loadStyleSheet(QApplication &app, const QString &styleSheetFile) {
     QFile file(styleSheetFile);
@@ -20,8 +25,36 @@ void loadStyleSheet(QApplication &app, const QString &styleSheetFile) {
 
 int main(int argc, char *argv[])
 {
+    // Замер идет без экрана; платформу нужно выбрать до создания QApplication
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--bench") == 0 && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+        }
+    }
     QApplication app(argc, argv);
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption({"bench", "Замер пути от порта до графиков: файл записи или порт", "source"});
+    parser.addOption({"bench-seconds", "Длительность замера, с", "seconds", "10"});
+    parser.addOption({"bench-warmup", "Прогрев перед замером, с", "seconds", "2"});
+    parser.addOption({"bench-speed", "Скорость воспроизведения записи (0 - без пауз)", "speed", "0"});
+    parser.addOption({"bench-baud", "Скорость порта", "baud", "115200"});
+    parser.addOption({"bench-json", "Файл отчета замера", "file"});
+    parser.addOption({"trace", "Трассировка интервалов обработки с запуска; при выходе пишется в файл", "file"});
+    parser.process(app);
+
+    // Трасса пишется при выходе, если ее не остановили кнопкой раньше
+    if (parser.isSet("trace")) {
+        const QString tracePath = parser.value("trace");
+        Tracer::instance().start();
+        QObject::connect(&app, &QCoreApplication::aboutToQuit, [tracePath]() {
+            if (Tracer::instance().isRecording() && !Tracer::instance().stop(tracePath)) {
+                qDebug() << "Не удалось записать трассировку" << tracePath;
+            }
+        });
+    }
+
     std::vector<DynamicSettingsFabric<int>> settingsFabrics;
 
     std::vector<DynamicSettingsFabric<bool>> booleanSettingsFabrics;
@@ -31,10 +64,31 @@ int main(int argc, char *argv[])
     
     std::shared_ptr<DynamicSetting<int>> plotBufferSize = generalSettings.createSetting("Размер буфера графика", 500);
     std::shared_ptr<DynamicSetting<int>> plotSize = generalSettings.createSetting("Размер графика", 300);
+    std::shared_ptr<DynamicSetting<int>> plotHistoryMemory = generalSettings.createSetting("Память истории всех графиков, МиБ", 96);
+    std::shared_ptr<DynamicSetting<int>> sensorNominalRate = generalSettings.createSetting("Номинальная частота датчика, Гц (0 - неизвестна)", 0);
+    std::shared_ptr<DynamicSetting<int>> ingestQueueSize = generalSettings.createSetting("Размер очереди приема, чтений", 1024);
+    std::shared_ptr<DynamicSetting<int>> readerCpu = generalSettings.createSetting("Ядро процессора для чтения порта (-1 - любое)", -1);
     std::shared_ptr<DynamicSetting<int>> measuresPrecision = generalSettings.createSetting("Точность сохранения измерений", 2);
+    std::shared_ptr<DynamicSetting<int>> syncIntervalMs = generalSettings.createSetting("Интервал сброса записи на диск, мс", 1000);
+    std::shared_ptr<DynamicSetting<int>> syncMegabytes = generalSettings.createSetting("Объем сброса записи на диск, МиБ", 4);
+    std::shared_ptr<DynamicSetting<int>> segmentMegabytes = generalSettings.createSetting("Размер сегмента записи, МиБ (0 - один файл)", 0);
+    std::shared_ptr<DynamicSetting<int>> segmentMinutes = generalSettings.createSetting("Длительность сегмента записи, мин (0 - один файл)", 0);
+    std::shared_ptr<DynamicSetting<int>> replaySpeed = generalSettings.createSetting("Скорость воспроизведения записи, раз (0 - без пауз)", 1);
 
     settingsFabrics.push_back(generalSettings);
 
+    DynamicSettingsFabric<bool> generalSettingsBoolean;
+    generalSettingsBoolean.setGroupName("Общие настройки");
+
+    std::shared_ptr<DynamicSetting<bool>> isRecordingEnabled = generalSettingsBoolean.createSetting("Записывать прием в файл", true);
+    std::shared_ptr<DynamicSetting<bool>> isBinaryFormatEnabled = generalSettingsBoolean.createSetting("Сжатый бинарный формат записи", false);
+    // Для записи данные не должны теряться, для просмотра важнее свежесть
+    std::shared_ptr<DynamicSetting<bool>> ingestNeverDrop = generalSettingsBoolean.createSetting("Не терять данные при переполнении очереди приема", false);
+    std::shared_ptr<DynamicSetting<bool>> readerRealtime = generalSettingsBoolean.createSetting("Приоритет реального времени для чтения порта", false);
+    std::shared_ptr<DynamicSetting<bool>> rawCaptureEnabled = generalSettingsBoolean.createSetting("Сохранять сырой поток порта", false);
+    // Время отсчетов из файла; иначе время показа, как у живого порта
+    std::shared_ptr<DynamicSetting<bool>> replayOriginalTime = generalSettingsBoolean.createSetting("Исходное время при воспроизведении записи", true);
+
     std::string groupName = "Акселерометр";
     DynamicSettingsFabric<int> accelerometrSettings;
     DynamicSettingsFabric<bool> accelerometrSettingsBoolean;
@@ -76,6 +130,7 @@ int main(int argc, char *argv[])
     booleanSettingsFabrics.push_back(gyroscopeSettingsBoolean);
     booleanSettingsFabrics.push_back(magnetometerSettingsBoolean);
     booleanSettingsFabrics.push_back(envSettingsBoolean);
+    booleanSettingsFabrics.push_back(generalSettingsBoolean);
 
     MainWindow mainWindow(settingsFabrics, booleanSettingsFabrics);
 
@@ -99,6 +154,39 @@ int main(int argc, char *argv[])
     PageRouter::instance().initialize(&mainWindow);
 
     InsCommandProcessor *processor = new InsCommandProcessor();
+    auto applyIngestPolicy = [processor, ingestQueueSize, ingestNeverDrop]() {
+        processor->setIngestPolicy(ingestQueueSize->get(),
+                                   ingestNeverDrop->get() ? IngestQueue::BLOCK : IngestQueue::DROP_OLDEST);
+    };
+    applyIngestPolicy();
+    ingestQueueSize->setOnUpdateCallback([applyIngestPolicy](int) { applyIngestPolicy(); });
+    ingestNeverDrop->setOnUpdateCallback([applyIngestPolicy](bool) { applyIngestPolicy(); });
+
+    // SCHED_FIFO и привязка к ядру действуют только для собственного чтения порта в Linux
+    auto applyReaderOptions = [processor, readerRealtime, readerCpu]() {
+        processor->setReaderThreadOptions(readerRealtime->get(), readerCpu->get());
+    };
+    applyReaderOptions();
+    readerRealtime->setOnUpdateCallback([applyReaderOptions](bool) { applyReaderOptions(); });
+    readerCpu->setOnUpdateCallback([applyReaderOptions](int) { applyReaderOptions(); });
+
+    // Сырой поток пишется рядом с записями, файл на каждый запуск чтения
+    auto applyRawCapture = [processor](bool enabled) {
+        processor->setRawCaptureDirectory(enabled ? FileStorageManager::experimentsDirectory() : QString());
+    };
+    applyRawCapture(rawCaptureEnabled->get());
+    rawCaptureEnabled->setOnUpdateCallback(applyRawCapture);
+
+    // Повторяемый результат воспроизведения - без пауз и с очередью приема без потерь
+    auto applyReplayOptions = [processor, replaySpeed, replayOriginalTime]() {
+        ReplayOptions options;
+        options.speed = std::max(0, replaySpeed->get());
+        options.originalTimestamps = replayOriginalTime->get();
+        processor->setReplayOptions(options);
+    };
+    applyReplayOptions();
+    replaySpeed->setOnUpdateCallback([applyReplayOptions](int) { applyReplayOptions(); });
+    replayOriginalTime->setOnUpdateCallback([applyReplayOptions](bool) { applyReplayOptions(); });
     FileStorageManager *fileStorageManager = new FileStorageManager(
         isEnvMeasuresEnabled,
         measuresPrecision,
@@ -107,13 +195,35 @@ int main(int argc, char *argv[])
         isAcceleroMeasuresEnabled,
         measuresPrecision,
         isMagnetoMeasuresEnabled,
-        measuresPrecision);
-    ChartWidget *chartWidget = new ChartWidget(processor, plotBufferSize, plotSize, fileStorageManager);
+        measuresPrecision,
+        isBinaryFormatEnabled,
+        syncIntervalMs,
+        syncMegabytes,
+        segmentMegabytes,
+        segmentMinutes,
+        isRecordingEnabled);
+    ChartWidget *chartWidget = new ChartWidget(processor, plotBufferSize, plotSize, plotHistoryMemory, sensorNominalRate, fileStorageManager);
 
     PageRouter::instance().registerWidget(Page::Graphics, chartWidget);
 
     PageRouter::instance().navigateTo(Page::Graphics);
 
     mainWindow.show();
+
+    if (parser.isSet("bench")) {
+        PipelineBenchOptions options;
+        options.source = parser.value("bench");
+        options.seconds = std::max(1, parser.value("bench-seconds").toInt());
+        options.warmupSeconds = std::max(0, parser.value("bench-warmup").toInt());
+        options.replaySpeed = std::max(0.0, parser.value("bench-speed").toDouble());
+        options.baudRate = parser.value("bench-baud").toInt();
+        options.ingestCapacity = ingestQueueSize->get();
+        options.jsonPath = parser.value("bench-json");
+        PipelineBench *bench = new PipelineBench(processor, chartWidget, options, &app);
+        QObject::connect(bench, &PipelineBench::finished, &app, &QCoreApplication::exit, Qt::QueuedConnection);
+        if (!bench->start()) {
+            return 1;
+        }
+    }
     return app.exec();
 }
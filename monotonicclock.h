@@ -0,0 +1,73 @@
+#ifndef MONOTONICCLOCK_H
+#define MONOTONICCLOCK_H
+
+#include <QtGlobal>
+#include <QDateTime>
+#include <chrono>
+
+#ifdef Q_OS_UNIX
+#include <time.h>
+#endif
+
+// Монотонное время в наносекундах: не прыгает при переводе системных часов.
+// В Linux это CLOCK_MONOTONIC, на остальных платформах - steady_clock.
+namespace MonotonicClock {
+
+inline qint64 nowNs() {
+#ifdef Q_OS_UNIX
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<qint64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+}
+
+// Привязка монотонного времени к календарному, снимается один раз за сессию.
+// Все метки сессии переводятся через один якорь, поэтому сохраняют
+// интервалы между собой, даже если системные часы переведут во время записи.
+class SessionClock
+{
+public:
+    SessionClock() {
+        restart();
+    }
+
+    void restart() {
+        monotonicAnchorNs_ = MonotonicClock::nowNs();
+        wallAnchorNs_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    // Наносекунды с эпохи для монотонной метки
+    qint64 toWallNs(qint64 monotonicNs) const {
+        return wallAnchorNs_ + (monotonicNs - monotonicAnchorNs_);
+    }
+
+    QDateTime toDateTime(qint64 monotonicNs) const {
+        return QDateTime::fromMSecsSinceEpoch(toWallNs(monotonicNs) / 1000000);
+    }
+
+    // Якорь из записанной сессии: метки воспроизведения переводятся в исходное время
+    void setAnchors(qint64 wallAnchorNs, qint64 monotonicAnchorNs) {
+        wallAnchorNs_ = wallAnchorNs;
+        monotonicAnchorNs_ = monotonicAnchorNs;
+    }
+
+    qint64 monotonicAnchorNs() const {
+        return monotonicAnchorNs_;
+    }
+
+    qint64 wallAnchorNs() const {
+        return wallAnchorNs_;
+    }
+
+private:
+    qint64 monotonicAnchorNs_ = 0;
+    qint64 wallAnchorNs_ = 0;
+};
+
+#endif // MONOTONICCLOCK_H
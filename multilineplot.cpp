@@ -1,9 +1,12 @@
 #include "multilineplot.h"
+#include "pipelinediagnostics.h"
+#include "tracer.h"
 #include <QVBoxLayout>
 
 MultiLinePlot::MultiLinePlot(QWidget *parent, const std::vector<DynamicPlotBuffer*>& buffers)
     : QWidget(parent)
     , buffers_(buffers)
+    , diagnosticsId_(PipelineDiagnostics::instance().registerPlot("Совмещенный график"))
 {
     setupPlot();
 }
@@ -43,6 +46,7 @@ void MultiLinePlot::addGraph(const QString &label,
 
     // Добавляем буфер для данных
     labels_.push_back(label);
+    PipelineDiagnostics::instance().renamePlot(diagnosticsId_, "Совмещенный: " + labels_.front());
 
     // Сохраняем настройку размера графика
     if (!plotSize_) {
@@ -65,44 +69,6 @@ void MultiLinePlot::clear()
     customPlot_->replot();
 }
 
-void MultiLinePlot::plotSensorData(
-    const QList<TimestampedSensorData> &dataList,
-    const std::vector<std::pair<
-        std::function<double(const TimestampedSensorData&)>,
-        std::function<bool(const TimestampedSensorData&)>
-    >> &extractors)
-{
-    if (extractors.size() != buffers_.size()) {
-        qDebug() << "Error: Number of extractors doesn't match number of graphs";
-        return;
-    }
-
-    // Очищаем текущие данные
-    clear();
-
-    // Заполняем графики новыми данными
-    for (size_t i = 0; i < extractors.size(); ++i) {
-        QVector<double> timeData;
-        QVector<double> valueData;
-
-        for (const auto &data : dataList) {
-            if (!extractors[i].second(data)) {
-                continue;
-            }
-            double key = data.getTimestamp().toMSecsSinceEpoch() / 1000.0;
-            double value = extractors[i].first(data);
-            timeData.append(key);
-            valueData.append(value);
-        }
-
-        customPlot_->graph(i)->setData(timeData, valueData);
-    }
-
-    // Обновляем отображение
-    customPlot_->rescaleAxes();
-    customPlot_->replot();
-}
-
 QList<QList<QPair<QDateTime, double>>> MultiLinePlot::getAllData()
 {
     QList<QList<QPair<QDateTime, double>>> allData;
@@ -125,6 +91,8 @@ void MultiLinePlot::update()
         return;
     }
 
+    TraceSpan span("plot update");
+    const qint64 startNs = MonotonicClock::nowNs();
     for (size_t i = 0; i < buffers_.size(); ++i) {
         if (buffers_[i] && i < customPlot_->graphCount()) {
             QVector<double> timeData = buffers_[i]->getVisibleTimeData();
@@ -134,7 +102,11 @@ void MultiLinePlot::update()
     }
 
     customPlot_->rescaleAxes();
-    customPlot_->replot();
+    {
+        TraceSpan replotSpan("replot");
+        customPlot_->replot();
+    }
+    PipelineDiagnostics::instance().recordRender(diagnosticsId_, MonotonicClock::nowNs() - startNs);
 }
 
 void MultiLinePlot::updateBuffers(const std::vector<DynamicPlotBuffer*>& newBuffers)
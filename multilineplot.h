@@ -23,13 +23,6 @@ public:
 
     void clear();
     
-    void plotSensorData(
-        const QList<TimestampedSensorData> &dataList,
-        const std::vector<std::pair<
-            std::function<double(const TimestampedSensorData&)>,
-            std::function<bool(const TimestampedSensorData&)>
-        >> &extractors);
-
     QList<QList<QPair<QDateTime, double>>> getAllData();
     void update();
     void updateBuffers(const std::vector<DynamicPlotBuffer*>& newBuffers);
@@ -43,6 +36,8 @@ private:
     std::vector<DynamicPlotBuffer*> buffers_;
     std::vector<QString> labels_;
     std::shared_ptr<DynamicSetting<int>> plotSize_;
+    // Номер в PipelineDiagnostics для времени отрисовки
+    int diagnosticsId_;
 
     // Цвета для графиков
     const QVector<QColor> colors_ = {
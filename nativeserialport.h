@@ -0,0 +1,407 @@
+#ifndef NATIVESERIALPORT_H
+#define NATIVESERIALPORT_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QDebug>
+#include <QSerialPort>
+#include <QString>
+#include <atomic>
+
+// Способ чтения порта выбирается при подключении.
+// STANDARD - QSerialPort на всех платформах; остальные режимы - собственное
+// чтение через termios и epoll, доступное только в Linux.
+enum class SerialReadMode {
+    STANDARD,
+    LOW_LATENCY, // пробуждение на каждый кадр, ASYNC_LOW_LATENCY у драйвера
+    THROUGHPUT   // крупные чтения, пробуждения объединяются ядром
+};
+
+struct NativeReaderOptions
+{
+    SerialReadMode mode = SerialReadMode::LOW_LATENCY;
+    int frameBytes = 0;     // VMIN в режиме низкой задержки: поток будится на целый кадр
+    bool realtime = false;  // SCHED_FIFO для потока чтения
+    int cpu = -1;           // ядро для потока чтения, -1 - без привязки
+};
+
+#ifdef Q_OS_LINUX
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// termios2 из <asm/termbits.h> несовместим с <termios.h>, поэтому структура и запросы объявлены здесь.
+// Через BOTHER задается произвольная скорость, в том числе выше 4 Мбод и без констант Bxxx.
+#ifndef BOTHER
+#define BOTHER 0010000
+#endif
+#ifndef IBSHIFT
+#define IBSHIFT 16
+#endif
+
+struct KernelTermios2
+{
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t c_line;
+    cc_t c_cc[19];
+    speed_t c_ispeed;
+    speed_t c_ospeed;
+};
+
+// Последовательный порт на файловом дескрипторе tty.
+// Чтение ждет epoll на дескрипторе порта и на eventfd для пробуждения при остановке.
+// Порог пробуждения задается VMIN: при VTIME = 0 epoll сообщает о готовности,
+// только когда в буфере tty набралось VMIN байт. Хвост меньше порога дочитывается по таймауту.
+// Работает и с реальным UART, и с псевдотерминалом (pty).
+class NativeSerialPort
+{
+public:
+    static constexpr int LOW_LATENCY_READ_BYTES = 4096;
+    static constexpr int THROUGHPUT_READ_BYTES = 64 * 1024;
+    static constexpr int THROUGHPUT_VMIN = 255; // наибольшее значение VMIN
+    // Ожидание, когда в буфере уже есть байты меньше порога
+    static constexpr int LOW_LATENCY_TAIL_MS = 2;
+    static constexpr int THROUGHPUT_TAIL_MS = 10;
+    // Ожидание при пустом буфере: ограничивает задержку коротких ответов на команды
+    static constexpr int IDLE_WAIT_MS = 20;
+
+    NativeSerialPort() = default;
+    ~NativeSerialPort() {
+        close();
+    }
+
+    NativeSerialPort(const NativeSerialPort&) = delete;
+    NativeSerialPort &operator=(const NativeSerialPort&) = delete;
+
+    bool open(const QString &portName, int baudRate,
+              QSerialPort::DataBits dataBits, QSerialPort::Parity parity,
+              QSerialPort::StopBits stopBits, QSerialPort::FlowControl flowControl,
+              const NativeReaderOptions &options) {
+        close();
+        options_ = options;
+
+        const QString path = portName.startsWith('/') ? portName : "/dev/" + portName;
+        fd_ = ::open(path.toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (fd_ < 0) {
+            return fail("Не удалось открыть " + path);
+        }
+        // Как и QSerialPort, порт открывается монопольно
+        ::ioctl(fd_, TIOCEXCL);
+
+        if (!configure(baudRate, dataBits, parity, stopBits, flowControl)) {
+            close();
+            return false;
+        }
+
+        epollFd_ = ::epoll_create1(EPOLL_CLOEXEC);
+        wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (epollFd_ < 0 || wakeFd_ < 0) {
+            const bool result = fail("Не удалось создать epoll");
+            close();
+            return result;
+        }
+        epoll_event event {};
+        event.events = EPOLLIN;
+        event.data.fd = fd_;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd_, &event);
+        event.data.fd = wakeFd_;
+        ::epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+
+        readBuffer_.resize(options_.mode == SerialReadMode::THROUGHPUT ? THROUGHPUT_READ_BYTES : LOW_LATENCY_READ_BYTES);
+        error_.clear();
+        hungUp_ = false;
+        return true;
+    }
+
+    void close() {
+        for (int *fd : {&wakeFd_, &epollFd_, &fd_}) {
+            if (*fd >= 0) {
+                ::close(*fd);
+                *fd = -1;
+            }
+        }
+    }
+
+    bool isOpen() const {
+        return fd_ >= 0;
+    }
+
+    // Устройство отключено или сообщило об ошибке. Порт при этом остается открытым:
+    // закрывает его владелец, а не поток чтения, иначе дескрипторы закрылись бы
+    // под одновременными write, setBaudRate и wakeUp из потока GUI
+    bool hasHungUp() const {
+        return hungUp_;
+    }
+
+    QString errorString() const {
+        return error_;
+    }
+
+    SerialReadMode mode() const {
+        return options_.mode;
+    }
+
+    // Стандартные скорости задаются через cfsetspeed, остальные - через termios2 и BOTHER
+    bool setBaudRate(int baudRate) {
+        const speed_t speed = toSpeed(baudRate);
+        if (speed == B0) {
+            return setCustomBaudRate(baudRate);
+        }
+
+        termios tio;
+        if (::tcgetattr(fd_, &tio) != 0) {
+            return fail("tcgetattr");
+        }
+        ::cfsetispeed(&tio, speed);
+        ::cfsetospeed(&tio, speed);
+        if (::tcsetattr(fd_, TCSANOW, &tio) != 0) {
+            return fail("tcsetattr");
+        }
+        return true;
+    }
+
+    // Отбрасывает принятые, но еще не прочитанные байты
+    void flushInput() {
+        ::tcflush(fd_, TCIFLUSH);
+    }
+
+    // Пишет все байты; при заполненном буфере передачи ждет его освобождения
+    qint64 write(const QByteArray &data) {
+        qint64 written = 0;
+        while (written < data.size()) {
+            const ssize_t result = ::write(fd_, data.constData() + written, data.size() - written);
+            if (result > 0) {
+                written += result;
+                continue;
+            }
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result < 0 && errno == EAGAIN) {
+                pollfd pfd {fd_, POLLOUT, 0};
+                if (::poll(&pfd, 1, IDLE_WAIT_MS * 5) > 0) {
+                    continue;
+                }
+            }
+            fail("Ошибка записи в порт");
+            break;
+        }
+        return written;
+    }
+
+    // Ждет данные и читает все доступное, не больше размера буфера режима.
+    // Пустой результат - таймаут, пробуждение через wakeUp или ошибка порта (hasHungUp() == true).
+    QByteArray read() {
+        int pending = 0;
+        ::ioctl(fd_, FIONREAD, &pending);
+        const int timeoutMs = pending == 0 ? IDLE_WAIT_MS
+            : options_.mode == SerialReadMode::THROUGHPUT ? THROUGHPUT_TAIL_MS : LOW_LATENCY_TAIL_MS;
+
+        epoll_event events[2];
+        const int count = ::epoll_wait(epollFd_, events, 2, timeoutMs);
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.fd == wakeFd_) {
+                eventfd_t value;
+                ::eventfd_read(wakeFd_, &value);
+                return QByteArray();
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                hungUp_ = true;
+                return QByteArray();
+            }
+        }
+
+        // По таймауту дочитывается хвост меньше VMIN: при O_NONBLOCK read не ждет порога
+        int total = 0;
+        while (total < readBuffer_.size()) {
+            const ssize_t result = ::read(fd_, readBuffer_.data() + total, readBuffer_.size() - total);
+            if (result > 0) {
+                total += result;
+                if (options_.mode != SerialReadMode::THROUGHPUT) {
+                    break;
+                }
+                continue;
+            }
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        return QByteArray(readBuffer_.constData(), total);
+    }
+
+    // Будит поток, ожидающий в read()
+    void wakeUp() {
+        if (wakeFd_ >= 0) {
+            ::eventfd_write(wakeFd_, 1);
+        }
+    }
+
+    // Вызывается из потока чтения: приоритет реального времени и привязка к ядру
+    void applyThreadOptions() const {
+        if (options_.realtime) {
+            sched_param param {};
+            param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+            const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+            if (result != 0) {
+                qDebug() << "SCHED_FIFO недоступен для потока чтения:" << std::strerror(result);
+            }
+        }
+        if (options_.cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(options_.cpu, &set);
+            const int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            if (result != 0) {
+                qDebug() << "Не удалось привязать поток чтения к ядру" << options_.cpu << ":" << std::strerror(result);
+            }
+        }
+    }
+
+private:
+    bool configure(int baudRate, QSerialPort::DataBits dataBits, QSerialPort::Parity parity,
+                   QSerialPort::StopBits stopBits, QSerialPort::FlowControl flowControl) {
+        termios tio;
+        if (::tcgetattr(fd_, &tio) != 0) {
+            return fail("tcgetattr");
+        }
+        ::cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+
+        tio.c_cflag &= ~CSIZE;
+        switch (dataBits) {
+        case QSerialPort::Data5: tio.c_cflag |= CS5; break;
+        case QSerialPort::Data6: tio.c_cflag |= CS6; break;
+        case QSerialPort::Data7: tio.c_cflag |= CS7; break;
+        default: tio.c_cflag |= CS8; break;
+        }
+
+        tio.c_cflag &= ~(PARENB | PARODD);
+        if (parity == QSerialPort::EvenParity) {
+            tio.c_cflag |= PARENB;
+        } else if (parity == QSerialPort::OddParity) {
+            tio.c_cflag |= PARENB | PARODD;
+        }
+
+        // Полтора стоп-бита termios не поддерживает, как и QSerialPort в Unix
+        if (stopBits == QSerialPort::TwoStop) {
+            tio.c_cflag |= CSTOPB;
+        } else {
+            tio.c_cflag &= ~CSTOPB;
+        }
+
+        if (flowControl == QSerialPort::HardwareControl) {
+            tio.c_cflag |= CRTSCTS;
+        } else {
+            tio.c_cflag &= ~CRTSCTS;
+        }
+
+        // VTIME = 0: порог VMIN действует и для epoll, таймаут ведет сам поток чтения
+        const int vmin = options_.mode == SerialReadMode::THROUGHPUT ? THROUGHPUT_VMIN
+                                                                     : qBound(1, options_.frameBytes, 255);
+        tio.c_cc[VMIN] = static_cast<cc_t>(vmin);
+        tio.c_cc[VTIME] = 0;
+
+        const speed_t speed = toSpeed(baudRate);
+        if (speed != B0) {
+            ::cfsetispeed(&tio, speed);
+            ::cfsetospeed(&tio, speed);
+        }
+
+        if (::tcsetattr(fd_, TCSANOW, &tio) != 0) {
+            return fail("tcsetattr");
+        }
+        if (speed == B0 && !setCustomBaudRate(baudRate)) {
+            return false;
+        }
+        ::tcflush(fd_, TCIOFLUSH);
+
+        if (options_.mode == SerialReadMode::LOW_LATENCY) {
+            // Драйвер передает байты в tty без накопления; pty и часть USB адаптеров флаг не поддерживают
+            serial_struct serial;
+            if (::ioctl(fd_, TIOCGSERIAL, &serial) == 0) {
+                serial.flags |= ASYNC_LOW_LATENCY;
+                if (::ioctl(fd_, TIOCSSERIAL, &serial) != 0) {
+                    qDebug() << "ASYNC_LOW_LATENCY не установлен:" << std::strerror(errno);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool setCustomBaudRate(int baudRate) {
+        if (baudRate <= 0) {
+            errno = EINVAL;
+            return fail(QString("Скорость %1 не поддерживается").arg(baudRate));
+        }
+        KernelTermios2 tio;
+        if (::ioctl(fd_, _IOR('T', 0x2A, KernelTermios2), &tio) != 0) {
+            return fail("TCGETS2");
+        }
+        tio.c_cflag &= ~CBAUD;
+        tio.c_cflag |= BOTHER;
+        tio.c_cflag &= ~(CBAUD << IBSHIFT);
+        tio.c_cflag |= BOTHER << IBSHIFT;
+        tio.c_ispeed = static_cast<speed_t>(baudRate);
+        tio.c_ospeed = static_cast<speed_t>(baudRate);
+        if (::ioctl(fd_, _IOW('T', 0x2B, KernelTermios2), &tio) != 0) {
+            return fail(QString("Скорость %1 не поддерживается").arg(baudRate));
+        }
+        return true;
+    }
+
+    static speed_t toSpeed(int baudRate) {
+        switch (baudRate) {
+        case 9600: return B9600;
+        case 19200: return B19200;
+        case 38400: return B38400;
+        case 57600: return B57600;
+        case 115200: return B115200;
+        case 230400: return B230400;
+        case 460800: return B460800;
+        case 500000: return B500000;
+        case 576000: return B576000;
+        case 921600: return B921600;
+        case 1000000: return B1000000;
+        case 1152000: return B1152000;
+        case 1500000: return B1500000;
+        case 2000000: return B2000000;
+        case 2500000: return B2500000;
+        case 3000000: return B3000000;
+        case 3500000: return B3500000;
+        case 4000000: return B4000000;
+        default: return B0;
+        }
+    }
+
+    bool fail(const QString &what) {
+        error_ = QString("%1: %2").arg(what, QString::fromLocal8Bit(std::strerror(errno)));
+        qDebug() << error_;
+        return false;
+    }
+
+    int fd_ = -1;
+    int epollFd_ = -1;
+    int wakeFd_ = -1;
+    NativeReaderOptions options_;
+    QString error_;
+    QByteArray readBuffer_;
+    std::atomic<bool> hungUp_ {false};
+};
+
+#endif // Q_OS_LINUX
+
+#endif // NATIVESERIALPORT_H
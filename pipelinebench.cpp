@@ -0,0 +1,218 @@
+#include "pipelinebench.h"
+#include "allocationcounter.h"
+#include "pipelinediagnostics.h"
+#include "replayengine.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <QTextStream>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// Время процессора процесса, с: пользовательское и системное, все потоки
+double processCpuSeconds()
+{
+#ifdef Q_OS_UNIX
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+             + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    }
+#endif
+    return 0;
+}
+
+// Текущий и наибольший резидентный объем, КиБ
+void processMemoryKiB(qint64 &rss, qint64 &peakRss)
+{
+    rss = 0;
+    peakRss = 0;
+#ifdef Q_OS_LINUX
+    QFile status("/proc/self/status");
+    if (status.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        for (const QByteArray &line : status.readAll().split('\n')) {
+            const QList<QByteArray> fields = line.simplified().split(' ');
+            if (fields.size() < 2) {
+                continue;
+            }
+            if (fields[0] == "VmRSS:") {
+                rss = fields[1].toLongLong();
+            } else if (fields[0] == "VmHWM:") {
+                peakRss = fields[1].toLongLong();
+            }
+        }
+    }
+#elif defined(Q_OS_UNIX)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        peakRss = usage.ru_maxrss;
+        rss = peakRss;
+    }
+#endif
+}
+
+}
+
+PipelineBench::PipelineBench(InsCommandProcessor *processor, ChartWidget *chartWidget,
+                             const PipelineBenchOptions &options, QObject *parent)
+    : QObject(parent), processor_(processor), chartWidget_(chartWidget), options_(options)
+{
+    phaseTimer_.setSingleShot(true);
+    sourceTimer_.setInterval(100);
+    connect(&sourceTimer_, &QTimer::timeout, this, &PipelineBench::checkSource);
+}
+
+bool PipelineBench::start()
+{
+    // Запись идет без пауз и без потерь: предел задает сам путь приема и отрисовки.
+    // У порта темп задает устройство, потери очереди попадают в отчет
+    if (ReplayEngine::isReplayFile(options_.source)) {
+        ReplayOptions replay;
+        replay.speed = options_.replaySpeed;
+        replay.originalTimestamps = false;
+        processor_->setReplayOptions(replay);
+        processor_->setIngestPolicy(options_.ingestCapacity, IngestQueue::BLOCK);
+    }
+
+    if (!processor_->openSerialPort(options_.source, options_.baudRate, QSerialPort::Data8,
+                                    QSerialPort::NoParity, QSerialPort::OneStop, QSerialPort::NoFlowControl)) {
+        qDebug() << "bench: не удалось открыть" << options_.source << processor_->getLastError();
+        return false;
+    }
+
+    chartWidget_->startLive();
+    sourceTimer_.start();
+    connect(&phaseTimer_, &QTimer::timeout, this, &PipelineBench::beginMeasurement);
+    phaseTimer_.start(options_.warmupSeconds * 1000);
+    return true;
+}
+
+void PipelineBench::beginMeasurement()
+{
+    disconnect(&phaseTimer_, nullptr, this, nullptr);
+    measuring_ = true;
+    chartWidget_->resetPixelLatency();
+    PipelineDiagnostics::instance().reset();
+    processor_->resetLinkStats();
+    startWallNs_ = MonotonicClock::nowNs();
+    startCpuSeconds_ = processCpuSeconds();
+    startDropped_ = processor_->getIngestStats().dropped;
+    startReadBytes_ = processor_->getReaderStats().bytes;
+
+    connect(&phaseTimer_, &QTimer::timeout, this, &PipelineBench::endMeasurement);
+    phaseTimer_.start(options_.seconds * 1000);
+}
+
+void PipelineBench::checkSource()
+{
+    if (!processor_->isReplaying() || !processor_->getReplayPosition().finished) {
+        return;
+    }
+    if (!measuring_) {
+        qDebug() << "bench: запись кончилась до начала замера, нужна более длинная запись";
+        sourceTimer_.stop();
+        phaseTimer_.stop();
+        emit finished(1);
+        return;
+    }
+    phaseTimer_.stop();
+    endMeasurement();
+}
+
+void PipelineBench::endMeasurement()
+{
+    sourceTimer_.stop();
+    measuring_ = false;
+
+    const double seconds = (MonotonicClock::nowNs() - startWallNs_) / 1e9;
+    const double cpuSeconds = processCpuSeconds() - startCpuSeconds_;
+    const LatencyHistogram &latency = chartWidget_->getPixelLatency();
+    const qint64 frames = latency.count();
+    const qint64 dropped = processor_->getIngestStats().dropped - startDropped_;
+    const qint64 bytes = processor_->getReaderStats().bytes - startReadBytes_;
+    const LinkStats link = processor_->getLinkStats();
+    qint64 rssKiB = 0;
+    qint64 peakRssKiB = 0;
+    processMemoryKiB(rssKiB, peakRssKiB);
+
+    chartWidget_->stopLive();
+    processor_->closeSerialPort();
+
+    const double rate = seconds > 0 ? frames / seconds : 0;
+    const double cpuPercent = seconds > 0 ? 100.0 * cpuSeconds / seconds : 0;
+
+    QTextStream out(stdout);
+    out << "source:          " << options_.source << "\n"
+        << "duration, s:     " << QString::number(seconds, 'f', 2) << "\n"
+        << "frames:          " << frames << " (" << QString::number(rate, 'f', 0) << " /s)\n"
+        << "ingest dropped:  " << dropped << " reads\n"
+        << "crc failures:    " << link.crcFailures << "\n"
+        << "latency p50:     " << QString::number(latency.percentileNs(0.5) / 1e3, 'f', 1) << " us\n"
+        << "latency p99:     " << QString::number(latency.percentileNs(0.99) / 1e3, 'f', 1) << " us\n"
+        << "latency p99.9:   " << QString::number(latency.percentileNs(0.999) / 1e3, 'f', 1) << " us\n"
+        << "latency max:     " << QString::number(latency.maxNs() / 1e3, 'f', 1) << " us\n"
+        << "cpu:             " << QString::number(cpuPercent, 'f', 1) << " %\n"
+        << "rss:             " << rssKiB << " KiB (peak " << peakRssKiB << " KiB)\n";
+    out.flush();
+
+    QJsonObject report;
+    report["benchmark"] = "pipeline";
+    report["source"] = options_.source;
+    report["replay_speed"] = options_.replaySpeed;
+    report["host"] = QSysInfo::machineHostName();
+    report["qt"] = qVersion();
+    report["platform"] = qgetenv("QT_QPA_PLATFORM").isEmpty() ? QString("default") : QString(qgetenv("QT_QPA_PLATFORM"));
+    report["seconds"] = seconds;
+    report["frames"] = frames;
+    report["frames_per_s"] = rate;
+    report["bytes_per_s"] = seconds > 0 ? bytes / seconds : 0;
+    report["ingest_dropped_reads"] = dropped;
+    report["crc_failures"] = link.crcFailures;
+    report["latency_p50_ns"] = latency.percentileNs(0.5);
+    report["latency_p99_ns"] = latency.percentileNs(0.99);
+    report["latency_p999_ns"] = latency.percentileNs(0.999);
+    report["latency_max_ns"] = latency.maxNs();
+    report["latency_mean_ns"] = latency.meanNs();
+    report["cpu_percent"] = cpuPercent;
+    report["rss_kib"] = rssKiB;
+    report["peak_rss_kib"] = peakRssKiB;
+
+    // Разбивка по этапам: какой из них вырос, если выросла общая задержка
+    const char *const stageKeys[PipelineDiagnostics::STAGE_COUNT] = {
+        "queue_wait", "framing", "decode", "buffer_update", "render"
+    };
+    QJsonObject stages;
+    for (int i = 0; i < PipelineDiagnostics::STAGE_COUNT; ++i) {
+        const LatencyHistogram &histogram = PipelineDiagnostics::instance().histogram(static_cast<PipelineDiagnostics::Stage>(i));
+        QJsonObject stage;
+        stage["count"] = histogram.count();
+        stage["mean_ns"] = histogram.meanNs();
+        stage["p50_ns"] = histogram.percentileNs(0.5);
+        stage["p99_ns"] = histogram.percentileNs(0.99);
+        stage["max_ns"] = histogram.maxNs();
+        if (AllocationCounter::isEnabled()) {
+            stage["allocations_per_event"] = PipelineDiagnostics::instance().allocationsPerEvent(static_cast<PipelineDiagnostics::Stage>(i));
+        }
+        stages[stageKeys[i]] = stage;
+    }
+    report["stages"] = stages;
+
+    int exitCode = frames > 0 ? 0 : 1;
+    if (!options_.jsonPath.isEmpty()) {
+        QFile file(options_.jsonPath);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            file.write(QJsonDocument(report).toJson());
+        } else {
+            qDebug() << "bench: не удалось записать" << options_.jsonPath << file.errorString();
+            exitCode = 1;
+        }
+    }
+    emit finished(exitCode);
+}
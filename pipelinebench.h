@@ -0,0 +1,60 @@
+#ifndef PIPELINEBENCH_H
+#define PIPELINEBENCH_H
+
+#include "chartwidget.h"
+#include "inscommandprocessor.h"
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+struct PipelineBenchOptions
+{
+    QString source;              // файл записи или порт, например псевдотерминал имитатора
+    int warmupSeconds = 2;       // не входит в замер: заполнение буферов графиков
+    int seconds = 10;
+    double replaySpeed = 0;      // 0 - без пауз, то есть предельная скорость
+    qint32 baudRate = 115200;
+    int ingestCapacity = 1024;
+    QString jsonPath;            // пусто - только вывод в stdout
+};
+
+// Режим --bench: источник проходит весь путь приложения -
+// поток чтения, разбор, декодирование, DynamicPlotsGroup и отрисовку.
+// Замеряются устойчивая частота кадров на графиках, перцентили задержки от чтения
+// до отрисовки, загрузка процессора и память. Отчет одинаков по форме для всех
+// коммитов, чтобы отчеты можно было сравнивать.
+class PipelineBench : public QObject
+{
+    Q_OBJECT
+
+public:
+    PipelineBench(InsCommandProcessor *processor, ChartWidget *chartWidget,
+                  const PipelineBenchOptions &options, QObject *parent = nullptr);
+
+    // false - источник не открылся
+    bool start();
+
+signals:
+    void finished(int exitCode);
+
+private:
+    void beginMeasurement();
+    void checkSource();
+    void endMeasurement();
+
+    InsCommandProcessor *processor_;
+    ChartWidget *chartWidget_;
+    PipelineBenchOptions options_;
+    QTimer phaseTimer_;
+    // Запись может кончиться раньше времени замера: тогда замер завершается по ней
+    QTimer sourceTimer_;
+    bool measuring_ = false;
+
+    qint64 startWallNs_ = 0;
+    double startCpuSeconds_ = 0;
+    qint64 startDropped_ = 0;
+    qint64 startReadBytes_ = 0;
+};
+
+#endif // PIPELINEBENCH_H
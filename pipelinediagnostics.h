@@ -0,0 +1,185 @@
+#ifndef PIPELINEDIAGNOSTICS_H
+#define PIPELINEDIAGNOSTICS_H
+
+#include "allocationcounter.h"
+#include "latencyhistogram.h"
+#include "monotonicclock.h"
+
+#include <QString>
+#include <QStringList>
+#include <array>
+#include <vector>
+
+// Постоянно включенные замеры этапов пути от порта до графиков:
+// по каждому этапу - гистограмма длительности и число событий, по каждому графику - время отрисовки.
+// Все этапы, кроме чтения порта, идут в потоке GUI, поэтому записи без блокировок;
+// счетчики потока чтения передаются снаружи из ReaderStats.
+// Со счетчиком выделений (AllocationCounter) по этапам считаются и выделения памяти на событие.
+class PipelineDiagnostics
+{
+public:
+    enum Stage {
+        QUEUE_WAIT,     // от чтения куска до его разбора в потоке GUI
+        FRAMING,        // поиск и проверка кадра в потоке байт
+        DECODE,         // CommandResponse и SensorData
+        BUFFER_UPDATE,  // запись точек в буферы графиков
+        RENDER,         // обновление таблицы и replot графиков группы
+        STAGE_COUNT
+    };
+
+    static PipelineDiagnostics &instance() {
+        static PipelineDiagnostics diagnostics;
+        return diagnostics;
+    }
+
+    static QString stageName(Stage stage) {
+        static const QStringList names = {"очередь", "разбор кадра", "декодирование", "буферы", "отрисовка"};
+        return names[stage];
+    }
+
+    void record(Stage stage, qint64 durationNs, qint64 allocations = 0) {
+        stages_[stage].histogram.record(durationNs);
+        stages_[stage].allocations += allocations;
+    }
+
+    // Ожидание в очереди - не работа, выделения для него не считаются
+    double allocationsPerEvent(Stage stage) const {
+        const qint64 count = stages_[stage].histogram.count();
+        return stage != QUEUE_WAIT && count > 0 ? static_cast<double>(stages_[stage].allocations) / count : 0;
+    }
+
+    // Номер графика для recordRender; графики живут до конца программы
+    int registerPlot(const QString &name) {
+        plots_.push_back(Plot());
+        plots_.back().name = name;
+        return static_cast<int>(plots_.size()) - 1;
+    }
+
+    void renamePlot(int plot, const QString &name) {
+        plots_[plot].name = name;
+    }
+
+    void recordRender(int plot, qint64 durationNs) {
+        plots_[plot].histogram.record(durationNs);
+    }
+
+    void reset() {
+        for (StageStats &stage : stages_) {
+            stage = StageStats();
+        }
+        for (Plot &plot : plots_) {
+            plot.histogram.reset();
+        }
+        lastUpdateNs_ = 0;
+        readWakeupsPerSecond_ = 0;
+        readBytesPerSecond_ = 0;
+    }
+
+    // Частоты событий с прошлого вызова; вызывается по таймеру панели
+    void updateRates(qint64 nowNs, qint64 readWakeups, qint64 readBytes) {
+        const double seconds = (nowNs - lastUpdateNs_) / 1e9;
+        const bool valid = lastUpdateNs_ > 0 && seconds > 0;
+        for (StageStats &stage : stages_) {
+            const qint64 count = stage.histogram.count();
+            stage.perSecond = valid ? (count - stage.lastCount) / seconds : 0;
+            stage.lastCount = count;
+        }
+        readWakeupsPerSecond_ = valid ? (readWakeups - lastReadWakeups_) / seconds : 0;
+        readBytesPerSecond_ = valid ? (readBytes - lastReadBytes_) / seconds : 0;
+        lastReadWakeups_ = readWakeups;
+        lastReadBytes_ = readBytes;
+        lastUpdateNs_ = nowNs;
+    }
+
+    const LatencyHistogram &histogram(Stage stage) const {
+        return stages_[stage].histogram;
+    }
+
+    // Таблица для панели и для файла: значения в микросекундах
+    QString report() const {
+        QString text = QString("Чтение порта: %1 чтений/с, %2 КиБ/с\n")
+                           .arg(readWakeupsPerSecond_, 0, 'f', 0)
+                           .arg(readBytesPerSecond_ / 1024, 0, 'f', 1);
+        const bool allocations = AllocationCounter::isEnabled();
+        text += header("Этап", allocations);
+        for (int i = 0; i < STAGE_COUNT; ++i) {
+            const Stage stage = static_cast<Stage>(i);
+            text += row(stageName(stage), stages_[i].perSecond, stages_[i].histogram,
+                        allocations && stage != QUEUE_WAIT ? allocationsPerEvent(stage) : -1, allocations);
+        }
+        text += "\n" + header("График", allocations);
+        for (const Plot &plot : plots_) {
+            if (plot.histogram.count() > 0) {
+                text += row(plot.name, -1, plot.histogram, -1, allocations);
+            }
+        }
+        return text;
+    }
+
+private:
+    struct StageStats
+    {
+        LatencyHistogram histogram;
+        qint64 allocations = 0;
+        qint64 lastCount = 0;
+        double perSecond = 0;
+    };
+
+    struct Plot
+    {
+        QString name;
+        LatencyHistogram histogram;
+    };
+
+    PipelineDiagnostics() = default;
+
+    static QString header(const QString &title, bool allocations) {
+        return QString("%1 %2 %3 %4 %5 %6 %7%8\n")
+            .arg(title, -24).arg("в сек", 9).arg("ср.", 9).arg("p50", 9)
+            .arg("p99", 9).arg("p99.9", 9).arg("макс.", 9)
+            .arg(allocations ? QString(" %1").arg("выдел.", 9) : QString());
+    }
+
+    // allocationsPerEvent < 0 - прочерк
+    static QString row(const QString &name, double perSecond, const LatencyHistogram &histogram,
+                       double allocationsPerEvent, bool allocations) {
+        return QString("%1 %2 %3 %4 %5 %6 %7%8\n")
+            .arg(name.left(24), -24)
+            .arg(perSecond >= 0 ? QString::number(perSecond, 'f', 0) : QString("-"), 9)
+            .arg(histogram.meanNs() / 1e3, 9, 'f', 1)
+            .arg(histogram.percentileNs(0.5) / 1e3, 9, 'f', 1)
+            .arg(histogram.percentileNs(0.99) / 1e3, 9, 'f', 1)
+            .arg(histogram.percentileNs(0.999) / 1e3, 9, 'f', 1)
+            .arg(histogram.maxNs() / 1e3, 9, 'f', 1)
+            .arg(!allocations ? QString()
+                              : QString(" %1").arg(allocationsPerEvent >= 0 ? QString::number(allocationsPerEvent, 'f', 2) : QString("-"), 9));
+    }
+
+    std::array<StageStats, STAGE_COUNT> stages_;
+    std::vector<Plot> plots_;
+    qint64 lastUpdateNs_ = 0;
+    qint64 lastReadWakeups_ = 0;
+    qint64 lastReadBytes_ = 0;
+    double readWakeupsPerSecond_ = 0;
+    double readBytesPerSecond_ = 0;
+};
+
+// Замер этапа на время жизни объекта
+class ScopedStage
+{
+public:
+    explicit ScopedStage(PipelineDiagnostics::Stage stage)
+        : stage_(stage), startNs_(MonotonicClock::nowNs()), startAllocations_(AllocationCounter::threadCount()) {}
+
+    ~ScopedStage() {
+        PipelineDiagnostics::instance().record(stage_, MonotonicClock::nowNs() - startNs_,
+                                               AllocationCounter::threadCount() - startAllocations_);
+    }
+
+private:
+    PipelineDiagnostics::Stage stage_;
+    qint64 startNs_;
+    qint64 startAllocations_;
+};
+
+#endif // PIPELINEDIAGNOSTICS_H
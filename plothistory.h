@@ -0,0 +1,313 @@
+#ifndef PLOTHISTORY_H
+#define PLOTHISTORY_H
+
+#include <QDir>
+#include <QTemporaryFile>
+#include <QVector>
+#include <QDebug>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+class PlotHistory;
+
+// Бюджет памяти, общий для историй всех графиков: лимит задается на все графики сразу,
+// а не на каждый. Пока общий объем блоков в памяти выше лимита, выгружают свои самые старые
+// блоки те истории, что занимают больше равной доли лимита; история меньше доли оставляет
+// свободное место остальным. Используется только из потока GUI.
+class PlotHistoryBudget
+{
+public:
+    static constexpr qint64 DEFAULT_LIMIT = 8 * 1024 * 1024;
+
+    explicit PlotHistoryBudget(qint64 limitBytes = DEFAULT_LIMIT)
+        : limit_(limitBytes) {}
+
+    PlotHistoryBudget(const PlotHistoryBudget&) = delete;
+    PlotHistoryBudget &operator=(const PlotHistoryBudget&) = delete;
+
+    qint64 limit() const {
+        return limit_;
+    }
+
+    void setLimit(qint64 bytes);
+
+    qint64 residentBytes() const {
+        return resident_;
+    }
+
+    bool isExceeded() const {
+        return resident_ > limit_;
+    }
+
+    // Равная доля лимита на одну историю
+    qint64 share() const {
+        return histories_.empty() ? limit_ : limit_ / static_cast<qint64>(histories_.size());
+    }
+
+private:
+    friend class PlotHistory;
+
+    qint64 limit_;
+    qint64 resident_ = 0;
+    std::vector<PlotHistory*> histories_;
+};
+
+// Полная история одного графика за сессию: только дописывается, хранится блоками по CHUNK_POINTS точек.
+// Когда блоки в памяти превышают общий бюджет (PlotHistoryBudget), самые старые заполненные блоки
+// выгружаются во временный файл и читаются обратно только при просмотре старых данных.
+// Ключи (время в секундах с эпохи) ожидаются неубывающими, как на оси графика.
+class PlotHistory
+{
+public:
+    static constexpr int CHUNK_POINTS = 4096;
+
+    // Без общего бюджета история получает собственный с лимитом по умолчанию
+    explicit PlotHistory(std::shared_ptr<PlotHistoryBudget> budget = nullptr) {
+        attach(budget ? std::move(budget) : std::make_shared<PlotHistoryBudget>());
+    }
+
+    ~PlotHistory() {
+        detach();
+    }
+
+    PlotHistory(const PlotHistory&) = delete;
+    PlotHistory &operator=(const PlotHistory&) = delete;
+
+    void setBudget(std::shared_ptr<PlotHistoryBudget> budget) {
+        detach();
+        attach(std::move(budget));
+        spillColdChunks();
+    }
+
+    const PlotHistoryBudget &budget() const {
+        return *budget_;
+    }
+
+    void append(double key, double value) {
+        if (chunks_.empty() || chunks_.back().count == CHUNK_POINTS) {
+            chunks_.emplace_back();
+            chunks_.back().keys.reserve(CHUNK_POINTS);
+            chunks_.back().values.reserve(CHUNK_POINTS);
+            chunks_.back().firstKey = key;
+            // Предыдущий блок заполнен и может быть выгружен
+            spillColdChunks();
+        }
+
+        Chunk &chunk = chunks_.back();
+        chunk.keys.append(key);
+        chunk.values.append(value);
+        chunk.lastKey = key;
+        ++chunk.count;
+        ++size_;
+        addResident(POINT_BYTES);
+    }
+
+    void clear() {
+        addResident(-memoryBytes_);
+        chunks_.clear();
+        spillFile_.reset();
+        cachedIndex_ = -1;
+        cachedKeys_.clear();
+        cachedValues_.clear();
+        size_ = 0;
+        firstResident_ = 0;
+        spillDisabled_ = false;
+    }
+
+    qint64 size() const {
+        return size_;
+    }
+
+    bool isEmpty() const {
+        return size_ == 0;
+    }
+
+    double firstKey() const {
+        return chunks_.empty() ? 0 : chunks_.front().firstKey;
+    }
+
+    double lastKey() const {
+        return chunks_.empty() ? 0 : chunks_.back().lastKey;
+    }
+
+    qint64 memoryBytes() const {
+        return memoryBytes_;
+    }
+
+    // Последние не более count точек с ключом из [startKey, endKey] в порядке возрастания.
+    // Читаются только блоки, пересекающие интервал, начиная с конца.
+    void readTail(double startKey, double endKey, int count,
+                  QVector<double> &keys, QVector<double> &values) const {
+        keys.clear();
+        values.clear();
+        if (count <= 0 || chunks_.empty() || endKey < startKey) {
+            return;
+        }
+
+        keys.resize(count);
+        values.resize(count);
+        int position = count;
+
+        // Последний блок, который начинается не позже endKey
+        auto it = std::upper_bound(chunks_.begin(), chunks_.end(), endKey,
+                                   [](double key, const Chunk &chunk) { return key < chunk.firstKey; });
+        for (int index = static_cast<int>(it - chunks_.begin()) - 1; index >= 0 && position > 0; --index) {
+            const Chunk &chunk = chunks_[index];
+            if (chunk.lastKey < startKey) {
+                break;
+            }
+
+            const double *chunkKeys = nullptr;
+            const double *chunkValues = nullptr;
+            if (!load(index, chunkKeys, chunkValues)) {
+                break;
+            }
+            for (int row = chunk.count - 1; row >= 0 && position > 0; --row) {
+                if (chunkKeys[row] > endKey) {
+                    continue;
+                }
+                if (chunkKeys[row] < startKey) {
+                    break;
+                }
+                --position;
+                keys[position] = chunkKeys[row];
+                values[position] = chunkValues[row];
+            }
+        }
+
+        if (position > 0) {
+            keys.remove(0, position);
+            values.remove(0, position);
+        }
+    }
+
+    // Последние не более count точек всей истории
+    void readTail(int count, QVector<double> &keys, QVector<double> &values) const {
+        readTail(firstKey(), lastKey(), count, keys, values);
+    }
+
+private:
+    friend class PlotHistoryBudget;
+
+    static constexpr qint64 POINT_BYTES = 2 * sizeof(double);
+
+    struct Chunk
+    {
+        QVector<double> keys;
+        QVector<double> values;
+        double firstKey = 0;
+        double lastKey = 0;
+        int count = 0;
+        qint64 fileOffset = -1; // смещение во временном файле, -1 - блок в памяти
+    };
+
+    void attach(std::shared_ptr<PlotHistoryBudget> budget) {
+        budget_ = std::move(budget);
+        budget_->histories_.push_back(this);
+        budget_->resident_ += memoryBytes_;
+    }
+
+    void detach() {
+        budget_->resident_ -= memoryBytes_;
+        std::vector<PlotHistory*> &histories = budget_->histories_;
+        histories.erase(std::remove(histories.begin(), histories.end(), this), histories.end());
+    }
+
+    void addResident(qint64 bytes) {
+        memoryBytes_ += bytes;
+        budget_->resident_ += bytes;
+    }
+
+    // Выгружает свои самые старые заполненные блоки, пока общая память выше бюджета,
+    // а своя - выше доли. Последний блок всегда остается в памяти: в него идет запись.
+    void spillColdChunks() {
+        while (!spillDisabled_ && firstResident_ + 1 < chunks_.size()
+               && budget_->isExceeded() && memoryBytes_ > budget_->share()) {
+            if (!spill(chunks_[firstResident_])) {
+                return;
+            }
+            ++firstResident_;
+        }
+    }
+
+    bool spill(Chunk &chunk) {
+        if (!spillFile_) {
+            spillFile_.reset(new QTemporaryFile(QDir::tempPath() + "/plothistory_XXXXXX.bin"));
+            if (!spillFile_->open()) {
+                qDebug() << "Не удалось создать файл истории графика:" << spillFile_->errorString();
+                spillFile_.reset();
+                // Без файла история просто остается в памяти
+                spillDisabled_ = true;
+                return false;
+            }
+        }
+
+        const qint64 offset = spillFile_->size();
+        const qint64 bytes = chunk.count * static_cast<qint64>(sizeof(double));
+        if (!spillFile_->seek(offset)
+            || spillFile_->write(reinterpret_cast<const char*>(chunk.keys.constData()), bytes) != bytes
+            || spillFile_->write(reinterpret_cast<const char*>(chunk.values.constData()), bytes) != bytes
+            || !spillFile_->flush()) {
+            qDebug() << "Ошибка записи в файл истории графика:" << spillFile_->errorString();
+            spillDisabled_ = true;
+            return false;
+        }
+
+        chunk.fileOffset = offset;
+        QVector<double>().swap(chunk.keys);
+        QVector<double>().swap(chunk.values);
+        addResident(-chunk.count * POINT_BYTES);
+        return true;
+    }
+
+    // Данные блока: из памяти или из файла через кэш последнего прочитанного блока
+    bool load(int index, const double *&keys, const double *&values) const {
+        const Chunk &chunk = chunks_[index];
+        if (chunk.fileOffset < 0) {
+            keys = chunk.keys.constData();
+            values = chunk.values.constData();
+            return true;
+        }
+
+        if (cachedIndex_ != index) {
+            const qint64 bytes = chunk.count * static_cast<qint64>(sizeof(double));
+            cachedKeys_.resize(chunk.count);
+            cachedValues_.resize(chunk.count);
+            if (!spillFile_->seek(chunk.fileOffset)
+                || spillFile_->read(reinterpret_cast<char*>(cachedKeys_.data()), bytes) != bytes
+                || spillFile_->read(reinterpret_cast<char*>(cachedValues_.data()), bytes) != bytes) {
+                qDebug() << "Ошибка чтения файла истории графика:" << spillFile_->errorString();
+                cachedIndex_ = -1;
+                return false;
+            }
+            cachedIndex_ = index;
+        }
+
+        keys = cachedKeys_.constData();
+        values = cachedValues_.constData();
+        return true;
+    }
+
+    std::vector<Chunk> chunks_;
+    qint64 size_ = 0;
+    qint64 memoryBytes_ = 0;
+    std::shared_ptr<PlotHistoryBudget> budget_;
+    bool spillDisabled_ = false; // файл истории недоступен, блоки остаются в памяти
+    size_t firstResident_ = 0; // блоки до него выгружены в файл
+
+    std::unique_ptr<QTemporaryFile> spillFile_;
+    mutable int cachedIndex_ = -1;
+    mutable QVector<double> cachedKeys_;
+    mutable QVector<double> cachedValues_;
+};
+
+inline void PlotHistoryBudget::setLimit(qint64 bytes)
+{
+    limit_ = bytes;
+    for (PlotHistory *history : histories_) {
+        history->spillColdChunks();
+    }
+}
+
+#endif // PLOTHISTORY_H
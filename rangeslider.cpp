@@ -38,6 +38,17 @@ void RangeSlider::setRange(const QDateTime &min, const QDateTime &max) {
     endSlider->setValue(100);
 }
 
+void RangeSlider::extendRange(const QDateTime &min, const QDateTime &max) {
+    minTimestamp = min;
+    maxTimestamp = max;
+    startLabel->setText(getStartTimestamp().toString("yyyy-MM-dd HH:mm:ss"));
+    endLabel->setText(getEndTimestamp().toString("yyyy-MM-dd HH:mm:ss"));
+}
+
+bool RangeSlider::isAtEnd() const {
+    return endSlider->value() == endSlider->maximum();
+}
+
 QDateTime RangeSlider::getStartTimestamp() const {
     int value = startSlider->value();
     qint64 diff = maxTimestamp.toMSecsSinceEpoch() - minTimestamp.toMSecsSinceEpoch();
@@ -13,6 +13,10 @@ class RangeSlider : public QWidget {
 public:
     explicit RangeSlider(QWidget *parent = nullptr);
     void setRange(const QDateTime &min, const QDateTime &max);
+    // Меняет границы, не трогая ползунки и не перезагружая выбранный интервал
+    void extendRange(const QDateTime &min, const QDateTime &max);
+    // Правый ползунок стоит в конце записи
+    bool isAtEnd() const;
     QDateTime getStartTimestamp() const;
     QDateTime getEndTimestamp() const;
 
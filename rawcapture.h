@@ -0,0 +1,385 @@
+#ifndef RAWCAPTURE_H
+#define RAWCAPTURE_H
+
+#include <QByteArray>
+#include <QDebug>
+#include <QFile>
+#include <QString>
+#include <QtGlobal>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ingestqueue.h"
+
+// Файл сырого потока порта (.insraw): байты до разбора и время каждого чтения.
+// Заголовок: сигнатура RAW_MAGIC, календарное и монотонное время якоря сессии (int64 LE).
+// Далее записи: varint приращения монотонного времени от предыдущей записи (от якоря для первой),
+// varint длины и сами байты. Запись с длиной 0 - разрыв: за ней varint числа потерянных байт.
+namespace RawCapture {
+
+static constexpr char RAW_MAGIC[8] = {'I', 'N', 'S', 'R', 'A', 'W', '\0', '\1'};
+static constexpr int HEADER_BYTES = sizeof(RAW_MAGIC) + 2 * sizeof(qint64);
+static constexpr const char *SUFFIX = "insraw";
+
+inline void appendVarint(QByteArray &out, quint64 value) {
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+}
+
+struct RawCaptureStats
+{
+    qint64 bytes = 0;        // принято в запись
+    qint64 records = 0;      // чтения порта
+    qint64 droppedBytes = 0; // не поместились: диск не успевает
+    qint64 writtenBytes = 0; // размер файла
+};
+
+// Запись сырого потока из потока чтения порта.
+// append только копирует байты в текущий блок под коротким мьютексом;
+// заполненные блоки пишет на диск отдельный поток крупными write.
+// Если диск отстает больше чем на MAX_QUEUED_BLOCKS блоков, новые байты
+// отбрасываются и в файл пишется запись разрыва: поток чтения не ждет диск.
+class RawCaptureWriter
+{
+public:
+    static constexpr int BLOCK_BYTES = 1024 * 1024;
+    static constexpr int MAX_QUEUED_BLOCKS = 64;
+    static constexpr int SPARE_BLOCKS = 4;
+    // Неполный блок уходит на диск не реже чем раз в FLUSH_INTERVAL_MS
+    static constexpr int FLUSH_INTERVAL_MS = 1000;
+
+    RawCaptureWriter() = default;
+
+    ~RawCaptureWriter() {
+        close();
+    }
+
+    RawCaptureWriter(const RawCaptureWriter&) = delete;
+    RawCaptureWriter &operator=(const RawCaptureWriter&) = delete;
+
+    bool open(const QString &path, qint64 wallAnchorNs, qint64 monotonicAnchorNs) {
+        close();
+        file_.setFileName(path);
+        // Существующий захват не перезаписывается: открытие завершается ошибкой
+        if (!file_.open(QIODevice::WriteOnly | QIODevice::NewOnly)) {
+            qDebug() << "Не удалось создать файл сырого потока" << path << ":" << file_.errorString();
+            return false;
+        }
+
+        QByteArray header(RawCapture::RAW_MAGIC, sizeof(RawCapture::RAW_MAGIC));
+        header.append(reinterpret_cast<const char*>(&wallAnchorNs), sizeof(wallAnchorNs));
+        header.append(reinterpret_cast<const char*>(&monotonicAnchorNs), sizeof(monotonicAnchorNs));
+        file_.write(header);
+
+        lastArrivalNs_ = monotonicAnchorNs;
+        stats_ = RawCaptureStats();
+        stats_.writtenBytes = header.size();
+        active_.clear();
+        active_.reserve(BLOCK_BYTES);
+        pendingGapBytes_ = 0;
+        stopping_ = false;
+        thread_ = std::thread(&RawCaptureWriter::run, this);
+        return true;
+    }
+
+    void close() {
+        if (!thread_.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        condition_.notify_one();
+        thread_.join();
+        file_.close();
+    }
+
+    bool isOpen() const {
+        return thread_.joinable();
+    }
+
+    QString fileName() const {
+        return file_.fileName();
+    }
+
+    // Вызывается из потока чтения сразу после read
+    void append(const char *data, int size, qint64 arrivalNs) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pendingGapBytes_ > 0 || static_cast<int>(full_.size()) >= MAX_QUEUED_BLOCKS) {
+            if (static_cast<int>(full_.size()) >= MAX_QUEUED_BLOCKS) {
+                pendingGapBytes_ += size;
+                stats_.droppedBytes += size;
+                return;
+            }
+            // Место появилось: сначала отмечается разрыв
+            RawCapture::appendVarint(active_, 0);
+            RawCapture::appendVarint(active_, 0);
+            RawCapture::appendVarint(active_, static_cast<quint64>(pendingGapBytes_));
+            pendingGapBytes_ = 0;
+        }
+
+        RawCapture::appendVarint(active_, static_cast<quint64>(std::max<qint64>(0, arrivalNs - lastArrivalNs_)));
+        RawCapture::appendVarint(active_, static_cast<quint64>(size));
+        active_.append(data, size);
+        lastArrivalNs_ = std::max(lastArrivalNs_, arrivalNs);
+        stats_.bytes += size;
+        ++stats_.records;
+
+        if (active_.size() >= BLOCK_BYTES) {
+            rotateBlock();
+            condition_.notify_one();
+        }
+    }
+
+    RawCaptureStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    // Записанные блоки возвращаются в spare_, поэтому в потоке чтения память не выделяется
+    void rotateBlock() {
+        full_.push_back(std::move(active_));
+        if (!spare_.empty()) {
+            active_ = std::move(spare_.back());
+            spare_.pop_back();
+        } else {
+            active_ = QByteArray();
+            active_.reserve(BLOCK_BYTES);
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            condition_.wait_for(lock, std::chrono::milliseconds(FLUSH_INTERVAL_MS),
+                                [this] { return stopping_ || !full_.empty(); });
+            // По таймауту и при остановке уходит и неполный блок
+            if (full_.empty() && !active_.isEmpty()) {
+                rotateBlock();
+            }
+
+            std::deque<QByteArray> blocks;
+            blocks.swap(full_);
+            const bool stopping = stopping_;
+            lock.unlock();
+
+            qint64 written = 0;
+            for (QByteArray &block : blocks) {
+                const qint64 result = file_.write(block);
+                if (result < 0) {
+                    qDebug() << "Ошибка записи сырого потока:" << file_.errorString();
+                } else {
+                    written += result;
+                }
+                // После reserve resize(0) сохраняет выделенную память
+                block.resize(0);
+            }
+            file_.flush();
+
+            lock.lock();
+            stats_.writtenBytes += written;
+            while (!blocks.empty() && static_cast<int>(spare_.size()) < SPARE_BLOCKS) {
+                spare_.push_back(std::move(blocks.front()));
+                blocks.pop_front();
+            }
+            if (stopping && full_.empty() && active_.isEmpty()) {
+                return;
+            }
+        }
+    }
+
+    QFile file_;
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    QByteArray active_;
+    std::deque<QByteArray> full_;
+    std::deque<QByteArray> spare_;
+    qint64 lastArrivalNs_ = 0;
+    qint64 pendingGapBytes_ = 0;
+    RawCaptureStats stats_;
+    bool stopping_ = false;
+};
+
+// Последовательное чтение файла сырого потока.
+// При открытии файл просматривается один раз: строится разреженный индекс
+// по времени, через который seek не перечитывает файл с начала.
+class RawCaptureReader
+{
+public:
+    // Запись индекса на каждые INDEX_STRIDE чтений порта
+    static constexpr int INDEX_STRIDE = 1024;
+
+    bool open(const QString &path) {
+        file_.close();
+        file_.setFileName(path);
+        if (!file_.open(QIODevice::ReadOnly)) {
+            qDebug() << "Не удалось открыть файл сырого потока:" << file_.errorString();
+            return false;
+        }
+
+        const QByteArray header = file_.read(RawCapture::HEADER_BYTES);
+        if (header.size() != RawCapture::HEADER_BYTES
+            || std::memcmp(header.constData(), RawCapture::RAW_MAGIC, sizeof(RawCapture::RAW_MAGIC)) != 0) {
+            qDebug() << "Файл не является записью сырого потока:" << path;
+            file_.close();
+            return false;
+        }
+        std::memcpy(&wallAnchorNs_, header.constData() + sizeof(RawCapture::RAW_MAGIC), sizeof(qint64));
+        std::memcpy(&monotonicAnchorNs_, header.constData() + sizeof(RawCapture::RAW_MAGIC) + sizeof(qint64), sizeof(qint64));
+
+        buildIndex();
+        return rewind();
+    }
+
+    qint64 wallAnchorNs() const {
+        return wallAnchorNs_;
+    }
+
+    qint64 monotonicAnchorNs() const {
+        return monotonicAnchorNs_;
+    }
+
+    // Монотонное время первого и последнего чтения
+    qint64 firstNs() const {
+        return firstNs_;
+    }
+
+    qint64 lastNs() const {
+        return lastNs_;
+    }
+
+    qint64 gapBytes() const {
+        return gapBytes_;
+    }
+
+    // false - конец файла или недописанная последняя запись
+    bool next(IngestChunk &chunk) {
+        while (true) {
+            quint64 delta = 0;
+            quint64 size = 0;
+            if (!readVarint(delta) || !readVarint(size)) {
+                return false;
+            }
+            timeNs_ += static_cast<qint64>(delta);
+            if (size == 0) {
+                quint64 lost = 0;
+                if (!readVarint(lost)) {
+                    return false;
+                }
+                gapBytes_ += static_cast<qint64>(lost);
+                continue;
+            }
+            chunk.data = file_.read(static_cast<qint64>(size));
+            if (chunk.data.size() != static_cast<int>(size)) {
+                return false;
+            }
+            chunk.arrivalNs = timeNs_;
+            return true;
+        }
+    }
+
+    bool rewind() {
+        timeNs_ = monotonicAnchorNs_;
+        return file_.seek(RawCapture::HEADER_BYTES);
+    }
+
+    // Становится перед первым чтением не раньше arrivalNs
+    bool seek(qint64 arrivalNs) {
+        auto it = std::upper_bound(index_.begin(), index_.end(), arrivalNs,
+                                   [](qint64 time, const IndexEntry &entry) { return time < entry.arrivalNs; });
+        if (it == index_.begin()) {
+            return rewind();
+        }
+        --it;
+        if (!file_.seek(it->offset)) {
+            return false;
+        }
+        timeNs_ = it->previousNs;
+
+        // Дочитывание до нужного времени внутри шага индекса
+        while (true) {
+            const qint64 offset = file_.pos();
+            const qint64 previous = timeNs_;
+            IngestChunk chunk;
+            if (!next(chunk)) {
+                return true;
+            }
+            if (chunk.arrivalNs >= arrivalNs) {
+                timeNs_ = previous;
+                return file_.seek(offset);
+            }
+        }
+    }
+
+private:
+    struct IndexEntry
+    {
+        qint64 arrivalNs;   // время чтения
+        qint64 previousNs;  // время предыдущего чтения, от него считается приращение
+        qint64 offset;      // смещение записи в файле
+    };
+
+    void buildIndex() {
+        index_.clear();
+        rewind();
+        firstNs_ = lastNs_ = monotonicAnchorNs_;
+        qint64 records = 0;
+        while (true) {
+            const qint64 offset = file_.pos();
+            const qint64 previous = timeNs_;
+            IngestChunk chunk;
+            if (!next(chunk)) {
+                break;
+            }
+            if (records % INDEX_STRIDE == 0) {
+                index_.push_back({chunk.arrivalNs, previous, offset});
+            }
+            if (records == 0) {
+                firstNs_ = chunk.arrivalNs;
+            }
+            lastNs_ = chunk.arrivalNs;
+            ++records;
+        }
+        gapBytes_ = 0;
+    }
+
+    bool readVarint(quint64 &value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            char byte;
+            if (!file_.getChar(&byte)) {
+                return false;
+            }
+            value |= static_cast<quint64>(static_cast<uint8_t>(byte) & 0x7F) << shift;
+            if (!(static_cast<uint8_t>(byte) & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    QFile file_;
+    qint64 wallAnchorNs_ = 0;
+    qint64 monotonicAnchorNs_ = 0;
+    qint64 firstNs_ = 0;
+    qint64 lastNs_ = 0;
+    qint64 timeNs_ = 0;
+    qint64 gapBytes_ = 0;
+    std::vector<IndexEntry> index_;
+};
+
+#endif // RAWCAPTURE_H
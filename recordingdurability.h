@@ -0,0 +1,170 @@
+#ifndef RECORDINGDURABILITY_H
+#define RECORDINGDURABILITY_H
+
+#include <QtGlobal>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Как часто записанные данные принудительно сбрасываются на диск.
+// Сброс выполняется, когда с прошлого сброса прошло intervalMs миллисекунд
+// или записано bytes байт; 0 отключает соответствующее условие.
+struct DurabilityPolicy
+{
+    int intervalMs = 1000;
+    qint64 bytes = 4 * 1024 * 1024;
+
+    bool isEnabled() const {
+        return intervalMs > 0 || bytes > 0;
+    }
+};
+
+// Результат восстановления файла записи после аварийного завершения
+struct RecoveryReport
+{
+    qint64 validBytes = 0;      // размер файла после восстановления
+    qint64 truncatedBytes = 0;  // отброшенный хвост: недописанная строка или блок
+    qint64 lastTimestampNs = std::numeric_limits<qint64>::min(); // последняя сохраненная строка
+
+    bool hasTimestamp() const {
+        return lastTimestampNs != std::numeric_limits<qint64>::min();
+    }
+};
+
+// Фоновый fsync для файла записи.
+// Поток записи только считает байты и сверяет время (written/isDue),
+// сам системный вызов выполняется в отдельном потоке и не блокирует запись.
+// Вызывающий код обязан вызвать finish() до закрытия дескриптора.
+class FileSyncer
+{
+public:
+    explicit FileSyncer(const DurabilityPolicy &policy)
+        : policy_(policy), thread_(&FileSyncer::run, this) {
+        sinceSync_.start();
+    }
+
+    ~FileSyncer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        condition_.notify_one();
+        thread_.join();
+    }
+
+    FileSyncer(const FileSyncer&) = delete;
+    FileSyncer &operator=(const FileSyncer&) = delete;
+
+    // Данные переданы ОС; timestampNs - время последней строки в них
+    void written(qint64 bytes, qint64 timestampNs) {
+        unsyncedBytes_ += bytes;
+        lastWrittenTimestamp_ = timestampNs;
+    }
+
+    bool intervalElapsed() const {
+        return policy_.intervalMs > 0 && sinceSync_.hasExpired(policy_.intervalMs);
+    }
+
+    bool isDue() const {
+        return unsyncedBytes_ > 0
+            && ((policy_.bytes > 0 && unsyncedBytes_ >= policy_.bytes) || intervalElapsed());
+    }
+
+    // Ставит fsync в очередь фонового потока. Если предыдущий сброс еще идет,
+    // запросы объединяются: следующий сброс покроет все записанное к этому моменту.
+    void requestSync(int fd) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            requestedFd_ = fd;
+            requestedTimestamp_ = lastWrittenTimestamp_;
+        }
+        condition_.notify_one();
+        unsyncedBytes_ = 0;
+        sinceSync_.restart();
+    }
+
+    // Дожидается фонового сброса и синхронно сбрасывает остаток
+    void finish(int fd) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this] { return requestedFd_ < 0 && !syncing_; });
+        lock.unlock();
+
+        if (unsyncedBytes_ > 0 && syncFile(fd)) {
+            lastDurableTimestamp_ = lastWrittenTimestamp_;
+        }
+        unsyncedBytes_ = 0;
+    }
+
+    // Время последней строки, гарантированно сохраненной на диск
+    qint64 lastDurableTimestamp() const {
+        return lastDurableTimestamp_;
+    }
+
+    static bool syncFile(int fd) {
+#if defined(Q_OS_WIN)
+        const bool ok = _commit(fd) == 0;
+#elif defined(Q_OS_LINUX)
+        // Для дописывания в конец fdatasync достаточно: размер файла он тоже сохраняет
+        const bool ok = ::fdatasync(fd) == 0;
+#else
+        const bool ok = ::fsync(fd) == 0;
+#endif
+        if (!ok) {
+            qDebug() << "Failed to sync recording to disk";
+        }
+        return ok;
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            condition_.wait(lock, [this] { return stopping_ || requestedFd_ >= 0; });
+            if (requestedFd_ < 0) {
+                return;
+            }
+
+            const int fd = requestedFd_;
+            const qint64 timestamp = requestedTimestamp_;
+            requestedFd_ = -1;
+            syncing_ = true;
+            lock.unlock();
+
+            const bool ok = syncFile(fd);
+
+            lock.lock();
+            syncing_ = false;
+            if (ok) {
+                lastDurableTimestamp_ = timestamp;
+            }
+            idle_.notify_all();
+        }
+    }
+
+    DurabilityPolicy policy_;
+    QElapsedTimer sinceSync_;
+    qint64 unsyncedBytes_ = 0;
+    qint64 lastWrittenTimestamp_ = std::numeric_limits<qint64>::min();
+    std::atomic<qint64> lastDurableTimestamp_{std::numeric_limits<qint64>::min()};
+
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::condition_variable idle_;
+    int requestedFd_ = -1;
+    qint64 requestedTimestamp_ = 0;
+    bool syncing_ = false;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+#endif // RECORDINGDURABILITY_H
@@ -0,0 +1,365 @@
+#ifndef REPLAYENGINE_H
+#define REPLAYENGINE_H
+
+#include "channelschema.h"
+#include "comand/crc8.h"
+#include "ingestqueue.h"
+#include "monotonicclock.h"
+#include "rawcapture.h"
+#include "sensordatacursor.h"
+#include "storagemanager.h"
+
+#include <QFileInfo>
+#include <QString>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <mutex>
+
+// Источник воспроизведения: куски байт потока порта в порядке времени.
+// Время кусков - в шкале якоря источника (wallAnchorNs/monotonicAnchorNs).
+class ReplaySource
+{
+public:
+    virtual ~ReplaySource() = default;
+
+    virtual bool next(IngestChunk &chunk) = 0;
+    virtual bool seek(qint64 timeNs) = 0;
+    virtual qint64 firstNs() const = 0;
+    virtual qint64 lastNs() const = 0;
+    virtual qint64 wallAnchorNs() const = 0;
+    virtual qint64 monotonicAnchorNs() const = 0;
+};
+
+// Сырой поток порта: байты идут в разбор ровно такими кусками, как были прочитаны
+class RawCaptureReplaySource : public ReplaySource
+{
+public:
+    bool open(const QString &path) {
+        return reader_.open(path);
+    }
+
+    bool next(IngestChunk &chunk) override {
+        return reader_.next(chunk);
+    }
+
+    bool seek(qint64 timeNs) override {
+        return reader_.seek(timeNs);
+    }
+
+    qint64 firstNs() const override {
+        return reader_.firstNs();
+    }
+
+    qint64 lastNs() const override {
+        return reader_.lastNs();
+    }
+
+    qint64 wallAnchorNs() const override {
+        return reader_.wallAnchorNs();
+    }
+
+    qint64 monotonicAnchorNs() const override {
+        return reader_.monotonicAnchorNs();
+    }
+
+private:
+    RawCaptureReader reader_;
+};
+
+// Разобранная запись (CSV, бинарная, SQLite, Arrow): каждая строка снова кодируется
+// в кадр SensorData, поэтому проходит тот же разбор, что и данные с порта.
+// Время строки - календарное, якорь нулевой. Отсутствующие в записи каналы передаются нулями.
+class RecordingReplaySource : public ReplaySource
+{
+public:
+    static constexpr uint8_t START_BYTE = 0xAA;
+    static constexpr uint8_t ACCEPTED = 0x01;
+
+    bool open(const QString &path) {
+        // DAO сообщает о поврежденном или недоступном файле исключением
+        try {
+            dao_.reset(FileStorageManager::createReadDao(path));
+        } catch (const std::exception &e) {
+            qDebug() << "Не удалось открыть запись:" << path << e.what();
+            return false;
+        }
+        if (!dao_) {
+            return false;
+        }
+
+        // Границы записи - одним проходом, как при загрузке файла
+        std::unique_ptr<ISensorDataCursor> cursor = dao_->selectAllSensorDataCursor();
+        bool empty = true;
+        while (cursor && cursor->next(batch_)) {
+            if (batch_.isEmpty()) {
+                continue;
+            }
+            if (empty) {
+                firstNs_ = batch_.timestamps.first();
+                empty = false;
+            }
+            lastNs_ = batch_.timestamps.last();
+        }
+        if (empty) {
+            qDebug() << "Запись пуста:" << path;
+            return false;
+        }
+        return seek(firstNs_);
+    }
+
+    bool next(IngestChunk &chunk) override {
+        while (row_ >= batch_.size()) {
+            batch_.clear();
+            row_ = 0;
+            if (!cursor_ || !cursor_->next(batch_)) {
+                return false;
+            }
+        }
+        encodeFrame(batch_, row_, counter_++, chunk.data);
+        chunk.arrivalNs = batch_.timestamps[row_];
+        ++row_;
+        return true;
+    }
+
+    bool seek(qint64 timeNs) override {
+        const QDateTime start = SensorDataBatch::fromNanos(timeNs);
+        const QDateTime end = SensorDataBatch::fromNanos(lastNs_).addMSecs(1);
+        cursor_ = dao_->selectSensorDataCursor(start, end);
+        batch_.clear();
+        row_ = 0;
+        return cursor_ != nullptr;
+    }
+
+    qint64 firstNs() const override {
+        return firstNs_;
+    }
+
+    qint64 lastNs() const override {
+        return lastNs_;
+    }
+
+    qint64 wallAnchorNs() const override {
+        return 0;
+    }
+
+    qint64 monotonicAnchorNs() const override {
+        return 0;
+    }
+
+    // Кадр как у устройства: заголовок, измерения по ChannelSchema, счетчик, CRC8 по заголовку и телу
+    static void encodeFrame(const SensorDataBatch &batch, int row, uint8_t counter, QByteArray &out) {
+        out.resize(0);
+        out.append(static_cast<char>(START_BYTE));
+        out.append(static_cast<char>(ACCEPTED));
+        out.append(static_cast<char>(ChannelSchema::MEASURES_BYTES + 1));
+        out.resize(out.size() + ChannelSchema::MEASURES_BYTES);
+        char *body = out.data() + 3;
+        ChannelSchema::forEachChannel([&](auto channel) {
+            constexpr int index = decltype(channel)::value;
+            const bool present = batch.hasChannels(ChannelSchema::GROUPS[ChannelSchema::CHANNELS[index].group].mask);
+            ChannelSchema::encode<index>(present ? batch.column<index>()[row] : 0, body);
+        });
+        out.append(static_cast<char>(counter));
+        out.append(static_cast<char>(crc8(out.constData(), out.size())));
+    }
+
+private:
+    std::unique_ptr<ISensorDataDAO> dao_;
+    std::unique_ptr<ISensorDataCursor> cursor_;
+    SensorDataBatch batch_;
+    int row_ = 0;
+    uint8_t counter_ = 0;
+    qint64 firstNs_ = 0;
+    qint64 lastNs_ = 0;
+};
+
+struct ReplayOptions
+{
+    double speed = 1;                // 1 - исходная скорость, N - в N раз быстрее, 0 - без пауз
+    bool originalTimestamps = true;  // время из файла; иначе время выдачи, как у живого порта
+};
+
+struct ReplayPosition
+{
+    qint64 firstNs = 0;
+    qint64 lastNs = 0;
+    qint64 positionNs = 0;
+    bool paused = true;
+    bool finished = false;
+};
+
+// Воспроизведение источника с заданной скоростью.
+// next() вызывается потоком чтения и ждет, пока очередной кусок не станет «пришедшим»:
+// время выдачи = начало воспроизведения + (время куска - время начала) / speed.
+// pause/play/seek/setSpeed вызываются из потока GUI и будят ожидающий next().
+// При speed = 0 и очереди приема без потерь результат разбора одинаков при каждом запуске.
+class ReplayEngine
+{
+public:
+    // Ожидание в next() не дольше, чтобы поток чтения проверял флаг остановки
+    static constexpr qint64 MAX_WAIT_NS = 100000000;
+
+    ReplayEngine(std::unique_ptr<ReplaySource> source, const ReplayOptions &options)
+        : source_(std::move(source)), options_(options) {
+        positionNs_ = source_->firstNs();
+    }
+
+    // Источник по расширению: сырой поток или любой формат записи
+    static std::unique_ptr<ReplaySource> openSource(const QString &path) {
+        if (QFileInfo(path).suffix().compare(RawCapture::SUFFIX, Qt::CaseInsensitive) == 0) {
+            std::unique_ptr<RawCaptureReplaySource> source(new RawCaptureReplaySource());
+            if (!source->open(path)) {
+                return nullptr;
+            }
+            return source;
+        }
+        std::unique_ptr<RecordingReplaySource> source(new RecordingReplaySource());
+        if (!source->open(path)) {
+            return nullptr;
+        }
+        return source;
+    }
+
+    static bool isReplayFile(const QString &path) {
+        const QFileInfo info(path);
+        static const QStringList suffixes = {RawCapture::SUFFIX, "csv", "insr", "db", "arrow", "feather"};
+        return info.isFile() && suffixes.contains(info.suffix().toLower());
+    }
+
+    qint64 wallAnchorNs() const {
+        return source_->wallAnchorNs();
+    }
+
+    qint64 monotonicAnchorNs() const {
+        return source_->monotonicAnchorNs();
+    }
+
+    const ReplayOptions &options() const {
+        return options_;
+    }
+
+    void play() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            paused_ = false;
+            restartPacing();
+        }
+        condition_.notify_all();
+    }
+
+    void pause() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            paused_ = true;
+        }
+        condition_.notify_all();
+    }
+
+    void setSpeed(double speed) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            options_.speed = std::max(0.0, speed);
+            restartPacing();
+        }
+        condition_.notify_all();
+    }
+
+    void seek(qint64 timeNs) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            timeNs = std::max(source_->firstNs(), std::min(source_->lastNs(), timeNs));
+            source_->seek(timeNs);
+            hasPending_ = false;
+            finished_ = false;
+            positionNs_ = timeNs;
+            restartPacing();
+        }
+        condition_.notify_all();
+    }
+
+    // Будит поток, ожидающий в next(), например при остановке чтения
+    void wakeUp() {
+        condition_.notify_all();
+    }
+
+    ReplayPosition position() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ReplayPosition position;
+        position.firstNs = source_->firstNs();
+        position.lastNs = source_->lastNs();
+        position.positionNs = positionNs_;
+        position.paused = paused_;
+        position.finished = finished_;
+        return position;
+    }
+
+    // Следующий кусок, когда подошло его время; false - пауза, конец или остановка
+    bool next(IngestChunk &chunk, const std::atomic<bool> &stop) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop) {
+            if (paused_ || finished_) {
+                condition_.wait_for(lock, std::chrono::nanoseconds(MAX_WAIT_NS));
+                return false;
+            }
+            if (!hasPending_) {
+                if (!source_->next(pending_)) {
+                    finished_ = true;
+                    continue;
+                }
+                hasPending_ = true;
+                if (!pacingStarted_) {
+                    pacingSourceNs_ = pending_.arrivalNs;
+                    pacingStarted_ = true;
+                }
+            }
+
+            if (options_.speed > 0) {
+                const qint64 dueNs = pacingWallNs_ + static_cast<qint64>((pending_.arrivalNs - pacingSourceNs_) / options_.speed);
+                const qint64 waitNs = dueNs - MonotonicClock::nowNs();
+                if (waitNs > 0) {
+                    condition_.wait_for(lock, std::chrono::nanoseconds(std::min(waitNs, MAX_WAIT_NS)));
+                    continue;
+                }
+            }
+
+            chunk = std::move(pending_);
+            hasPending_ = false;
+            positionNs_ = chunk.arrivalNs;
+            if (!options_.originalTimestamps) {
+                chunk.arrivalNs = MonotonicClock::nowNs();
+            }
+            return true;
+        }
+        return false;
+    }
+
+private:
+    // Отсчет темпа заново: после паузы, перемотки и смены скорости
+    void restartPacing() {
+        pacingWallNs_ = MonotonicClock::nowNs();
+        pacingSourceNs_ = hasPending_ ? pending_.arrivalNs : positionNs_;
+        pacingStarted_ = hasPending_;
+    }
+
+    std::unique_ptr<ReplaySource> source_;
+    ReplayOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable condition_;
+    IngestChunk pending_;
+    bool hasPending_ = false;
+    bool paused_ = true;
+    bool finished_ = false;
+    qint64 positionNs_ = 0;
+    qint64 pacingWallNs_ = 0;
+    qint64 pacingSourceNs_ = 0;
+    bool pacingStarted_ = false;
+};
+
+#endif // REPLAYENGINE_H
@@ -0,0 +1,167 @@
+#ifndef SAMPLETIMING_H
+#define SAMPLETIMING_H
+
+#include <QtGlobal>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+// Метрики модели времени отсчетов
+struct SampleTimingMetrics
+{
+    qint64 frames = 0;      // принятые кадры
+    qint64 dropped = 0;     // пропуски по разрывам счетчика
+    qint64 duplicates = 0;  // повторы счетчика
+    qint64 resyncs = 0;     // сбросы модели после скачка времени
+    double rateHz = 0;      // оценка частоты отсчетов устройства
+    double driftPpm = std::numeric_limits<double>::quiet_NaN(); // уход часов устройства от номинала
+    double jitterNs = 0;    // СКО времени прихода относительно модели
+
+    bool hasDrift() const {
+        return !std::isnan(driftPpm);
+    }
+};
+
+// Восстановление времени отсчетов по счетчику кадров dataSendCount.
+// Счетчик восьмибитный: он разворачивается в сквозной номер отсчета, разрыв
+// больше единицы считается потерей кадров. Время прихода кадров приближается
+// прямой arrival = t0 + period * index методом наименьших квадратов с
+// экспоненциальным забыванием, поэтому медленный дрейф часов отслеживается,
+// а задержки очереди и планировщика усредняются. Время отсчета берется с прямой.
+// Потерю 256 и более кадров подряд по восьмибитному счетчику обнаружить нельзя.
+class SampleTimingModel
+{
+public:
+    static constexpr int COUNTER_MODULO = 256;
+    // До накопления MIN_FIT_FRAMES кадров время отсчета равно времени прихода
+    static constexpr int MIN_FIT_FRAMES = 16;
+    // Отклонение прихода от модели, после которого модель строится заново
+    static constexpr qint64 RESYNC_NS = 1000000000;
+    // Эффективное окно регрессии около 1 / (1 - FORGETTING) кадров
+    static constexpr double FORGETTING = 0.999;
+
+    explicit SampleTimingModel(double nominalRateHz = 0) : nominalRateHz_(nominalRateHz) {}
+
+    void setNominalRate(double rateHz) {
+        nominalRateHz_ = rateHz;
+    }
+
+    void reset() {
+        metrics_ = SampleTimingMetrics();
+        hasCounter_ = false;
+        resetFit();
+    }
+
+    // Возвращает восстановленное время отсчета в той же шкале, что arrivalNs
+    qint64 update(uint8_t counter, qint64 arrivalNs) {
+        ++metrics_.frames;
+
+        if (hasCounter_) {
+            const int delta = (counter - lastCounter_ + COUNTER_MODULO) % COUNTER_MODULO;
+            if (delta == 0) {
+                ++metrics_.duplicates;
+                return lastSampleNs_;
+            }
+            metrics_.dropped += delta - 1;
+            index_ += delta;
+        }
+        hasCounter_ = true;
+        lastCounter_ = counter;
+
+        if (weight_ == 0) {
+            originNs_ = arrivalNs;
+            originIndex_ = index_;
+        }
+
+        const double x = static_cast<double>(index_ - originIndex_);
+        const double y = static_cast<double>(arrivalNs - originNs_);
+
+        if (isFitted() && std::fabs(y - predict(x)) > RESYNC_NS) {
+            // Устройство перезапущено или связь стояла: старая прямая больше не годится
+            ++metrics_.resyncs;
+            resetFit();
+            originNs_ = arrivalNs;
+            originIndex_ = index_;
+            return accept(arrivalNs);
+        }
+
+        fit(x, y);
+        if (!isFitted()) {
+            return accept(arrivalNs);
+        }
+
+        const double period = sxy_ / sxx_;
+        metrics_.rateHz = period > 0 ? 1e9 / period : 0;
+        if (nominalRateHz_ > 0 && metrics_.rateHz > 0) {
+            metrics_.driftPpm = (metrics_.rateHz / nominalRateHz_ - 1.0) * 1e6;
+        }
+        const double residual = y - predict(x);
+        residualSquares_ = FORGETTING * residualSquares_ + (1 - FORGETTING) * residual * residual;
+        metrics_.jitterNs = std::sqrt(residualSquares_);
+
+        return accept(originNs_ + static_cast<qint64>(std::llround(predict(x))));
+    }
+
+    const SampleTimingMetrics &metrics() const {
+        return metrics_;
+    }
+
+private:
+    void resetFit() {
+        weight_ = 0;
+        fitFrames_ = 0;
+        meanX_ = 0;
+        meanY_ = 0;
+        sxx_ = 0;
+        sxy_ = 0;
+        residualSquares_ = 0;
+    }
+
+    // Взвешенное обновление средних и сумм (вариант Уэлфорда), устойчивое на длинных сессиях
+    void fit(double x, double y) {
+        weight_ = FORGETTING * weight_ + 1;
+        const double dx = x - meanX_;
+        meanX_ += dx / weight_;
+        meanY_ += (y - meanY_) / weight_;
+        sxx_ = FORGETTING * sxx_ + dx * (x - meanX_);
+        sxy_ = FORGETTING * sxy_ + dx * (y - meanY_);
+        ++fitFrames_;
+    }
+
+    bool isFitted() const {
+        return fitFrames_ >= MIN_FIT_FRAMES && sxx_ > 0;
+    }
+
+    double predict(double x) const {
+        return meanY_ + sxy_ / sxx_ * (x - meanX_);
+    }
+
+    // Время отсчетов не убывает, даже когда прямая уточняется назад
+    qint64 accept(qint64 sampleNs) {
+        if (metrics_.frames > 1 && sampleNs < lastSampleNs_) {
+            sampleNs = lastSampleNs_;
+        }
+        lastSampleNs_ = sampleNs;
+        return sampleNs;
+    }
+
+    double nominalRateHz_;
+    SampleTimingMetrics metrics_;
+
+    bool hasCounter_ = false;
+    uint8_t lastCounter_ = 0;
+    qint64 index_ = 0;
+    qint64 lastSampleNs_ = 0;
+
+    qint64 originNs_ = 0;
+    qint64 originIndex_ = 0;
+    double weight_ = 0;
+    int fitFrames_ = 0;
+    double meanX_ = 0;
+    double meanY_ = 0;
+    double sxx_ = 0;
+    double sxy_ = 0;
+    double residualSquares_ = 0;
+};
+
+#endif // SAMPLETIMING_H
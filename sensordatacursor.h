@@ -0,0 +1,207 @@
+#ifndef SENSORDATACURSOR_H
+#define SENSORDATACURSOR_H
+
+#include "channelschema.h"
+#include "extendedsensordata.h"
+
+#include <QVector>
+#include <QDateTime>
+#include <QStringList>
+#include <array>
+#include <cstdint>
+
+// Пакет измерений в колоночном виде: по вектору на каждый канал.
+// Время хранится в наносекундах с эпохи.
+struct SensorDataBatch
+{
+    enum Channels {
+        ENV = 0x01,
+        GYRO = 0x02,
+        ACCELERO = 0x04,
+        MAGNETO = 0x08,
+        ALL = ENV | GYRO | ACCELERO | MAGNETO
+    };
+
+    static constexpr qint64 NANOS_IN_MSEC = 1000000;
+
+    // Имена каналов в порядке ChannelSchema::CHANNELS: группы ENV, GYRO, ACCELERO, MAGNETO, по три на группу.
+    // Используются как имена колонок во всех форматах записи.
+    static inline const QStringList CHANNEL_NAMES = [] {
+        QStringList names;
+        for (const ChannelSchema::Channel &channel : ChannelSchema::CHANNELS) {
+            names << QString::fromLatin1(channel.name);
+        }
+        return names;
+    }();
+
+    static constexpr int GROUP_MASKS[ChannelSchema::GROUP_COUNT] = {
+        ChannelSchema::GROUPS[ChannelSchema::ENV_GROUP].mask,
+        ChannelSchema::GROUPS[ChannelSchema::GYRO_GROUP].mask,
+        ChannelSchema::GROUPS[ChannelSchema::ACCELERO_GROUP].mask,
+        ChannelSchema::GROUPS[ChannelSchema::MAGNETO_GROUP].mask
+    };
+
+    QVector<qint64> timestamps;
+    std::array<QVector<ChannelSchema::GroupValueType<ChannelSchema::ENV_GROUP>>, ChannelSchema::AXES> env;
+    std::array<QVector<ChannelSchema::GroupValueType<ChannelSchema::GYRO_GROUP>>, ChannelSchema::AXES> gyro;
+    std::array<QVector<ChannelSchema::GroupValueType<ChannelSchema::ACCELERO_GROUP>>, ChannelSchema::AXES> accelero;
+    std::array<QVector<ChannelSchema::GroupValueType<ChannelSchema::MAGNETO_GROUP>>, ChannelSchema::AXES> magneto;
+
+    // Какие группы каналов присутствуют в пакете
+    int channels = ALL;
+
+    int size() const {
+        return timestamps.size();
+    }
+
+    bool isEmpty() const {
+        return timestamps.isEmpty();
+    }
+
+    bool hasChannels(int mask) const {
+        return (channels & mask) == mask;
+    }
+
+    // Присутствует ли в пакете группа канала с номером Index
+    template<int Index>
+    bool hasChannel() const {
+        return hasChannels(ChannelSchema::GROUPS[ChannelSchema::CHANNELS[Index].group].mask);
+    }
+
+    // Колонка канала по номеру в ChannelSchema::CHANNELS
+    template<int Index>
+    QVector<ChannelSchema::ValueType<Index>> &column() {
+        return groupColumns<ChannelSchema::CHANNELS[Index].group>(*this)[ChannelSchema::CHANNELS[Index].axis];
+    }
+
+    template<int Index>
+    const QVector<ChannelSchema::ValueType<Index>> &column() const {
+        return groupColumns<ChannelSchema::CHANNELS[Index].group>(*this)[ChannelSchema::CHANNELS[Index].axis];
+    }
+
+    // Дописывает значение из поля CSV (QByteArray) или результата запроса (QVariant),
+    // приводя его к типу канала
+    template<int Index, typename Source>
+    void appendConverted(const Source &source) {
+        if constexpr (ChannelSchema::CHANNELS[Index].wire == ChannelSchema::WireType::Float32) {
+            column<Index>().append(source.toFloat());
+        } else {
+            column<Index>().append(static_cast<ChannelSchema::ValueType<Index>>(source.toInt()));
+        }
+    }
+
+    // Очищает данные, сохраняя выделенную память для следующего пакета
+    void clear() {
+        timestamps.resize(0);
+        ChannelSchema::forEachChannel([&](auto channel) {
+            column<decltype(channel)::value>().resize(0);
+        });
+    }
+
+    void reserve(int rows) {
+        timestamps.reserve(rows);
+        ChannelSchema::forEachChannel([&](auto channel) {
+            column<decltype(channel)::value>().reserve(rows);
+        });
+    }
+
+    void append(const TimestampedSensorData &data) {
+        timestamps.append(toNanos(data.getTimestamp()));
+        appendGroup(env, data.getEnvironmentalMeasures(), ENV);
+        appendGroup(gyro, data.getGyroMeasures(), GYRO);
+        appendGroup(accelero, data.getAcceleroMeasures(), ACCELERO);
+        appendGroup(magneto, data.getMagnetoMeasures(), MAGNETO);
+    }
+
+    // Без промежуточных списков: после reserve строка дописывается без выделения памяти
+    void append(qint64 timestampNs, const SensorData &data) {
+        timestamps.append(timestampNs);
+        ChannelSchema::forEachChannel([&](auto channel) {
+            constexpr int index = decltype(channel)::value;
+            constexpr ChannelSchema::Channel descriptor = ChannelSchema::CHANNELS[index];
+            if (hasChannel<index>()) {
+                column<index>().append(data.groupValues<descriptor.group>()[descriptor.axis]);
+            }
+        });
+    }
+
+    // Дописывает строку row другого пакета; переносятся каналы, присутствующие в этом пакете
+    void appendRow(const SensorDataBatch &source, int row) {
+        timestamps.append(source.timestamps[row]);
+        ChannelSchema::forEachChannel([&](auto channel) {
+            constexpr int index = decltype(channel)::value;
+            if (hasChannel<index>()) {
+                column<index>().append(source.column<index>()[row]);
+            }
+        });
+    }
+
+    // Собирает строку обратно в объект для кода, работающего построчно
+    TimestampedSensorData row(int index) const {
+        QList<float> envMeasures;
+        QList<int16_t> gyroMeasures;
+        QList<int16_t> acceleroMeasures;
+        QList<int16_t> magnetoMeasures;
+        if (hasChannels(ENV)) {
+            envMeasures = {env[0][index], env[1][index], env[2][index]};
+        }
+        if (hasChannels(GYRO)) {
+            gyroMeasures = {gyro[0][index], gyro[1][index], gyro[2][index]};
+        }
+        if (hasChannels(ACCELERO)) {
+            acceleroMeasures = {accelero[0][index], accelero[1][index], accelero[2][index]};
+        }
+        if (hasChannels(MAGNETO)) {
+            magnetoMeasures = {magneto[0][index], magneto[1][index], magneto[2][index]};
+        }
+        return TimestampedSensorData(envMeasures, gyroMeasures, acceleroMeasures, magnetoMeasures,
+                                     fromNanos(timestamps[index]));
+    }
+
+    static qint64 toNanos(const QDateTime &timestamp) {
+        return timestamp.toMSecsSinceEpoch() * NANOS_IN_MSEC;
+    }
+
+    static QDateTime fromNanos(qint64 nanos) {
+        return QDateTime::fromMSecsSinceEpoch(nanos / NANOS_IN_MSEC);
+    }
+
+private:
+    template<int Group, typename Self>
+    static auto &groupColumns(Self &self) {
+        if constexpr (Group == ChannelSchema::ENV_GROUP) {
+            return self.env;
+        } else if constexpr (Group == ChannelSchema::GYRO_GROUP) {
+            return self.gyro;
+        } else if constexpr (Group == ChannelSchema::ACCELERO_GROUP) {
+            return self.accelero;
+        } else {
+            return self.magneto;
+        }
+    }
+
+    template<typename T>
+    void appendGroup(std::array<QVector<T>, ChannelSchema::AXES> &columns, const QList<T> &values, int mask) {
+        if (!hasChannels(mask)) {
+            return;
+        }
+        for (int i = 0; i < ChannelSchema::AXES; ++i) {
+            columns[i].append(i < values.size() ? values[i] : T());
+        }
+    }
+};
+
+// Курсор выдает результат выборки пакетами фиксированного размера,
+// поэтому потребление памяти не зависит от размера выборки.
+// Курсор не должен переживать DAO, который его создал.
+class ISensorDataCursor
+{
+public:
+    virtual ~ISensorDataCursor() = default;
+
+    // Заполняет batch следующими строками (не более размера пакета).
+    // Возвращает false, когда строк больше нет.
+    virtual bool next(SensorDataBatch &batch) = 0;
+};
+
+#endif // SENSORDATACURSOR_H
@@ -16,7 +16,7 @@ SerialReaderWriter::~SerialReaderWriter()
 }
 
 bool SerialReaderWriter::openSerialPort(const QString &portName,
-                                        QSerialPort::BaudRate baudRate,
+                                        qint32 baudRate,
                                         QSerialPort::DataBits dataBits,
                                         QSerialPort::Parity parity,
                                         QSerialPort::StopBits stopBits,
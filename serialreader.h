@@ -13,7 +13,7 @@ public:
     ~SerialReaderWriter();
 
     virtual bool openSerialPort(const QString &portName,
-                        QSerialPort::BaudRate baudRate,
+                        qint32 baudRate,
                         QSerialPort::DataBits dataBits,
                         QSerialPort::Parity parity,
                         QSerialPort::StopBits stopBits,
@@ -26,8 +26,6 @@ public:
 protected:
     QSerialPort *serialPort;
     QString portName_;
-
-private:
     QString lastError;
 };
 
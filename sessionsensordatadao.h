@@ -0,0 +1,443 @@
+#ifndef SESSIONSENSORDATADAO_H
+#define SESSIONSENSORDATADAO_H
+
+#include "isensordatadao.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QVector>
+#include <QDebug>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// Сегмент сессии записи
+struct SessionSegment
+{
+    QString fileName;   // имя файла в каталоге сегментов
+    qint64 startNs = std::numeric_limits<qint64>::max();
+    qint64 endNs = std::numeric_limits<qint64>::min();
+    qint64 rowCount = 0;
+    bool open = true;   // сегмент еще пишется или запись была прервана; границы неизвестны
+
+    bool overlaps(qint64 rangeStartNs, qint64 rangeEndNs) const {
+        return open || (rowCount > 0 && endNs >= rangeStartNs && startNs <= rangeEndNs);
+    }
+};
+
+// Когда запись переходит в новый сегмент; 0 отключает условие
+struct RotationPolicy
+{
+    qint64 maxBytes = 0;
+    qint64 maxDurationNs = 0;
+
+    bool isEnabled() const {
+        return maxBytes > 0 || maxDurationNs > 0;
+    }
+};
+
+// Длинная запись, разбитая на сегменты.
+// Манифест name.session (JSON) перечисляет сегменты с границами по времени и хранит
+// набор групп каналов, которые пишут сегменты (SensorDataBatch::Channels),
+// сами сегменты лежат в каталоге name рядом с манифестом и пишутся любым
+// DAO, который создает фабрика. Выборка открывает только сегменты,
+// пересекающие запрошенный интервал, и выдает их как одну запись.
+class SessionSensorDataDAO : public ISensorDataDAO {
+public:
+    static constexpr int MANIFEST_VERSION = 1;
+    static constexpr const char *MANIFEST_SUFFIX = "session";
+    // Размер файла сегмента проверяется раз в столько строк
+    static constexpr int SIZE_CHECK_ROWS = 256;
+
+    using SegmentFactory = std::function<ISensorDataDAO*(const QString &segmentPath)>;
+
+    // Чтение существующей сессии
+    SessionSensorDataDAO(const QString &manifestPath, SegmentFactory openSegment)
+        : manifestPath(manifestPath), openSegment(std::move(openSegment)) {
+        if (!readManifest(manifestPath, segments, &channels)) {
+            qDebug() << "Failed to read session manifest:" << manifestPath;
+            throw std::runtime_error("Failed to read session manifest.");
+        }
+    }
+
+    // Новая запись: сегменты создаются createSegment с расширением segmentSuffix
+    // и сохраняют группы каналов channels
+    SessionSensorDataDAO(const QString &manifestPath, SegmentFactory openSegment, SegmentFactory createSegment,
+                         const QString &segmentSuffix, int channels, const RotationPolicy &rotation)
+        : manifestPath(manifestPath), openSegment(std::move(openSegment)),
+          createSegment(std::move(createSegment)), segmentSuffix(segmentSuffix), rotation(rotation),
+          channels(channels) {
+        if (!QDir().mkpath(segmentDirectory(manifestPath)) || !openNextSegment()) {
+            qDebug() << "Failed to start session:" << manifestPath;
+            throw std::runtime_error("Failed to start session.");
+        }
+    }
+
+    ~SessionSensorDataDAO() {
+        if (current) {
+            closeCurrentSegment();
+            writeManifest();
+        }
+    }
+
+    bool insertSensorData(const TimestampedSensorData &data) override {
+        if (!createSegment) {
+            qDebug() << "Session is opened read-only:" << manifestPath;
+            return false;
+        }
+
+        const qint64 timestamp = SensorDataBatch::toNanos(data.getTimestamp());
+        // Переход выполняется синхронно перед вставкой, поэтому строки не теряются
+        if (shouldRotate(timestamp)) {
+            closeCurrentSegment();
+            if (!openNextSegment()) {
+                return false;
+            }
+        }
+        if (!current || !current->insertSensorData(data)) {
+            return false;
+        }
+
+        SessionSegment &segment = segments.last();
+        segment.startNs = qMin(segment.startNs, timestamp);
+        segment.endNs = qMax(segment.endNs, timestamp);
+        ++segment.rowCount;
+        ++rowsSinceSizeCheck;
+        return true;
+    }
+
+    void setDurabilityPolicy(const DurabilityPolicy &policy) override {
+        durability = policy;
+        hasDurability = true;
+        if (current) {
+            current->setDurabilityPolicy(policy);
+        }
+    }
+
+    // Закрытые сегменты сохранены на диск полностью
+    qint64 lastDurableTimestamp() const override {
+        const qint64 currentDurable = current ? current->lastDurableTimestamp() : std::numeric_limits<qint64>::min();
+        return qMax(closedDurableNs, currentDurable);
+    }
+
+    void syncIfDue() override {
+        if (current) {
+            current->syncIfDue();
+        }
+    }
+
+    int fileCount() const override {
+        return segments.size();
+    }
+
+    std::unique_ptr<ISensorDataCursor> selectSensorDataCursor(const QDateTime &start, const QDateTime &end,
+                                                              int batchSize = DEFAULT_BATCH_SIZE) override {
+        return openCursor(SensorDataBatch::toNanos(start), SensorDataBatch::toNanos(end), batchSize);
+    }
+
+    std::unique_ptr<ISensorDataCursor> selectAllSensorDataCursor(int batchSize = DEFAULT_BATCH_SIZE) override {
+        return openCursor(std::numeric_limits<qint64>::min(), std::numeric_limits<qint64>::max(), batchSize);
+    }
+
+    std::unique_ptr<ISensorDataCursor> openCursor(qint64 startNs, qint64 endNs, int batchSize = DEFAULT_BATCH_SIZE) {
+        std::vector<Cursor::Source> sources;
+        for (const SessionSegment &segment : segments) {
+            if (!segment.overlaps(startNs, endNs)) {
+                continue;
+            }
+            const bool live = current && &segment == &segments.last();
+            sources.push_back({segmentPath(segment), live ? current.get() : nullptr});
+        }
+        return std::unique_ptr<ISensorDataCursor>(new Cursor(std::move(sources), openSegment, startNs, endNs, batchSize));
+    }
+
+    // Слежение за сессией: сегменты читаются по порядку, новые берутся из манифеста
+    std::unique_ptr<ISensorDataCursor> selectFollowCursor(int batchSize = DEFAULT_BATCH_SIZE) override {
+        return std::unique_ptr<ISensorDataCursor>(new FollowCursor(manifestPath, openSegment, batchSize));
+    }
+
+    const QVector<SessionSegment> &getSegments() const {
+        return segments;
+    }
+
+    QString segmentPath(const SessionSegment &segment) const {
+        return QDir(segmentDirectory(manifestPath)).filePath(segment.fileName);
+    }
+
+    // Границы, число строк и группы каналов по манифесту, без чтения сегментов.
+    // Возвращает false, если есть незакрытые сегменты или в манифесте нет набора каналов
+    // и манифесту верить нельзя.
+    bool summary(qint64 &minTimestampNs, qint64 &maxTimestampNs, qint64 &rowCount, int &channelMask) const {
+        if (channels < 0) {
+            return false;
+        }
+        channelMask = channels;
+        minTimestampNs = std::numeric_limits<qint64>::max();
+        maxTimestampNs = std::numeric_limits<qint64>::min();
+        rowCount = 0;
+        for (const SessionSegment &segment : segments) {
+            if (segment.open) {
+                return false;
+            }
+            if (segment.rowCount > 0) {
+                minTimestampNs = qMin(minTimestampNs, segment.startNs);
+                maxTimestampNs = qMax(maxTimestampNs, segment.endNs);
+                rowCount += segment.rowCount;
+            }
+        }
+        return true;
+    }
+
+    static QString segmentDirectory(const QString &manifestPath) {
+        const QFileInfo info(manifestPath);
+        return info.absoluteDir().filePath(info.completeBaseName());
+    }
+
+    // channels - группы каналов сегментов, -1 для манифестов, записанных без них
+    static bool readManifest(const QString &manifestPath, QVector<SessionSegment> &segments, int *channels = nullptr) {
+        QFile file(manifestPath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+
+        const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+        if (root.value("version").toInt() != MANIFEST_VERSION) {
+            return false;
+        }
+
+        if (channels) {
+            *channels = root.value("channels").toInt(-1);
+        }
+        segments.clear();
+        for (const QJsonValue &value : root.value("segments").toArray()) {
+            const QJsonObject object = value.toObject();
+            SessionSegment segment;
+            segment.fileName = object.value("file").toString();
+            segment.startNs = object.value("start").toString().toLongLong();
+            segment.endNs = object.value("end").toString().toLongLong();
+            segment.rowCount = object.value("rows").toString().toLongLong();
+            segment.open = object.value("open").toBool();
+            segments.append(segment);
+        }
+        return true;
+    }
+
+private:
+    // Сегменты читаются по очереди, в каждый момент открыт только один
+    class Cursor : public ISensorDataCursor {
+    public:
+        struct Source {
+            QString path;
+            ISensorDataDAO *live; // сегмент, который пишется сейчас; иначе открывается фабрикой
+        };
+
+        Cursor(std::vector<Source> sources, SegmentFactory openSegment, qint64 startNs, qint64 endNs, int batchSize)
+            : sources_(std::move(sources)), openSegment_(std::move(openSegment)),
+              startNs_(startNs), endNs_(endNs), batchSize_(batchSize) {}
+
+        bool next(SensorDataBatch &batch) override {
+            while (true) {
+                if (!cursor_ && !openNextSource()) {
+                    batch.clear();
+                    return false;
+                }
+                if (cursor_->next(batch)) {
+                    return true;
+                }
+                cursor_.reset();
+                dao_.reset();
+            }
+        }
+
+    private:
+        bool openNextSource() {
+            while (next_ < sources_.size()) {
+                const Source &source = sources_[next_++];
+                ISensorDataDAO *dao = source.live;
+                if (dao == nullptr) {
+                    try {
+                        dao_.reset(openSegment_(source.path));
+                    } catch (const std::exception &e) {
+                        qDebug() << "Failed to open session segment:" << source.path << e.what();
+                        continue;
+                    }
+                    dao = dao_.get();
+                }
+
+                const bool all = startNs_ == std::numeric_limits<qint64>::min()
+                                 && endNs_ == std::numeric_limits<qint64>::max();
+                cursor_ = all ? dao->selectAllSensorDataCursor(batchSize_)
+                              : dao->selectSensorDataCursor(SensorDataBatch::fromNanos(startNs_),
+                                                            SensorDataBatch::fromNanos(endNs_), batchSize_);
+                if (cursor_) {
+                    return true;
+                }
+                dao_.reset();
+            }
+            return false;
+        }
+
+        std::vector<Source> sources_;
+        SegmentFactory openSegment_;
+        qint64 startNs_;
+        qint64 endNs_;
+        int batchSize_;
+        size_t next_ = 0;
+        std::unique_ptr<ISensorDataDAO> dao_;
+        std::unique_ptr<ISensorDataCursor> cursor_;
+    };
+
+    // Манифест перечитывается, только когда текущий сегмент дочитан до конца.
+    // Сегмент закрывается до записи манифеста, поэтому если в манифесте уже есть
+    // следующий сегмент, текущий дописан полностью и после дочитывания его можно оставить.
+    class FollowCursor : public ISensorDataCursor {
+    public:
+        FollowCursor(const QString &manifestPath, SegmentFactory openSegment, int batchSize)
+            : manifestPath_(manifestPath), openSegment_(std::move(openSegment)), batchSize_(batchSize) {}
+
+        bool next(SensorDataBatch &batch) override {
+            batch.clear();
+            while (true) {
+                if (!cursor_ && !openCurrentSegment()) {
+                    return false;
+                }
+                if (cursor_->next(batch)) {
+                    return true;
+                }
+                if (index_ + 1 < segments_.size()) {
+                    cursor_.reset();
+                    dao_.reset();
+                    ++index_;
+                    continue;
+                }
+                if (!readManifest(manifestPath_, segments_) || index_ + 1 >= segments_.size()) {
+                    return false;
+                }
+            }
+        }
+
+    private:
+        bool openCurrentSegment() {
+            if (index_ >= segments_.size()
+                && (!readManifest(manifestPath_, segments_) || index_ >= segments_.size())) {
+                return false;
+            }
+
+            const QString path = QDir(segmentDirectory(manifestPath_)).filePath(segments_[index_].fileName);
+            try {
+                dao_.reset(openSegment_(path));
+            } catch (const std::exception &e) {
+                qDebug() << "Failed to open session segment:" << path << e.what();
+                return false;
+            }
+            cursor_ = dao_->selectFollowCursor(batchSize_);
+            if (!cursor_) {
+                dao_.reset();
+                return false;
+            }
+            return true;
+        }
+
+        QString manifestPath_;
+        SegmentFactory openSegment_;
+        int batchSize_;
+        QVector<SessionSegment> segments_;
+        int index_ = 0;
+        std::unique_ptr<ISensorDataDAO> dao_;
+        std::unique_ptr<ISensorDataCursor> cursor_;
+    };
+
+    bool shouldRotate(qint64 timestamp) {
+        const SessionSegment &segment = segments.last();
+        if (!current || segment.rowCount == 0 || !rotation.isEnabled()) {
+            return false;
+        }
+        if (rotation.maxDurationNs > 0 && timestamp - segment.startNs >= rotation.maxDurationNs) {
+            return true;
+        }
+        if (rotation.maxBytes > 0 && rowsSinceSizeCheck >= SIZE_CHECK_ROWS) {
+            rowsSinceSizeCheck = 0;
+            return QFileInfo(segmentPath(segment)).size() >= rotation.maxBytes;
+        }
+        return false;
+    }
+
+    // Деструктор DAO сбрасывает буферы и дожидается fsync
+    void closeCurrentSegment() {
+        current.reset();
+        SessionSegment &segment = segments.last();
+        segment.open = false;
+        if (segment.rowCount > 0) {
+            closedDurableNs = qMax(closedDurableNs, segment.endNs);
+        }
+    }
+
+    bool openNextSegment() {
+        SessionSegment segment;
+        segment.fileName = QString("%1.%2").arg(segments.size() + 1, 4, 10, QChar('0')).arg(segmentSuffix);
+        try {
+            current.reset(createSegment(segmentPath(segment)));
+        } catch (const std::exception &e) {
+            qDebug() << "Failed to create session segment:" << segment.fileName << e.what();
+            return false;
+        }
+        if (hasDurability) {
+            current->setDurabilityPolicy(durability);
+        }
+
+        segments.append(segment);
+        rowsSinceSizeCheck = 0;
+        return writeManifest();
+    }
+
+    // Манифест заменяется атомарно при каждом переходе и при закрытии сессии
+    bool writeManifest() const {
+        QJsonArray array;
+        for (const SessionSegment &segment : segments) {
+            QJsonObject object;
+            object.insert("file", segment.fileName);
+            object.insert("start", QString::number(segment.rowCount > 0 ? segment.startNs : 0));
+            object.insert("end", QString::number(segment.rowCount > 0 ? segment.endNs : 0));
+            object.insert("rows", QString::number(segment.rowCount));
+            object.insert("open", segment.open);
+            array.append(object);
+        }
+
+        QJsonObject root;
+        root.insert("version", MANIFEST_VERSION);
+        if (channels >= 0) {
+            root.insert("channels", channels);
+        }
+        root.insert("segments", array);
+
+        QSaveFile file(manifestPath);
+        if (!file.open(QIODevice::WriteOnly)) {
+            qDebug() << "Failed to write session manifest:" << file.errorString();
+            return false;
+        }
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+        return file.commit();
+    }
+
+    QString manifestPath;
+    SegmentFactory openSegment;
+    SegmentFactory createSegment;
+    QString segmentSuffix;
+    RotationPolicy rotation;
+    DurabilityPolicy durability;
+    bool hasDurability = false;
+    int channels = -1;  // группы каналов сегментов; -1 - неизвестны
+
+    QVector<SessionSegment> segments;
+    std::unique_ptr<ISensorDataDAO> current;
+    int rowsSinceSizeCheck = 0;
+    qint64 closedDurableNs = std::numeric_limits<qint64>::min();
+};
+
+#endif // SESSIONSENSORDATADAO_H
@@ -0,0 +1,501 @@
+// Имитатор ИНС на псевдотерминале для нагрузочной проверки приема без устройства.
+// Открывает pty и печатает путь к нему; в приложении этот путь вводится как имя порта.
+// Понимает команды GetData, Stop и ReconfigureUart и передает кадры SensorData
+// с растущим счетчиком dataSendCount. Частота не ограничена возможностями UART:
+// --rate 0 передает кадры без пауз, насколько успевает приемник.
+//
+// Использование: inssimulator [--rate 1000] [--noise 2] [--bit-error-rate 0] ...
+// Полный список параметров: inssimulator --help
+
+#include "comand/command.h"
+#include "comand/commandresponse.h"
+#include "comand/EmtyData.h"
+#include "comand/crc8.h"
+#include "comand/uartsettings.h"
+#include "channelschema.h"
+#include "monotonicclock.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <random>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+std::atomic<bool> stopRequested(false);
+
+void onSignal(int)
+{
+    stopRequested = true;
+}
+
+// termios2 для чтения скорости, выставленной приложением на своей стороне pty
+#ifndef BOTHER
+#define BOTHER 0010000
+#endif
+
+struct KernelTermios2
+{
+    tcflag_t c_iflag;
+    tcflag_t c_oflag;
+    tcflag_t c_cflag;
+    tcflag_t c_lflag;
+    cc_t c_line;
+    cc_t c_cc[19];
+    speed_t c_ispeed;
+    speed_t c_ospeed;
+};
+
+uint8_t crc8(const QByteArray &data)
+{
+    return ::crc8(data.constData(), data.size());
+}
+
+struct SimulatorOptions
+{
+    double rateHz = 1000;          // 0 - без пауз
+    double noise = 2;              // СКО шума датчиков, единицы АЦП
+    double bitErrorRate = 0;       // вероятность инвертировать бит в байте
+    double dropRate = 0;           // вероятность потерять байт
+    double burstRate = 0;          // вероятность пачки мусора на кадр
+    int burstBytes = 16;
+    double duplicateRate = 0;      // вероятность повторить кадр с тем же счетчиком
+    double skipRate = 0;           // вероятность не передать кадр (разрыв счетчика)
+    qint32 baudRate = 115200;      // начальная скорость устройства
+    qint32 maxCleanBaud = 0;       // выше этой скорости связь с ошибками, 0 - без ограничения
+    double overspeedBitErrorRate = 0.01;
+    bool enforceBaud = false;      // ограничить поток скоростью UART (10 бит на байт)
+    quint32 seed = 1;
+    QString link;                  // символическая ссылка на pty
+};
+
+struct SimulatorStats
+{
+    qint64 frames = 0;
+    qint64 bytes = 0;
+    qint64 backpressureFrames = 0; // не поместились в буфер pty
+    qint64 commands = 0;
+    qint64 badCommands = 0;
+};
+
+class InsSimulator
+{
+public:
+    // Неотправленный хвост, после которого новые кадры отбрасываются
+    static constexpr int MAX_PENDING_BYTES = 1024 * 1024;
+    // Кадров за один проход цикла: ограничивает задержку разбора команд
+    static constexpr int MAX_FRAMES_PER_PASS = 4096;
+    // Отставание расписания, после которого оно сдвигается к текущему времени
+    static constexpr qint64 MAX_LAG_NS = 1000000000;
+
+    explicit InsSimulator(const SimulatorOptions &options)
+        : options_(options), random_(options.seed), deviceBaudRate_(options.baudRate) {}
+
+    ~InsSimulator() {
+        if (!options_.link.isEmpty()) {
+            QFile::remove(options_.link);
+        }
+        if (slaveFd_ >= 0) {
+            ::close(slaveFd_);
+        }
+        if (masterFd_ >= 0) {
+            ::close(masterFd_);
+        }
+    }
+
+    bool open() {
+        masterFd_ = ::posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (masterFd_ < 0 || ::grantpt(masterFd_) != 0 || ::unlockpt(masterFd_) != 0) {
+            err_ << "Не удалось создать pty: " << std::strerror(errno) << Qt::endl;
+            return false;
+        }
+        slavePath_ = QString::fromLocal8Bit(::ptsname(masterFd_));
+
+        // Своя копия второй стороны держит pty открытым между подключениями приложения,
+        // иначе master получает POLLHUP. Без эха и построчной обработки, как у UART.
+        slaveFd_ = ::open(slavePath_.toLocal8Bit().constData(), O_RDWR | O_NOCTTY | O_CLOEXEC);
+        if (slaveFd_ < 0) {
+            err_ << "Не удалось открыть " << slavePath_ << ": " << std::strerror(errno) << Qt::endl;
+            return false;
+        }
+        termios tio;
+        ::tcgetattr(slaveFd_, &tio);
+        ::cfmakeraw(&tio);
+        ::tcsetattr(slaveFd_, TCSANOW, &tio);
+        // Начальная скорость pty совпадает со скоростью устройства
+        KernelTermios2 tio2;
+        if (::ioctl(slaveFd_, _IOR('T', 0x2A, KernelTermios2), &tio2) == 0) {
+            tio2.c_cflag = (tio2.c_cflag & ~(CBAUD | (CBAUD << 16))) | BOTHER | (BOTHER << 16);
+            tio2.c_ispeed = static_cast<speed_t>(deviceBaudRate_);
+            tio2.c_ospeed = static_cast<speed_t>(deviceBaudRate_);
+            ::ioctl(slaveFd_, _IOW('T', 0x2B, KernelTermios2), &tio2);
+        }
+
+        if (!options_.link.isEmpty()) {
+            QFile::remove(options_.link);
+            if (!QFile::link(slavePath_, options_.link)) {
+                err_ << "Не удалось создать ссылку " << options_.link << Qt::endl;
+            }
+        }
+
+        out_ << "Порт имитатора: " << (options_.link.isEmpty() ? slavePath_ : options_.link) << Qt::endl;
+        return true;
+    }
+
+    int run() {
+        const qint64 periodNs = options_.rateHz > 0 ? static_cast<qint64>(1e9 / options_.rateHz) : 0;
+        qint64 reportNs = MonotonicClock::nowNs() + 1000000000;
+        qint64 lastBudgetNs = MonotonicClock::nowNs();
+        double byteBudget = 0;
+        SimulatorStats reported;
+
+        while (!stopRequested) {
+            const qint64 now = MonotonicClock::nowNs();
+
+            qint64 waitNs = 100000000;
+            if (streaming_ && periodNs > 0) {
+                waitNs = std::max<qint64>(0, nextFrameNs_ - now);
+            } else if (streaming_) {
+                waitNs = pending_.size() > MAX_PENDING_BYTES ? 1000000 : 0;
+            }
+            if (!pending_.isEmpty()) {
+                waitNs = std::min<qint64>(waitNs, 1000000);
+            }
+            // При ограничении скоростью UART запись идет по бюджету, а не по готовности pty
+            const bool waitWritable = !pending_.isEmpty() && !options_.enforceBaud;
+            pollfd pfd {masterFd_, static_cast<short>(POLLIN | (waitWritable ? POLLOUT : 0)), 0};
+            timespec timeout {static_cast<time_t>(waitNs / 1000000000), static_cast<long>(waitNs % 1000000000)};
+            if (::ppoll(&pfd, 1, &timeout, nullptr) > 0 && (pfd.revents & POLLIN)) {
+                readCommands();
+            }
+
+            if (streaming_) {
+                generateDueFrames(periodNs);
+            }
+
+            if (options_.enforceBaud) {
+                const qint64 budgetNow = MonotonicClock::nowNs();
+                byteBudget = std::min<double>(byteBudget + (budgetNow - lastBudgetNs) * 1e-9 * deviceBaudRate_ / 10,
+                                              deviceBaudRate_ / 10.0);
+                lastBudgetNs = budgetNow;
+                flush(static_cast<qint64>(byteBudget));
+                byteBudget -= lastWritten_;
+            } else {
+                flush(pending_.size());
+            }
+
+            if (MonotonicClock::nowNs() >= reportNs) {
+                report(reported);
+                reported = stats_;
+                reportNs += 1000000000;
+            }
+        }
+
+        out_ << "Всего кадров " << stats_.frames << ", байт " << stats_.bytes
+             << ", не передано из-за переполнения " << stats_.backpressureFrames << Qt::endl;
+        return 0;
+    }
+
+private:
+    void readCommands() {
+        char buffer[256];
+        const ssize_t count = ::read(masterFd_, buffer, sizeof(buffer));
+        if (count <= 0) {
+            return;
+        }
+        // На чужой скорости устройство получает мусор
+        if (hostBaudRate() != deviceBaudRate_) {
+            return;
+        }
+        input_.append(buffer, count);
+
+        while (input_.size() >= 4) {
+            if (static_cast<uint8_t>(input_.at(0)) != Command<EmptyData>::START_BYTE) {
+                input_.remove(0, 1);
+                continue;
+            }
+            const int size = 3 + static_cast<uint8_t>(input_.at(2)) + 1;
+            if (input_.size() < size) {
+                break;
+            }
+            const QByteArray message = input_.left(size);
+            input_.remove(0, size);
+            if (crc8(message.left(size - 1)) != static_cast<uint8_t>(message.at(size - 1))) {
+                ++stats_.badCommands;
+                err_ << "Команда с неверным CRC" << Qt::endl;
+                continue;
+            }
+            ++stats_.commands;
+            handleCommand(static_cast<uint8_t>(message.at(1)), message.mid(3, size - 4));
+        }
+    }
+
+    // GetData и Stop не подтверждаются: приложение разбирает все ответы в потоке как кадры данных
+    void handleCommand(uint8_t type, const QByteArray &body) {
+        switch (type) {
+        case GetData:
+            if (!streaming_) {
+                streaming_ = true;
+                nextFrameNs_ = MonotonicClock::nowNs();
+            }
+            err_ << "GetData" << Qt::endl;
+            break;
+        case Stop:
+            streaming_ = false;
+            err_ << "Stop" << Qt::endl;
+            break;
+        case ReconfigureUart: {
+            const qint32 baudRate = body.size() == 5 ? UartSettings::baudRateFromCode(static_cast<uint8_t>(body.at(0))) : 0;
+            // Подтверждение уходит на прежней скорости, затем устройство переключается
+            sendResponse(baudRate > 0 ? CommandResponse<EmptyData>::Accepted : CommandResponse<EmptyData>::Rejected);
+            flush(pending_.size());
+            if (baudRate > 0) {
+                deviceBaudRate_ = baudRate;
+            }
+            err_ << "ReconfigureUart " << (baudRate > 0 ? QString::number(baudRate) : QString("отклонена")) << Qt::endl;
+            break;
+        }
+        default:
+            ++stats_.badCommands;
+            err_ << "Неизвестная команда " << type << Qt::endl;
+            break;
+        }
+    }
+
+    void sendResponse(uint8_t type) {
+        QByteArray message;
+        message.append(static_cast<char>(Command<EmptyData>::START_BYTE));
+        message.append(static_cast<char>(type));
+        message.append(static_cast<char>(0));
+        message.append(static_cast<char>(crc8(message)));
+        pending_.append(message);
+    }
+
+    void generateDueFrames(qint64 periodNs) {
+        const qint64 now = MonotonicClock::nowNs();
+        if (periodNs > 0 && now - nextFrameNs_ > MAX_LAG_NS) {
+            // Приемник или планировщик стояли: пропущенные кадры не догоняются
+            const qint64 missed = (now - nextFrameNs_) / periodNs;
+            counter_ = static_cast<uint8_t>(counter_ + missed);
+            nextFrameNs_ += missed * periodNs;
+        }
+
+        const bool overspeed = options_.maxCleanBaud > 0 && deviceBaudRate_ > options_.maxCleanBaud;
+        const bool mismatch = hostBaudRate() != deviceBaudRate_;
+        for (int i = 0; i < MAX_FRAMES_PER_PASS && (periodNs == 0 || nextFrameNs_ <= now); ++i) {
+            // Без пауз кадры создаются, только пока приемник успевает их забирать
+            if (periodNs == 0 && pending_.size() > MAX_PENDING_BYTES) {
+                break;
+            }
+            nextFrameNs_ += periodNs;
+            const QByteArray frame = makeFrame(counter_++);
+            ++stats_.frames;
+
+            if (chance(options_.skipRate)) {
+                continue;
+            }
+            if (pending_.size() > MAX_PENDING_BYTES) {
+                ++stats_.backpressureFrames;
+                continue;
+            }
+            const int copies = chance(options_.duplicateRate) ? 2 : 1;
+            for (int copy = 0; copy < copies; ++copy) {
+                appendWithFaults(frame, overspeed, mismatch);
+            }
+        }
+    }
+
+    // Раскладку и масштаб каналов задает ChannelSchema, как в кадрах воспроизведения
+    QByteArray makeFrame(uint8_t counter) {
+        const double t = sampleIndex_++ / std::max(1.0, options_.rateHz > 0 ? options_.rateHz : 1000.0);
+
+        QByteArray frame;
+        frame.reserve(3 + ChannelSchema::MEASURES_BYTES + 2);
+        frame.append(static_cast<char>(Command<EmptyData>::START_BYTE));
+        frame.append(static_cast<char>(CommandResponse<EmptyData>::Accepted));
+        frame.append(static_cast<char>(ChannelSchema::MEASURES_BYTES + 1));
+        frame.resize(3 + ChannelSchema::MEASURES_BYTES);
+        char *body = frame.data() + 3;
+        ChannelSchema::forEachChannel([&](auto channel) {
+            constexpr int index = decltype(channel)::value;
+            ChannelSchema::encode<index>(sample(ChannelSchema::CHANNELS[index], t), body);
+        });
+        frame.append(static_cast<char>(counter));
+        frame.append(static_cast<char>(crc8(frame)));
+        return frame;
+    }
+
+    // Значение канала в физических единицах; шум --noise задан в единицах АЦП и переводится масштабом канала
+    double sample(const ChannelSchema::Channel &channel, double t) {
+        switch (channel.group) {
+        case ChannelSchema::ENV_GROUP: {
+            const double env[3] = {
+                22.0 + 0.5 * std::sin(t * 0.05) + gaussian(0.01),
+                40.0 + 2.0 * std::cos(t * 0.02) + gaussian(0.05),
+                101.3 + 0.1 * std::sin(t * 0.01) + gaussian(0.005),
+            };
+            return env[channel.axis];
+        }
+        default: {
+            // Гироскоп в град/c (предел кадра ±32.767), акселерометр в mg, магнитометр в мГс
+            static constexpr double AMPLITUDE[ChannelSchema::GROUP_COUNT] = {0, 20, 2000, 300};
+            static constexpr double OFFSET[ChannelSchema::GROUP_COUNT] = {0, 0, 0, 150};
+            const int sensor = channel.group - ChannelSchema::GYRO_GROUP;
+            return OFFSET[channel.group]
+                   + AMPLITUDE[channel.group] * std::sin(2 * M_PI * (0.5 + channel.axis * 0.3) * t + sensor)
+                   + gaussian(options_.noise) * channel.scale;
+        }
+        }
+    }
+
+    void appendWithFaults(const QByteArray &frame, bool overspeed, bool mismatch) {
+        if (chance(options_.burstRate)) {
+            for (int i = 0; i < options_.burstBytes; ++i) {
+                pending_.append(static_cast<char>(random_()));
+            }
+        }
+        const double bitErrorRate = overspeed ? std::max(options_.bitErrorRate, options_.overspeedBitErrorRate)
+                                              : options_.bitErrorRate;
+        for (char byte : frame) {
+            if (mismatch) {
+                // Скорости сторон разошлись: приемник видит только ошибки кадрирования
+                pending_.append(static_cast<char>(random_()));
+                continue;
+            }
+            if (chance(options_.dropRate)) {
+                continue;
+            }
+            if (chance(bitErrorRate)) {
+                byte ^= static_cast<char>(1 << (random_() % 8));
+            }
+            pending_.append(byte);
+        }
+    }
+
+    void flush(qint64 maxBytes) {
+        lastWritten_ = 0;
+        const qint64 bytes = std::min<qint64>(maxBytes, pending_.size());
+        if (bytes <= 0) {
+            return;
+        }
+        const ssize_t written = ::write(masterFd_, pending_.constData(), bytes);
+        if (written > 0) {
+            pending_.remove(0, written);
+            stats_.bytes += written;
+            lastWritten_ = written;
+        }
+    }
+
+    // Скорость, которую приложение выставило на своей стороне pty
+    qint32 hostBaudRate() const {
+        KernelTermios2 tio;
+        if (::ioctl(masterFd_, _IOR('T', 0x2A, KernelTermios2), &tio) != 0) {
+            return deviceBaudRate_;
+        }
+        return static_cast<qint32>(tio.c_ospeed);
+    }
+
+    bool chance(double probability) {
+        return probability > 0 && uniform_(random_) < probability;
+    }
+
+    double gaussian(double sigma) {
+        return sigma > 0 ? std::normal_distribution<double>(0, sigma)(random_) : 0;
+    }
+
+    void report(const SimulatorStats &previous) {
+        out_ << "кадров/с " << stats_.frames - previous.frames
+             << ", байт/с " << stats_.bytes - previous.bytes
+             << ", в очереди " << pending_.size()
+             << ", переполнение " << stats_.backpressureFrames - previous.backpressureFrames
+             << ", скорость устройства " << deviceBaudRate_
+             << (streaming_ ? "" : " (остановлен)") << Qt::endl;
+    }
+
+    SimulatorOptions options_;
+    std::mt19937 random_;
+    std::uniform_real_distribution<double> uniform_ {0.0, 1.0};
+    QTextStream out_ {stdout};
+    QTextStream err_ {stderr};
+
+    int masterFd_ = -1;
+    int slaveFd_ = -1;
+    QString slavePath_;
+
+    QByteArray input_;
+    QByteArray pending_;
+    qint64 lastWritten_ = 0;
+    bool streaming_ = false;
+    qint64 nextFrameNs_ = 0;
+    qint64 sampleIndex_ = 0;
+    uint8_t counter_ = 0;
+    qint32 deviceBaudRate_;
+    SimulatorStats stats_;
+};
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("inssimulator");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Имитатор ИНС на псевдотерминале");
+    parser.addHelpOption();
+    const QList<QCommandLineOption> options = {
+        {"rate", "Частота кадров, Гц; 0 - без пауз.", "hz", "1000"},
+        {"noise", "СКО шума датчиков, единицы АЦП.", "sigma", "2"},
+        {"bit-error-rate", "Вероятность ошибки бита на байт.", "p", "0"},
+        {"drop-rate", "Вероятность потери байта.", "p", "0"},
+        {"burst-rate", "Вероятность пачки мусора перед кадром.", "p", "0"},
+        {"burst-bytes", "Длина пачки мусора, байт.", "n", "16"},
+        {"duplicate-rate", "Вероятность повтора кадра.", "p", "0"},
+        {"skip-rate", "Вероятность пропуска кадра.", "p", "0"},
+        {"baud", "Начальная скорость устройства.", "baud", "115200"},
+        {"max-clean-baud", "Скорость, выше которой связь идет с ошибками; 0 - без ограничения.", "baud", "0"},
+        {"overspeed-bit-error-rate", "Вероятность ошибки бита выше max-clean-baud.", "p", "0.01"},
+        {"enforce-baud", "Ограничить поток скоростью UART."},
+        {"seed", "Начальное значение генератора случайных чисел.", "n", "1"},
+        {"link", "Символическая ссылка на pty, например /tmp/ttyINS.", "path"},
+    };
+    parser.addOptions(options);
+    parser.process(app);
+
+    SimulatorOptions simulatorOptions;
+    simulatorOptions.rateHz = parser.value("rate").toDouble();
+    simulatorOptions.noise = parser.value("noise").toDouble();
+    simulatorOptions.bitErrorRate = parser.value("bit-error-rate").toDouble();
+    simulatorOptions.dropRate = parser.value("drop-rate").toDouble();
+    simulatorOptions.burstRate = parser.value("burst-rate").toDouble();
+    simulatorOptions.burstBytes = parser.value("burst-bytes").toInt();
+    simulatorOptions.duplicateRate = parser.value("duplicate-rate").toDouble();
+    simulatorOptions.skipRate = parser.value("skip-rate").toDouble();
+    simulatorOptions.baudRate = parser.value("baud").toInt();
+    simulatorOptions.maxCleanBaud = parser.value("max-clean-baud").toInt();
+    simulatorOptions.overspeedBitErrorRate = parser.value("overspeed-bit-error-rate").toDouble();
+    simulatorOptions.enforceBaud = parser.isSet("enforce-baud");
+    simulatorOptions.seed = parser.value("seed").toUInt();
+    simulatorOptions.link = parser.value("link");
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    InsSimulator simulator(simulatorOptions);
+    if (!simulator.open()) {
+        return 1;
+    }
+    return simulator.run();
+}
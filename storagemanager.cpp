@@ -1,6 +1,12 @@
 #include "storagemanager.h"
+#include "SensorDataDAO.h"
+#include "binarysensordatadao.h"
+#include "arrowsensordatadao.h"
+#include "sessionsensordatadao.h"
+#include "tracer.h"
 
 #include <qfiledialog.h>
+#include <limits>
 
 FileStorageManager::FileStorageManager(
     std::shared_ptr<DynamicSetting<bool>> isEnvMeasuresEnabled,
@@ -10,7 +16,13 @@ FileStorageManager::FileStorageManager(
     std::shared_ptr<DynamicSetting<bool>> isAcceleroMeasuresEnabled,
     std::shared_ptr<DynamicSetting<int>> acceleroMeasuresPrecision,
     std::shared_ptr<DynamicSetting<bool>> isMagnetoMeasuresEnabled,
-    std::shared_ptr<DynamicSetting<int>> magnetoMeasuresPrecision
+    std::shared_ptr<DynamicSetting<int>> magnetoMeasuresPrecision,
+    std::shared_ptr<DynamicSetting<bool>> isBinaryFormatEnabled,
+    std::shared_ptr<DynamicSetting<int>> syncIntervalMs,
+    std::shared_ptr<DynamicSetting<int>> syncMegabytes,
+    std::shared_ptr<DynamicSetting<int>> segmentMegabytes,
+    std::shared_ptr<DynamicSetting<int>> segmentMinutes,
+    std::shared_ptr<DynamicSetting<bool>> isRecordingEnabled
 ) {
     this->isEnvMeasuresEnabled = isEnvMeasuresEnabled;
     this->envMeasuresPrecision = envMeasuresPrecision;
@@ -20,91 +32,367 @@ FileStorageManager::FileStorageManager(
     this->acceleroMeasuresPrecision = acceleroMeasuresPrecision;
     this->isMagnetoMeasuresEnabled = isMagnetoMeasuresEnabled;
     this->magnetoMeasuresPrecision = magnetoMeasuresPrecision;
-    cachedData.clear();
+    this->isBinaryFormatEnabled = isBinaryFormatEnabled;
+    this->syncIntervalMs = syncIntervalMs;
+    this->syncMegabytes = syncMegabytes;
+    this->segmentMegabytes = segmentMegabytes;
+    this->segmentMinutes = segmentMinutes;
+    this->isRecordingEnabled_ = isRecordingEnabled;
 }
 
 FileStorageManager::~FileStorageManager() {
-    freeFile(csvDaoToRead);
-    freeFile(csvDaoToSave);
+    followCursor.reset();
+    freeFile(daoToRead);
+    stopRecording();
 }
 
-void FileStorageManager::loadFile(QWidget *widget) {
+void FileStorageManager::loadFile(QWidget *widget, bool follow) {
 
-    readFilePath = QFileDialog::getOpenFileName(widget, "Выберите CSV файл", QDir::currentPath(), "CSV Files (*.csv)");
-    if (readFilePath.isEmpty()) {
+    const QString filePath = QFileDialog::getOpenFileName(widget, "Выберите файл записи", QDir::currentPath(),
+                                                          "Записи (*.csv *.insr *.db *.arrow *.feather *.session);;CSV Files (*.csv);;"
+                                                          "Сжатые записи (*.insr);;SQLite (*.db);;Arrow IPC (*.arrow *.feather);;"
+                                                          "Сегментированные записи (*.session)");
+    if (filePath.isEmpty()) {
         qDebug() << "File wasn't chosen";
+        readFilePath.clear();
         return;
     }
 
-    freeFile(csvDaoToRead);
+    loadFile(filePath, follow);
+}
+
+void FileStorageManager::loadFile(const QString &filePath, bool follow) {
+    TraceSpan span("load file");
+    readFilePath = filePath;
+
+    // Курсор слежения может ссылаться на DAO, поэтому освобождается первым
+    followCursor.reset();
+    freeFile(daoToRead);
+    daoToRead = nullptr;
 
-    this->csvDaoToRead = new CsvSensorDataDAO(readFilePath);
+    // Файл, в который сейчас идет запись, не трогаем: его хвост еще дописывается
+    recoveryReport = RecoveryReport();
+    if (!(isRecording() && readFilePath == saveFilePath) && !follow) {
+        recoveryReport = recoverRecording(readFilePath);
+    }
+
+    this->daoToRead = createReadDao(readFilePath);
 
+    if (follow) {
+        followCursor = daoToRead->selectFollowCursor();
+        if (!followCursor) {
+            qDebug() << "Format does not support following:" << readFilePath;
+        }
+    }
+
+    // Для закрытой сессии границы и каналы известны из манифеста, сегменты не читаются
+    SessionSensorDataDAO *session = dynamic_cast<SessionSensorDataDAO*>(daoToRead);
+    if (!followCursor && session && session->summary(minTimestampNs, maxTimestampNs, rowCount, readChannels)) {
+        if (rowCount == 0) {
+            readChannels = 0;
+            minTimestampNs = 0;
+            maxTimestampNs = 0;
+        }
+        return;
+    }
 
-    cachedData = csvDaoToRead->selectAllSensorData();
+    scanReadFile();
 }
 
-QList<TimestampedSensorData> FileStorageManager::loadDataForPeriod(const QDateTime &start, const QDateTime &end) const {
-    QList<TimestampedSensorData> filteredData;
-    for (const auto &data : cachedData) {
-        if (data.getTimestamp() >= start && data.getTimestamp() <= end) {
-            filteredData.append(data);
+RecoveryReport FileStorageManager::recoverRecording(const QString &filePath) {
+    const QString suffix = QFileInfo(filePath).suffix();
+    if (suffix.compare("insr", Qt::CaseInsensitive) == 0) {
+        return BinarySensorDataDAO::recoverFile(filePath);
+    }
+    if (suffix.compare("csv", Qt::CaseInsensitive) == 0) {
+        return CsvSensorDataDAO::recoverFile(filePath);
+    }
+    if (suffix.compare(SessionSensorDataDAO::MANIFEST_SUFFIX, Qt::CaseInsensitive) == 0) {
+        // Прерванная сессия: незакрытым может остаться только последний сегмент
+        RecoveryReport report;
+        QVector<SessionSegment> segments;
+        if (!SessionSensorDataDAO::readManifest(filePath, segments)) {
+            return report;
+        }
+        const QDir directory(SessionSensorDataDAO::segmentDirectory(filePath));
+        for (const SessionSegment &segment : segments) {
+            if (segment.rowCount > 0) {
+                report.lastTimestampNs = qMax(report.lastTimestampNs, segment.endNs);
+            }
+            if (!segment.open) {
+                continue;
+            }
+            const RecoveryReport segmentReport = recoverRecording(directory.filePath(segment.fileName));
+            report.validBytes += segmentReport.validBytes;
+            report.truncatedBytes += segmentReport.truncatedBytes;
+            report.lastTimestampNs = qMax(report.lastTimestampNs, segmentReport.lastTimestampNs);
         }
+        return report;
+    }
+    return RecoveryReport();
+}
+
+QString FileStorageManager::experimentsDirectory() {
+    return QDir::currentPath() + "/experiments";
+}
+
+ISensorDataDAO *FileStorageManager::createReadDao(const QString &filePath) {
+    const QString suffix = QFileInfo(filePath).suffix();
+    if (suffix.compare("db", Qt::CaseInsensitive) == 0) {
+        return new SensorDataDAO(filePath);
+    }
+    if (suffix.compare("insr", Qt::CaseInsensitive) == 0) {
+        return new BinarySensorDataDAO(filePath, BinarySensorDataDAO::ReadOnly());
+    }
+    if (suffix.compare("arrow", Qt::CaseInsensitive) == 0 || suffix.compare("feather", Qt::CaseInsensitive) == 0) {
+        return new ArrowSensorDataDAO(filePath);
+    }
+    if (suffix.compare(SessionSensorDataDAO::MANIFEST_SUFFIX, Qt::CaseInsensitive) == 0) {
+        return new SessionSensorDataDAO(filePath, &FileStorageManager::createReadDao);
     }
-    return filteredData;
+    return new CsvSensorDataDAO(filePath);
 }
 
+void FileStorageManager::scanReadFile() {
+    minTimestampNs = std::numeric_limits<qint64>::max();
+    maxTimestampNs = std::numeric_limits<qint64>::min();
+    rowCount = 0;
+    readChannels = 0;
 
-QList<TimestampedSensorData> FileStorageManager::loadAllData() const {
-    return cachedData;
+    // При слежении файл сканируется тем же курсором, который потом читает новые строки
+    std::unique_ptr<ISensorDataCursor> cursor;
+    ISensorDataCursor *source = followCursor.get();
+    if (source == nullptr) {
+        cursor = openCursor();
+        source = cursor.get();
+    }
+
+    SensorDataBatch batch;
+    while (source && source->next(batch)) {
+        accumulateBounds(batch);
+    }
+
+    if (rowCount == 0) {
+        minTimestampNs = 0;
+        maxTimestampNs = 0;
+    }
+}
+
+void FileStorageManager::accumulateBounds(const SensorDataBatch &batch) {
+    if (rowCount == 0) {
+        minTimestampNs = std::numeric_limits<qint64>::max();
+        maxTimestampNs = std::numeric_limits<qint64>::min();
+        readChannels = batch.channels;
+    }
+    readChannels &= batch.channels;
+    for (qint64 timestamp : batch.timestamps) {
+        minTimestampNs = std::min(minTimestampNs, timestamp);
+        maxTimestampNs = std::max(maxTimestampNs, timestamp);
+    }
+    rowCount += batch.size();
+}
+
+bool FileStorageManager::isFollowing() const {
+    return followCursor != nullptr;
 }
 
-void FileStorageManager::openFileToSave() {
-    qDebug() << "Starting saveToFile method...";
+void FileStorageManager::stopFollowing() {
+    followCursor.reset();
+}
 
-    // Define the directory for saving files
-    QString experimentsDir = QDir::currentPath() + "/experiments"; // Исправлено название папки
-    QDir dir(experimentsDir);
-    if (!dir.exists()) {
-        qDebug() << "Creating experiments directory...";
-        dir.mkpath(".");
+bool FileStorageManager::readAppended(SensorDataBatch &batch) {
+    if (!followCursor || !followCursor->next(batch)) {
+        return false;
     }
+    accumulateBounds(batch);
+    return true;
+}
 
-    QString fileName = QDateTime::currentDateTime().toString("yyyy-MM-dd_HH-mm-ss-zzz") + ".csv"; // Добавлены миллисекунды и улучшен формат
-    saveFilePath = experimentsDir + "/" + fileName;
-    qDebug() << "File path:" << saveFilePath;
+QStringList FileStorageManager::getFollowedPaths() const {
+    if (!followCursor) {
+        return {};
+    }
 
-    freeFile(csvDaoToSave);
+    const QString suffix = QFileInfo(readFilePath).suffix();
+    if (suffix.compare(SessionSensorDataDAO::MANIFEST_SUFFIX, Qt::CaseInsensitive) != 0) {
+        return {readFilePath};
+    }
 
-    this->csvDaoToSave = new CsvSensorDataDAO(
-        saveFilePath,
-        isEnvMeasuresEnabled->get(),
-        envMeasuresPrecision->get(),
-        isGyroMeasuresEnabled->get(),
-        gyroMeasuresPrecision->get(),
-        isAcceleroMeasuresEnabled->get(),
-        acceleroMeasuresPrecision->get(),
-        isMagnetoMeasuresEnabled->get(),
-        magnetoMeasuresPrecision->get());
+    // У сессии дописывается последний сегмент, а манифест меняется при переходе к новому
+    QStringList paths = {readFilePath};
+    const QStringList segments = QDir(SessionSensorDataDAO::segmentDirectory(readFilePath))
+                                     .entryList(QDir::Files, QDir::Name);
+    if (!segments.isEmpty()) {
+        paths.append(QDir(SessionSensorDataDAO::segmentDirectory(readFilePath)).filePath(segments.last()));
+    }
+    return paths;
 }
 
-void FileStorageManager::saveData(const TimestampedSensorData &data) {
-    if (csvDaoToSave == nullptr) {
-        return;
+std::unique_ptr<ISensorDataCursor> FileStorageManager::openCursor(const QDateTime &start, const QDateTime &end) const {
+    if (daoToRead == nullptr) {
+        return nullptr;
+    }
+    return daoToRead->selectSensorDataCursor(start, end);
+}
+
+std::unique_ptr<ISensorDataCursor> FileStorageManager::openCursor() const {
+    if (daoToRead == nullptr) {
+        return nullptr;
+    }
+    return daoToRead->selectAllSensorDataCursor();
+}
+
+QDateTime FileStorageManager::getMinTimestamp() const {
+    return SensorDataBatch::fromNanos(minTimestampNs);
+}
+
+QDateTime FileStorageManager::getMaxTimestamp() const {
+    return SensorDataBatch::fromNanos(maxTimestampNs);
+}
+
+qint64 FileStorageManager::getRowCount() const {
+    return rowCount;
+}
+
+int FileStorageManager::getChannels() const {
+    return readChannels;
+}
+
+int FileStorageManager::getMeasuresPrecision() const {
+    return envMeasuresPrecision->get();
+}
+
+bool FileStorageManager::startRecording() {
+    stopRecording();
+
+    QDir dir(experimentsDirectory());
+    if (!dir.exists() && !dir.mkpath(".")) {
+        qDebug() << "Failed to create experiments directory:" << dir.path();
+        return false;
+    }
+
+    const SaveFormat format = currentSaveFormat();
+    const QString suffix = format.binary ? "insr" : "csv";
+
+    RotationPolicy rotation;
+    if (segmentMegabytes) {
+        rotation.maxBytes = std::max(0, segmentMegabytes->get()) * qint64(1024 * 1024);
+    }
+    if (segmentMinutes) {
+        rotation.maxDurationNs = std::max(0, segmentMinutes->get()) * qint64(60) * 1000 * SensorDataBatch::NANOS_IN_MSEC;
+    }
+
+    // С ротацией сохраняется манифест сессии, сегменты пишутся в одноименный каталог
+    const QString fileName = QDateTime::currentDateTime().toString("yyyy-MM-dd_HH-mm-ss-zzz") + "."
+                             + (rotation.isEnabled() ? QString(SessionSensorDataDAO::MANIFEST_SUFFIX) : suffix);
+    saveFilePath = dir.filePath(fileName);
+
+    ISensorDataDAO *dao = nullptr;
+    try {
+        if (rotation.isEnabled()) {
+            dao = new SessionSensorDataDAO(
+                saveFilePath,
+                &FileStorageManager::createReadDao,
+                [format](const QString &segmentPath) { return createSaveDao(segmentPath, format); },
+                suffix,
+                format.channels(),
+                rotation);
+        } else {
+            dao = createSaveDao(saveFilePath, format);
+        }
+    } catch (const std::exception &e) {
+        qDebug() << "Failed to start recording:" << saveFilePath << e.what();
+        return false;
+    }
+
+    DurabilityPolicy policy;
+    if (syncIntervalMs) {
+        policy.intervalMs = std::max(0, syncIntervalMs->get());
     }
+    if (syncMegabytes) {
+        policy.bytes = std::max(0, syncMegabytes->get()) * qint64(1024 * 1024);
+    }
+    dao->setDurabilityPolicy(policy);
+
+    // Строки доходят до DAO не реже, чем требует интервал сброса
+    const int flushIntervalMs = policy.intervalMs > 0 ? std::min(policy.intervalMs, int(LiveRecorder::FLUSH_INTERVAL_MS))
+                                                      : LiveRecorder::FLUSH_INTERVAL_MS;
+    recorder.reset(new LiveRecorder(dao, flushIntervalMs));
+    qDebug() << "Recording to" << saveFilePath;
+    return true;
+}
+
+bool FileStorageManager::isRecordingEnabled() const {
+    return isRecordingEnabled_ && isRecordingEnabled_->get();
+}
+
+void FileStorageManager::record(qint64 timestampNs, const SensorData &data) {
+    if (recorder) {
+        recorder->append(timestampNs, data);
+    }
+}
+
+void FileStorageManager::stopRecording() {
+    recorder.reset();
+}
+
+bool FileStorageManager::isRecording() const {
+    return recorder != nullptr;
+}
+
+LiveRecorderStats FileStorageManager::getRecordingStats() const {
+    return recorder ? recorder->stats() : LiveRecorderStats();
+}
 
-    csvDaoToSave->insertSensorData(data);
+FileStorageManager::SaveFormat FileStorageManager::currentSaveFormat() const {
+    SaveFormat format;
+    format.binary = isBinaryFormatEnabled && isBinaryFormatEnabled->get();
+    format.enabled[ChannelSchema::ENV_GROUP] = isEnvMeasuresEnabled->get();
+    format.enabled[ChannelSchema::GYRO_GROUP] = isGyroMeasuresEnabled->get();
+    format.enabled[ChannelSchema::ACCELERO_GROUP] = isAcceleroMeasuresEnabled->get();
+    format.enabled[ChannelSchema::MAGNETO_GROUP] = isMagnetoMeasuresEnabled->get();
+    format.precision[ChannelSchema::ENV_GROUP] = envMeasuresPrecision->get();
+    format.precision[ChannelSchema::GYRO_GROUP] = gyroMeasuresPrecision->get();
+    format.precision[ChannelSchema::ACCELERO_GROUP] = acceleroMeasuresPrecision->get();
+    format.precision[ChannelSchema::MAGNETO_GROUP] = magnetoMeasuresPrecision->get();
+    return format;
+}
+
+ISensorDataDAO *FileStorageManager::createSaveDao(const QString &filePath, const SaveFormat &format) {
+    if (format.binary) {
+        // Сжатие без потерь, поэтому настройки точности к бинарному формату не применяются
+        return new BinarySensorDataDAO(filePath, format.channels());
+    }
+
+    return new CsvSensorDataDAO(
+        filePath,
+        format.enabled[ChannelSchema::ENV_GROUP],
+        format.precision[ChannelSchema::ENV_GROUP],
+        format.enabled[ChannelSchema::GYRO_GROUP],
+        format.precision[ChannelSchema::GYRO_GROUP],
+        format.enabled[ChannelSchema::ACCELERO_GROUP],
+        format.precision[ChannelSchema::ACCELERO_GROUP],
+        format.enabled[ChannelSchema::MAGNETO_GROUP],
+        format.precision[ChannelSchema::MAGNETO_GROUP]);
+}
+
+RecoveryReport FileStorageManager::getRecoveryReport() const {
+    return recoveryReport;
 }
 
 QString FileStorageManager::getReadFileName() const {
     return QFileInfo(readFilePath).fileName();
 }
 
+QString FileStorageManager::getReadFilePath() const {
+    return readFilePath;
+}
+
 QString FileStorageManager::getSaveFileName() const {
     return saveFilePath;
 }   
 
-void FileStorageManager::freeFile(CsvSensorDataDAO *dao) {
+void FileStorageManager::freeFile(ISensorDataDAO *dao) {
     if (dao) {
         delete dao;
         dao = nullptr;
@@ -4,9 +4,13 @@
 #include <QList>
 #include <QDateTime>
 #include <QString>
+#include <QStringList>
 #include <CsvSensorDataDAO.h>
+#include <memory>
 #include "extendedsensordata.h"
+#include "sensordatacursor.h"
 #include "DynamicSetting.h"
+#include "liverecorder.h"
 
 class FileStorageManager {
 
@@ -20,28 +24,102 @@ public:
         std::shared_ptr<DynamicSetting<bool>> isAcceleroMeasuresEnabled,
         std::shared_ptr<DynamicSetting<int>> acceleroMeasuresPrecision,
         std::shared_ptr<DynamicSetting<bool>> isMagnetoMeasuresEnabled,
-        std::shared_ptr<DynamicSetting<int>> magnetoMeasuresPrecision);
+        std::shared_ptr<DynamicSetting<int>> magnetoMeasuresPrecision,
+        std::shared_ptr<DynamicSetting<bool>> isBinaryFormatEnabled,
+        std::shared_ptr<DynamicSetting<int>> syncIntervalMs,
+        std::shared_ptr<DynamicSetting<int>> syncMegabytes,
+        std::shared_ptr<DynamicSetting<int>> segmentMegabytes,
+        std::shared_ptr<DynamicSetting<int>> segmentMinutes,
+        std::shared_ptr<DynamicSetting<bool>> isRecordingEnabled);
     ~FileStorageManager();
-    void loadFile(QWidget *widget);
+    void loadFile(QWidget *widget, bool follow = false);
+    // В режиме слежения файл, который еще пишется, читается курсором с продолжением:
+    // загрузка дочитывает его до текущего конца, readAppended возвращает только новые строки.
+    // Восстановление хвоста при этом не выполняется, его дописывает другой процесс.
+    void loadFile(const QString &filePath, bool follow = false);
 
-    QList<TimestampedSensorData> loadDataForPeriod(const QDateTime &start, const QDateTime &end) const;
-    QList<TimestampedSensorData> loadAllData() const;
+    bool isFollowing() const;
+    void stopFollowing();
+    // Следующий пакет дописанных строк; false, если новых целых строк пока нет
+    bool readAppended(SensorDataBatch &batch);
+    // Файлы, изменение которых означает появление новых данных
+    QStringList getFollowedPaths() const;
 
-    void openFileToSave();
-    void saveData(const TimestampedSensorData &data);
+    // Каталог, в который пишутся записи
+    static QString experimentsDirectory();
+
+    // DAO для чтения записи, формат определяется по расширению файла
+    static ISensorDataDAO *createReadDao(const QString &filePath);
+
+    // Потоковое чтение загруженного файла пакетами
+    std::unique_ptr<ISensorDataCursor> openCursor(const QDateTime &start, const QDateTime &end) const;
+    std::unique_ptr<ISensorDataCursor> openCursor() const;
+
+    // Границы и размер загруженной записи, вычисляются одним проходом при загрузке
+    QDateTime getMinTimestamp() const;
+    QDateTime getMaxTimestamp() const;
+    qint64 getRowCount() const;
+
+    // Группы каналов, присутствующие во всей загруженной записи
+    int getChannels() const;
+    // Точность записи измерений окружающей среды в CSV
+    int getMeasuresPrecision() const;
+
+    // Запись принимаемых данных в новый файл каталога experiments.
+    // Формат, каналы, точность, политика сброса и ротация берутся из настроек на момент начала.
+    bool startRecording();
+    // Включена ли запись приема в настройках
+    bool isRecordingEnabled() const;
+    // timestampNs - наносекунды с эпохи; строка пишется в файл потоком записи
+    void record(qint64 timestampNs, const SensorData &data);
+    // Дописывает принятые строки и закрывает файл
+    void stopRecording();
+    bool isRecording() const;
+    LiveRecorderStats getRecordingStats() const;
+
+    // Итог восстановления последнего загруженного файла: если запись
+    // была прервана аварийно, недописанный хвост отбрасывается при загрузке
+    RecoveryReport getRecoveryReport() const;
 
     QString getReadFileName() const;
+    QString getReadFilePath() const;
     QString getSaveFileName() const;
 
 
 private:
-    void freeFile(CsvSensorDataDAO *dao);
+    void freeFile(ISensorDataDAO *dao);
+    void scanReadFile();
+    void accumulateBounds(const SensorDataBatch &batch);
+    // Настройки записи, снятые при ее начале: сегменты сессии создаются потоком записи
+    struct SaveFormat
+    {
+        bool binary = false;
+        bool enabled[ChannelSchema::GROUP_COUNT] = {};
+        int precision[ChannelSchema::GROUP_COUNT] = {};
+
+        // Сохраняемые группы каналов, маска SensorDataBatch::Channels
+        int channels() const {
+            int mask = 0;
+            for (int group = 0; group < ChannelSchema::GROUP_COUNT; ++group) {
+                mask |= enabled[group] ? ChannelSchema::GROUPS[group].mask : 0;
+            }
+            return mask;
+        }
+    };
+    SaveFormat currentSaveFormat() const;
+    static ISensorDataDAO *createSaveDao(const QString &filePath, const SaveFormat &format);
+    static RecoveryReport recoverRecording(const QString &filePath);
 private:
-    CsvSensorDataDAO *csvDaoToRead = nullptr;
-    CsvSensorDataDAO *csvDaoToSave = nullptr;
+    ISensorDataDAO *daoToRead = nullptr;
+    std::unique_ptr<LiveRecorder> recorder;
+    std::unique_ptr<ISensorDataCursor> followCursor;
     QString readFilePath;
     QString saveFilePath;
-    QList<TimestampedSensorData> cachedData;
+    qint64 minTimestampNs = 0;
+    qint64 maxTimestampNs = 0;
+    qint64 rowCount = 0;
+    int readChannels = 0;
+    RecoveryReport recoveryReport;
     std::shared_ptr<DynamicSetting<bool>> isEnvMeasuresEnabled;
     std::shared_ptr<DynamicSetting<int>> envMeasuresPrecision;
     std::shared_ptr<DynamicSetting<bool>> isGyroMeasuresEnabled;
@@ -50,6 +128,12 @@ private:
     std::shared_ptr<DynamicSetting<int>> acceleroMeasuresPrecision;
     std::shared_ptr<DynamicSetting<bool>> isMagnetoMeasuresEnabled;
     std::shared_ptr<DynamicSetting<int>> magnetoMeasuresPrecision;
+    std::shared_ptr<DynamicSetting<bool>> isBinaryFormatEnabled;
+    std::shared_ptr<DynamicSetting<int>> syncIntervalMs;
+    std::shared_ptr<DynamicSetting<int>> syncMegabytes;
+    std::shared_ptr<DynamicSetting<int>> segmentMegabytes;
+    std::shared_ptr<DynamicSetting<int>> segmentMinutes;
+    std::shared_ptr<DynamicSetting<bool>> isRecordingEnabled_;
 };
 
 #endif // STORAGEMANAGER_H
@@ -0,0 +1,190 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include "monotonicclock.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QString>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Трассировка интервалов пути приема для просмотра в chrome://tracing или ui.perfetto.dev.
+// Каждый поток пишет в свое кольцо фиксированного размера без блокировок и выделений памяти;
+// при переполнении затираются самые старые интервалы. Выключенная трассировка стоит
+// одного чтения атомарного флага на интервал. Имена интервалов - строковые литералы.
+class Tracer
+{
+public:
+    static constexpr int DEFAULT_EVENTS_PER_THREAD = 1 << 16;
+
+    static Tracer &instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    static bool isEnabled() {
+        return instance().enabled_.load(std::memory_order_relaxed);
+    }
+
+    // Кольца очищаются; кольца завершившихся потоков отбрасываются
+    void start(int eventsPerThread = DEFAULT_EVENTS_PER_THREAD) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        enabled_.store(false);
+        capacity_ = std::max(1, eventsPerThread);
+        retired_.clear();
+        for (Ring *ring : live_) {
+            ring->written.store(0, std::memory_order_relaxed);
+        }
+        originNs_ = MonotonicClock::nowNs();
+        enabled_.store(true);
+    }
+
+    bool isRecording() const {
+        return enabled_.load();
+    }
+
+    // Останавливает запись и сохраняет трассу в формате Chrome trace event JSON
+    bool stop(const QString &path) {
+        enabled_.store(false);
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+        file.write("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+        bool first = true;
+        auto writeRing = [&](const Ring &ring) {
+            writeEvent(file, first, QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,\"args\":{\"name\":\"%2\"}}")
+                                        .arg(ring.tid).arg(escaped(ring.name)));
+            const quint64 written = ring.written.load(std::memory_order_acquire);
+            const quint64 count = std::min<quint64>(written, ring.events.size());
+            for (quint64 i = written - count; i < written; ++i) {
+                const Event &event = ring.events[i % ring.events.size()];
+                writeEvent(file, first, QString("{\"name\":\"%1\",\"ph\":\"X\",\"pid\":1,\"tid\":%2,\"ts\":%3,\"dur\":%4}")
+                                            .arg(QLatin1String(event.name))
+                                            .arg(ring.tid)
+                                            .arg((event.startNs - originNs_) / 1e3, 0, 'f', 3)
+                                            .arg(event.durationNs / 1e3, 0, 'f', 3));
+            }
+        };
+        for (const Ring *ring : live_) {
+            writeRing(*ring);
+        }
+        for (const std::unique_ptr<Ring> &ring : retired_) {
+            writeRing(*ring);
+        }
+        file.write("\n]}\n");
+        return file.error() == QFile::NoError;
+    }
+
+    void record(const char *name, qint64 startNs, qint64 endNs) {
+        Ring *ring = currentRing();
+        const quint64 index = ring->written.load(std::memory_order_relaxed);
+        Event &event = ring->events[index % ring->events.size()];
+        event.name = name;
+        event.startNs = startNs;
+        event.durationNs = endNs - startNs;
+        ring->written.store(index + 1, std::memory_order_release);
+    }
+
+private:
+    struct Event
+    {
+        const char *name = "";
+        qint64 startNs = 0;
+        qint64 durationNs = 0;
+    };
+
+    struct Ring
+    {
+        QString name;
+        int tid = 0;
+        std::vector<Event> events;
+        std::atomic<quint64> written{0};
+    };
+
+    // Кольцо принадлежит потоку; при завершении потока оно переходит в retired_ до следующего start
+    struct ThreadRing
+    {
+        std::unique_ptr<Ring> ring;
+
+        ~ThreadRing() {
+            if (ring) {
+                Tracer::instance().retire(std::move(ring));
+            }
+        }
+    };
+
+    Tracer() = default;
+
+    Ring *currentRing() {
+        thread_local ThreadRing threadRing;
+        if (!threadRing.ring) {
+            std::unique_ptr<Ring> ring(new Ring());
+            QThread *thread = QThread::currentThread();
+            std::lock_guard<std::mutex> lock(mutex_);
+            ring->tid = ++lastTid_;
+            ring->name = !thread->objectName().isEmpty() ? thread->objectName()
+                         : QCoreApplication::instance() && thread == QCoreApplication::instance()->thread() ? QString("GUI")
+                                                                                                           : QString("thread %1").arg(ring->tid);
+            ring->events.resize(capacity_);
+            live_.push_back(ring.get());
+            threadRing.ring = std::move(ring);
+        }
+        return threadRing.ring.get();
+    }
+
+    void retire(std::unique_ptr<Ring> ring) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        live_.erase(std::remove(live_.begin(), live_.end(), ring.get()), live_.end());
+        if (ring->written.load() > 0) {
+            retired_.push_back(std::move(ring));
+        }
+    }
+
+    static QString escaped(QString text) {
+        return text.replace('\\', "\\\\").replace('"', "\\\"");
+    }
+
+    static void writeEvent(QFile &file, bool &first, const QString &json) {
+        if (!first) {
+            file.write(",\n");
+        }
+        first = false;
+        file.write(json.toUtf8());
+    }
+
+    std::atomic<bool> enabled_{false};
+    std::mutex mutex_;
+    std::vector<Ring*> live_;
+    std::vector<std::unique_ptr<Ring>> retired_;
+    int capacity_ = DEFAULT_EVENTS_PER_THREAD;
+    int lastTid_ = 0;
+    qint64 originNs_ = 0;
+};
+
+// Интервал от создания до разрушения объекта; при выключенной трассировке ничего не пишет
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name)
+        : name_(name), startNs_(Tracer::isEnabled() ? MonotonicClock::nowNs() : 0) {}
+
+    ~TraceSpan() {
+        if (startNs_ != 0 && Tracer::isEnabled()) {
+            Tracer::instance().record(name_, startNs_, MonotonicClock::nowNs());
+        }
+    }
+
+private:
+    const char *name_;
+    qint64 startNs_;
+};
+
+#endif // TRACER_H
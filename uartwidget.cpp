@@ -1,6 +1,7 @@
 #include "pagerouter.h"
 #include "uartwidget.h"
 #include "ui_uartwidget.h"
+#include "comand/uartsettings.h"
 
 #include <QDebug>
 #include <QFile>
@@ -16,23 +17,57 @@ UartWidget::UartWidget(InsCommandProcessor *serial, QWidget *parent) :
     isExpanded(true)
 {
     serailPortMonitor = new SerialPortMonitor();
+    speedTuner = new LinkSpeedTuner(serial, this);
+    replayTimer = new QTimer(this);
+    replayTimer->setInterval(REPLAY_POSITION_INTERVAL_MS);
     ui->setupUi(this);
 
+    // Путь можно ввести вручную, например псевдотерминал /dev/pts/N для проверки без устройства,
+    // или файл записи (.insraw, .csv, .insr, .db, .arrow) для воспроизведения вместо устройства
+    ui->PortNameComboBox->setEditable(true);
     Q_FOREACH(QSerialPortInfo port, QSerialPortInfo::availablePorts()) {
         ui->PortNameComboBox->addItem(port.portName());
     }
 
     // Заполнение параметров для UART
     ui->reconfigureUartButton->setVisible(false);
-    ui->BaudRateComboBox->addItems({"9600", "19200", "38400", "57600", "115200"});
+    ui->autoTuneButton->setVisible(false);
+    ui->replaySlider->setVisible(false);
+    for (qint32 rate : UartSettings::deviceBaudRates()) {
+        ui->BaudRateComboBox->addItem(QString::number(rate));
+    }
+    ui->BaudRateComboBox->setCurrentText("115200");
     ui->DataBitsComboBox->addItems({"7", "8"});
     ui->DataBitsComboBox->setCurrentIndex(1);
     ui->ParityComboBox->addItems({"None", "Even", "Odd"});
     ui->StopBitsComboBox->addItems({"1", "1.5", "2"});
     ui->FlowControlComboBox->addItems({"None", "RTS/CTS"});
+    ui->ReadModeComboBox->addItem("Стандартный", static_cast<int>(SerialReadMode::STANDARD));
+#ifdef Q_OS_LINUX
+    ui->ReadModeComboBox->addItem("Низкая задержка", static_cast<int>(SerialReadMode::LOW_LATENCY));
+    ui->ReadModeComboBox->addItem("Пропускная способность", static_cast<int>(SerialReadMode::THROUGHPUT));
+#endif
 
     connect(ui->ConnectButton, &QPushButton::clicked, this, &UartWidget::onConnectButtonClicked);
     connect(ui->reconfigureUartButton, &QPushButton::clicked, this, &UartWidget::reconfigureUart);
+    connect(ui->autoTuneButton, &QPushButton::clicked, this, &UartWidget::autoTuneSpeed);
+    connect(speedTuner, &LinkSpeedTuner::stepFinished, this, [=](qint32 rate, const LinkStats &stats, bool clean) {
+        ui->autoTuneButton->setText(QString("Подбор: %1 %2").arg(rate).arg(clean ? "без ошибок" : "с ошибками"));
+    });
+    connect(speedTuner, &LinkSpeedTuner::finished, this, [=](qint32 rate, bool success) {
+        ui->autoTuneButton->setText("Подобрать скорость");
+        ui->autoTuneButton->setEnabled(true);
+        ui->reconfigureUartButton->setEnabled(true);
+        ui->BaudRateComboBox->setCurrentText(QString::number(rate));
+        if (success) {
+            QMessageBox::information(this, "Подбор скорости", QString("Установлена скорость %1").arg(rate));
+        } else {
+            QMessageBox::warning(this, "Подбор скорости",
+                                 QString("Связь на скорости %1 с ошибками, скорость не изменена").arg(rate));
+        }
+    });
+    connect(replayTimer, &QTimer::timeout, this, &UartWidget::updateReplayPosition);
+    connect(ui->replaySlider, &QSlider::sliderReleased, this, &UartWidget::seekReplay);
     connect(serailPortMonitor, &SerialPortMonitor::newPortDetected, [=](const QString &portName) {
         qDebug() << "Signal received for new port:" << portName;
         ui->PortNameComboBox->addItem(portName);
@@ -91,7 +126,12 @@ void UartWidget::loadSetupUartPage() {
 
     ui->PortNameComboBox->setVisible(true);
     ui->portNameLabel->setVisible(true);
+    ui->ReadModeComboBox->setVisible(true);
+    ui->readModeLabel->setVisible(true);
     ui->reconfigureUartButton->setVisible(false);
+    ui->autoTuneButton->setVisible(false);
+    ui->replaySlider->setVisible(false);
+    replayTimer->stop();
     ui->ConnectButton->setVisible(true);
 }
 
@@ -100,7 +140,19 @@ void UartWidget::loadConfigureUartPage() {
 
     ui->PortNameComboBox->setVisible(false);
     ui->portNameLabel->setVisible(false);
-    ui->reconfigureUartButton->setVisible(isExpanded);
+    // Режим чтения выбирается только при подключении
+    ui->ReadModeComboBox->setVisible(false);
+    ui->readModeLabel->setVisible(false);
+    // У записи нет настроек UART, вместо них - позиция воспроизведения
+    const bool replaying = serialReaderWriter->isReplaying();
+    ui->reconfigureUartButton->setVisible(isExpanded && !replaying);
+    ui->autoTuneButton->setVisible(isExpanded && !replaying);
+    ui->replaySlider->setVisible(isExpanded && replaying);
+    if (replaying) {
+        replayTimer->start();
+    } else {
+        replayTimer->stop();
+    }
     ui->ConnectButton->setVisible(false);
 }
 
@@ -116,17 +168,7 @@ void UartWidget::prepareUartParams() {
     QString stopBitsStr = ui->StopBitsComboBox->currentText();
     QString flowControlStr = ui->FlowControlComboBox->currentText();
 
-    if (baudRateStr == "9600") {
-        baudRate = QSerialPort::Baud9600;
-    } else if (baudRateStr == "19200") {
-        baudRate = QSerialPort::Baud19200;
-    } else if (baudRateStr == "38400") {
-        baudRate = QSerialPort::Baud38400;
-    } else if (baudRateStr == "57600") {
-        baudRate = QSerialPort::Baud57600;
-    } else if (baudRateStr == "115200") {
-        baudRate = QSerialPort::Baud115200;
-    }
+    baudRate = baudRateStr.toInt();
 
     if (dataBitsStr == "5") {
         dataBits = QSerialPort::Data5;
@@ -180,9 +222,23 @@ void UartWidget::reconfigureUart() {
     serialReaderWriter->setSpeed(baudRate);
 }
 
+// Подбор начинается с выбранной в списке скорости: на ней устройство работает сейчас
+void UartWidget::autoTuneSpeed() {
+    if (speedTuner->isRunning()) {
+        return;
+    }
+    prepareUartParams();
+    if (!speedTuner->start(baudRate, UartSettings::deviceBaudRates(), dataBits, parity, flowControl, stopBits)) {
+        return;
+    }
+    ui->autoTuneButton->setEnabled(false);
+    ui->reconfigureUartButton->setEnabled(false);
+}
+
 void UartWidget::onConnectButtonClicked() {
     // Установка параметров QSerialPort
     prepareUartParams();
+    serialReaderWriter->setReadMode(static_cast<SerialReadMode>(ui->ReadModeComboBox->currentData().toInt()));
     if (!serialReaderWriter->openSerialPort(ui->PortNameComboBox->currentText(), baudRate, dataBits, parity, stopBits, flowControl)) {
         QMessageBox::critical(this, "Connection Error", serialReaderWriter->getLastError());
     } else {
@@ -192,6 +248,24 @@ void UartWidget::onConnectButtonClicked() {
     }
 }
 
+void UartWidget::updateReplayPosition() {
+    if (ui->replaySlider->isSliderDown()) {
+        return;
+    }
+    const ReplayPosition position = serialReaderWriter->getReplayPosition();
+    const qint64 duration = position.lastNs - position.firstNs;
+    const int value = duration > 0
+        ? static_cast<int>((position.positionNs - position.firstNs) * ui->replaySlider->maximum() / duration)
+        : 0;
+    ui->replaySlider->setValue(value);
+}
+
+void UartWidget::seekReplay() {
+    const ReplayPosition position = serialReaderWriter->getReplayPosition();
+    const qint64 duration = position.lastNs - position.firstNs;
+    serialReaderWriter->seekReplay(position.firstNs + duration * ui->replaySlider->value() / ui->replaySlider->maximum());
+}
+
 void UartWidget::setExpanded(bool expanded)
 {
     qDebug() << "set expanded: " << expanded;
@@ -206,7 +280,10 @@ void UartWidget::updateWidgetState()
     // Hide/show buttons based on connection status
     bool isConnected = serialReaderWriter->isConnected();
     ui->ConnectButton->setVisible(isExpanded && !isConnected);
-    ui->reconfigureUartButton->setVisible(isExpanded && isConnected);
+    bool replaying = serialReaderWriter->isReplaying();
+    ui->reconfigureUartButton->setVisible(isExpanded && isConnected && !replaying);
+    ui->autoTuneButton->setVisible(isExpanded && isConnected && !replaying);
+    ui->replaySlider->setVisible(isExpanded && replaying);
 
     // Set minimum widths for comboboxes
     int minWidth = isExpanded ? 200 : 50;
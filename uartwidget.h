@@ -2,11 +2,13 @@
 #define UARTWIDGET_H
 
 #include "inscommandprocessor.h"
+#include "linkspeedtuner.h"
 #include "routablewidget.cpp"
 #include "serialportmonitor.h"
 #include "serialreader.h"
 
 #include <QSerialPort>
+#include <QTimer>
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class UartWidget; }
@@ -17,6 +19,8 @@ class UartWidget : public RoutableWidget
     Q_OBJECT
 
 public:
+    static constexpr int REPLAY_POSITION_INTERVAL_MS = 250;
+
     explicit UartWidget(InsCommandProcessor *serial, QWidget *parent = nullptr);
     ~UartWidget();
 
@@ -28,6 +32,7 @@ public:
     void loadConfigureUartPage();
 
     void reconfigureUart();
+    void autoTuneSpeed();
     void setExpanded(bool expanded);
 
 private slots:
@@ -38,14 +43,18 @@ private:
 
     void prepareUartParams();
     void updateWidgetState();
+    void updateReplayPosition();
+    void seekReplay();
 
 private:
     InsCommandProcessor *serialReaderWriter;
 
     Ui::UartWidget *ui;
     SerialPortMonitor *serailPortMonitor = 0;
+    LinkSpeedTuner *speedTuner;
+    QTimer *replayTimer;
 
-    QSerialPort::BaudRate baudRate;
+    qint32 baudRate;
     QSerialPort::DataBits dataBits;
     QSerialPort::Parity parity;
     QSerialPort::StopBits stopBits;